@@ -0,0 +1,202 @@
+package api
+
+import (
+	"context"
+	"fmt"
+	"log"
+	"net/http"
+
+	"github.com/equinor/oneseismic/api/internal/auth"
+	"github.com/equinor/oneseismic/api/internal/message"
+	"github.com/equinor/oneseismic/api/internal/util"
+
+	"github.com/gin-gonic/gin"
+	"github.com/go-redis/redis/v8"
+)
+
+type Area struct {
+	BasicEndpoint
+}
+
+func MakeArea(
+	keyring  *auth.Keyring,
+	endpoint string,
+	storage  redis.Cmdable,
+	tokens   auth.Tokens,
+) *Area {
+	return &Area {
+		MakeBasicEndpoint(
+			keyring,
+			endpoint,
+			storage,
+			tokens,
+		),
+	}
+}
+
+func (a *Area) MakeTask(
+	pid       string,
+	guid      string,
+	token     string,
+	manifest  []byte,
+	shape     []int32,
+	shapecube []int32,
+	params    *message.AreaParams,
+) *message.Task {
+	task := a.BasicEndpoint.MakeTask(
+		pid,
+		guid,
+		token,
+		manifest,
+		shape,
+		shapecube,
+	)
+	task.Function = "area"
+	task.Params   = params
+	return task
+}
+
+/*
+ * The polygon is the request body, as the (dim0, dim1) of its vertices, in
+ * either grid, label or world (x, y) coordinates. All traces inside or on the
+ * boundary of the polygon are extracted, clipped to the cube, in the sample
+ * range [zmin, zmax] which defaults to all samples.
+ */
+type area struct {
+	Polygon     [][2]float64 `json:"polygon"`
+	Coordinates string       `json:"coordinates"`
+	Zmin        *int         `json:"zmin"`
+	Zmax        *int         `json:"zmax"`
+}
+
+func (a *area) toAreaParams() (*message.AreaParams, error) {
+	coordinates := a.Coordinates
+	if coordinates == "" {
+		coordinates = "label"
+	}
+	if coordinates != "label" && coordinates != "grid" && coordinates != "world" {
+		return nil, fmt.Errorf("unknown coordinates %s", coordinates)
+	}
+	if len(a.Polygon) < 3 {
+		return nil, fmt.Errorf(
+			"expected polygon of at least 3 points, was %d",
+			len(a.Polygon),
+		)
+	}
+	if a.Zmin != nil && a.Zmax != nil && *a.Zmin > *a.Zmax {
+		return nil, fmt.Errorf("zmin (= %d) > zmax (= %d)", *a.Zmin, *a.Zmax)
+	}
+	return &message.AreaParams{
+		Polygon:     a.Polygon,
+		Coordinates: coordinates,
+		Zmin:        a.Zmin,
+		Zmax:        a.Zmax,
+	}, nil
+}
+
+func (a *Area) Get(ctx *gin.Context) {
+	pid := ctx.GetString("pid")
+	guid := ctx.Param("guid")
+
+	format, err := parseFormat(ctx)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	m, err := util.GetManifest(ctx, a.tokens, a.endpoint, guid)
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		return
+	}
+
+	body := area {}
+	err = ctx.ShouldBindJSON(&body)
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	params, err := body.toAreaParams()
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	authorization := ctx.GetHeader("Authorization")
+	token, err := a.tokens.GetOnbehalf(authorization)
+	if err != nil {
+		// No further recovery is tried - GetManifest should already have fixed
+		// a broken token, so this should be readily cached. If it is
+		// just-about to expire then the process will fail pretty soon anyway,
+		// so just give up.
+		log.Printf("pid=%s, %v", pid, err)
+		auth.AbortContextFromToken(ctx, err)
+		return
+	}
+
+	manifest, err := m.Pack()
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		ctx.AbortWithStatus(http.StatusInternalServerError)
+		return
+	}
+
+	cubeshape := make([]int32, 0, len(m.Dimensions))
+	for i := 0; i < len(m.Dimensions); i++ {
+		cubeshape = append(cubeshape, int32(len(m.Dimensions[i])))
+	}
+	msg := a.MakeTask(
+		pid,
+		guid,
+		token,
+		manifest,
+		[]int32{ 64, 64, 64 },
+		cubeshape,
+		params,
+	)
+	msg.Format = format
+
+	query, err := a.sched.MakeQuery(ctx, msg)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		qe, ok := err.(*QueryError)
+		if ok && qe.Status() != 0 {
+			ctx.AbortWithStatus(qe.Status())
+		} else {
+			ctx.AbortWithStatus(http.StatusInternalServerError)
+		}
+		return
+	}
+
+	/*
+	 * Identical queries share a process, so the result may be that of an
+	 * earlier request
+	 */
+	key, err := a.keyring.Sign(query.Pid())
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusInternalServerError)
+		return
+	}
+	go func() {
+		err := a.sched.Schedule(context.Background(), pid, query)
+		if err != nil {
+			/*
+			 * Make scheduling errors fatal to detect them for debugging.
+			 * Eventually this should log, maybe cancel the process, and
+			 * continue.
+			 */
+			log.Fatalf("pid=%s, %v", pid, err)
+		}
+	}()
+
+	ctx.JSON(http.StatusOK, gin.H {
+		"location": fmt.Sprintf("result/%s", query.Pid()),
+		"status":   fmt.Sprintf("result/%s/status", query.Pid()),
+		"authorization": key,
+	})
+}
@@ -0,0 +1,277 @@
+package api
+
+import (
+	"context"
+	"fmt"
+	"log"
+	"net/http"
+
+	"github.com/equinor/oneseismic/api/internal/auth"
+	"github.com/equinor/oneseismic/api/internal/message"
+	"github.com/equinor/oneseismic/api/internal/util"
+
+	"github.com/gin-gonic/gin"
+	"github.com/go-redis/redis/v8"
+)
+
+type Batch struct {
+	BasicEndpoint
+}
+
+func MakeBatch(
+	keyring  *auth.Keyring,
+	endpoint string,
+	storage  redis.Cmdable,
+	tokens   auth.Tokens,
+) *Batch {
+	return &Batch {
+		MakeBasicEndpoint(
+			keyring,
+			endpoint,
+			storage,
+			tokens,
+		),
+	}
+}
+
+func (b *Batch) MakeTask(
+	pid       string,
+	guid      string,
+	token     string,
+	manifest  []byte,
+	shape     []int32,
+	shapecube []int32,
+	params    *message.BatchParams,
+) *message.Task {
+	task := b.BasicEndpoint.MakeTask(
+		pid,
+		guid,
+		token,
+		manifest,
+		shape,
+		shapecube,
+	)
+	task.Function = "batch"
+	task.Params   = params
+	return task
+}
+
+/*
+ * A slice in a batch, with the same parameters as the slice endpoint, except
+ * progressive, which can not be batched.
+ */
+type batchslice struct {
+	Dim    int      `json:"dim"`
+	Lineno int      `json:"lineno"`
+	Zmin   *int     `json:"zmin"`
+	Zmax   *int     `json:"zmax"`
+	Roi    [][2]int `json:"roi"`
+	Stride []int    `json:"stride"`
+}
+
+func (s *batchslice) toSliceParams() (*message.SliceParams, error) {
+	if s.Zmin != nil && s.Zmax != nil && *s.Zmin > *s.Zmax {
+		return nil, fmt.Errorf("zmin (= %d) > zmax (= %d)", *s.Zmin, *s.Zmax)
+	}
+	if s.Roi != nil && len(s.Roi) != 2 {
+		return nil, fmt.Errorf("expected roi of 2 ranges, was %d", len(s.Roi))
+	}
+	for _, r := range s.Roi {
+		if r[0] > r[1] {
+			return nil, fmt.Errorf("roi (= %v) first > last", s.Roi)
+		}
+	}
+	if s.Stride != nil && len(s.Stride) != 2 {
+		return nil, fmt.Errorf("expected stride of 2 elements, was %d", len(s.Stride))
+	}
+	for _, x := range s.Stride {
+		if x < 1 {
+			return nil, fmt.Errorf("stride (= %v) < 1", s.Stride)
+		}
+	}
+	return &message.SliceParams {
+		Dim:    s.Dim,
+		Lineno: s.Lineno,
+		Zmin:   s.Zmin,
+		Zmax:   s.Zmax,
+		Roi:    s.Roi,
+		Stride: s.Stride,
+	}, nil
+}
+
+/*
+ * The batch is the request body, a set of slices and curtains (of
+ * intersections) of the same cube, e.g. a fence of curtains or a set of
+ * inlines. The queries are planned together, so that fragments shared by
+ * many queries are only read once, but every query is its own process, with
+ * its own result.
+ */
+type batch struct {
+	Slices   []batchslice `json:"slices"`
+	Curtains []path       `json:"curtains"`
+}
+
+func (b *Batch) Get(ctx *gin.Context) {
+	pid := ctx.GetString("pid")
+	guid := ctx.Param("guid")
+
+	format, err := parseFormat(ctx)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	attribute, window, err := parseAttribute(ctx)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	m, err := util.GetManifest(ctx, b.tokens, b.endpoint, guid)
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		return
+	}
+
+	body := batch {}
+	err = ctx.ShouldBindJSON(&body)
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+	if len(body.Slices) + len(body.Curtains) == 0 {
+		log.Printf("pid=%s, empty batch", pid)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	authorization := ctx.GetHeader("Authorization")
+	token, err := b.tokens.GetOnbehalf(authorization)
+	if err != nil {
+		// No further recovery is tried - GetManifest should already have fixed
+		// a broken token, so this should be readily cached. If it is
+		// just-about to expire then the process will fail pretty soon anyway,
+		// so just give up.
+		log.Printf("pid=%s, %v", pid, err)
+		auth.AbortContextFromToken(ctx, err)
+		return
+	}
+
+	manifest, err := m.Pack()
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		ctx.AbortWithStatus(http.StatusInternalServerError)
+		return
+	}
+
+	cubeshape := make([]int32, 0, len(m.Dimensions))
+	for i := 0; i < len(m.Dimensions); i++ {
+		cubeshape = append(cubeshape, int32(len(m.Dimensions[i])))
+	}
+	shape := []int32{ 64, 64, 64 }
+
+	/*
+	 * Every query is its own process with its own pid, so that its result is
+	 * read like the result of any other query.
+	 */
+	params := &message.BatchParams {}
+	mktask := func(function string, queryparams interface{}) {
+		task := b.BasicEndpoint.MakeTask(
+			util.MakePID(),
+			guid,
+			token,
+			manifest,
+			shape,
+			cubeshape,
+		)
+		task.Function = function
+		task.Params   = queryparams
+		task.Format = format
+		task.Attribute = attribute
+		task.AttributeWindow = window
+		params.Tasks = append(params.Tasks, task)
+	}
+	for _, s := range body.Slices {
+		slice, err := s.toSliceParams()
+		if err != nil {
+			log.Printf("pid=%s, %v", pid, err)
+			ctx.AbortWithStatus(http.StatusBadRequest)
+			return
+		}
+		mktask("slice", slice)
+	}
+	for _, c := range body.Curtains {
+		if len(c.Polyline) > 0 {
+			log.Printf("pid=%s, polylines can not be batched", pid)
+			ctx.AbortWithStatus(http.StatusBadRequest)
+			return
+		}
+		curtain, err := c.toCurtainParams(m)
+		if err != nil {
+			log.Printf("pid=%s, %v", pid, err)
+			ctx.AbortWithStatus(http.StatusBadRequest)
+			return
+		}
+		mktask("curtain", curtain)
+	}
+
+	msg := b.MakeTask(
+		pid,
+		guid,
+		token,
+		manifest,
+		shape,
+		cubeshape,
+		params,
+	)
+
+	plan, err := b.sched.MakeBatch(msg)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		qe, ok := err.(*QueryError)
+		if ok && qe.Status() != 0 {
+			ctx.AbortWithStatus(qe.Status())
+		} else {
+			ctx.AbortWithStatus(http.StatusInternalServerError)
+		}
+		return
+	}
+
+	results := make([]gin.H, 0, len(params.Tasks))
+	for _, task := range params.Tasks {
+		key, err := b.keyring.Sign(task.Pid)
+		if err != nil {
+			log.Printf("pid=%s, %v", pid, err)
+			ctx.AbortWithStatus(http.StatusInternalServerError)
+			return
+		}
+		results = append(results, gin.H {
+			"location": fmt.Sprintf("result/%s", task.Pid),
+			"status":   fmt.Sprintf("result/%s/status", task.Pid),
+			"authorization": key,
+		})
+	}
+
+	go func() {
+		err := b.sched.ScheduleBatch(context.Background(), pid, plan)
+		if err != nil {
+			/*
+			 * Make scheduling errors fatal to detect them for debugging.
+			 * Eventually this should log, maybe cancel the process, and
+			 * continue.
+			 */
+			log.Fatalf("pid=%s, %v", pid, err)
+		}
+	}()
+
+	/*
+	 * The results are the slices followed by the curtains, in the order of
+	 * the request
+	 */
+	ctx.JSON(http.StatusOK, gin.H {
+		"results": results,
+	})
+}
@@ -56,31 +56,117 @@ func (c *Curtain) MakeTask(
 	return task
 }
 
+func (c *Curtain) MakePolylineTask(
+	pid       string,
+	guid      string,
+	token     string,
+	manifest  []byte,
+	shape     []int32,
+	shapecube []int32,
+	params    *message.PolylineParams,
+) *message.Task {
+	task := c.BasicEndpoint.MakeTask(
+		pid,
+		guid,
+		token,
+		manifest,
+		shape,
+		shapecube,
+	)
+	task.Function = "polyline"
+	task.Params   = params
+	return task
+}
+
 /*
  * The path is a tiny helper to parse the input "parameter" (the request body).
  * Eventually this will parse some normalised format, either from a previously
  * parsed input, or from some curtain storage system.
+ *
+ * The path is either a list of intersections, which are grid nodes (line
+ * numbers), or a polyline of control points that need not be on the grid,
+ * which is densified to points spacing apart by the planner, with the traces
+ * interpolated from the neighbouring traces. The control points can be in
+ * label, grid or world coordinates, and the spacing is in world units for
+ * world coordinates and in traces otherwise. The planner rejects spacings
+ * below a tenth of the distance between traces, and paths of too many points.
+ * The curtain of intersections can be cropped to the z-range [zmin, zmax], in
+ * sample labels.
  */
 type path struct {
-	Intersections [][2]int `json:intersections`
+	Intersections [][2]int     `json:"intersections"`
+	TargetShape   []int        `json:"target_shape"`
+	Polyline      [][2]float64 `json:"polyline"`
+	Spacing       float32      `json:"spacing"`
+	Coordinates   string       `json:"coordinates"`
+	Zmin          *int         `json:"zmin"`
+	Zmax          *int         `json:"zmax"`
+}
+
+func (p *path) toPolylineParams() (*message.PolylineParams, error) {
+	if len(p.Intersections) > 0 {
+		return nil, fmt.Errorf("both intersections and polyline given")
+	}
+	spacing := p.Spacing
+	if spacing == 0 {
+		spacing = 1
+	}
+	if spacing < 0 {
+		return nil, fmt.Errorf("spacing (= %v) < 0", spacing)
+	}
+	coordinates := p.Coordinates
+	if coordinates == "" {
+		coordinates = "label"
+	}
+	if coordinates != "label" && coordinates != "grid" && coordinates != "world" {
+		return nil, fmt.Errorf("unknown coordinates %s", coordinates)
+	}
+	return &message.PolylineParams{
+		Points:      p.Polyline,
+		Spacing:     spacing,
+		Coordinates: coordinates,
+	}, nil
 }
 
 func (p *path) toCurtainParams(
 	manifest *message.Manifest,
 ) (*message.CurtainParams, error) {
+	if p.Zmin != nil && p.Zmax != nil && *p.Zmin > *p.Zmax {
+		return nil, fmt.Errorf("zmin (= %d) > zmax (= %d)", *p.Zmin, *p.Zmax)
+	}
 	xs := make([]int, len(p.Intersections))
 	ys := make([]int, len(p.Intersections))
 	for i, xy := range p.Intersections {
 		xs[i] = xy[0]
 		ys[i] = xy[1]
 	}
-	return &message.CurtainParams{ Dim0s: xs, Dim1s: ys }, nil
+	return &message.CurtainParams{
+		Dim0s:       xs,
+		Dim1s:       ys,
+		TargetShape: p.TargetShape,
+		Zmin:        p.Zmin,
+		Zmax:        p.Zmax,
+	}, nil
 }
 
 func (c *Curtain) Get(ctx *gin.Context) {
 	pid := ctx.GetString("pid")
 	guid := ctx.Param("guid")
 
+	format, err := parseFormat(ctx)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	attribute, window, err := parseAttribute(ctx)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
 	m, err := util.GetManifest(ctx, c.tokens, c.endpoint, guid)
 	if err != nil {
 		log.Printf("pid=%s %v", pid, err)
@@ -94,11 +180,22 @@ func (c *Curtain) Get(ctx *gin.Context) {
 		return
 	}
 
-	params, err := path.toCurtainParams(m)
-	if err != nil {
-		log.Printf("pid=%s, %v", pid, err)
-		ctx.AbortWithStatus(http.StatusInternalServerError)
-		return
+	var params *message.CurtainParams
+	var polyline *message.PolylineParams
+	if len(path.Polyline) > 0 {
+		polyline, err = path.toPolylineParams()
+		if err != nil {
+			log.Printf("pid=%s, %v", pid, err)
+			ctx.AbortWithStatus(http.StatusBadRequest)
+			return
+		}
+	} else {
+		params, err = path.toCurtainParams(m)
+		if err != nil {
+			log.Printf("pid=%s, %v", pid, err)
+			ctx.AbortWithStatus(http.StatusInternalServerError)
+			return
+		}
 	}
 
 	authorization := ctx.GetHeader("Authorization")
@@ -124,24 +221,33 @@ func (c *Curtain) Get(ctx *gin.Context) {
 	for i := 0; i < len(m.Dimensions); i++ {
 		cubeshape = append(cubeshape, int32(len(m.Dimensions[i])))
 	}
-	msg := c.MakeTask(
-		pid,
-		guid,
-		token,
-		manifest,
-		[]int32{ 64, 64, 64 },
-		cubeshape,
-		params,
-	)
-
-	key, err := c.keyring.Sign(pid)
-	if err != nil {
-		log.Printf("pid=%s, %v", pid, err)
-		ctx.AbortWithStatus(http.StatusInternalServerError)
-		return
+	var msg *message.Task
+	if polyline != nil {
+		msg = c.MakePolylineTask(
+			pid,
+			guid,
+			token,
+			manifest,
+			[]int32{ 64, 64, 64 },
+			cubeshape,
+			polyline,
+		)
+	} else {
+		msg = c.MakeTask(
+			pid,
+			guid,
+			token,
+			manifest,
+			[]int32{ 64, 64, 64 },
+			cubeshape,
+			params,
+		)
 	}
+	msg.Format = format
+	msg.Attribute = attribute
+	msg.AttributeWindow = window
 
-	query, err := c.sched.MakeQuery(msg)
+	query, err := c.sched.MakeQuery(ctx, msg)
 	if err != nil {
 		log.Printf("pid=%s, %v", pid, err)
 		qe := err.(*QueryError)
@@ -152,6 +258,17 @@ func (c *Curtain) Get(ctx *gin.Context) {
 		}
 		return
 	}
+
+	/*
+	 * Identical queries share a process, so the result may be that of an
+	 * earlier request
+	 */
+	key, err := c.keyring.Sign(query.Pid())
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusInternalServerError)
+		return
+	}
 	go func() {
 		err := c.sched.Schedule(context.Background(), pid, query)
 		if err != nil {
@@ -165,8 +282,8 @@ func (c *Curtain) Get(ctx *gin.Context) {
 	}()
 
 	ctx.JSON(http.StatusOK, gin.H {
-		"location": fmt.Sprintf("result/%s", pid),
-		"status":   fmt.Sprintf("result/%s/status", pid),
+		"location": fmt.Sprintf("result/%s", query.Pid()),
+		"status":   fmt.Sprintf("result/%s/status", query.Pid()),
 		"authorization": key,
 	})
 }
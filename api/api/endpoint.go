@@ -5,6 +5,8 @@ import (
 	"log"
 	"net/http"
 	"net/url"
+	"strconv"
+	"strings"
 
 	"github.com/gin-gonic/gin"
 	"github.com/go-redis/redis/v8"
@@ -58,6 +60,105 @@ func (be *BasicEndpoint) MakeTask(
 	}
 }
 
+/*
+ * Parse the optional format query parameter, which selects the sample
+ * encoding of the result. Defaults to f32, the native format of fragments.
+ */
+func parseFormat(ctx *gin.Context) (string, error) {
+	format := ctx.DefaultQuery("format", "f32")
+	switch format {
+	case "f32", "f16", "bf16", "i16", "i8":
+		return format, nil
+	default:
+		return "", fmt.Errorf("unknown format %s", format)
+	}
+}
+
+/*
+ * Parse the optional attribute and attribute_window query parameters. The
+ * attribute reduces the samples over windows in z in the worker, and the
+ * window must divide the fragment height, which is checked by the planner.
+ */
+func parseAttribute(ctx *gin.Context) (string, int, error) {
+	attribute := ctx.DefaultQuery("attribute", "none")
+	switch attribute {
+	case "none", "rms", "mean", "maxabs", "sumpos", "sumneg":
+	default:
+		return "", 0, fmt.Errorf("unknown attribute %s", attribute)
+	}
+
+	window, err := strconv.Atoi(ctx.DefaultQuery("attribute_window", "1"))
+	if err != nil {
+		return "", 0, fmt.Errorf("error parsing attribute_window: %w", err)
+	}
+	if window < 1 {
+		return "", 0, fmt.Errorf("attribute_window (= %d) < 1", window)
+	}
+	return attribute, window, nil
+}
+
+/*
+ * Parse the optional target_shape query parameter, a comma-separated list of
+ * the minimum output size, e.g. the size of the view. The planner uses it to
+ * serve the query from an overview level. Returns nil if not set.
+ */
+func parseTargetShape(ctx *gin.Context) ([]int, error) {
+	return parseIntList(ctx, "target_shape")
+}
+
+/*
+ * Parse the optional comma-separated list of ints query parameter name.
+ * Returns nil if not set.
+ */
+func parseIntList(ctx *gin.Context, name string) ([]int, error) {
+	param := ctx.Query(name)
+	if param == "" {
+		return nil, nil
+	}
+
+	parts := strings.Split(param, ",")
+	xs := make([]int, len(parts))
+	for i, part := range parts {
+		x, err := strconv.Atoi(part)
+		if err != nil {
+			return nil, fmt.Errorf("error parsing %s: %w", name, err)
+		}
+		xs[i] = x
+	}
+	return xs, nil
+}
+
+/*
+ * Parse the optional zmin and zmax query parameters, the z-range in sample
+ * labels. Returns nil for the bounds that are not set.
+ */
+func parseZRange(ctx *gin.Context) (*int, *int, error) {
+	bound := func(name string) (*int, error) {
+		param := ctx.Query(name)
+		if param == "" {
+			return nil, nil
+		}
+		x, err := strconv.Atoi(param)
+		if err != nil {
+			return nil, fmt.Errorf("error parsing %s: %w", name, err)
+		}
+		return &x, nil
+	}
+
+	zmin, err := bound("zmin")
+	if err != nil {
+		return nil, nil, err
+	}
+	zmax, err := bound("zmax")
+	if err != nil {
+		return nil, nil, err
+	}
+	if zmin != nil && zmax != nil && *zmin > *zmax {
+		return nil, nil, fmt.Errorf("zmin (= %d) > zmax (= %d)", *zmin, *zmax)
+	}
+	return zmin, zmax, nil
+}
+
 func (be *BasicEndpoint) Root(ctx *gin.Context) {
 	pid := ctx.GetString("pid")
 
@@ -153,6 +254,12 @@ func (s *BasicEndpoint) Entry(ctx *gin.Context) {
 		"functions": gin.H {
 			"slice":   fmt.Sprintf("query/%s/slice",   guid),
 			"curtain": fmt.Sprintf("query/%s/curtain", guid),
+			"horizon": fmt.Sprintf("query/%s/horizon", guid),
+			"wellpath": fmt.Sprintf("query/%s/wellpath", guid),
+			"points":   fmt.Sprintf("query/%s/points",   guid),
+			"area":     fmt.Sprintf("query/%s/area",     guid),
+			"stats":    fmt.Sprintf("query/%s/stats",    guid),
+			"batch":    fmt.Sprintf("query/%s/batch",    guid),
 		},
 		"dimensions": dims,
 		"pid": pid,
@@ -0,0 +1,206 @@
+package api
+
+import (
+	"context"
+	"fmt"
+	"log"
+	"net/http"
+
+	"github.com/equinor/oneseismic/api/internal/auth"
+	"github.com/equinor/oneseismic/api/internal/message"
+	"github.com/equinor/oneseismic/api/internal/util"
+
+	"github.com/gin-gonic/gin"
+	"github.com/go-redis/redis/v8"
+)
+
+type Horizon struct {
+	BasicEndpoint
+}
+
+func MakeHorizon(
+	keyring  *auth.Keyring,
+	endpoint string,
+	storage  redis.Cmdable,
+	tokens   auth.Tokens,
+) *Horizon {
+	return &Horizon {
+		MakeBasicEndpoint(
+			keyring,
+			endpoint,
+			storage,
+			tokens,
+		),
+	}
+}
+
+func (h *Horizon) MakeTask(
+	pid       string,
+	guid      string,
+	token     string,
+	manifest  []byte,
+	shape     []int32,
+	shapecube []int32,
+	params    *message.HorizonParams,
+) *message.Task {
+	task := h.BasicEndpoint.MakeTask(
+		pid,
+		guid,
+		token,
+		manifest,
+		shape,
+		shapecube,
+	)
+	task.Function = "horizon"
+	task.Params   = params
+	return task
+}
+
+/*
+ * The surface is the request body, with the surface given row-major on the
+ * grid dim0s x dim1s, one z per grid point, in the units of the last
+ * dimension. Points outside the cube, e.g. -999.25, are holes. The window is
+ * the number of samples to extract above and below the surface.
+ */
+type surface struct {
+	Dim0s  []int     `json:"dim0s"`
+	Dim1s  []int     `json:"dim1s"`
+	Values []float32 `json:"surface"`
+	Window int       `json:"window"`
+}
+
+func (s *surface) toHorizonParams() (*message.HorizonParams, error) {
+	if s.Window < 0 {
+		return nil, fmt.Errorf("window (= %d) < 0", s.Window)
+	}
+	if len(s.Values) != len(s.Dim0s) * len(s.Dim1s) {
+		return nil, fmt.Errorf(
+			"expected surface of %dx%d points, was %d",
+			len(s.Dim0s),
+			len(s.Dim1s),
+			len(s.Values),
+		)
+	}
+	return &message.HorizonParams{
+		Dim0s:   s.Dim0s,
+		Dim1s:   s.Dim1s,
+		Surface: s.Values,
+		Window:  s.Window,
+	}, nil
+}
+
+func (h *Horizon) Get(ctx *gin.Context) {
+	pid := ctx.GetString("pid")
+	guid := ctx.Param("guid")
+
+	format, err := parseFormat(ctx)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	attribute, window, err := parseAttribute(ctx)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	m, err := util.GetManifest(ctx, h.tokens, h.endpoint, guid)
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		return
+	}
+
+	surface := surface {}
+	err = ctx.ShouldBindJSON(&surface)
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	params, err := surface.toHorizonParams()
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	authorization := ctx.GetHeader("Authorization")
+	token, err := h.tokens.GetOnbehalf(authorization)
+	if err != nil {
+		// No further recovery is tried - GetManifest should already have fixed
+		// a broken token, so this should be readily cached. If it is
+		// just-about to expire then the process will fail pretty soon anyway,
+		// so just give up.
+		log.Printf("pid=%s, %v", pid, err)
+		auth.AbortContextFromToken(ctx, err)
+		return
+	}
+
+	manifest, err := m.Pack()
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		ctx.AbortWithStatus(http.StatusInternalServerError)
+		return
+	}
+
+	cubeshape := make([]int32, 0, len(m.Dimensions))
+	for i := 0; i < len(m.Dimensions); i++ {
+		cubeshape = append(cubeshape, int32(len(m.Dimensions[i])))
+	}
+	msg := h.MakeTask(
+		pid,
+		guid,
+		token,
+		manifest,
+		[]int32{ 64, 64, 64 },
+		cubeshape,
+		params,
+	)
+	msg.Format = format
+	msg.Attribute = attribute
+	msg.AttributeWindow = window
+
+	query, err := h.sched.MakeQuery(ctx, msg)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		qe, ok := err.(*QueryError)
+		if ok && qe.Status() != 0 {
+			ctx.AbortWithStatus(qe.Status())
+		} else {
+			ctx.AbortWithStatus(http.StatusInternalServerError)
+		}
+		return
+	}
+
+	/*
+	 * Identical queries share a process, so the result may be that of an
+	 * earlier request
+	 */
+	key, err := h.keyring.Sign(query.Pid())
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusInternalServerError)
+		return
+	}
+	go func() {
+		err := h.sched.Schedule(context.Background(), pid, query)
+		if err != nil {
+			/*
+			 * Make scheduling errors fatal to detect them for debugging.
+			 * Eventually this should log, maybe cancel the process, and
+			 * continue.
+			 */
+			log.Fatalf("pid=%s, %v", pid, err)
+		}
+	}()
+
+	ctx.JSON(http.StatusOK, gin.H {
+		"location": fmt.Sprintf("result/%s", query.Pid()),
+		"status":   fmt.Sprintf("result/%s/status", query.Pid()),
+		"authorization": key,
+	})
+}
@@ -0,0 +1,201 @@
+package api
+
+import (
+	"context"
+	"fmt"
+	"log"
+	"net/http"
+
+	"github.com/equinor/oneseismic/api/internal/auth"
+	"github.com/equinor/oneseismic/api/internal/message"
+	"github.com/equinor/oneseismic/api/internal/util"
+
+	"github.com/gin-gonic/gin"
+	"github.com/go-redis/redis/v8"
+)
+
+type Points struct {
+	BasicEndpoint
+}
+
+func MakePoints(
+	keyring  *auth.Keyring,
+	endpoint string,
+	storage  redis.Cmdable,
+	tokens   auth.Tokens,
+) *Points {
+	return &Points {
+		MakeBasicEndpoint(
+			keyring,
+			endpoint,
+			storage,
+			tokens,
+		),
+	}
+}
+
+func (p *Points) MakeTask(
+	pid       string,
+	guid      string,
+	token     string,
+	manifest  []byte,
+	shape     []int32,
+	shapecube []int32,
+	params    *message.PointsParams,
+) *message.Task {
+	task := p.BasicEndpoint.MakeTask(
+		pid,
+		guid,
+		token,
+		manifest,
+		shape,
+		shapecube,
+	)
+	task.Function = "points"
+	task.Params   = params
+	return task
+}
+
+/*
+ * The points are the request body, as three parallel lists of the
+ * coordinates of every point, either in grid coordinates (indices into the
+ * cube) or label coordinates (line numbers and sample labels). Points must
+ * be on the grid, and the samples are returned in the order of the request.
+ */
+type points struct {
+	Dim0s       []int  `json:"dim0s"`
+	Dim1s       []int  `json:"dim1s"`
+	Dim2s       []int  `json:"dim2s"`
+	Coordinates string `json:"coordinates"`
+}
+
+func (p *points) toPointsParams() (*message.PointsParams, error) {
+	coordinates := p.Coordinates
+	if coordinates == "" {
+		coordinates = "grid"
+	}
+	if coordinates != "label" && coordinates != "grid" {
+		return nil, fmt.Errorf("unknown coordinates %s", coordinates)
+	}
+	if len(p.Dim0s) != len(p.Dim1s) || len(p.Dim0s) != len(p.Dim2s) {
+		return nil, fmt.Errorf(
+			"expected dim0s, dim1s, dim2s of equal length, was %d, %d, %d",
+			len(p.Dim0s),
+			len(p.Dim1s),
+			len(p.Dim2s),
+		)
+	}
+	return &message.PointsParams{
+		Dim0s:       p.Dim0s,
+		Dim1s:       p.Dim1s,
+		Dim2s:       p.Dim2s,
+		Coordinates: coordinates,
+	}, nil
+}
+
+func (p *Points) Get(ctx *gin.Context) {
+	pid := ctx.GetString("pid")
+	guid := ctx.Param("guid")
+
+	format, err := parseFormat(ctx)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	m, err := util.GetManifest(ctx, p.tokens, p.endpoint, guid)
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		return
+	}
+
+	body := points {}
+	err = ctx.ShouldBindJSON(&body)
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	params, err := body.toPointsParams()
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	authorization := ctx.GetHeader("Authorization")
+	token, err := p.tokens.GetOnbehalf(authorization)
+	if err != nil {
+		// No further recovery is tried - GetManifest should already have fixed
+		// a broken token, so this should be readily cached. If it is
+		// just-about to expire then the process will fail pretty soon anyway,
+		// so just give up.
+		log.Printf("pid=%s, %v", pid, err)
+		auth.AbortContextFromToken(ctx, err)
+		return
+	}
+
+	manifest, err := m.Pack()
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		ctx.AbortWithStatus(http.StatusInternalServerError)
+		return
+	}
+
+	cubeshape := make([]int32, 0, len(m.Dimensions))
+	for i := 0; i < len(m.Dimensions); i++ {
+		cubeshape = append(cubeshape, int32(len(m.Dimensions[i])))
+	}
+	msg := p.MakeTask(
+		pid,
+		guid,
+		token,
+		manifest,
+		[]int32{ 64, 64, 64 },
+		cubeshape,
+		params,
+	)
+	msg.Format = format
+
+	query, err := p.sched.MakeQuery(ctx, msg)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		qe, ok := err.(*QueryError)
+		if ok && qe.Status() != 0 {
+			ctx.AbortWithStatus(qe.Status())
+		} else {
+			ctx.AbortWithStatus(http.StatusInternalServerError)
+		}
+		return
+	}
+
+	/*
+	 * Identical queries share a process, so the result may be that of an
+	 * earlier request
+	 */
+	key, err := p.keyring.Sign(query.Pid())
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusInternalServerError)
+		return
+	}
+	go func() {
+		err := p.sched.Schedule(context.Background(), pid, query)
+		if err != nil {
+			/*
+			 * Make scheduling errors fatal to detect them for debugging.
+			 * Eventually this should log, maybe cancel the process, and
+			 * continue.
+			 */
+			log.Fatalf("pid=%s, %v", pid, err)
+		}
+	}()
+
+	ctx.JSON(http.StatusOK, gin.H {
+		"location": fmt.Sprintf("result/%s", query.Pid()),
+		"status":   fmt.Sprintf("result/%s/status", query.Pid()),
+		"authorization": key,
+	})
+}
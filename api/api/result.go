@@ -47,10 +47,23 @@ func parseProcessHeader(doc []byte) (*message.ProcessHeader, error) {
 func resultFromProcessHeader(
 	head *message.ProcessHeader,
 ) *message.ResultHeader {
+	format := head.Format
+	if format == "" {
+		format = "f32"
+	}
+	decimation := head.Decimation
+	if decimation == 0 {
+		decimation = 1
+	}
 	return &message.ResultHeader {
-		Bundles: head.Ntasks,
-		Shape:   head.Shape,
-		Index:   head.Index,
+		Bundles:    head.Ntasks,
+		Shape:      head.Shape,
+		Index:      head.Index,
+		Format:     format,
+		Decimation: decimation,
+		Phases:     head.Phases,
+		Lineno:     head.Lineno,
+		FillValue:  head.FillValue,
 	}
 }
 
@@ -89,8 +102,11 @@ func collectResult(
 			return
 		}
 
-		for _, message := range reply[0].Messages {
-			for _, tile := range message.Values {
+		for _, xmsg := range reply[0].Messages {
+			for key, tile := range xmsg.Values {
+				if key == message.StatsKey {
+					continue
+				}
 				chunk, ok := tile.(string)
 				if !ok {
 					msg := fmt.Sprintf("tile.type = %T; expected []byte]", tile)
@@ -101,7 +117,7 @@ func collectResult(
 				tiles <- []byte(chunk)
 				count++
 			}
-			streamCursor = message.ID
+			streamCursor = xmsg.ID
 		}
 	}
 }
@@ -237,11 +253,23 @@ func (r *Result) Status(ctx *gin.Context) {
 		return
 	}
 
+	failed, err := r.Storage.Exists(ctx, message.FailedKey(pid)).Result()
+	if err != nil {
+		log.Printf("%s %v", pid, err)
+		ctx.AbortWithStatus(http.StatusInternalServerError)
+		return
+	}
+
 	done := count == int64(proc.Ntasks)
 	completed := fmt.Sprintf("%d/%d", count, proc.Ntasks)
 
-	// TODO: add (and detect) failed status
-	if done {
+	if failed > 0 {
+		ctx.JSON(http.StatusOK, gin.H {
+			"location": fmt.Sprintf("result/%s", pid),
+			"status": "failed",
+			"progress": completed,
+		})
+	} else if done {
 		ctx.JSON(http.StatusOK, gin.H {
 			"location": fmt.Sprintf("result/%s", pid),
 			"status": "finished",
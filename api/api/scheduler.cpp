@@ -4,7 +4,9 @@
 #include <memory>
 #include <numeric>
 
+#include <oneseismic/messages.hpp>
 #include <oneseismic/plan.hpp>
+#include <oneseismic/tracing.hpp>
 
 namespace {
 
@@ -15,13 +17,20 @@ char* copy(char* dst, const T& x) noexcept (true) {
     return dst + len;
 }
 
-}
-
-plan mkschedule(const char* doc, int len, int task_size) {
+/*
+ * Run the planner schedule(nheaders), and flatten its output into a plan.
+ * The planners put the headers last, but the plan has them first, so the last
+ * nheaders elements are moved to the front.
+ */
+template < typename Schedule >
+plan mkplan(const char* doc, int len, Schedule&& schedule) noexcept (true) {
     plan p {};
     std::vector< std::string > packed;
+    std::size_t heads = 1;
+    one::tracing::recorder spans;
     try {
-        packed = one::mkschedule(doc, len, task_size);
+        one::tracing::scope trace(&spans);
+        packed = schedule(heads);
     } catch (one::not_found& e) {
         p.status_code = 404;
         auto* err = new char[std::strlen(e.what()) + 1];
@@ -51,21 +60,66 @@ plan mkschedule(const char* doc, int len, int task_size) {
     p.len   = packed.size();
     char* dst = p.tasks;
 
-    p.sizes[0] = packed.back().size();
-    dst = copy(dst, packed.back());
-    for (std::size_t i = 0; i < packed.size() - 1; ++i) {
-        p.sizes[i + 1] = packed[i].size();
+    const auto first = packed.size() - heads;
+    for (std::size_t i = 0; i < heads; ++i) {
+        p.sizes[i] = packed[first + i].size();
+        dst = copy(dst, packed[first + i]);
+    }
+    for (std::size_t i = 0; i < first; ++i) {
+        p.sizes[heads + i] = packed[i].size();
         dst = copy(dst, packed[i]);
     }
 
+    if (!spans.events().empty()) try {
+        one::common_task task;
+        task.unpack(doc, doc + len);
+        const auto trace = spans.chrome_json(task.pid, "plan");
+        p.trace = new char[trace.size() + 1];
+        std::strcpy(p.trace, trace.c_str());
+    } catch (std::exception&) {
+        /* the plan is good even if the trace is not */
+    }
+
     return p;
 }
 
+}
+
+plan mkschedule(const char* doc, int len, int task_size) {
+    return mkplan(doc, len, [=](std::size_t&) {
+        return one::mkschedule(doc, len, task_size);
+    });
+}
+
+plan mkbatch(const char* doc, int len, int task_size) {
+    return mkplan(doc, len, [=](std::size_t& nheaders) {
+        one::batch_task batch;
+        batch.unpack(doc, doc + len);
+        nheaders = batch.tasks.size();
+        return one::mkbatch(doc, len, task_size);
+    });
+}
+
+queryhash mkqueryhash(const char* doc, int len) {
+    queryhash qh {};
+    try {
+        const auto hash = one::query_hash(doc, len);
+        if (hash.size() >= sizeof(qh.hash))
+            return qh;
+        std::strcpy(qh.hash, hash.c_str());
+        qh.ok = true;
+    } catch (std::exception&) {
+        qh = queryhash {};
+    }
+    return qh;
+}
+
 void cleanup(plan* p) {
     if (!p) return;
 
     delete p->err;
     delete p->sizes;
     delete p->tasks;
+    delete[] p->trace;
     *p = plan {};
 }
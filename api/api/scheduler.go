@@ -19,6 +19,7 @@ import "unsafe"
 import(
 	"context"
 	"fmt"
+	"log"
 	"time"
 
 	"github.com/go-redis/redis/v8"
@@ -29,11 +30,52 @@ import(
 type cppscheduler struct {
 	tasksize int
 	storage  redis.Cmdable
+	/*
+	 * Identical queries share the process of the first one for cachettl
+	 * after it is planned, both while it is running and after it is done, so
+	 * that its result is served from storage rather than re-computed. At most
+	 * cachesize processes are shared at the time, and the oldest are evicted
+	 * first. The cachettl must be shorter than the lifetime of the results.
+	 */
+	cachettl  time.Duration
+	cachesize int64
 }
 
 type Query struct {
+	/*
+	 * The pid of the process that computes the result of the query. If
+	 * shared is true, the process is an earlier identical query, which is
+	 * already scheduled, and the query should not be scheduled again.
+	 */
+	pid    string
+	shared bool
+	/*
+	 * The query hash claimed by the process, or the empty string if the
+	 * process is not shared. The hash is released if scheduling fails.
+	 */
+	hash   string
 	header []byte
 	plan   [][]byte
+	/*
+	 * The tracing spans of the planning, or nil if liboneseismic is built
+	 * without tracing.
+	 */
+	trace  []byte
+}
+
+/*
+ * A batch of queries, planned as one process. The headers are the process
+ * headers of the queries, in the same order as the pids.
+ */
+type BatchPlan struct {
+	pids    []string
+	headers [][]byte
+	plan    [][]byte
+	trace   []byte
+}
+
+func (q *Query) Pid() string {
+	return q.pid
 }
 
 type QueryError struct {
@@ -56,22 +98,173 @@ func (qe *QueryError) Status() int {
  * for now.
  */
 type scheduler interface {
-	MakeQuery(*message.Task) (*Query, error)
+	MakeQuery(context.Context, *message.Task) (*Query, error)
 	Schedule(context.Context, string, *Query) error
+	MakeBatch(*message.Task) (*BatchPlan, error)
+	ScheduleBatch(context.Context, string, *BatchPlan) error
 }
 
 func newScheduler(storage redis.Cmdable) scheduler {
 	return &cppscheduler{
-		storage:  storage,
-		tasksize: 10,
+		storage:   storage,
+		tasksize:  10,
+		cachettl:  5 * time.Minute,
+		cachesize: 1000,
+	}
+}
+
+/*
+ * Unpack the plan made by the C++ planner into its chunks (headers and
+ * tasks), and the planning trace.
+ */
+func unpackplan(csched *C.struct_plan) ([][]byte, []byte, error) {
+	if csched.err != nil {
+		return nil, nil, &QueryError {
+			msg: C.GoString(csched.err),
+			status: int(csched.status_code),
+		}
 	}
+
+	ntasks := int(csched.len)
+	result := make([][]byte, 0, ntasks)
+	sizes  := (*[1 << 30]C.int)(unsafe.Pointer(csched.sizes))[:ntasks:ntasks]
+
+	offset := uintptr(0)
+	for _, size := range sizes {
+		task := unsafe.Pointer(uintptr(unsafe.Pointer(csched.tasks)) + offset)
+		result = append(result, C.GoBytes(task, size))
+		offset += uintptr(size)
+	}
+
+	var trace []byte
+	if csched.trace != nil {
+		trace = []byte(C.GoString(csched.trace))
+	}
+	return result, trace, nil
 }
 
-func (sched *cppscheduler) MakeQuery(msg *message.Task) (*Query, error) {
+/*
+ * The canonical hash of the (packed) task, or the empty string if the task
+ * can not be hashed.
+ */
+func queryhash(task []byte) string {
+	qh := C.mkqueryhash(
+		(*C.char)(unsafe.Pointer(&task[0])),
+		C.int(len(task)),
+	)
+	if !qh.ok {
+		return ""
+	}
+	return C.GoString(&qh.hash[0])
+}
+
+func cachekey(hash string) string {
+	return fmt.Sprintf("query/%s", hash)
+}
+
+/*
+ * The index of the shared processes, as a sorted set of query hashes scored
+ * by the time they were added.
+ */
+const cacheindex = "query/index"
+
+/*
+ * Claim the query hash for the process pid. If an identical query already
+ * holds the hash, its pid is returned instead. The pid is empty if the
+ * cache is not available, in which case the query should just be computed
+ * as usual.
+ */
+func (sched *cppscheduler) claim(
+	ctx  context.Context,
+	hash string,
+	pid  string,
+) (string, error) {
+	key := cachekey(hash)
+	claimed, err := sched.storage.SetNX(ctx, key, pid, sched.cachettl).Result()
+	if err != nil {
+		return "", err
+	}
+	if !claimed {
+		/*
+		 * If the key expired between SetNX and Get the query is computed
+		 * again, without claiming the hash. This is rare and harmless.
+		 */
+		owner, err := sched.storage.Get(ctx, key).Result()
+		if err != nil {
+			return "", err
+		}
+		failed, err := sched.storage.Exists(ctx, message.FailedKey(owner)).Result()
+		if err != nil {
+			return "", err
+		}
+		if failed == 0 {
+			return owner, nil
+		}
+		/*
+		 * A failed process never finishes, so take over the hash rather than
+		 * sharing it
+		 */
+		err = sched.storage.Set(ctx, key, pid, sched.cachettl).Err()
+		if err != nil {
+			return "", err
+		}
+	}
+
+	now := time.Now()
+	sched.storage.ZAdd(ctx, cacheindex, &redis.Z {
+		Score:  float64(now.UnixNano()),
+		Member: hash,
+	})
+	expired := now.Add(-sched.cachettl).UnixNano()
+	sched.storage.ZRemRangeByScore(
+		ctx,
+		cacheindex,
+		"-inf",
+		fmt.Sprintf("%d", expired),
+	)
+
+	size, err := sched.storage.ZCard(ctx, cacheindex).Result()
+	if err != nil || size <= sched.cachesize {
+		return pid, nil
+	}
+	evicted, err := sched.storage.ZPopMin(
+		ctx,
+		cacheindex,
+		size - sched.cachesize,
+	).Result()
+	if err != nil {
+		return pid, nil
+	}
+	for _, z := range evicted {
+		sched.storage.Del(ctx, cachekey(z.Member.(string)))
+	}
+	return pid, nil
+}
+
+func (sched *cppscheduler) MakeQuery(
+	ctx context.Context,
+	msg *message.Task,
+) (*Query, error) {
 	task, err := msg.Pack()
 	if err != nil {
 		return nil, fmt.Errorf("pack error: %w", err)
 	}
+
+	/*
+	 * Identical queries share a process, so the first query claims the hash
+	 * and is planned, and the rest read the result of its process.
+	 */
+	hash := queryhash(task)
+	if hash != "" {
+		pid, err := sched.claim(ctx, hash, msg.Pid)
+		if err != nil {
+			log.Printf("pid=%s, query cache unavailable: %v", msg.Pid, err)
+			hash = ""
+		} else if pid != msg.Pid {
+			return &Query { pid: pid, shared: true }, nil
+		}
+	}
+
 	// TODO: exhaustive error check including those from C++ exceptions
 	csched := C.mkschedule(
 		(*C.char)(unsafe.Pointer(&task[0])),
@@ -79,47 +272,70 @@ func (sched *cppscheduler) MakeQuery(msg *message.Task) (*Query, error) {
 		C.int(sched.tasksize),
 	)
 	defer C.cleanup(&csched)
-	if csched.err != nil {
-		return nil, &QueryError {
-			msg: C.GoString(csched.err),
-			status: int(csched.status_code),
+	result, trace, err := unpackplan(&csched)
+	if err != nil {
+		/*
+		 * Identical queries would fail the same way, but the failure is not
+		 * cached, so release the hash
+		 */
+		if hash != "" {
+			sched.storage.Del(ctx, cachekey(hash))
 		}
-	}
-
-	ntasks := int(csched.len)
-	result := make([][]byte, 0, ntasks)
-	sizes  := (*[1 << 30]C.int)(unsafe.Pointer(csched.sizes))[:ntasks:ntasks]
-
-	this := uintptr(unsafe.Pointer(csched.tasks))
-	for _, size := range sizes {
-		result = append(result, C.GoBytes(unsafe.Pointer(this), size))
-		this += uintptr(size)
+		return nil, err
 	}
 
 	return &Query {
+		pid:    msg.Pid,
+		hash:   hash,
 		header: result[0],
 		plan:   result[1:],
+		trace:  trace,
 	}, nil
 }
 
-func (sched *cppscheduler) Schedule(
-	ctx  context.Context,
-	pid  string,
-	plan *Query,
-) error {
-	/*
-	 * TODO: This mixes I/O with parsing and building the plan. This could very
-	 * well be split up into sub structs and functions which can then be
-	 * dependency-injected for some customisation and easier testing.
-	 */
-	sched.storage.Set(
-		ctx,
-		fmt.Sprintf("%s/header.json", pid),
-		plan.header,
-		10 * time.Minute,
+func (sched *cppscheduler) MakeBatch(msg *message.Task) (*BatchPlan, error) {
+	params, ok := msg.Params.(*message.BatchParams)
+	if !ok {
+		return nil, fmt.Errorf("expected batch params, was %T", msg.Params)
+	}
+	task, err := msg.Pack()
+	if err != nil {
+		return nil, fmt.Errorf("pack error: %w", err)
+	}
+	csched := C.mkbatch(
+		(*C.char)(unsafe.Pointer(&task[0])),
+		C.int(len(task)),
+		C.int(sched.tasksize),
 	)
-	ntasks := len(plan.plan)
-	for i, task := range plan.plan {
+	defer C.cleanup(&csched)
+	result, trace, err := unpackplan(&csched)
+	if err != nil {
+		return nil, err
+	}
+
+	nqueries := len(params.Tasks)
+	pids := make([]string, nqueries)
+	for i, query := range params.Tasks {
+		pids[i] = query.Pid
+	}
+	return &BatchPlan {
+		pids:    pids,
+		headers: result[:nqueries],
+		plan:    result[nqueries:],
+		trace:   trace,
+	}, nil
+}
+
+/*
+ * Put the tasks of the process pid on the job queue
+ */
+func (sched *cppscheduler) enqueue(
+	ctx   context.Context,
+	pid   string,
+	tasks [][]byte,
+) error {
+	ntasks := len(tasks)
+	for i, task := range tasks {
 		if ctx.Err() != nil {
 			return ctx.Err()
 		}
@@ -139,3 +355,65 @@ func (sched *cppscheduler) Schedule(
 	}
 	return nil
 }
+
+func (sched *cppscheduler) Schedule(
+	ctx  context.Context,
+	pid  string,
+	plan *Query,
+) error {
+	if plan.shared {
+		return nil
+	}
+	/*
+	 * TODO: This mixes I/O with parsing and building the plan. This could very
+	 * well be split up into sub structs and functions which can then be
+	 * dependency-injected for some customisation and easier testing.
+	 */
+	sched.storage.Set(
+		ctx,
+		fmt.Sprintf("%s/header.json", pid),
+		plan.header,
+		10 * time.Minute,
+	)
+	if len(plan.trace) > 0 {
+		key := message.TraceKey(pid)
+		sched.storage.RPush(ctx, key, plan.trace)
+		sched.storage.Expire(ctx, key, 10 * time.Minute)
+	}
+	err := sched.enqueue(ctx, pid, plan.plan)
+	if err != nil && plan.hash != "" {
+		/*
+		 * Identical queries would read the result of a process that never
+		 * finishes, so release the hash
+		 */
+		sched.storage.Del(ctx, cachekey(plan.hash))
+	}
+	return err
+}
+
+/*
+ * Schedule a batch. The headers are written for the processes of the
+ * queries, so that their results can be read like any other process, while
+ * the tasks are scheduled as the process pid. The workers write the results
+ * to the processes of the queries.
+ */
+func (sched *cppscheduler) ScheduleBatch(
+	ctx   context.Context,
+	pid   string,
+	batch *BatchPlan,
+) error {
+	for i, query := range batch.pids {
+		sched.storage.Set(
+			ctx,
+			fmt.Sprintf("%s/header.json", query),
+			batch.headers[i],
+			10 * time.Minute,
+		)
+		if len(batch.trace) > 0 {
+			key := message.TraceKey(query)
+			sched.storage.RPush(ctx, key, batch.trace)
+			sched.storage.Expire(ctx, key, 10 * time.Minute)
+		}
+	}
+	return sched.enqueue(ctx, pid, batch.plan)
+}
@@ -1,6 +1,8 @@
 #ifndef ONESEISMIC_CGO_SLICE_H
 #define ONESEISMIC_CGO_SLICE_H
 
+#include <stdbool.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif //__cplusplus
@@ -48,9 +50,33 @@ struct plan {
      */
     int* sizes;
     char* tasks;
+
+    /*
+     * The tracing spans of the planning as a null-terminated Chrome trace
+     * JSON array, or a nullptr if no spans were recorded, which is always the
+     * case unless liboneseismic is built with ONESEISMIC_TRACING.
+     */
+    char* trace;
 };
 
 struct plan mkschedule(const char* doc, int len, int task_size);
+/*
+ * Plan a batch of queries (see batch_task in messages.hpp). The plan starts
+ * with the headers of all the queries, in the order of the queries in the
+ * batch, followed by the tasks of the batch.
+ */
+struct plan mkbatch(const char* doc, int len, int task_size);
+
+/*
+ * The canonical hash of a query (see one::query_hash), as a null-terminated
+ * hex string. Identical queries have the same hash. If the query can not be
+ * hashed, e.g. because it is malformed, ok is false and hash is empty.
+ */
+struct queryhash {
+    bool ok;
+    char hash[65];
+};
+struct queryhash mkqueryhash(const char* doc, int len);
 void cleanup(struct plan*);
 
 #ifdef __cplusplus
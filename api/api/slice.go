@@ -41,9 +41,15 @@ func MakeSlice(
 }
 
 type sliceParams struct {
-	guid      string
-	dimension int
-	lineno    int
+	guid        string
+	dimension   int
+	lineno      int
+	targetShape []int
+	progressive bool
+	zmin        *int
+	zmax        *int
+	roi         [][2]int
+	stride      []int
 }
 
 /*
@@ -68,10 +74,66 @@ func parseSliceParams(ctx *gin.Context) (*sliceParams, error) {
 		return nil, fmt.Errorf("error parsing lineno: %w", err)
 	}
 
+	targetShape, err := parseTargetShape(ctx)
+	if err != nil {
+		return nil, err
+	}
+
+	progressive := false
+	if prog := ctx.Query("progressive"); prog != "" {
+		progressive, err = strconv.ParseBool(prog)
+		if err != nil {
+			return nil, fmt.Errorf("error parsing progressive: %w", err)
+		}
+	}
+
+	zmin, zmax, err := parseZRange(ctx)
+	if err != nil {
+		return nil, err
+	}
+
+	/*
+	 * The region of interest is the labels first0,last0,first1,last1 of the
+	 * two dimensions of the slice, and the stride is stride0,stride1.
+	 */
+	rois, err := parseIntList(ctx, "roi")
+	if err != nil {
+		return nil, err
+	}
+	if rois != nil && len(rois) != 4 {
+		return nil, fmt.Errorf("expected roi of 4 elements, was %d", len(rois))
+	}
+	var roi [][2]int
+	for i := 0; i < len(rois); i += 2 {
+		if rois[i] > rois[i + 1] {
+			return nil, fmt.Errorf("roi (= %v) first > last", rois)
+		}
+		roi = append(roi, [2]int{ rois[i], rois[i + 1] })
+	}
+
+	stride, err := parseIntList(ctx, "stride")
+	if err != nil {
+		return nil, err
+	}
+	if stride != nil && len(stride) != 2 {
+		return nil, fmt.Errorf("expected stride of 2 elements, was %d", len(stride))
+	}
+	for _, x := range stride {
+		if x < 1 {
+			return nil, fmt.Errorf("stride (= %v) < 1", stride)
+		}
+	}
+
 	return &sliceParams {
 		guid: guid,
 		dimension: dimension,
 		lineno: lineno,
+		targetShape: targetShape,
+		progressive: progressive,
+		zmin: zmin,
+		zmax: zmax,
+		roi: roi,
+		stride: stride,
 	}, nil
 }
 
@@ -98,8 +160,14 @@ func (s *Slice) MakeTask(
 	)
 	task.Function = "slice"
 	task.Params   = &message.SliceParams {
-		Dim:    params.dimension,
-		Lineno: params.lineno,
+		Dim:         params.dimension,
+		Lineno:      params.lineno,
+		TargetShape: params.targetShape,
+		Progressive: params.progressive,
+		Zmin:        params.zmin,
+		Zmax:        params.zmax,
+		Roi:         params.roi,
+		Stride:      params.stride,
 	}
 	return task
 }
@@ -150,6 +218,20 @@ func (s *Slice) Get(ctx *gin.Context) {
 		return
 	}
 
+	format, err := parseFormat(ctx)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	attribute, window, err := parseAttribute(ctx)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
 	m, err := util.GetManifest(ctx, s.tokens, s.endpoint, params.guid)
 	if err != nil {
 		log.Printf("%s %v", pid, err)
@@ -197,15 +279,11 @@ func (s *Slice) Get(ctx *gin.Context) {
 		cubeshape,
 		params,
 	)
+	msg.Format = format
+	msg.Attribute = attribute
+	msg.AttributeWindow = window
 
-	key, err := s.keyring.Sign(pid)
-	if err != nil {
-		log.Printf("pid=%s, %v", pid, err)
-		ctx.AbortWithStatus(http.StatusInternalServerError)
-		return
-	}
-
-	query, err := s.sched.MakeQuery(msg)
+	query, err := s.sched.MakeQuery(ctx, msg)
 	if err != nil {
 		log.Printf("pid=%s, %v", pid, err)
 		qe := err.(*QueryError)
@@ -217,6 +295,17 @@ func (s *Slice) Get(ctx *gin.Context) {
 		return
 	}
 
+	/*
+	 * Identical queries share a process, so the result may be that of an
+	 * earlier request
+	 */
+	key, err := s.keyring.Sign(query.Pid())
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusInternalServerError)
+		return
+	}
+
 	go func () {
 		err := s.sched.Schedule(context.Background(), pid, query)
 		if err != nil {
@@ -229,8 +318,8 @@ func (s *Slice) Get(ctx *gin.Context) {
 		}
 	}()
 	ctx.JSON(http.StatusOK, gin.H {
-		"location": fmt.Sprintf("result/%s", pid),
-		"status":   fmt.Sprintf("result/%s/status", pid),
+		"location": fmt.Sprintf("result/%s", query.Pid()),
+		"status":   fmt.Sprintf("result/%s/status", query.Pid()),
 		"authorization": key,
 	})
 }
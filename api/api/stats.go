@@ -0,0 +1,189 @@
+package api
+
+import (
+	"context"
+	"fmt"
+	"log"
+	"net/http"
+	"strconv"
+
+	"github.com/equinor/oneseismic/api/internal/auth"
+	"github.com/equinor/oneseismic/api/internal/message"
+	"github.com/equinor/oneseismic/api/internal/util"
+
+	"github.com/gin-gonic/gin"
+	"github.com/go-redis/redis/v8"
+)
+
+type Stats struct {
+	BasicEndpoint
+}
+
+func MakeStats(
+	keyring  *auth.Keyring,
+	endpoint string,
+	storage  redis.Cmdable,
+	tokens   auth.Tokens,
+) *Stats {
+	return &Stats {
+		MakeBasicEndpoint(
+			keyring,
+			endpoint,
+			storage,
+			tokens,
+		),
+	}
+}
+
+func (s *Stats) MakeTask(
+	pid       string,
+	guid      string,
+	token     string,
+	manifest  []byte,
+	shape     []int32,
+	shapecube []int32,
+	params    *message.StatsParams,
+) *message.Task {
+	task := s.BasicEndpoint.MakeTask(
+		pid,
+		guid,
+		token,
+		manifest,
+		shape,
+		shapecube,
+	)
+	task.Function = "stats"
+	task.Params   = params
+	return task
+}
+
+/*
+ * Parse the optional dim, lineno and bins query parameters. Without dim the
+ * stats are of the whole cube, and with dim the lineno is required.
+ */
+func parseStatsParams(ctx *gin.Context) (*message.StatsParams, error) {
+	bins, err := strconv.Atoi(ctx.DefaultQuery("bins", "64"))
+	if err != nil {
+		return nil, fmt.Errorf("error parsing bins: %w", err)
+	}
+	if bins < 1 {
+		return nil, fmt.Errorf("bins (= %d) < 1", bins)
+	}
+	params := &message.StatsParams { Bins: bins }
+
+	dim := ctx.Query("dim")
+	if dim == "" {
+		return params, nil
+	}
+	d, err := strconv.Atoi(dim)
+	if err != nil {
+		return nil, fmt.Errorf("error parsing dim: %w", err)
+	}
+	if d < 0 {
+		return nil, fmt.Errorf("dim (= %d) < 0", d)
+	}
+	lineno, err := strconv.Atoi(ctx.Query("lineno"))
+	if err != nil {
+		return nil, fmt.Errorf("error parsing lineno: %w", err)
+	}
+	params.Dim    = &d
+	params.Lineno = lineno
+	return params, nil
+}
+
+/*
+ * The stats (count, min, max, mean, rms and histogram) of the cube, or of a
+ * line, for histograms and colour scales. The stats are read from the
+ * fragment stats written by the upload, without reading any samples, so a
+ * line is summarised by the fragments it is in.
+ */
+func (s *Stats) Get(ctx *gin.Context) {
+	pid := ctx.GetString("pid")
+	guid := ctx.Param("guid")
+
+	params, err := parseStatsParams(ctx)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusBadRequest)
+		return
+	}
+
+	m, err := util.GetManifest(ctx, s.tokens, s.endpoint, guid)
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		return
+	}
+
+	authorization := ctx.GetHeader("Authorization")
+	token, err := s.tokens.GetOnbehalf(authorization)
+	if err != nil {
+		// No further recovery is tried - GetManifest should already have fixed
+		// a broken token, so this should be readily cached. If it is
+		// just-about to expire then the process will fail pretty soon anyway,
+		// so just give up.
+		log.Printf("pid=%s, %v", pid, err)
+		auth.AbortContextFromToken(ctx, err)
+		return
+	}
+
+	manifest, err := m.Pack()
+	if err != nil {
+		log.Printf("pid=%s %v", pid, err)
+		ctx.AbortWithStatus(http.StatusInternalServerError)
+		return
+	}
+
+	cubeshape := make([]int32, 0, len(m.Dimensions))
+	for i := 0; i < len(m.Dimensions); i++ {
+		cubeshape = append(cubeshape, int32(len(m.Dimensions[i])))
+	}
+	msg := s.MakeTask(
+		pid,
+		guid,
+		token,
+		manifest,
+		[]int32{ 64, 64, 64 },
+		cubeshape,
+		params,
+	)
+
+	query, err := s.sched.MakeQuery(ctx, msg)
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		qe, ok := err.(*QueryError)
+		if ok && qe.Status() != 0 {
+			ctx.AbortWithStatus(qe.Status())
+		} else {
+			ctx.AbortWithStatus(http.StatusInternalServerError)
+		}
+		return
+	}
+
+	/*
+	 * Identical queries share a process, so the result may be that of an
+	 * earlier request
+	 */
+	key, err := s.keyring.Sign(query.Pid())
+	if err != nil {
+		log.Printf("pid=%s, %v", pid, err)
+		ctx.AbortWithStatus(http.StatusInternalServerError)
+		return
+	}
+	go func() {
+		err := s.sched.Schedule(context.Background(), pid, query)
+		if err != nil {
+			/*
+			 * Make scheduling errors fatal to detect them for debugging.
+			 * Eventually this should log, maybe cancel the process, and
+			 * continue.
+			 */
+			log.Fatalf("pid=%s, %v", pid, err)
+		}
+	}()
+
+	ctx.JSON(http.StatusOK, gin.H {
+		"location": fmt.Sprintf("result/%s", query.Pid()),
+		"status":   fmt.Sprintf("result/%s/status", query.Pid()),
+		"authorization": key,
+	})
+}
@@ -8,6 +8,7 @@ import "unsafe"
 
 import (
 	"context"
+	"encoding/json"
 	"fmt"
 	"io/ioutil"
 	"log"
@@ -164,6 +165,13 @@ func (p *process) fragments() []string {
 	 * (!!) at the end, which in turn would build invalid URLs.
 	 */
 	gofrags := C.GoString(cfrags)
+	/*
+	 * Tasks of only absent fragments have no fragments at all, and splitting
+	 * the empty string would give a single, empty ID.
+	 */
+	if gofrags == "" {
+		return nil
+	}
 	return strings.Split(gofrags, ";")
 }
 
@@ -222,6 +230,30 @@ func (p *process) pack() []byte {
 	return C.GoBytes(packed.body, packed.size)
 }
 
+/*
+ * The tracing spans of the process as a Chrome trace JSON array, or nil if
+ * there are no spans, which is the case unless liboneseismic is built with
+ * tracing. Like pack(), this should be called when all fragments have been
+ * given to add().
+ */
+func (p *process) trace() []byte {
+	pid  := C.CString(p.pid)
+	part := C.CString(p.part)
+	defer C.free(unsafe.Pointer(pid))
+	defer C.free(unsafe.Pointer(part))
+
+	trace := C.tracejson(p.cpp, pid, part)
+	if trace.err {
+		log.Printf("%s unable to export trace: %v", p.logpid(), p.c_error())
+		return nil
+	}
+	if trace.size <= 2 {
+		// Empty array, []
+		return nil
+	}
+	return C.GoBytes(trace.body, trace.size)
+}
+
 /*
  * Make a container URL. This is just a stupid helper to make calling prettier,
  * and it is somewhat inflexible by reading endpoint + guid from the input
@@ -249,7 +281,8 @@ func (p *process) container() (azblob.ContainerURL, error) {
  * channel, or until n fragments have been read from the fragments channel. In
  * real programs this should usually be called as a goroutine, although it
  * doesn't have to without introducing deadlocks if the channels are
- * sufficiently buffered.
+ * sufficiently buffered. Tasks without fragments (n = 0) are packed and
+ * written immediately.
  *
  * This function finalizes the process.
  */
@@ -269,6 +302,7 @@ func (p *process) gather(
 			}
 		case e := <-errors:
 			log.Printf("%s download failed: %v", p.logpid(), e)
+			p.fail(storage)
 			for {
 				// Grab the remaining available errors to log them, but don't
 				// wait around for any new ones to come in
@@ -283,17 +317,137 @@ func (p *process) gather(
 	}
 
 	packed := p.pack()
-	log.Printf("%s ready", p.logpid())
+	stats  := p.stats()
+	stages.record(stats)
+	log.Printf(
+		"%s ready init_ms=%.3f add_ms=%.3f add_max_ms=%.3f adds=%d " +
+		"pack_ms=%.3f bytes_in=%d bytes_out=%d allocations=%d",
+		p.logpid(),
+		stats.InitMs,
+		stats.AddMs,
+		stats.AddMaxMs,
+		stats.Adds,
+		stats.PackMs,
+		stats.BytesIn,
+		stats.BytesOut,
+		stats.Allocations,
+	)
+
+	packedstats, err := stats.Pack()
+	if err != nil {
+		log.Printf("%s unable to pack stats: %v", p.logpid(), err)
+		packedstats = nil
+	}
+	if trace := p.trace(); len(trace) > 0 {
+		key := message.TraceKey(p.pid)
+		storage.RPush(p.ctx, key, trace)
+		storage.Expire(p.ctx, key, 10 * time.Minute)
+	}
+
+	/*
+	 * The result of a batch task is the results of all the queries in the
+	 * task, which are written to the processes of the queries.
+	 */
+	if p.task.Function == "batch" {
+		results, err := (&message.BatchResults{}).Unpack(packed)
+		if err != nil {
+			log.Fatalf("%s unable to unpack batch results: %v", p.logpid(), err)
+		}
+		for _, result := range results.Results {
+			p.write(storage, result.Pid, result.Part, result.Body, packedstats)
+		}
+	} else {
+		p.write(storage, p.pid, p.part, packed, packedstats)
+	}
+	log.Printf("%s written to storage", p.logpid())
+
+	if prefetching != nil {
+		ids := p.prefetch(prefetching)
+		if len(ids) == 0 {
+			return
+		}
+		container, err := p.container()
+		if err != nil {
+			log.Printf("%s unable to prefetch: %v", p.logpid(), err)
+			return
+		}
+		prefetching.schedule(p.logpid(), container, ids)
+	}
+}
+
+/*
+ * The pids of the queries of a batch task. Clients poll the queries of a
+ * batch by their own pids, not by the pid of the batch.
+ */
+func (p *process) batchpids() []string {
+	var batch struct {
+		Queries []struct {
+			Pid string `json:"pid"`
+		} `json:"queries"`
+	}
+	err := json.Unmarshal(p.rawtask, &batch)
+	if err != nil {
+		log.Printf("%s unable to parse batch queries: %v", p.logpid(), err)
+		return nil
+	}
+
+	pids := make([]string, 0, len(batch.Queries))
+	for _, query := range batch.Queries {
+		pids = append(pids, query.Pid)
+	}
+	return pids
+}
+
+/*
+ * Mark the process as failed. The process never finishes when one of its
+ * tasks is dropped, so identical queries should not share it, and its status
+ * should say so. A failed batch task fails all the queries in it.
+ */
+func (p *process) fail(storage redis.Cmdable) {
+	pids := []string{ p.pid }
+	if p.task.Function == "batch" {
+		pids = append(pids, p.batchpids()...)
+	}
+
+	for _, pid := range pids {
+		key := message.FailedKey(pid)
+		err := storage.Set(p.ctx, key, p.part, 10 * time.Minute).Err()
+		if err != nil {
+			log.Printf("%s unable to mark %s as failed: %v", p.logpid(), pid, err)
+		}
+	}
+}
+
+/*
+ * Write the result as part of the process pid, with the stats of the task if
+ * they are not nil.
+ */
+func (p *process) write(
+	storage redis.Cmdable,
+	pid     string,
+	part    string,
+	result  []byte,
+	stats   []byte,
+) {
+	values := map[string]interface{}{part: result}
+	if stats != nil {
+		values[message.StatsKey] = stats
+	}
 	args := redis.XAddArgs{
-		Stream: p.pid,
-		Values: map[string]interface{}{p.part: packed},
+		Stream: pid,
+		Values: values,
 	}
 	err := storage.XAdd(p.ctx, &args).Err()
 	if err != nil {
-		log.Printf("%s write to storage failed: %v", p.logpid(), err)
+		log.Printf(
+			"%s write of pid=%s, part=%s to storage failed: %v",
+			p.logpid(),
+			pid,
+			part,
+			err,
+		)
 	}
-	storage.Expire(p.ctx, p.pid, 10 * time.Minute)
-	log.Printf("%s written to storage", p.logpid())
+	storage.Expire(p.ctx, pid, 10 * time.Minute)
 }
 
 /*
@@ -329,7 +483,7 @@ func fetch(
 	errors    chan error,
 ) {
 	for task := range tasks {
-		chunk, err := fetchblob(ctx, task.blob)
+		chunk, err := cache.fetch(ctx, task.blob)
 		if err != nil {
 			errors <- err
 			return
@@ -1,10 +1,16 @@
 package main
 
+// #include <stdlib.h>
+// #include "tasks.h"
+import "C"
+import "unsafe"
+
 import (
 	"context"
 	"fmt"
 	"log"
 	"os"
+	"time"
 
 	"github.com/equinor/oneseismic/api/internal/util"
 
@@ -19,6 +25,10 @@ type opts struct {
 	stream     string
 	consumerid string
 	jobs       int
+	statsint   int
+	heatmap    string
+	cachesize  int
+	prefetch   int
 }
 
 func parseopts() opts {
@@ -69,6 +79,40 @@ func parseopts() opts {
 		"Allow N concurrent connections at once. Defaults to 10",
 		"N",
 	)
+	getopt.FlagLong(
+		&opts.heatmap,
+		"heatmap",
+		0,
+		"Record fragment accesses to a heatmap file, " +
+		    "which is rewritten every minute. " +
+		    "Summarise with oneseismic-heatmap.",
+		"file",
+	)
+	cachesize := getopt.IntLong(
+		"fragment-cache",
+		0,
+		0,
+		"Cache up to N MB of downloaded fragments in memory, " +
+		    "0 to disable. Defaults to 0",
+		"N",
+	)
+	prefetch := getopt.IntLong(
+		"prefetch",
+		0,
+		0,
+		"Speculatively prefetch the neighbouring fragments of slices " +
+		    "into the fragment cache, with at most N concurrent downloads, " +
+		    "0 to disable. Requires --fragment-cache. Defaults to 0",
+		"N",
+	)
+	statsint := getopt.IntLong(
+		"stats-interval",
+		0,
+		60,
+		"Log histograms of task stage timings every N seconds, " +
+		    "0 to disable. Defaults to 60",
+		"N",
+	)
 	getopt.Parse()
 
 	if *help {
@@ -80,6 +124,12 @@ func parseopts() opts {
 		opts.consumerid = fmt.Sprintf("consumer:%s", util.MakePID())
 	}
 	opts.jobs = *jobs
+	opts.statsint = *statsint
+	opts.cachesize = *cachesize
+	opts.prefetch = *prefetch
+	if opts.prefetch > 0 && opts.cachesize == 0 {
+		log.Fatalf("--prefetch requires --fragment-cache")
+	}
 	return opts
 }
 
@@ -120,6 +170,7 @@ func run(
 	container, err := proc.container()
 	if err != nil {
 		log.Printf("%s dropping bad process %v", proc.logpid(), err)
+		proc.fail(storage)
 		return
 	}
 
@@ -196,6 +247,23 @@ func main() {
 		opts.stream,
 	)
 
+	if opts.heatmap != "" {
+		path := C.CString(opts.heatmap)
+		defer C.free(unsafe.Pointer(path))
+		C.heatmap(path, 60)
+	}
+
+	if opts.cachesize > 0 {
+		cache = newfragmentcache(int64(opts.cachesize) * 1024 * 1024)
+	}
+	if opts.prefetch > 0 {
+		prefetching = newprefetcher(opts.prefetch)
+	}
+
+	if opts.statsint > 0 {
+		go reportstats(time.Duration(opts.statsint) * time.Second)
+	}
+
 	// TODO: destroy consumers on shutdown
 	// All reads can re-use the same group-args
 	// NoAck is turned on - we can afford to fail requests and lose messages
@@ -0,0 +1,275 @@
+package main
+
+// #include <stdlib.h>
+// #include "tasks.h"
+import "C"
+
+import (
+	"container/list"
+	"context"
+	"encoding/json"
+	"fmt"
+	"log"
+	"strings"
+	"sync"
+	"time"
+
+	"github.com/Azure/azure-storage-blob-go/azblob"
+)
+
+/*
+ * A worker-local least-recently-used cache of downloaded fragments, bounded
+ * by the total size of the fragments. Fragments are immutable once uploaded,
+ * so entries never go stale and are only ever evicted to make room.
+ *
+ * The cache is keyed by the blob URL, which identifies the storage account,
+ * cube, and fragment, but carries no credentials. A fragment is only served
+ * from the cache to a process that has already been authorized for the cube
+ * by the query server, so sharing entries between users is ok.
+ */
+type fragmentcache struct {
+	mutex    sync.Mutex
+	capacity int64
+	size     int64
+	lru      *list.List
+	entries  map[string]*list.Element
+}
+
+type cacheentry struct {
+	key   string
+	chunk []byte
+}
+
+func newfragmentcache(capacity int64) *fragmentcache {
+	return &fragmentcache {
+		capacity: capacity,
+		lru:      list.New(),
+		entries:  make(map[string]*list.Element),
+	}
+}
+
+func (c *fragmentcache) get(key string) ([]byte, bool) {
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+	e, ok := c.entries[key]
+	if !ok {
+		return nil, false
+	}
+	c.lru.MoveToFront(e)
+	return e.Value.(*cacheentry).chunk, true
+}
+
+func (c *fragmentcache) contains(key string) bool {
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+	_, ok := c.entries[key]
+	return ok
+}
+
+func (c *fragmentcache) put(key string, chunk []byte) {
+	size := int64(len(chunk))
+	if size > c.capacity {
+		return
+	}
+
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+	if e, ok := c.entries[key]; ok {
+		c.lru.MoveToFront(e)
+		return
+	}
+	for c.size + size > c.capacity {
+		oldest := c.lru.Back()
+		entry := c.lru.Remove(oldest).(*cacheentry)
+		delete(c.entries, entry.key)
+		c.size -= int64(len(entry.chunk))
+	}
+	c.entries[key] = c.lru.PushFront(&cacheentry { key: key, chunk: chunk })
+	c.size += size
+}
+
+/*
+ * Fetch the blob through the cache. The cache is optional, and a nil cache
+ * always downloads the blob.
+ */
+func (c *fragmentcache) fetch(
+	ctx  context.Context,
+	blob azblob.BlobURL,
+) ([]byte, error) {
+	if c == nil {
+		return fetchblob(ctx, blob)
+	}
+
+	key := blob.String()
+	if chunk, ok := c.get(key); ok {
+		return chunk, nil
+	}
+	chunk, err := fetchblob(ctx, blob)
+	if err != nil {
+		return nil, err
+	}
+	c.put(key, chunk)
+	return chunk, nil
+}
+
+/*
+ * The fragment cache of this worker, or nil if fragments are not cached.
+ */
+var cache *fragmentcache
+
+/*
+ * The prefetcher speculatively downloads the fragments the next query is
+ * likely to read into the fragment cache when a process is done, e.g. the
+ * neighbouring fragment layer when an interpreter scrolls through inlines,
+ * so that the next step is a cache hit.
+ *
+ * The scroll direction is inferred from the previous line of the same cube
+ * and dimension seen by this worker, and both directions are prefetched when
+ * it is unknown.
+ *
+ * Prefetching is rate limited to at most jobs concurrent downloads, and
+ * prefetches beyond that are dropped rather than queued, so that speculation
+ * never competes with (or delays) real work for long. The downloads outlive
+ * the process and are given timeout to complete.
+ */
+type prefetcher struct {
+	slots   chan struct{}
+	timeout time.Duration
+
+	mutex sync.Mutex
+	lines map[string]scroll
+}
+
+/*
+ * The latest line of a cube and dimension, and the direction it was reached
+ * in. The tasks of a process all have the same line, so the direction is only
+ * updated when the line changes.
+ */
+type scroll struct {
+	lineno    int
+	direction int
+}
+
+/*
+ * The number of cubes and dimensions to track the scroll direction of. The
+ * tracking is simply reset when it is full.
+ */
+const maxscrolls = 10000
+
+func newprefetcher(jobs int) *prefetcher {
+	return &prefetcher {
+		slots:   make(chan struct{}, jobs),
+		timeout: 30 * time.Second,
+		lines:   make(map[string]scroll),
+	}
+}
+
+/*
+ * The prefetcher of this worker, or nil if prefetching is disabled.
+ * Prefetching requires the fragment cache.
+ */
+var prefetching *prefetcher
+
+/*
+ * The scroll direction of the line, +1 or -1, or 0 if unknown, and record
+ * the line as the latest for the key.
+ */
+func (pf *prefetcher) direction(key string, lineno int) int {
+	pf.mutex.Lock()
+	defer pf.mutex.Unlock()
+	prev, ok := pf.lines[key]
+	if !ok && len(pf.lines) >= maxscrolls {
+		pf.lines = make(map[string]scroll)
+	}
+
+	next := scroll { lineno: lineno, direction: prev.direction }
+	switch {
+	case !ok:
+		next.direction = 0
+	case prev.lineno < lineno:
+		next.direction = 1
+	case prev.lineno > lineno:
+		next.direction = -1
+	}
+	pf.lines[key] = next
+	return next.direction
+}
+
+/*
+ * Download the blobs into the cache in the background, skipping the blobs
+ * already in the cache, and dropping the blobs when all slots are taken.
+ */
+func (pf *prefetcher) schedule(
+	logpid    string,
+	container azblob.ContainerURL,
+	ids       []string,
+) {
+	dropped := 0
+	for _, id := range ids {
+		blob := container.NewBlobURL(id)
+		if cache.contains(blob.String()) {
+			continue
+		}
+
+		select {
+		case pf.slots <- struct{}{}:
+		default:
+			dropped++
+			continue
+		}
+		go func() {
+			defer func() { <-pf.slots }()
+			ctx, cancel := context.WithTimeout(context.Background(), pf.timeout)
+			defer cancel()
+			_, err := cache.fetch(ctx, blob)
+			if err != nil {
+				log.Printf("%s prefetch failed: %v", logpid, err)
+			}
+		}()
+	}
+	if dropped > 0 {
+		log.Printf("%s prefetch dropped %d fragments", logpid, dropped)
+	}
+}
+
+/*
+ * The fragment IDs to prefetch after this process, see tasks.h. This is only
+ * implemented for slices, and must be called before cleanup().
+ */
+func (p *process) prefetch(pf *prefetcher) []string {
+	if p.task.Function != "slice" {
+		return nil
+	}
+
+	var slice struct {
+		Params struct {
+			Dim         int  `json:"dim"`
+			Lineno      int  `json:"lineno"`
+			Progressive bool `json:"progressive"`
+		} `json:"params"`
+		Decimation int `json:"decimation"`
+	}
+	err := json.Unmarshal(p.rawtask, &slice)
+	if err != nil || slice.Params.Progressive {
+		return nil
+	}
+	key := fmt.Sprintf(
+		"%s/%s/%d/%d",
+		p.task.StorageEndpoint,
+		p.task.Guid,
+		slice.Decimation,
+		slice.Params.Dim,
+	)
+	direction := pf.direction(key, slice.Params.Lineno)
+
+	cids := C.prefetch(p.cpp, C.int(direction))
+	if cids == nil {
+		log.Printf("%s unable to get prefetch IDs: %v", p.logpid(), p.c_error())
+		return nil
+	}
+	ids := C.GoString(cids)
+	if ids == "" {
+		return nil
+	}
+	return strings.Split(ids, ";")
+}
@@ -0,0 +1,150 @@
+package main
+
+// #include "tasks.h"
+import "C"
+
+import (
+	"fmt"
+	"log"
+	"strings"
+	"sync"
+	"time"
+
+	"github.com/equinor/oneseismic/api/internal/message"
+)
+
+/*
+ * Read the stats of the task from C++. This should be called after pack(),
+ * when all stages of the task have been recorded.
+ */
+func (p *process) stats() message.TaskStats {
+	cs := C.stats(p.cpp)
+	return message.TaskStats {
+		Part:        p.part,
+		InitMs:      float64(cs.init_ms),
+		AddMs:       float64(cs.add_ms),
+		AddMaxMs:    float64(cs.add_max_ms),
+		Adds:        int(cs.adds),
+		PackMs:      float64(cs.pack_ms),
+		BytesIn:     uint64(cs.bytes_in),
+		BytesOut:    uint64(cs.bytes_out),
+		Allocations: uint64(cs.allocations),
+	}
+}
+
+/*
+ * The upper bounds (in milliseconds) of the histogram buckets. They double in
+ * size, from well below the time of a single add() to well above the time of
+ * a whole task, and everything slower ends up in the last (overflow) bucket.
+ */
+var bucketbounds = []float64 {
+	0.125, 0.25, 0.5, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096,
+}
+
+type histogram struct {
+	counts []uint64
+	sum    float64
+}
+
+func newhistogram() *histogram {
+	return &histogram { counts: make([]uint64, len(bucketbounds) + 1) }
+}
+
+func (h *histogram) observe(ms float64) {
+	i := 0
+	for i < len(bucketbounds) && ms > bucketbounds[i] {
+		i++
+	}
+	h.counts[i]++
+	h.sum += ms
+}
+
+/*
+ * Format the histogram as a single log-friendly line, e.g.
+ * n=12 mean=1.20 le0.5=3 le1=4 le2=5, leaving out empty buckets.
+ */
+func (h *histogram) String() string {
+	n := uint64(0)
+	for _, c := range h.counts {
+		n += c
+	}
+	if n == 0 {
+		return "n=0"
+	}
+
+	var b strings.Builder
+	fmt.Fprintf(&b, "n=%d mean=%.2f", n, h.sum / float64(n))
+	for i, c := range h.counts {
+		if c == 0 {
+			continue
+		}
+		if i < len(bucketbounds) {
+			fmt.Fprintf(&b, " le%g=%d", bucketbounds[i], c)
+		} else {
+			fmt.Fprintf(&b, " inf=%d", c)
+		}
+	}
+	return b.String()
+}
+
+/*
+ * Per-stage histograms of all tasks processed by this worker since the last
+ * report. Tasks are gathered concurrently, so the histograms are guarded by a
+ * mutex; recording is cheap compared to a task, and contention is low.
+ */
+type stagestats struct {
+	sync.Mutex
+	init   *histogram
+	add    *histogram
+	addmax *histogram
+	pack   *histogram
+}
+
+var stages = newstagestats()
+
+func newstagestats() *stagestats {
+	return &stagestats {
+		init:   newhistogram(),
+		add:    newhistogram(),
+		addmax: newhistogram(),
+		pack:   newhistogram(),
+	}
+}
+
+func (s *stagestats) record(st message.TaskStats) {
+	s.Lock()
+	defer s.Unlock()
+	s.init.observe(st.InitMs)
+	s.add.observe(st.AddMs)
+	s.addmax.observe(st.AddMaxMs)
+	s.pack.observe(st.PackMs)
+}
+
+/*
+ * Log the histograms and reset them, so every report covers the tasks since
+ * the previous one.
+ */
+func (s *stagestats) report() {
+	s.Lock()
+	inits, adds, addmaxs, packs := s.init, s.add, s.addmax, s.pack
+	s.init   = newhistogram()
+	s.add    = newhistogram()
+	s.addmax = newhistogram()
+	s.pack   = newhistogram()
+	s.Unlock()
+
+	log.Printf("stats stage=init %v", inits)
+	log.Printf("stats stage=add %v", adds)
+	log.Printf("stats stage=addmax %v", addmaxs)
+	log.Printf("stats stage=pack %v", packs)
+}
+
+/*
+ * Report the stage histograms every interval. This never returns, and should
+ * be run as a goroutine.
+ */
+func reportstats(interval time.Duration) {
+	for range time.Tick(interval) {
+		stages.report()
+	}
+}
@@ -1,7 +1,9 @@
+#include <chrono>
 #include <memory>
 #include <string>
 
 #include <oneseismic/geometry.hpp>
+#include <oneseismic/heatmap.hpp>
 #include <oneseismic/messages.hpp>
 #include <oneseismic/process.hpp>
 
@@ -11,6 +13,8 @@ struct proc {
     std::unique_ptr< one::proc > p;
     std::string errmsg;
     std::string packed;
+    std::string trace;
+    std::string prefetch;
 };
 
 proc* newproc(const char* kind) try {
@@ -47,6 +51,16 @@ const char* fragments(proc* p) {
     return p->p->fragments().c_str();
 }
 
+const char* prefetch(proc* p, int direction) {
+    try {
+        p->prefetch = p->p->prefetch(direction);
+        return p->prefetch.c_str();
+    } catch (std::exception& e) {
+        p->errmsg = e.what();
+        return nullptr;
+    }
+}
+
 bool add(proc* p, int index, const void* chunk, int len) {
     try {
         p->p->add(index, static_cast< const char* >(chunk), len);
@@ -71,3 +85,46 @@ packed pack(proc* p) {
     }
     return pd;
 }
+
+procstats stats(proc* p) {
+    const auto& st = p->p->stats();
+    procstats ps;
+    ps.init_ms     = st.init_ms;
+    ps.add_ms      = st.add_ms;
+    ps.add_max_ms  = st.add_max_ms;
+    ps.adds        = st.adds;
+    ps.pack_ms     = st.pack_ms;
+    ps.bytes_in    = st.bytes_in;
+    ps.bytes_out   = st.bytes_out;
+    ps.allocations = st.allocations;
+    return ps;
+}
+
+packed tracejson(proc* p, const char* pid, const char* part) {
+    packed pd;
+    try {
+        p->trace = p->p->tracer().chrome_json(pid, part);
+        pd.err = false;
+        pd.size = p->trace.size();
+        pd.body = p->trace.data();
+    } catch (std::exception& e) {
+        p->errmsg = e.what();
+        pd.err = true;
+    }
+    return pd;
+}
+
+bool heatmap(const char* path, int interval) {
+    static std::unique_ptr< one::heatmap::recorder > rec;
+    static std::unique_ptr< one::heatmap::flusher > flusher;
+    if (rec) return false;
+
+    rec = std::make_unique< one::heatmap::recorder >();
+    flusher = std::make_unique< one::heatmap::flusher >(
+        *rec,
+        path,
+        std::chrono::seconds(interval)
+    );
+    one::heatmap::install(rec.get(), one::heatmap::at_proc);
+    return true;
+}
@@ -63,6 +63,15 @@ bool add(struct proc*, int index, const void* chunk, int len);
  */
 const char* fragments(struct proc*);
 
+/*
+ * Get the list of fragments that the next query in direction (+1, -1, or 0
+ * for both) is likely to read, in the same format as fragments(), for
+ * speculative prefetching. The list is empty if the proc makes no prediction.
+ * The char array is owned by C++, *must not* be free'd, and is valid until
+ * the next call to prefetch(). Returns NULL on error.
+ */
+const char* prefetch(struct proc*, int direction);
+
 /*
  * The result of the pack(), which packs all add()ed objects into a response
  * that can be written to redis. The actual redis write is expected to be
@@ -81,6 +90,44 @@ struct packed {
 };
 struct packed pack(struct proc*);
 
+/*
+ * Statistics of the task, recorded by init(), add(), and pack(). Times are
+ * wall time in milliseconds. Allocations are only counted when liboneseismic
+ * is built with ONESEISMIC_COUNT_ALLOCATIONS, and are 0 otherwise.
+ *
+ * The stats are reset by init(), and are complete after pack().
+ */
+struct procstats {
+    double init_ms;
+    double add_ms;
+    double add_max_ms;
+    int adds;
+    double pack_ms;
+    size_t bytes_in;
+    size_t bytes_out;
+    size_t allocations;
+};
+struct procstats stats(struct proc*);
+
+/*
+ * The tracing spans of the task as a Chrome trace JSON array, tagged with
+ * the pid and part. The array is empty unless liboneseismic is built with
+ * ONESEISMIC_TRACING.
+ *
+ * The memory is owned by C++ and *must not* be free'd by go, and is valid
+ * until the next call to tracejson(). If tracejson fails (packed.err == true)
+ * then accessing the other fields is undefined behaviour.
+ */
+struct packed tracejson(struct proc*, const char* pid, const char* part);
+
+/*
+ * Start recording the fragments handed out by fragments() in a fragment
+ * access heatmap (see oneseismic/heatmap.hpp), which is written to path
+ * every interval seconds. The recorder lives for the rest of the program.
+ * Returns false if recording is already started.
+ */
+bool heatmap(const char* path, int interval);
+
 
 #ifdef __cplusplus
 }
@@ -193,6 +193,12 @@ func main() {
 	basic := api.MakeBasicEndpoint(&keyring, opts.storageURL, cmdable, tokens)
 	slice := api.MakeSlice(&keyring, opts.storageURL, cmdable, tokens)
 	curtain := api.MakeCurtain(&keyring, opts.storageURL, cmdable, tokens)
+	horizon := api.MakeHorizon(&keyring, opts.storageURL, cmdable, tokens)
+	wellpath := api.MakeWellpath(&keyring, opts.storageURL, cmdable, tokens)
+	points := api.MakePoints(&keyring, opts.storageURL, cmdable, tokens)
+	area := api.MakeArea(&keyring, opts.storageURL, cmdable, tokens)
+	stats := api.MakeStats(&keyring, opts.storageURL, cmdable, tokens)
+	batch := api.MakeBatch(&keyring, opts.storageURL, cmdable, tokens)
 	result := api.Result {
 		Timeout: time.Second * 15,
 		StorageURL: opts.storageURL,
@@ -222,6 +228,12 @@ func main() {
 	queries.GET("/:guid", basic.Entry)
 	queries.GET("/:guid/slice/:dimension/:lineno", slice.Get)
 	queries.GET("/:guid/curtain", curtain.Get)
+	queries.GET("/:guid/horizon", horizon.Get)
+	queries.GET("/:guid/wellpath", wellpath.Get)
+	queries.GET("/:guid/points", points.Get)
+	queries.GET("/:guid/area", area.Get)
+	queries.GET("/:guid/stats", stats.Get)
+	queries.GET("/:guid/batch", batch.Get)
 
 	results := app.Group("/result")
 	results.Use(auth.ResultAuth(&keyring))
@@ -3,6 +3,7 @@ package message
 import (
 	"bytes"
 	"encoding/json"
+	"fmt"
 
 	"github.com/vmihailenco/msgpack/v5"
 )
@@ -25,6 +26,9 @@ type Task struct {
 	Shape           []int32      `json:"shape"`
 	ShapeCube       []int32      `json:"shape-cube"`
 	Function        string       `json:"function"`
+	Format          string       `json:"format,omitempty"`
+	Attribute       string       `json:"attribute,omitempty"`
+	AttributeWindow int          `json:"attribute-window,omitempty"`
 	Params          interface {} `json:"params"`
 }
 
@@ -38,6 +42,35 @@ func (msg *Task) Unpack(doc []byte) (*Task, error) {
 
 type Manifest struct {
 	Dimensions [][]int `json:"dimensions"`
+	/*
+	 * The decimation factors of the overview levels available for this cube,
+	 * written by the upload. The planner picks a level from these, so they
+	 * must be forwarded to the C++ core.
+	 */
+	Decimations []int `json:"decimations,omitempty"`
+	/*
+	 * The affine transform from the grid of the first two dimensions to the
+	 * world (projected) coordinates of the survey, written by the scan. It is
+	 * needed by the planner to map queries in world coordinates to the grid.
+	 */
+	Transform []float64 `json:"transform,omitempty"`
+	/*
+	 * The fragment-existence bitmaps of sparse cubes, by decimation, and the
+	 * value of the samples of absent fragments, written by the upload. Like
+	 * the decimations they must be forwarded to the C++ core.
+	 */
+	FragmentMask map[string]string `json:"fragment-mask,omitempty"`
+	FillValue    float32           `json:"fill-value,omitempty"`
+	/*
+	 * The fragment stats sidecar, written by the upload, which the planner
+	 * needs to answer stats queries.
+	 */
+	FragmentStats *FragmentStats `json:"fragment-stats,omitempty"`
+}
+
+type FragmentStats struct {
+	Shape []int `json:"shape"`
+	Bins  int   `json:"bins"`
 }
 
 func (m *Manifest) Pack() ([]byte, error) {
@@ -50,13 +83,92 @@ func (m *Manifest) Unpack(doc []byte) (*Manifest, error) {
 
 
 type SliceParams struct {
-	Dim    int `json:"dim"`
-	Lineno int `json:"lineno"`
+	Dim         int      `json:"dim"`
+	Lineno      int      `json:"lineno"`
+	TargetShape []int    `json:"target_shape,omitempty"`
+	Progressive bool     `json:"progressive,omitempty"`
+	Zmin        *int     `json:"zmin,omitempty"`
+	Zmax        *int     `json:"zmax,omitempty"`
+	Roi         [][2]int `json:"roi,omitempty"`
+	Stride      []int    `json:"stride,omitempty"`
 }
 
 type CurtainParams struct {
-	Dim0s []int `json:"dim0s"`
-	Dim1s []int `json:"dim1s"`
+	Dim0s       []int `json:"dim0s"`
+	Dim1s       []int `json:"dim1s"`
+	TargetShape []int `json:"target_shape,omitempty"`
+	Zmin        *int  `json:"zmin,omitempty"`
+	Zmax        *int  `json:"zmax,omitempty"`
+}
+
+type HorizonParams struct {
+	Dim0s   []int     `json:"dim0s"`
+	Dim1s   []int     `json:"dim1s"`
+	Surface []float32 `json:"surface"`
+	Window  int       `json:"window"`
+}
+
+type WellpathParams struct {
+	Points      [][3]float64 `json:"points"`
+	Coordinates string       `json:"coordinates"`
+}
+
+type PolylineParams struct {
+	Points      [][2]float64 `json:"points"`
+	Spacing     float32      `json:"spacing"`
+	Coordinates string       `json:"coordinates"`
+}
+
+type PointsParams struct {
+	Dim0s       []int  `json:"dim0s"`
+	Dim1s       []int  `json:"dim1s"`
+	Dim2s       []int  `json:"dim2s"`
+	Coordinates string `json:"coordinates"`
+}
+
+/*
+ * The stats of the whole cube, or of the line lineno in dimension dim when
+ * dim is set
+ */
+type StatsParams struct {
+	Dim    *int `json:"dim,omitempty"`
+	Lineno int  `json:"lineno"`
+	Bins   int  `json:"bins"`
+}
+
+type AreaParams struct {
+	Polygon     [][2]float64 `json:"polygon"`
+	Coordinates string       `json:"coordinates"`
+	Zmin        *int         `json:"zmin,omitempty"`
+	Zmax        *int         `json:"zmax,omitempty"`
+}
+
+/*
+ * A batch of queries against the same cube, planned as one process. The
+ * tasks are complete tasks with their own pids, and must all read the same
+ * cube as the batch.
+ */
+type BatchParams struct {
+	Tasks []*Task `json:"tasks"`
+}
+
+/*
+ * The results of a batch task, one per query. Corresponds to batch_results
+ * in oneseismic/messages.hpp. The body is the result of the query, which is
+ * written as part of the process of the query.
+ */
+type BatchResult struct {
+	Pid  string `msgpack:"pid"`
+	Part string `msgpack:"part"`
+	Body []byte `msgpack:"body"`
+}
+
+type BatchResults struct {
+	Results []BatchResult `msgpack:"results"`
+}
+
+func (r *BatchResults) Unpack(doc []byte) (*BatchResults, error) {
+	return r, msgpack.Unmarshal(doc, r)
 }
 
 type DimensionDescription struct {
@@ -69,6 +181,19 @@ func (m *DimensionDescription) Pack() ([]byte, error) {
 	return json.Marshal(m)
 }
 
+/*
+ * A phase of a progressive process, e.g. the coarse preview of a slice. The
+ * fields mirror those of the process header, but for the bundles of this phase
+ * only. Phases are scheduled in order.
+ */
+type ProcessPhase struct {
+	Ntasks     int     `json:"ntasks"     msgpack:"ntasks"`
+	Decimation int     `json:"decimation" msgpack:"decimation"`
+	Shape      []int   `json:"shape"      msgpack:"shape"`
+	Index      [][]int `json:"index"      msgpack:"index"`
+	Lineno     *int    `json:"lineno,omitempty" msgpack:"lineno,omitempty"`
+}
+
 /*
  * This document is written as a "process header" in redis when a process is
  * scheduled, and holds the required information to build the response header.
@@ -108,6 +233,33 @@ type ProcessHeader struct {
 	 * language-specific index like in xarray in python.
 	 */
 	Index [][]int `json:"index"`
+	/*
+	 * The sample encoding of the values in the result, one of f32, f16, bf16,
+	 * i16, i8. See oneseismic/encoding.hpp for how to decode them.
+	 */
+	Format string `json:"format"`
+	/*
+	 * The decimation factor of the overview level the result is read from,
+	 * where 1 is full resolution.
+	 */
+	Decimation int `json:"decimation"`
+	/*
+	 * The phases of progressive processes, in scheduling order, or empty. The
+	 * shape, index and decimation of the header describe the last phase, and
+	 * Ntasks counts the tasks of all phases.
+	 */
+	Phases []ProcessPhase `json:"phases"`
+	/*
+	 * The label of the line of a slice, which on overview levels is the
+	 * closest line at or before the requested one. Only slices have it.
+	 */
+	Lineno *int `json:"lineno,omitempty"`
+	/*
+	 * The value of the samples of fragments that are not stored in sparse
+	 * cubes, which are left out of the result. Clients fill the parts of the
+	 * result that no bundle covers with it.
+	 */
+	FillValue float32 `json:"fill-value"`
 }
 
 func (m *ProcessHeader) Pack() ([]byte, error) {
@@ -124,9 +276,14 @@ func (m *ProcessHeader) Unpack(doc []byte) (*ProcessHeader, error) {
  * stability requirements than most messages in oneseismic.
  */
 type ResultHeader struct {
-	Bundles int
-	Shape   []int
-	Index   [][]int
+	Bundles    int
+	Shape      []int
+	Index      [][]int
+	Format     string
+	Decimation int
+	Phases     []ProcessPhase
+	Lineno     *int
+	FillValue  float32
 }
 
 /*
@@ -141,13 +298,18 @@ func (rh *ResultHeader) Pack() ([]byte, error) {
 	if err := enc.EncodeArrayLen(2); err != nil {
 		return nil, err
 	}
-	if err := enc.EncodeMapLen(3); err != nil {
+	if err := enc.EncodeMapLen(8); err != nil {
 		return nil, err
 	}
 	err := enc.EncodeMulti(
-		"bundles", rh.Bundles,
-		"shape",   rh.Shape,
-		"index",   rh.Index,
+		"bundles",    rh.Bundles,
+		"shape",      rh.Shape,
+		"index",      rh.Index,
+		"format",     rh.Format,
+		"decimation", rh.Decimation,
+		"phases",     rh.Phases,
+		"lineno",     rh.Lineno,
+		"fill-value", rh.FillValue,
 	)
 	if err != nil {
 		return nil, err
@@ -157,3 +319,53 @@ func (rh *ResultHeader) Pack() ([]byte, error) {
 	}
 	return b.Bytes(), nil
 }
+
+/*
+ * The redis key of the list of tracing spans of the process pid. The planner
+ * and every worker push their spans as a Chrome trace JSON array, and the
+ * arrays concatenated make up the trace of the whole process. Spans are only
+ * recorded when liboneseismic is built with ONESEISMIC_TRACING.
+ */
+func TraceKey(pid string) string {
+	return fmt.Sprintf("%s/trace", pid)
+}
+
+/*
+ * The redis key that marks the process pid as failed. A worker that can not
+ * complete a task of the process sets it, since the process then never
+ * finishes.
+ */
+func FailedKey(pid string) string {
+	return fmt.Sprintf("%s/failed", pid)
+}
+
+/*
+ * The field in the result stream entries that holds the task stats, next to
+ * the field of the packed bundle (keyed by part). Readers of the result
+ * stream must not count it as a bundle.
+ */
+const StatsKey = "stats"
+
+/*
+ * Corresponds to procstats in cmd/fetch/tasks.h - the time spent in and data
+ * moved through the stages of a single task, as recorded by the worker.
+ */
+type TaskStats struct {
+	Part        string  `json:"part"`
+	InitMs      float64 `json:"init_ms"`
+	AddMs       float64 `json:"add_ms"`
+	AddMaxMs    float64 `json:"add_max_ms"`
+	Adds        int     `json:"adds"`
+	PackMs      float64 `json:"pack_ms"`
+	BytesIn     uint64  `json:"bytes_in"`
+	BytesOut    uint64  `json:"bytes_out"`
+	Allocations uint64  `json:"allocations"`
+}
+
+func (m *TaskStats) Pack() ([]byte, error) {
+	return json.Marshal(m)
+}
+
+func (m *TaskStats) Unpack(doc []byte) (*TaskStats, error) {
+	return m, json.Unmarshal(doc, m)
+}
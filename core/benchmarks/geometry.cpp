@@ -0,0 +1,60 @@
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <catch/catch.hpp>
+
+#include <oneseismic/geometry.hpp>
+
+#include "survey.hpp"
+
+TEST_CASE("gvt::slice", "[geometry]") {
+    auto gvt = survey::gvt();
+
+    BENCHMARK("inline") {
+        return gvt.slice(gvt.mkdim(0), 18);
+    };
+    BENCHMARK("crossline") {
+        return gvt.slice(gvt.mkdim(1), 23);
+    };
+    BENCHMARK("time") {
+        return gvt.slice(gvt.mkdim(2), 10);
+    };
+}
+
+TEST_CASE("gvt point mapping", "[geometry]") {
+    const auto gvt = survey::gvt();
+
+    /*
+     * Random points in the survey, which is the worst case for the
+     * per-point mapping that curtains and point queries do
+     */
+    std::minstd_rand rng(42);
+    std::uniform_int_distribution< std::size_t > x(0, survey::inlines - 1);
+    std::uniform_int_distribution< std::size_t > y(0, survey::crosslines - 1);
+    std::uniform_int_distribution< std::size_t > z(0, survey::samples - 1);
+    std::vector< one::CP< 3 > > points;
+    for (int i = 0; i < 10000; ++i)
+        points.push_back({ x(rng), y(rng), z(rng) });
+
+    BENCHMARK("frag_id x 10000") {
+        std::size_t acc = 0;
+        for (const auto& p : points)
+            acc += gvt.frag_id(p)[0];
+        return acc;
+    };
+
+    BENCHMARK("to_local x 10000") {
+        std::size_t acc = 0;
+        for (const auto& p : points)
+            acc += gvt.to_local(p)[0];
+        return acc;
+    };
+
+    BENCHMARK("frag_id + to_local x 10000") {
+        std::size_t acc = 0;
+        for (const auto& p : points)
+            acc += gvt.frag_id(p)[0] + gvt.to_local(p)[1];
+        return acc;
+    };
+}
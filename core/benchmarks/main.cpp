@@ -0,0 +1,22 @@
+/*
+ * Micro-benchmarks for the core library, built on catch2's benchmarking
+ * support. Run everything with:
+ *
+ *      benchmarks
+ *
+ * or a subset by tag or name, just like the tests, e.g. benchmarks [plan].
+ * For machine-readable output, e.g. to compare against a baseline or track in
+ * CI, use the xml reporter, which includes mean, standard deviation and
+ * outlier analysis for every benchmark:
+ *
+ *      benchmarks -r xml -o benchmarks.xml
+ *
+ * The number of samples and the confidence level can be tuned with
+ * --benchmark-samples and --benchmark-confidence-interval.
+ */
+#define CATCH_CONFIG_RUNNER
+#include <catch/catch.hpp>
+
+int main(int argc, char** argv) {
+    return Catch::Session().run(argc, argv);
+}
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <catch/catch.hpp>
+
+#include <oneseismic/messages.hpp>
+#include <oneseismic/plan.hpp>
+#include <oneseismic/process.hpp>
+
+#include "survey.hpp"
+
+namespace {
+
+/*
+ * Benchmark x.pack() and T::unpack() of the packed x. Every message is
+ * benchmarked as a pair, as they are always used in pairs - one side of the
+ * system packs, the other unpacks.
+ */
+template < typename T >
+void pack_unpack(const std::string& name, const T& x) {
+    const auto packed = x.pack();
+
+    BENCHMARK((name + " pack").c_str()) {
+        return x.pack();
+    };
+
+    BENCHMARK((name + " unpack").c_str()) {
+        T t;
+        t.unpack(packed.data(), packed.data() + packed.size());
+        return t;
+    };
+}
+
+template < typename T >
+T unpack(const std::string& s) {
+    T t;
+    t.unpack(s.data(), s.data() + s.size());
+    return t;
+}
+
+/*
+ * Run a task through proc with the same fragment for every id, and unpack the
+ * result, to get a result message of realistic size.
+ */
+template < typename Result >
+Result run(const std::string& kind, const std::string& task) {
+    const auto fragment = survey::fragment_samples();
+    const auto* chunk = reinterpret_cast< const char* >(fragment.data());
+    const auto  len   = int(fragment.size() * sizeof(float));
+
+    auto proc = one::proc::make(kind);
+    proc->init(task.data(), task.size());
+    const auto& fragments = proc->fragments();
+    const auto n = fragments.empty()
+        ? 0
+        : 1 + std::count(fragments.begin(), fragments.end(), ';');
+    for (int i = 0; i < n; ++i)
+        proc->add(i, chunk, len);
+
+    return unpack< Result >(proc->pack());
+}
+
+}
+
+TEST_CASE("slice messages", "[messages]") {
+    const auto task   = survey::slice_task(2);
+    const auto packed = task.pack();
+    const auto sched  = one::mkschedule(packed.data(), packed.size(), 10);
+
+    pack_unpack("slice_task", task);
+    pack_unpack("slice_fetch", unpack< one::slice_fetch >(sched.front()));
+    pack_unpack("process_header", unpack< one::process_header >(sched.back()));
+    pack_unpack("slice_tiles", run< one::slice_tiles >("slice", sched.front()));
+}
+
+TEST_CASE("curtain messages", "[messages]") {
+    const auto task   = survey::curtain_task(3000);
+    const auto packed = task.pack();
+    const auto sched  = one::mkschedule(packed.data(), packed.size(), 10);
+
+    pack_unpack("curtain_task", task);
+    pack_unpack("curtain_fetch", unpack< one::curtain_fetch >(sched.front()));
+    pack_unpack("process_header", unpack< one::process_header >(sched.back()));
+    pack_unpack(
+        "curtain_traces",
+        run< one::curtain_traces >("curtain", sched.front())
+    );
+}
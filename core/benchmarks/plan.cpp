@@ -0,0 +1,40 @@
+#include <string>
+
+#include <catch/catch.hpp>
+
+#include <oneseismic/plan.hpp>
+
+#include "survey.hpp"
+
+/*
+ * Planning includes parsing the query and the manifest, which for a survey of
+ * this size is a good part of the cost, and mirrors what the api pays per
+ * request. The task size is the same as the api's.
+ */
+TEST_CASE("slice planning", "[plan]") {
+    const auto inline_task    = survey::slice_task(0).pack();
+    const auto crossline_task = survey::slice_task(1).pack();
+    const auto time_task      = survey::slice_task(2).pack();
+
+    BENCHMARK("inline") {
+        return one::mkschedule(inline_task.data(), inline_task.size(), 10);
+    };
+    BENCHMARK("crossline") {
+        return one::mkschedule(crossline_task.data(), crossline_task.size(), 10);
+    };
+    BENCHMARK("time") {
+        return one::mkschedule(time_task.data(), time_task.size(), 10);
+    };
+}
+
+TEST_CASE("curtain planning", "[plan]") {
+    const auto short_task = survey::curtain_task(100).pack();
+    const auto long_task  = survey::curtain_task(3000).pack();
+
+    BENCHMARK("100 traces") {
+        return one::mkschedule(short_task.data(), short_task.size(), 10);
+    };
+    BENCHMARK("3000 traces") {
+        return one::mkschedule(long_task.data(), long_task.size(), 10);
+    };
+}
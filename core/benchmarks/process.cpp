@@ -0,0 +1,68 @@
+#include <array>
+#include <string>
+#include <vector>
+
+#include <catch/catch.hpp>
+
+#include <oneseismic/messages.hpp>
+#include <oneseismic/process.hpp>
+
+#include "survey.hpp"
+
+namespace {
+
+const char* as_chunk(const std::vector< float >& xs) {
+    return reinterpret_cast< const char* >(xs.data());
+}
+
+int chunk_size(const std::vector< float >& xs) {
+    return int(xs.size() * sizeof(float));
+}
+
+one::slice_fetch slice_fetch(int dim, const std::string& format) {
+    one::slice_fetch fetch(survey::slice_task(dim));
+    fetch.format = format;
+    fetch.lineno = 17;
+    fetch.ids    = { { 1, 1, 1 } };
+    return fetch;
+}
+
+}
+
+TEST_CASE("proc::add slice", "[process]") {
+    const auto fragment = survey::fragment_samples();
+    const auto format = GENERATE(std::string("f32"), std::string("f16"));
+
+    for (int dim = 0; dim < 3; ++dim) {
+        const auto msg = slice_fetch(dim, format).pack();
+        auto proc = one::proc::make("slice");
+        proc->init(msg.data(), msg.size());
+
+        const auto name = "dim " + std::to_string(dim) + " " + format;
+        BENCHMARK(name.c_str()) {
+            proc->add(0, as_chunk(fragment), chunk_size(fragment));
+        };
+    }
+}
+
+TEST_CASE("proc::add curtain", "[process]") {
+    const auto fragment = survey::fragment_samples();
+
+    /*
+     * A diagonal through the fragment, which is typical for curtains
+     */
+    one::curtain_fetch fetch(survey::curtain_task(2));
+    one::single single;
+    single.id = { 1, 1, 1 };
+    for (int i = 0; i < survey::fragment; ++i)
+        single.coordinates.push_back({ i, i });
+    fetch.ids = { single };
+
+    const auto msg = fetch.pack();
+    auto proc = one::proc::make("curtain");
+    proc->init(msg.data(), msg.size());
+
+    BENCHMARK("64 traces") {
+        proc->add(0, as_chunk(fragment), chunk_size(fragment));
+    };
+}
@@ -0,0 +1,98 @@
+#ifndef ONESEISMIC_BENCHMARKS_SURVEY_HPP
+#define ONESEISMIC_BENCHMARKS_SURVEY_HPP
+
+#include <cmath>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <oneseismic/geometry.hpp>
+#include <oneseismic/messages.hpp>
+
+/*
+ * Realistic inputs for the benchmarks. The survey is a fairly large modern
+ * 3D survey, 2401 inlines x 3001 crosslines x 1501 samples, stored in 64^3
+ * fragments like the api does. Curtains are well-path-like diagonals through
+ * the survey.
+ */
+namespace survey {
+
+constexpr int inlines    = 2401;
+constexpr int crosslines = 3001;
+constexpr int samples    = 1501;
+constexpr int fragment   = 64;
+
+inline std::vector< int > labels(int first, int n) {
+    std::vector< int > xs(n);
+    std::iota(xs.begin(), xs.end(), first);
+    return xs;
+}
+
+inline std::string manifest() {
+    nlohmann::json doc;
+    doc["dimensions"] = {
+        labels(1000, inlines),
+        labels(2000, crosslines),
+        labels(0,    samples),
+    };
+    return doc.dump();
+}
+
+inline one::gvt< 3 > gvt() {
+    return one::gvt< 3 > {
+        { std::size_t(inlines), std::size_t(crosslines), std::size_t(samples) },
+        { std::size_t(fragment), std::size_t(fragment), std::size_t(fragment) },
+    };
+}
+
+template < typename Task >
+void fill_common(Task& task, const std::string& function) {
+    task.pid   = "benchmark-pid";
+    task.token = "benchmark-token";
+    task.guid  = "benchmark-guid";
+    task.storage_endpoint = "benchmark-endpoint";
+    task.manifest   = manifest();
+    task.shape      = { fragment, fragment, fragment };
+    task.shape_cube = { inlines, crosslines, samples };
+    task.function   = function;
+}
+
+inline one::slice_task slice_task(int dim) {
+    one::slice_task task;
+    fill_common(task, "slice");
+    task.dim = dim;
+    const int linenos[] = { 1000 + inlines / 2, 2000 + crosslines / 2, 700 };
+    task.lineno = linenos[dim];
+    return task;
+}
+
+/*
+ * A curtain of n traces, a straight line from one corner of the survey to the
+ * other, in line numbers.
+ */
+inline one::curtain_task curtain_task(int n) {
+    one::curtain_task task;
+    fill_common(task, "curtain");
+    for (int i = 0; i < n; ++i) {
+        const double t = double(i) / (n - 1);
+        task.dim0s.push_back(1000 + int(std::lround(t * (inlines - 1))));
+        task.dim1s.push_back(2000 + int(std::lround(t * (crosslines - 1))));
+    }
+    return task;
+}
+
+/*
+ * A fragment with distinct, non-trivial sample values
+ */
+inline std::vector< float > fragment_samples() {
+    std::vector< float > xs(fragment * fragment * fragment);
+    for (std::size_t i = 0; i < xs.size(); ++i)
+        xs[i] = std::sin(float(i) * 0.01f) * 1000.0f;
+    return xs;
+}
+
+}
+
+#endif //ONESEISMIC_BENCHMARKS_SURVEY_HPP
@@ -0,0 +1,66 @@
+#ifndef ONESEISMIC_ATTRIBUTES_HPP
+#define ONESEISMIC_ATTRIBUTES_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace one {
+
+/*
+ * Windowed amplitude attributes
+ * -----------------------------
+ * Many interpretation workflows only look at a reduction of the amplitudes
+ * over a window in z, e.g. an RMS map of a reservoir interval, and not at the
+ * samples themselves. Computing the reduction in the worker, while the
+ * fragment is in memory, means only the reduced values are packed, which
+ * shrinks the response by the window length.
+ *
+ * The supported attributes are:
+ *  none   - no reduction, the samples are returned as-is
+ *  rms    - root-mean-square, sqrt(sum(x^2) / n)
+ *  mean   - the mean amplitude
+ *  maxabs - the max absolute amplitude
+ *  sumpos - the sum of the positive amplitudes
+ *  sumneg - the sum of the negative amplitudes
+ *
+ * Like encodings, attributes are given by name in messages.
+ */
+enum class attribute {
+    none,
+    rms,
+    mean,
+    maxabs,
+    sumpos,
+    sumneg,
+};
+
+/*
+ * Parse an attribute by name. Throws std::invalid_argument if the name is
+ * not a known attribute.
+ */
+attribute parse_attribute(const std::string&) noexcept (false);
+const char* to_string(attribute) noexcept (true);
+
+/*
+ * Reduce n samples from src in consecutive windows of window samples, and
+ * write one value per window to dst. dst must have room for
+ * (n + window - 1) / window elements. The last window may be shorter than
+ * window, and is reduced over the samples it has.
+ *
+ * The kernels accumulate in a fixed number of independent lanes, so that
+ * the compiler can vectorise the reductions without reordering floating
+ * point operations.
+ *
+ * Calling reduce() with attribute::none is a logic error.
+ */
+void reduce(
+    attribute,
+    const float* src,
+    std::size_t n,
+    std::size_t window,
+    float* dst
+) noexcept (false);
+
+}
+
+#endif //ONESEISMIC_ATTRIBUTES_HPP
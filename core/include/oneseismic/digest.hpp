@@ -0,0 +1,134 @@
+#ifndef ONESEISMIC_DIGEST_HPP
+#define ONESEISMIC_DIGEST_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace one {
+
+/*
+ * Digests
+ * -------
+ * Plain, incremental SHA-1 and SHA-256 (FIPS 180-4), so that hashes are the
+ * same across builds and platforms without depending on a crypto library.
+ *
+ * SHA-1 is not collision resistant, and is only used for identifying files.
+ * Anything where a crafted collision would do harm, e.g. sharing results
+ * between users, uses SHA-256.
+ *
+ * Both hash the message in blocks of 64 bytes, and end it with the padding
+ * and the big-endian bit length, which is what md_buffer does.
+ */
+class md_buffer {
+public:
+    template < typename Block >
+    void update(const char* data, std::size_t len, Block block)
+    noexcept (true);
+
+    template < typename Block >
+    void pad(Block block) noexcept (true);
+
+private:
+    std::uint64_t total = 0;
+    unsigned char buffer[64];
+    std::size_t buffered = 0;
+};
+
+class sha1_state {
+public:
+    using digest = std::array< unsigned char, 20 >;
+
+    void update(const char* data, std::size_t len) noexcept (true);
+    digest finish() noexcept (true);
+
+private:
+    std::uint32_t h[5] = {
+        0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0,
+    };
+    md_buffer message;
+
+    void block(const unsigned char* p) noexcept (true);
+};
+
+class sha256_state {
+public:
+    using digest = std::array< unsigned char, 32 >;
+
+    void update(const char* data, std::size_t len) noexcept (true);
+    digest finish() noexcept (true);
+
+private:
+    std::uint32_t h[8] = {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+        0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+    };
+    md_buffer message;
+
+    void block(const unsigned char* p) noexcept (true);
+};
+
+sha1_state::digest sha1_digest(const char* data, std::size_t len)
+noexcept (true);
+sha256_state::digest sha256_digest(const char* data, std::size_t len)
+noexcept (true);
+
+/*
+ * The digest as a lowercase hex string
+ */
+template < std::size_t N >
+std::string hex(const std::array< unsigned char, N >& digest) noexcept (false) {
+    const char* digits = "0123456789abcdef";
+    std::string s;
+    s.reserve(2 * N);
+    for (const auto x : digest) {
+        s.push_back(digits[x >> 4]);
+        s.push_back(digits[x & 0xF]);
+    }
+    return s;
+}
+
+template < typename Block >
+void md_buffer::update(const char* data, std::size_t len, Block block)
+noexcept (true) {
+    const auto* p = reinterpret_cast< const unsigned char* >(data);
+    this->total += len;
+
+    if (this->buffered > 0) {
+        const auto n = std::min(len, sizeof(this->buffer) - this->buffered);
+        std::memcpy(this->buffer + this->buffered, p, n);
+        this->buffered += n;
+        p   += n;
+        len -= n;
+        if (this->buffered < sizeof(this->buffer))
+            return;
+        block(this->buffer);
+        this->buffered = 0;
+    }
+
+    for (; len >= 64; p += 64, len -= 64)
+        block(p);
+
+    std::memcpy(this->buffer, p, len);
+    this->buffered = len;
+}
+
+template < typename Block >
+void md_buffer::pad(Block block) noexcept (true) {
+    const auto bits = this->total * 8;
+    unsigned char pad[72] = { 0x80 };
+    const auto padlen = this->buffered < 56
+                      ? 56 - this->buffered
+                      : 120 - this->buffered
+                      ;
+    for (int i = 0; i < 8; ++i)
+        pad[padlen + i] = (unsigned char)(bits >> (56 - 8 * i));
+    this->update(reinterpret_cast< const char* >(pad), padlen + 8, block);
+}
+
+}
+
+#endif //ONESEISMIC_DIGEST_HPP
@@ -0,0 +1,87 @@
+#ifndef ONESEISMIC_ENCODING_HPP
+#define ONESEISMIC_ENCODING_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace one {
+
+/*
+ * Sample encodings for results
+ * ----------------------------
+ * Fragments are stored as 4-byte floats, and extracted samples are f32 all
+ * the way to pack(). For large responses, e.g. a time slice through a full
+ * survey, the full precision is rarely needed, and the response size is
+ * dominated by the samples. Tasks can ask for samples to be encoded with fewer
+ * bits before they are packed.
+ *
+ * The supported encodings are:
+ *  f32  - the native 4-byte float, no conversion
+ *  f16  - IEEE-754 half precision float
+ *  bf16 - bfloat16, the upper 16 bits of an f32
+ *  i16  - 16-bit signed integer, linearly scaled
+ *  i8   - 8-bit signed integer, linearly scaled
+ *
+ * The encoded samples are always stored as int16_t, with the bit pattern of
+ * the 16-bit float formats, or the integer value for i16 and i8. The integer
+ * formats are scaled per-tile (or per-trace), and decoded with:
+ *
+ *      x = offset + scale * q
+ *
+ * except for the lowest code, -32768 for i16 and -128 for i8, which is
+ * reserved for non-finite samples and decodes to nan. Infinities are not
+ * kept by the integer formats.
+ *
+ * For the float formats scale and offset are always 1 and 0.
+ *
+ * The encodings are given by name in messages, and the names are used
+ * verbatim on the wire. The name of the f32 encoding is the same as the
+ * fragment file suffix.
+ */
+enum class encoding {
+    f32,
+    f16,
+    bf16,
+    i16,
+    i8,
+};
+
+/*
+ * Parse an encoding by name. Throws std::invalid_argument if the name is not
+ * a known encoding.
+ */
+encoding parse_encoding(const std::string&) noexcept (false);
+const char* to_string(encoding) noexcept (true);
+
+/*
+ * Encode n floats from src into dst. dst must have room for n elements.
+ * Returns the scale and offset needed to decode the samples through the out
+ * parameters.
+ *
+ * The loops are straight-line per-element conversions over contiguous
+ * buffers, written so the compiler can vectorise them.
+ *
+ * Calling encode() with encoding::f32 is a logic error, as f32 samples are
+ * not stored as int16_t.
+ */
+void encode(
+    encoding,
+    const float* src,
+    std::size_t n,
+    std::int16_t* dst,
+    float& scale,
+    float& offset
+) noexcept (false);
+
+void decode(
+    encoding,
+    const std::int16_t* src,
+    std::size_t n,
+    float* dst,
+    float scale,
+    float offset
+) noexcept (false);
+
+}
+
+#endif //ONESEISMIC_ENCODING_HPP
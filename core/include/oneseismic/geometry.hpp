@@ -473,6 +473,22 @@ class gvt {
         std::vector< FID< ND > >
         slice(Dimension dim, std::size_t n) noexcept (false);
 
+        /*
+         * Get the fragment-IDs for a slice through the region of interest
+         * [begin, end) of the cube, at every stride'th sample from begin.
+         * Fragments without any of those samples are skipped. The begin, end
+         * and stride of the pinned dimension are ignored, and n is the line,
+         * like in slice(dim, n).
+         */
+        std::vector< FID< ND > >
+        slice(
+            Dimension dim,
+            std::size_t n,
+            const std::array< std::size_t, ND >& begin,
+            const std::array< std::size_t, ND >& end,
+            const std::array< std::size_t, ND >& stride
+        ) noexcept (false);
+
         /*
          * The slice layout for putting a single fragment into a cube
          */
@@ -529,6 +545,68 @@ class gvt {
         FS< ND > fragment_dims;
 };
 
+/*
+ * The cell for linear interpolation at the fractional index x, along an axis
+ * of n samples. The value at x is
+ *
+ *      (1 - weight) * axis[lower] + weight * axis[upper]
+ *
+ * x must be in [0, n-1]. Points on the last sample get the cell below, with
+ * weight 1, so that upper is always inside the axis.
+ */
+struct lerp_cell {
+    std::size_t lower;
+    std::size_t upper;
+    float       weight;
+};
+
+lerp_cell interpolation_cell(float x, std::size_t n) noexcept (true);
+
+/*
+ * The affine transform between grid coordinates (i, j), i.e. (fractional)
+ * indices along the first two dimensions of the cube, and the world
+ * coordinates (x, y) of the survey, e.g. UTM easting and northing:
+ *
+ *      x = t[0] + t[1] * i + t[2] * j
+ *      y = t[3] + t[4] * i + t[5] * j
+ *
+ * which is the same convention as the GDAL geotransform. World coordinates
+ * are large numbers with small differences, so they are doubles.
+ *
+ * The conversions take arrays of coordinates (structure-of-arrays), so that
+ * converting a whole path is a plain loop the compiler vectorises.
+ */
+class world_transform {
+public:
+    /*
+     * Throws std::invalid_argument if the transform is singular, e.g. when
+     * the survey has no trace coordinates.
+     */
+    explicit world_transform(const std::array< double, 6 >& t)
+    noexcept (false);
+
+    void to_world(
+        const double* i,
+        const double* j,
+        std::size_t n,
+        double* x,
+        double* y)
+    const noexcept (true);
+
+    void to_grid(
+        const double* x,
+        const double* y,
+        std::size_t n,
+        double* i,
+        double* j)
+    const noexcept (true);
+
+private:
+    std::array< double, 6 > fwd;
+    /* the inverse of the linear part of fwd, row-major */
+    std::array< double, 4 > inv;
+};
+
 }
 
 #endif //ONESEISMIC_GEOMETRY_HPP
@@ -0,0 +1,178 @@
+#ifndef ONESEISMIC_HEATMAP_HPP
+#define ONESEISMIC_HEATMAP_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace one {
+namespace heatmap {
+
+/*
+ * Fragment access heatmaps
+ * ------------------------
+ * The recorder counts how often every fragment is accessed, so that caches
+ * and fragment layouts can be tuned for the queries that are actually made.
+ * When a recorder is install()ed, the planner counts the fragments of every
+ * plan (in schedule_maker::build), and proc counts the fragments it hands
+ * out in fragments(), unless the recorder is installed for only one of them.
+ *
+ * Fragments are counted per cube, where the cube is the guid and the
+ * fragment prefix, e.g. <guid>/src/64-64-64, so that overview levels and
+ * different fragment shapes are kept apart.
+ *
+ * Counting is lock-free - the counters are an open-addressing hash table of
+ * atomics with a fixed capacity, which is claimed with a compare-and-swap
+ * and incremented with fetch_add. When the table is full, accesses to new
+ * fragments are counted as dropped. Only registering a cube, which happens
+ * once per plan or task, takes a lock.
+ *
+ * Snapshots are written in a compact binary format, little endian:
+ *
+ *      magic       8 bytes, "OSHEAT01"
+ *      ncubes      u32
+ *      cubes       ncubes x [u32 length, name]
+ *      nentries    u64
+ *      entries     nentries x [u16 cube, u16 i, u16 j, u16 k, u64 count]
+ *      dropped     u64
+ */
+struct entry {
+    int           cube;
+    int           i;
+    int           j;
+    int           k;
+    std::uint64_t count;
+};
+
+struct snapshot {
+    std::vector< std::string > cubes;
+    std::vector< entry >       entries;
+    std::uint64_t              dropped = 0;
+};
+
+class recorder {
+public:
+    /*
+     * The capacity is the max number of distinct fragments across all cubes
+     * and is rounded up to a power of two.
+     */
+    explicit recorder(std::size_t capacity = 1 << 20) noexcept (false);
+
+    /*
+     * Get the handle of the cube, registering it if needed.
+     */
+    int cube(const std::string& key) noexcept (false);
+    void record(int cube, int i, int j, int k) noexcept (true);
+
+    snapshot collect() const noexcept (false);
+    void write(std::ostream&) const noexcept (false);
+
+private:
+    std::size_t mask;
+    std::unique_ptr< std::atomic< std::uint64_t >[] > keys;
+    std::unique_ptr< std::atomic< std::uint64_t >[] > counts;
+    std::atomic< std::uint64_t > dropped;
+
+    mutable std::mutex mtx;
+    std::map< std::string, int > handles;
+    std::vector< std::string > names;
+};
+
+/*
+ * The cube key of the fragments of guid with the (formatted) fragment shape,
+ * at the overview level of decimation, e.g. <guid>/src/64-64-64 or
+ * <guid>/lod2/64-64-64.
+ */
+std::string cube_key(
+        const std::string& guid,
+        const std::string& shape,
+        int decimation)
+noexcept (false);
+
+/*
+ * The sites that count accesses. Processes that both plan and process, like
+ * the oneseismic-query engine, should only record at one of them, or every
+ * access is counted twice.
+ */
+enum site : int {
+    at_plan = 1 << 0,
+    at_proc = 1 << 1,
+    at_all  = at_plan | at_proc,
+};
+
+/*
+ * Install the recorder the sites should count accesses in, or nullptr to
+ * stop recording. The recorder must outlive its installation.
+ */
+void install(recorder*, int sites = at_all) noexcept (true);
+/*
+ * The installed recorder, or nullptr if none is installed for the site.
+ */
+recorder* installed(site) noexcept (true);
+
+/*
+ * Write snapshots of the recorder to path every interval, and once more on
+ * destruction. Snapshots are written to a temporary file that is renamed
+ * into place, so readers never see a partial snapshot.
+ */
+class flusher {
+public:
+    flusher(
+        const recorder&,
+        std::string path,
+        std::chrono::milliseconds interval)
+    noexcept (false);
+    ~flusher();
+
+    void flush() const noexcept (false);
+
+private:
+    const recorder& rec;
+    std::string path;
+    std::chrono::milliseconds interval;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool done = false;
+    std::thread worker;
+};
+
+/*
+ * Read a snapshot written by recorder::write. Throws std::invalid_argument
+ * if the stream is not a heatmap snapshot.
+ */
+snapshot read(std::istream&) noexcept (false);
+
+/*
+ * Estimated cache hit rates for a cache of capacity fragments, given the
+ * access counts of every fragment.
+ *
+ * static_hit_rate is the hit rate of a cache that always holds the
+ * capacity most popular fragments, which is the best a cache can do when
+ * accesses are independent.
+ *
+ * lru_hit_rate is the hit rate of an LRU cache under the independent
+ * reference model, by Che's approximation [1]. It assumes accesses are
+ * independent, and so ignores the locality of accesses of a single query.
+ *
+ * [1] Che, Tung, Wang. Hierarchical web caching systems: modeling, design
+ *     and experimental results. IEEE JSAC 20(7), 2002.
+ */
+double static_hit_rate(std::vector< std::uint64_t > counts, std::size_t capacity)
+noexcept (false);
+double lru_hit_rate(const std::vector< std::uint64_t >& counts, std::size_t capacity)
+noexcept (false);
+
+}
+}
+
+#endif //ONESEISMIC_HEATMAP_HPP
@@ -0,0 +1,133 @@
+#ifndef ONESEISMIC_INGEST_HPP
+#define ONESEISMIC_INGEST_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace one {
+
+/*
+ * Ingestion
+ * ---------
+ * Ingestion makes the fragments of a cube from a SEG-Y file, like
+ * `python -m oneseismic.upload`, and writes the same objects:
+ *
+ *      <guid>/manifest.json
+ *      <guid>/src/64-64-64/0-0-0.f32
+ *      <guid>/src/64-64-64/stats.bin
+ *      <guid>/lod2/64-64-64/0-0-0.f32
+ *      ...
+ *
+ * The input is the (memory mapped) SEG-Y file and the manifest made by
+ * `python -m oneseismic.scan`, which has the line numbers, the header words
+ * and the last trace of every line. Traces are converted and scattered into
+ * the fragments of the full resolution cube and all the overview levels in a
+ * single read of the file, and a lane (all the fragments with the same i, see
+ * upload.py) is handed to the writer threads as soon as its last trace is
+ * read.
+ *
+ * The fragments are buffered a lane at a time, and the memory of the open
+ * and not-yet-written lanes is bounded by ingest_options.memory. A file
+ * sorted by inline only ever has a few lanes open, but when a new lane does
+ * not fit, e.g. because the file is sorted by crossline, the lane is skipped
+ * and picked up by another read of the file. The reads are cheap, since the
+ * file is memory mapped, and the result is the same regardless of the
+ * budget.
+ */
+
+/*
+ * Decode n samples of SEG-Y format 1 (IBM float) or 5 (IEEE float) to native
+ * floats. Throws std::invalid_argument on other formats.
+ */
+void decode_samples(
+        float* out,
+        const char* in,
+        std::size_t n,
+        int format,
+        bool big_endian)
+noexcept (false);
+
+/*
+ * The size in bytes (2 or 4) of the trace header field at the (1-based) byte
+ * offset word, e.g. 4 for inline (189) and 2 for the coordinate scalar (71).
+ * Throws std::invalid_argument if no field starts at word.
+ */
+int header_word_size(int word) noexcept (false);
+
+/*
+ * The destination of the objects of ingestion. Objects are addressed like
+ * in fragment_source (see source.hpp), and put() must be safe to call from
+ * multiple threads.
+ */
+class fragment_sink {
+public:
+    virtual void put(const std::string& path, const char* data, std::size_t)
+        noexcept (false) = 0;
+    virtual ~fragment_sink() = default;
+};
+
+/*
+ * Write objects to files under a root directory, creating directories as
+ * needed. This is the layout read by filesystem_source and mmap_source.
+ */
+class filesystem_sink : public fragment_sink {
+public:
+    explicit filesystem_sink(std::string root);
+    void put(const std::string& path, const char* data, std::size_t)
+        noexcept (false) override;
+
+private:
+    std::string root;
+};
+
+struct ingest_options {
+    std::vector< int > fragment_shape = { 64, 64, 64 };
+    /*
+     * Decimation factors of the overview levels. Factors <= 1 are ignored.
+     */
+    std::vector< int > decimations = { 2, 4, 8 };
+    /*
+     * The histogram bins of the fragment stats sidecar, or 0 for no stats.
+     */
+    int statsbins = 16;
+    /*
+     * Writer threads
+     */
+    int threads = 1;
+    /*
+     * The memory budget of fragment buffers, in bytes. This must fit at
+     * least a lane of the full resolution cube.
+     */
+    std::size_t memory = std::size_t(1) << 32;
+};
+
+struct ingest_stats {
+    std::size_t traces    = 0;
+    std::size_t fragments = 0;
+    std::size_t bytes     = 0;
+    /*
+     * The number of reads of the file
+     */
+    int passes = 0;
+};
+
+/*
+ * Ingest the SEG-Y file segy of len bytes, as described by the scan
+ * manifest, and put the fragments and the manifest in the sink. Returns the
+ * manifest as written, i.e. with the overview levels, the fragment mask and
+ * the fragment stats added.
+ */
+std::string ingest(
+        const char* segy,
+        std::size_t len,
+        const std::string& manifest,
+        fragment_sink& sink,
+        const ingest_options& opts,
+        ingest_stats* stats = nullptr)
+noexcept (false);
+
+}
+
+#endif //ONESEISMIC_INGEST_HPP
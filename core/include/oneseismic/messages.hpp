@@ -1,6 +1,9 @@
 #ifndef ONESEISMIC_MESSAGES_HPP
 #define ONESEISMIC_MESSAGES_HPP
 
+#include <array>
+#include <cstdint>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -37,11 +40,80 @@ struct common_task {
     std::vector< int > shape;
     std::vector< int > shape_cube;
     std::string        function;
+    /*
+     * The sample encoding of the result, see encoding.hpp. This field is
+     * optional in messages, and defaults to f32.
+     */
+    std::string        format = "f32";
+    /*
+     * The decimation factor of the overview level to read from. This is set
+     * by the planner, and 1 means the full resolution cube. For decimated
+     * levels, shape_cube is the shape of the decimated cube.
+     */
+    int                decimation = 1;
+    /*
+     * The amplitude attribute to reduce the samples to, see attributes.hpp,
+     * over windows of attribute_window samples in z. Both fields are optional
+     * in messages, and default to no reduction. Windows must divide the
+     * fragment height, so that no window spans two fragments. Horizons reduce
+     * their whole window, and ignore attribute_window.
+     */
+    std::string        attribute = "none";
+    int                attribute_window = 1;
+    /*
+     * The fragment-existence bitmap of the fragment columns (i, j) of the
+     * level, as hex, set by the planner from the manifest of sparse cubes.
+     * Bit n = i * columns(j) + j is bit n % 8 of byte n / 8, and is set when
+     * the column is stored. Absent fragments are never planned, and the mask
+     * is forwarded so that workers do not prefetch them either, and so that
+     * well paths and polylines can read the samples of absent fragments as
+     * fill_value when they interpolate. Both fields are optional in messages,
+     * and an empty mask means all fragments are stored.
+     */
+    std::string        fragment_mask;
+    float              fill_value = 0;
 
     std::string pack() const noexcept(false);
     void unpack(const char* fst, const char* lst) noexcept (false);
 };
 
+/*
+ * The decoded fragment_mask of a task, which answers if the fragment column
+ * (i, j) of the level of the task is stored. An empty mask has all columns.
+ * Decoding throws bad_message if the mask does not fit the fragment columns
+ * of the cube (shape_cube, shape) of the task, or is not hex.
+ */
+class fragment_mask {
+public:
+    fragment_mask() = default;
+    explicit fragment_mask(const common_task& task) noexcept (false);
+
+    bool stored(int i, int j) const noexcept (true);
+
+private:
+    std::vector< bool > bits;
+    int columns = 0;
+};
+
+/*
+ * A phase of a progressive process. Progressive processes are planned as a
+ * small, coarse phase read from an overview level, followed by the full
+ * request, so that clients can show a preview while the rest of the result
+ * is being computed. The tasks of a phase are always scheduled before the
+ * tasks of the next phase.
+ *
+ * The phase describes its slice of the response like the process header does
+ * for the full response. Every result bundle carries the decimation of the
+ * phase it belongs to.
+ */
+struct process_phase {
+    int                ntasks;
+    int                decimation;
+    std::vector< int > shape;
+    std::vector< std::vector< int > > index;
+    int                lineno = std::numeric_limits< int >::min();
+};
+
 /*
  * The process header, which should be output by the scheduler/planner. It
  * describes the number of tasks the process has been split into and advices
@@ -58,6 +130,35 @@ struct process_header {
     int                ntasks;
     std::vector< int > shape;
     std::vector< std::vector< int > > index;
+    /*
+     * The sample encoding used for the values in the response, so that
+     * clients know how to decode them.
+     */
+    std::string        format = "f32";
+    /*
+     * The decimation factor of the overview level the response is read from.
+     * The index is always the labels or coordinates of the decimated cube.
+     */
+    int                decimation = 1;
+    /*
+     * The phases of a progressive process, in scheduling order. This is empty
+     * for regular, single-phase processes. The shape, index and decimation of
+     * the header always describe the final (last) phase, and ntasks is the
+     * total number of tasks of all phases.
+     */
+    std::vector< process_phase > phases;
+    /*
+     * The label of the line of a slice, which on overview levels is the
+     * closest line at or before the requested one. Other functions leave it
+     * unset, and then it is not packed.
+     */
+    int                lineno = std::numeric_limits< int >::min();
+    /*
+     * The value of the samples of fragments that are not stored in sparse
+     * cubes. The planner leaves them out of the process, so clients fill the
+     * parts of the result that no bundle covers with it.
+     */
+    float              fill_value = 0;
 
     std::string pack() const noexcept(false);
     void unpack(const char* fst, const char* lst) noexcept (false);
@@ -69,6 +170,31 @@ struct slice_task : public common_task {
 
     int dim;
     int lineno;
+    /*
+     * The (optional) minimum shape of the output. When set, the planner picks
+     * the coarsest overview level where the slice is still at least this
+     * large, e.g. the resolution of the screen it will be shown on.
+     */
+    std::vector< int > target_shape;
+    /*
+     * Plan the slice progressively - read a coarse preview from the coarsest
+     * overview level first, then the slice as requested.
+     */
+    bool progressive = false;
+    /*
+     * The (optional) z-range [zmin, zmax] of the slice, in sample labels. Only
+     * applies to slices along the lateral dimensions.
+     */
+    int zmin = std::numeric_limits< int >::min();
+    int zmax = std::numeric_limits< int >::max();
+    /*
+     * The (optional) region of interest, as the labels [first, last] of the
+     * two dimensions of the slice, and the (optional) stride of the two
+     * dimensions, e.g. for a zoomed-in view or a sparse preview. The z-range
+     * of a lateral slice is the intersection of the roi and [zmin, zmax].
+     */
+    std::vector< std::array< int, 2 > > roi;
+    std::vector< int > stride;
 
     std::string pack() const noexcept(false);
     void unpack(const char* fst, const char* lst) noexcept (false);
@@ -80,6 +206,172 @@ struct curtain_task : public common_task {
 
     std::vector< int > dim0s;
     std::vector< int > dim1s;
+    /*
+     * The (optional) minimum shape (traces, samples) of the output. See
+     * slice_task.
+     */
+    std::vector< int > target_shape;
+    /* The (optional) z-range [zmin, zmax], in sample labels */
+    int zmin = std::numeric_limits< int >::min();
+    int zmax = std::numeric_limits< int >::max();
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * A horizon is a surface through the cube, picked by an interpreter, with
+ * (at most) one z per trace. It is given on the grid dim0s x dim1s (line
+ * numbers, like the curtain), and the surface is row-major with one z per
+ * grid point, in the units of the third dimension (e.g. time in ms).
+ *
+ * Points where z is outside the samples of the cube, such as the customary
+ * -999.25, are holes in the surface and are not extracted.
+ *
+ * The window is the number of samples to extract above and below the
+ * surface, so the response has 2 * window + 1 samples per point, or is just
+ * a map of the amplitudes on the surface when the window is 0.
+ */
+struct horizon_task : public common_task {
+    horizon_task() = default;
+    explicit horizon_task(const common_task& t) : common_task(t) {}
+
+    std::vector< int >   dim0s;
+    std::vector< int >   dim1s;
+    std::vector< float > surface;
+    int                  window = 0;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * A well path is a list of points (x, y, z) through the cube, which need not
+ * be on the grid. The samples are trilinearly interpolated from the 8
+ * neighbouring samples of every point.
+ *
+ * The points are given either as grid coordinates, i.e. fractional indices
+ * into the cube, as label coordinates, i.e. fractional line numbers and
+ * sample labels like in the manifest, or as world coordinates, i.e. (x, y) in
+ * the projected coordinates of the survey (see world_transform) and z as a
+ * sample label. Points outside the cube are holes and are not extracted.
+ */
+struct wellpath_task : public common_task {
+    wellpath_task() = default;
+    explicit wellpath_task(const common_task& t) : common_task(t) {}
+
+    std::vector< std::array< double, 3 > > points;
+    /* grid, label or world */
+    std::string coordinates = "label";
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * A batch of arbitrary points (dim0s[i], dim1s[i], dim2s[i]) in the cube,
+ * e.g. for sampling training data. The points are given either as grid
+ * coordinates, i.e. indices into the cube, or as label coordinates, i.e. line
+ * numbers and sample labels like in the manifest. Unlike the well path, the
+ * points are on the grid, and no interpolation is done.
+ */
+struct points_task : public common_task {
+    points_task() = default;
+    explicit points_task(const common_task& t) : common_task(t) {}
+
+    std::vector< int > dim0s;
+    std::vector< int > dim1s;
+    std::vector< int > dim2s;
+    /* grid or label */
+    std::string coordinates = "grid";
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * A curtain along a polyline through the cube, e.g. a line drawn on a map.
+ * The points are the (x, y) control points of the polyline, given either as
+ * grid coordinates (fractional indices into the cube), label coordinates
+ * (fractional line numbers) or world coordinates (see world_transform), and
+ * need not be on the grid.
+ *
+ * The planner densifies the polyline to points spacing apart along the line,
+ * starting at the first control point and ending at the last, and the traces
+ * are bilinearly interpolated from the 4 neighbouring traces of every point.
+ * The spacing is in world units for world coordinates, and in traces
+ * otherwise.
+ */
+struct polyline_task : public common_task {
+    polyline_task() = default;
+    explicit polyline_task(const common_task& t) : common_task(t) {}
+
+    std::vector< std::array< double, 2 > > points;
+    float spacing = 1;
+    /* grid, label or world */
+    std::string coordinates = "label";
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * An area of interest, e.g. a lease, as every trace inside the polygon,
+ * cropped to the samples in [zmin, zmax]. The polygon is the (x, y) vertices
+ * in grid, label or world coordinates (see wellpath_task), is closed
+ * implicitly, and may extend beyond the cube. A trace is inside when its
+ * grid position is inside the polygon by the even-odd rule, or on its edge.
+ *
+ * zmin and zmax are sample labels, and default to the whole trace.
+ */
+struct area_task : public common_task {
+    area_task() = default;
+    explicit area_task(const common_task& t) : common_task(t) {}
+
+    std::vector< std::array< double, 2 > > polygon;
+    /* grid, label or world */
+    std::string coordinates = "label";
+    int zmin = std::numeric_limits< int >::min();
+    int zmax = std::numeric_limits< int >::max();
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * Summary statistics of the cube, or of the line lineno of dimension dim,
+ * for histograms and colour scaling. Statistics are answered from the
+ * fragment statistics sidecar written by the upload, without reading any
+ * fragments, so a line is summarised by the layer of fragments it is in.
+ * The histogram has `bins` bins, evenly spaced between min and max.
+ *
+ * A dim of -1 means the whole cube, and is the default.
+ */
+struct stats_task : public common_task {
+    stats_task() = default;
+    explicit stats_task(const common_task& t) : common_task(t) {}
+
+    int dim    = -1;
+    int lineno = 0;
+    int bins   = 64;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * A batch of queries against the same cube, e.g. a fence of curtains or a set
+ * of inlines. The tasks are complete, packed tasks with their own pids, and
+ * must read the same cube (guid) with the same fragment shape. The batch is
+ * planned as one process, so that every fragment is only read once, no matter
+ * how many of the queries need it, and the results are routed to the pids of
+ * the queries.
+ */
+struct batch_task : public common_task {
+    batch_task() = default;
+    explicit batch_task(const common_task& t) : common_task(t) {}
+
+    std::vector< std::string > tasks;
 
     std::string pack() const noexcept(false);
     void unpack(const char* fst, const char* lst) noexcept (false);
@@ -91,6 +383,18 @@ struct slice_fetch : public slice_task {
     slice_fetch() = default;
     explicit slice_fetch(const slice_task& t) : slice_task(t) {}
 
+    /*
+     * The region of interest as the samples [begin, end) of the two
+     * dimensions of the slice, as indices in the (possibly decimated) cube,
+     * at every step'th sample from begin. Fragments are cropped to the
+     * region, and end past the end of the cube means the whole dimension.
+     */
+    std::array< int, 2 > begin = { 0, 0 };
+    std::array< int, 2 > end   = {
+        std::numeric_limits< int >::max(),
+        std::numeric_limits< int >::max(),
+    };
+    std::array< int, 2 > step  = { 1, 1 };
     std::vector< std::vector< int > > ids;
 
     std::string pack() const noexcept (false);
@@ -104,6 +408,15 @@ struct tile {
     int superstride;
     int substride;
     std::vector< float > v;
+
+    /*
+     * The encoded samples, when the output is not f32. When a tile is
+     * encoded, v is empty and the samples are packed from encoded instead.
+     * See encoding.hpp for the interpretation of scale and offset.
+     */
+    float scale  = 1;
+    float offset = 0;
+    std::vector< std::int16_t > encoded;
 };
 
 struct slice_tiles {
@@ -112,6 +425,12 @@ struct slice_tiles {
      */
     std::vector< int > shape;
     std::vector< tile > tiles;
+    std::string format = "f32";
+    /*
+     * The decimation of the overview level the tiles are read from, which
+     * identifies the phase in progressive processes.
+     */
+    int decimation = 1;
 
     std::string pack() const noexcept(false);
     void unpack(const char* fst, const char* lst) noexcept (false);
@@ -131,6 +450,13 @@ struct curtain_fetch : public curtain_task {
     curtain_fetch() = default;
     explicit curtain_fetch(const curtain_task& t) : curtain_task(t) {}
 
+    /*
+     * The samples [zbegin, zend) of the z-range, as indices in the (possibly
+     * decimated) cube. Traces are cropped to this range, and zend past the
+     * end of the cube means the whole trace.
+     */
+    int zbegin = 0;
+    int zend   = std::numeric_limits< int >::max();
     std::vector< single > ids;
 
     std::string pack() const noexcept(false);
@@ -140,10 +466,306 @@ struct curtain_fetch : public curtain_task {
 struct trace {
     std::vector< int > coordinates;
     std::vector< float > v;
+
+    /* Encoded samples, see tile */
+    float scale  = 1;
+    float offset = 0;
+    std::vector< std::int16_t > encoded;
 };
 
 struct curtain_traces {
     std::vector< trace > traces;
+    std::string format = "f32";
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * A column of fragments (the same i, j) that is intersected by the horizon,
+ * with the fragments (k) intersected by the surface +- window, and the points
+ * of the surface in this column. Points are (position, i', j', k), where
+ * position is the row-major index of the point in the horizon grid, (i', j')
+ * is the trace in the fragment, and k is the index of the surface sample in
+ * the cube.
+ */
+struct horizon_column {
+    std::vector< int > id;
+    std::vector< int > ks;
+    std::vector< std::array< int, 4 > > points;
+};
+
+/*
+ * A column of fragments (the same i, j) with traces inside an area, with the
+ * fragments (k) of the z-range, and the bitmask of the traces inside the
+ * area. Trace (i', j') is bit i' * fragment_shape[1] + j' of the mask, which
+ * is stored in 64-bit words.
+ */
+struct area_column {
+    std::vector< int >           id;
+    std::vector< int >           ks;
+    std::vector< std::uint64_t > mask;
+};
+
+/*
+ * The planned area_task, with the samples [zbegin, zend) of the z-range as
+ * indices into the cube, and the columns of the traces inside the area.
+ */
+struct area_fetch : public area_task {
+    area_fetch() = default;
+    explicit area_fetch(const area_task& t) : area_task(t) {}
+
+    int zbegin = 0;
+    int zend   = 0;
+    std::vector< area_column > ids;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * The share of a query in a batch_fetch. The fetch is the packed X_fetch of
+ * the query, restricted to the fragments of this task, and its result is
+ * written as part (n/m) of the query process pid.
+ */
+struct batch_query {
+    std::string pid;
+    std::string part;
+    std::string function;
+    std::string fetch;
+};
+
+/*
+ * The planned batch_task. Every fragment of the batch is in exactly one
+ * batch_fetch, together with the share of all the queries that read it.
+ */
+struct batch_fetch : public common_task {
+    batch_fetch() = default;
+    explicit batch_fetch(const common_task& t) : common_task(t) {}
+
+    std::vector< batch_query > queries;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * The planned horizon_task. The surface (and grid) are only needed for
+ * planning and the header, so they are cleared, and every task only carries
+ * the points of its own columns.
+ */
+struct horizon_fetch : public horizon_task {
+    horizon_fetch() = default;
+    explicit horizon_fetch(const horizon_task& t) : horizon_task(t) {}
+
+    std::vector< horizon_column > ids;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * The planned wellpath_task. The points are in grid coordinates, and only the
+ * points of this task are included, together with their position in the
+ * well path (index). The ids are the fragments of all the samples needed to
+ * interpolate the points.
+ */
+struct wellpath_fetch : public wellpath_task {
+    wellpath_fetch() = default;
+    explicit wellpath_fetch(const wellpath_task& t) : wellpath_task(t) {}
+
+    std::vector< int > index;
+    std::vector< std::vector< int > > ids;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * The points of a points_task in a single fragment, as the offsets of the
+ * samples in the fragment and the positions of the points in the request.
+ */
+struct points_fragment {
+    std::vector< int > id;
+    std::vector< int > offsets;
+    std::vector< int > index;
+};
+
+/*
+ * The planned points_task. The points are binned by fragment in ids, and the
+ * dim0s, dim1s and dim2s are cleared.
+ */
+struct points_fetch : public points_task {
+    points_fetch() = default;
+    explicit points_fetch(const points_task& t) : points_task(t) {}
+
+    std::vector< points_fragment > ids;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * The planned polyline_task. The points are the densified path in grid
+ * coordinates, and only the points of this task are included, together with
+ * their position in the densified path (index). The ids are the fragments of
+ * all the traces needed to interpolate the points.
+ */
+struct polyline_fetch : public polyline_task {
+    polyline_fetch() = default;
+    explicit polyline_fetch(const polyline_task& t) : polyline_task(t) {}
+
+    std::vector< int > index;
+    std::vector< std::vector< int > > ids;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * One sample per point, for requests of arbitrary points, with the position
+ * of every point in the request (index), so a full response is assembled
+ * with:
+ *      out = empty(npoints)
+ *      out[index] = v
+ */
+struct point_values {
+    std::vector< int >   index;
+    std::vector< float > v;
+    std::string format = "f32";
+
+    /* Encoded samples, see tile */
+    float scale  = 1;
+    float offset = 0;
+    std::vector< std::int16_t > encoded;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * The interpolated traces of a polyline, with the position of every trace in
+ * the densified path (index), its (x, y) in grid coordinates (points), and
+ * samples values per trace. A full response is assembled with:
+ *      out = empty((npoints, samples))
+ *      out[index] = v.reshape(-1, samples)
+ */
+struct polyline_traces {
+    std::vector< int >   index;
+    std::vector< std::array< float, 2 > > points;
+    int                  samples = 0;
+    std::vector< float > v;
+    std::string format = "f32";
+
+    /* Encoded samples, see tile */
+    float scale  = 1;
+    float offset = 0;
+    std::vector< std::int16_t > encoded;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * The traces of an area, as a structure of arrays. Trace n is at the grid
+ * position (dim0s[n], dim1s[n]), with its samples at v[n * samples:], and
+ * the traces are in no particular order. A full response is assembled by
+ * concatenating the traces of all bundles.
+ */
+struct area_traces {
+    std::vector< int >   dim0s;
+    std::vector< int >   dim1s;
+    int                  samples = 0;
+    std::vector< float > v;
+    std::string format = "f32";
+
+    /* Encoded samples, see tile */
+    float scale  = 1;
+    float offset = 0;
+    std::vector< std::int16_t > encoded;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * The samples around the horizon, already assembled by the worker. index is
+ * the position (in the horizon grid) of every point in this bundle, and v
+ * holds the samples of every point, window samples per point, with the
+ * points in the same order as index. Window samples above or below the cube
+ * are 0.
+ *
+ * A full response is then assembled with:
+ *      out = empty((len(dim0s) * len(dim1s), window))
+ *      out[index] = v.reshape(-1, window)
+ */
+struct horizon_values {
+    std::vector< int >   index;
+    int                  window = 1;
+    std::vector< float > v;
+    std::string format = "f32";
+
+    /* Encoded samples, see tile */
+    float scale  = 1;
+    float offset = 0;
+    std::vector< std::int16_t > encoded;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * The stats of the fragments in the layer of dimension dim, or of all the
+ * fragments for dim = -1. The stats are read from the sidecar, which is the
+ * only object fetched. The sidecar is described by bins, the number of bins
+ * of the histogram of every fragment.
+ */
+struct stats_fetch : public stats_task {
+    stats_fetch() = default;
+    explicit stats_fetch(const stats_task& t) : stats_task(t) {}
+
+    int layer = 0;
+    int sidecar_bins = 16;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * The summary statistics, and the histogram as counts of the bins between
+ * the edges. The histogram is merged from the coarse histograms of the
+ * fragments, by spreading their bins evenly across the output bins, so the
+ * counts are approximate, but the count, min, max, mean and rms are exact.
+ *
+ * A clip for the colour scale is read off the cumulative counts, e.g. the
+ * 1st and 99th percentile.
+ */
+struct stats_values {
+    std::int64_t count = 0;
+    float        min   = 0;
+    float        max   = 0;
+    float        mean  = 0;
+    float        rms   = 0;
+    std::vector< float >        edges;
+    std::vector< std::int64_t > counts;
+
+    std::string pack() const noexcept(false);
+    void unpack(const char* fst, const char* lst) noexcept (false);
+};
+
+/*
+ * The result of a batch_fetch, one per query in the task. The body is the
+ * packed result of the query (slice_tiles, curtain_traces etc), and should be
+ * written as part of the process pid, like the result of a plain task.
+ */
+struct batch_result {
+    std::string pid;
+    std::string part;
+    std::string body;
+};
+
+struct batch_results {
+    std::vector< batch_result > results;
 
     std::string pack() const noexcept(false);
     void unpack(const char* fst, const char* lst) noexcept (false);
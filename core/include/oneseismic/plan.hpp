@@ -14,6 +14,24 @@ struct not_found : public std::out_of_range {
 std::vector< std::string >
 mkschedule(const char* doc, int len, int task_size) noexcept (false);
 
+/*
+ * Plan a batch of queries (a batch_task, see messages.hpp) as one process,
+ * where every fragment is read by exactly one task. The output is the
+ * batch_fetch tasks, followed by the headers of the queries, in the order of
+ * the queries in the batch.
+ */
+std::vector< std::string >
+mkbatch(const char* doc, int len, int task_size) noexcept (false);
+
+/*
+ * The canonical hash of a query, as a 64-character hex string. The hash is
+ * computed from the normalised task, i.e. with all the defaults of the
+ * function parameters filled in, so identical queries hash the same, even
+ * when they come from different requests (pids) and users (tokens). The
+ * manifest is a part of the hash, so the hash changes with the cube.
+ */
+std::string query_hash(const char* doc, int len) noexcept (false);
+
 }
 
 #endif //ONESEISMIC_PLAN_HPP
@@ -1,14 +1,45 @@
 #ifndef ONESEISMIC_PROC_HPP
 #define ONESEISMIC_PROC_HPP
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include <oneseismic/heatmap.hpp>
+#include <oneseismic/tracing.hpp>
+
 #include <oneseismic/messages.hpp>
 
 namespace one {
 
+/*
+ * Per-task statistics, recorded by the proc as it runs. Timings are wall
+ * time in milliseconds, and all counters are reset by init().
+ *
+ * Allocations are only counted when the library is built with
+ * ONESEISMIC_COUNT_ALLOCATIONS, which replaces the global operator new with
+ * one that counts calls per thread. Otherwise allocations is always 0.
+ */
+struct proc_stats {
+    double      init_ms     = 0;
+    /* add_ms is the sum over all add()s, add_max_ms the slowest */
+    double      add_ms      = 0;
+    double      add_max_ms  = 0;
+    int         adds        = 0;
+    double      pack_ms     = 0;
+    /* fragment bytes given to add(), and bytes returned by pack() */
+    std::size_t bytes_in    = 0;
+    std::size_t bytes_out   = 0;
+    std::size_t allocations = 0;
+};
+
+/*
+ * The number of allocations made by the calling thread so far, or 0 when
+ * allocations are not counted.
+ */
+std::size_t thread_allocations() noexcept (true);
+
 class proc {
 public:
     /*
@@ -23,7 +54,7 @@ public:
     std::unique_ptr< proc > make(const std::string& kind)
     noexcept (false);
 
-    virtual void init(const char* msg, int len) = 0;
+    void init(const char* msg, int len) noexcept (false);
 
     /*
      * Get the list of fragment IDs for this process as a ';'-separated string.
@@ -39,6 +70,19 @@ public:
      */
     const std::string& fragments() const;
 
+    /*
+     * Get the fragment IDs that the next query, in direction, is likely to
+     * read, in the same format as fragments(). This is used to speculatively
+     * prefetch fragments into a cache before they are requested, e.g. the
+     * neighbouring fragment layer when scrolling through inlines. The
+     * direction is +1 for increasing line numbers, -1 for decreasing, and 0
+     * for both.
+     *
+     * The string is empty if the process has no sensible prediction, which is
+     * the default.
+     */
+    std::string prefetch(int direction) const noexcept (false);
+
     /*
      * Add (or register) a downloaded fragment. This function is responsible
      * for extracting data from the fragment, and storing it so that when all
@@ -56,17 +100,50 @@ public:
      * Chunks can be added in any order, but chunks and ids must always
      * correspond.
      */
-    virtual void add(int key, const char* chunk, int len) = 0;
-    virtual std::string pack() = 0;
+    void add(int key, const char* chunk, int len) noexcept (false);
+    std::string pack() noexcept (false);
+
+    /*
+     * The statistics of the task since the last init()
+     */
+    const proc_stats& stats() const noexcept (true);
+
+    /*
+     * The tracing spans of the task since the last init(). Spans are only
+     * recorded when the library is built with ONESEISMIC_TRACING.
+     */
+    const tracing::recorder& tracer() const noexcept (true);
 
     virtual ~proc() = default;
 
 protected:
     /*
-     * Set the fragment shape. This is cleared by clear() and must be set for
-     * every init(). It sets the prefix for fragment-ID generation.
+     * The process-specific implementations of init(), add(), and pack(). The
+     * public functions record statistics around these.
+     */
+    virtual void do_init(const char* msg, int len) = 0;
+    virtual void do_add(int key, const char* chunk, int len) = 0;
+    virtual std::string do_pack() = 0;
+    /*
+     * The (i, j, k) of the fragments to prefetch, see prefetch()
      */
-    void set_fragment_shape(const std::string&) noexcept (false);
+    virtual std::vector< std::vector< int > > do_prefetch(int direction) const;
+
+    /*
+     * Set the fragment shape and resolution. This is cleared by clear() and
+     * must be set for every init(). It sets the prefix for fragment-ID
+     * generation.
+     *
+     * The resolution is the decimation factor of the overview level of the
+     * task, where 1 is the full-resolution source cube (src/), and n is the
+     * level decimated by n (lod<n>/).
+     *
+     * The guid of the task only identifies the cube in the fragment access
+     * heatmap, if one is installed (see heatmap.hpp), and the fragment mask
+     * of the task decides which fragments can be prefetched.
+     */
+    void set_fragment_shape(const common_task& task, const std::string& shape)
+    noexcept (false);
     /*
      * Register a fragment id, for url generation. Duplicates will not be
      * removed, this is effectively an accumulating ';'.join([prefix + id]...)
@@ -75,11 +152,23 @@ protected:
      * handles are re-used.
      */
     void add_fragment(const std::string& id) noexcept (false);
+    /*
+     * Register the fragment (i, j, k), which also counts the access in the
+     * fragment access heatmap.
+     */
+    void add_fragment(const std::vector< int >& id) noexcept (false);
     void clear() noexcept (true);
 
 private:
     std::string prefix;
     std::string frags;
+    proc_stats  statistics;
+    tracing::recorder spans;
+
+    fragment_mask      mask;
+
+    heatmap::recorder* heat = nullptr;
+    int heatcube = -1;
 };
 
 }
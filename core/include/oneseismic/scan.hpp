@@ -0,0 +1,63 @@
+#ifndef ONESEISMIC_SCAN_HPP
+#define ONESEISMIC_SCAN_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace one {
+
+/*
+ * Scan
+ * ----
+ * The scan reads the binary header and all the trace headers of a SEG-Y
+ * file, and reports the layout and line numbers of the file as JSON, for
+ * ingestion. The report is the same as `python -m oneseismic.scan`, i.e.
+ * lineset.report() with the guid:
+ *
+ *  {
+ *      "byteorder": "big",
+ *      "format": 1,
+ *      "samples": 850,
+ *      "sampleinterval": 4000,
+ *      "byteoffset-first-trace": 3600,
+ *      "dimensions": [[inlines], [crosslines], [samples]],
+ *      "key1-last-trace": { "<inline>": traceno },
+ *      "key-words": [189, 193],
+ *      "transform": [x0, dx/di, dx/dj, y0, dy/di, dy/dj],
+ *      "guid": "<hex digest>"
+ *  }
+ *
+ * The file is given as a buffer, which is usually memory mapped. The trace
+ * headers are at a fixed stride, so the headers are read by threads in
+ * parallel chunks of the file, and merged.
+ */
+struct scan_options {
+    int primary   = 189;
+    int secondary = 193;
+    bool big_endian = true;
+    int threads = 1;
+    /*
+     * The digest of the file, for the guid, one of:
+     *
+     *  sha1        the sha1 of the file, which is the guid of the python
+     *              scan. This is computed in a single thread, but alongside
+     *              the header scan.
+     *  sha1-tree   the sha1 of the sha1s of 64 MB blocks of the file, which
+     *              is computed in parallel. The guid is the same for any
+     *              number of threads, but different from the sha1 guid, so
+     *              the same file scanned with both gets two guids.
+     */
+    std::string digest = "sha1";
+};
+
+std::string scan(const char* segy, std::size_t len, const scan_options&)
+    noexcept (false);
+
+/*
+ * The sha1 of len bytes, as a 40-character hex string
+ */
+std::string sha1(const char* data, std::size_t len) noexcept (true);
+
+}
+
+#endif //ONESEISMIC_SCAN_HPP
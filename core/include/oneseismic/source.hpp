@@ -0,0 +1,118 @@
+#ifndef ONESEISMIC_SOURCE_HPP
+#define ONESEISMIC_SOURCE_HPP
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace one {
+
+/*
+ * Fragment sources
+ * ----------------
+ * In the service, fragments are downloaded from blob storage by the (go)
+ * workers, and handed to proc::add() as byte buffers. Tools that run the
+ * query engine outside the service, such as oneseismic-query, instead read
+ * fragments through a fragment_source.
+ *
+ * Objects are addressed by their path relative to the root of the storage,
+ * i.e. the same name they would have in the blob container:
+ *
+ *      <guid>/manifest.json
+ *      <guid>/src/64-64-64/0-1-2.f32
+ *
+ * All sources must be safe to call get() on from multiple threads.
+ */
+class blob {
+public:
+    blob() = default;
+    blob(const char* data, std::size_t size, std::shared_ptr< const void > own)
+        : ptr(data), len(size), owner(std::move(own))
+    {}
+
+    const char* data() const noexcept (true) { return this->ptr; }
+    std::size_t size() const noexcept (true) { return this->len; }
+
+private:
+    const char* ptr = nullptr;
+    std::size_t len = 0;
+    /*
+     * Keeps the bytes alive for as long as the blob is in use, be it a
+     * buffer, a memory map, or an entry in a cache.
+     */
+    std::shared_ptr< const void > owner;
+};
+
+class fragment_source {
+public:
+    /*
+     * Get the object at path. Throws not_found if there is no such object.
+     */
+    virtual blob get(const std::string& path) noexcept (false) = 0;
+    virtual ~fragment_source() = default;
+};
+
+/*
+ * Read objects from files under a root directory, with a fresh read() for
+ * every get().
+ */
+class filesystem_source : public fragment_source {
+public:
+    explicit filesystem_source(std::string root);
+    blob get(const std::string& path) noexcept (false) override;
+
+private:
+    std::string root;
+};
+
+/*
+ * Memory-map objects from files under a root directory. Files are mapped on
+ * first access, and stay mapped for the lifetime of the source, so repeated
+ * reads of the same fragment are served from the page cache without copying.
+ */
+class mmap_source : public fragment_source {
+public:
+    explicit mmap_source(std::string root);
+    blob get(const std::string& path) noexcept (false) override;
+
+private:
+    std::string root;
+    std::mutex mtx;
+    std::map< std::string, blob > maps;
+};
+
+/*
+ * Keep objects in memory. Objects are either put() explicitly, e.g. by a
+ * generator of synthetic cubes, or read from a backing directory on first
+ * access and kept. Without a root, get() of an object that has not been put()
+ * fails with not_found.
+ *
+ * This takes storage out of the measurements entirely, which makes it a good
+ * fit for benchmarking the engine itself.
+ */
+class memory_source : public fragment_source {
+public:
+    memory_source() = default;
+    explicit memory_source(std::string root);
+
+    blob get(const std::string& path) noexcept (false) override;
+    void put(const std::string& path, std::string bytes) noexcept (false);
+
+private:
+    std::string root;
+    std::mutex mtx;
+    std::map< std::string, blob > objects;
+};
+
+/*
+ * Make a source by name, one of filesystem, mmap, memory. Throws
+ * std::invalid_argument on unknown names.
+ */
+std::unique_ptr< fragment_source >
+make_source(const std::string& kind, const std::string& root) noexcept (false);
+
+}
+
+#endif //ONESEISMIC_SOURCE_HPP
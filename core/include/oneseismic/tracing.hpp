@@ -0,0 +1,127 @@
+#ifndef ONESEISMIC_TRACING_HPP
+#define ONESEISMIC_TRACING_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace one {
+namespace tracing {
+
+/*
+ * Tracing spans
+ * -------------
+ * A span is the wall time of a named stage, e.g. building a plan or adding a
+ * fragment to a proc. Spans are recorded into the recorder that is current
+ * for the calling thread, which is set with a scope:
+ *
+ *      one::tracing::recorder rec;
+ *      {
+ *          one::tracing::scope scope(&rec);
+ *          auto sched = one::mkschedule(doc, len, task_size);
+ *      }
+ *      std::cout << rec.chrome_json(pid, "plan");
+ *
+ * Spans are only compiled into the library when it is built with
+ * ONESEISMIC_TRACING, otherwise ONESEISMIC_TRACE expands to nothing and
+ * recorders stay empty. When compiled in, a span without a current recorder
+ * costs a thread-local read.
+ *
+ * Recorders export the Chrome trace event format [1], which can be opened in
+ * chrome://tracing and https://ui.perfetto.dev. The oneseismic pid becomes the
+ * process and the part becomes the thread, so spans from the api and all the
+ * workers of a request line up in a single view when their exports are
+ * concatenated with merge(). Timestamps are from the system clock, and are
+ * only as aligned as the clocks of the machines.
+ *
+ * [1] https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+ */
+struct event {
+    const char*   category;
+    const char*   name;
+    /* microseconds since the unix epoch, and duration in microseconds */
+    std::int64_t  ts;
+    std::int64_t  dur;
+};
+
+class recorder {
+public:
+    void record(const event&) noexcept (false);
+    std::vector< event > events() const noexcept (false);
+    void clear() noexcept (true);
+
+    /*
+     * The recorded spans as a Chrome trace JSON array, tagged with the
+     * process pid and part, e.g. "0/4" for the first of four tasks.
+     */
+    std::string chrome_json(const std::string& pid, const std::string& part)
+    const noexcept (false);
+
+private:
+    mutable std::mutex mtx;
+    std::vector< event > evs;
+};
+
+/*
+ * Make the recorder current for the calling thread for the lifetime of the
+ * scope. Scopes nest, and the previous recorder is restored on exit.
+ */
+class scope {
+public:
+    explicit scope(recorder*) noexcept (true);
+    ~scope();
+
+    scope(const scope&) = delete;
+    scope& operator = (const scope&) = delete;
+
+private:
+    recorder* prev;
+};
+
+recorder* current() noexcept (true);
+
+/*
+ * Record the lifetime of the span into the current recorder, if any. The
+ * category and name must be string literals, or otherwise outlive the
+ * recorder.
+ */
+class span {
+public:
+    span(const char* category, const char* name) noexcept (true);
+    ~span();
+
+    span(const span&) = delete;
+    span& operator = (const span&) = delete;
+
+private:
+    recorder*   rec;
+    const char* category;
+    const char* name;
+    std::chrono::system_clock::time_point start;
+    std::chrono::steady_clock::time_point steady;
+};
+
+/*
+ * Merge the chrome_json() exports of several recorders, e.g. of the planner
+ * and all the workers of a request, into a single trace.
+ */
+std::string merge(const std::vector< std::string >& traces) noexcept (false);
+
+}
+}
+
+#define ONESEISMIC_TRACE_CONCAT_(x, y) x##y
+#define ONESEISMIC_TRACE_CONCAT(x, y) ONESEISMIC_TRACE_CONCAT_(x, y)
+
+#ifdef ONESEISMIC_TRACING
+    #define ONESEISMIC_TRACE(category, name) \
+        ::one::tracing::span ONESEISMIC_TRACE_CONCAT(oneseismic_span_, __LINE__)( \
+            category, name \
+        )
+#else
+    #define ONESEISMIC_TRACE(category, name) do {} while (false)
+#endif
+
+#endif //ONESEISMIC_TRACING_HPP
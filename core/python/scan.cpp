@@ -0,0 +1,59 @@
+#include "scan.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <thread>
+
+#include <oneseismic/scan.hpp>
+#include <oneseismic/source.hpp>
+
+namespace {
+
+char* copy(const std::string& x) noexcept (false) {
+    auto* s = new char[x.size() + 1];
+    std::memcpy(s, x.c_str(), x.size() + 1);
+    return s;
+}
+
+}
+
+scan_result oneseismic_scan(
+        const char* path,
+        int primary,
+        int secondary,
+        bool big_endian,
+        int threads,
+        const char* digest) {
+    scan_result result {};
+    try {
+        one::scan_options opts;
+        opts.primary    = primary;
+        opts.secondary  = secondary;
+        opts.big_endian = big_endian;
+        opts.threads    = threads > 0
+                        ? threads
+                        : int(std::max(1u, std::thread::hardware_concurrency()))
+                        ;
+        opts.digest     = digest;
+
+        /*
+         * The mmap source maps the file as-is, so path is relative to the
+         * working directory, like any other path
+         */
+        one::mmap_source source("");
+        const auto segy = source.get(path);
+        result.report = copy(one::scan(segy.data(), segy.size(), opts));
+    } catch (std::exception& e) {
+        result.err = copy(e.what());
+    }
+    return result;
+}
+
+void oneseismic_scan_cleanup(scan_result* result) {
+    if (!result) return;
+    delete[] result->err;
+    delete[] result->report;
+    *result = scan_result {};
+}
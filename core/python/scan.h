@@ -0,0 +1,44 @@
+#ifndef ONESEISMIC_PYTHON_SCAN_H
+#define ONESEISMIC_PYTHON_SCAN_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif //__cplusplus
+
+/*
+ * The C interface of the native scanner (see oneseismic/scan.hpp), which is
+ * built as the liboneseismic-scan shared library with BUILD_PYTHON, and
+ * loaded with ctypes by oneseismic.scan.native.
+ */
+struct scan_result {
+    /*
+     * The error message. On success, this is a nullptr. Checking err for null
+     * is the only correct way to determine if the function succeeded or not.
+     */
+    const char* err;
+    /*
+     * The report as null-terminated JSON, or a nullptr on error
+     */
+    char* report;
+};
+
+/*
+ * Scan the SEG-Y file at path, which is memory mapped. The digest is sha1 or
+ * sha1-tree, and threads < 1 means hardware concurrency.
+ */
+struct scan_result oneseismic_scan(
+    const char* path,
+    int primary,
+    int secondary,
+    bool big_endian,
+    int threads,
+    const char* digest
+);
+void oneseismic_scan_cleanup(struct scan_result*);
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+#endif //ONESEISMIC_PYTHON_SCAN_H
@@ -0,0 +1,80 @@
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include <oneseismic/process.hpp>
+
+/*
+ * Allocation counting for proc_stats. When ONESEISMIC_COUNT_ALLOCATIONS is
+ * set, the global operator new is replaced with one that counts the calls
+ * made by every thread, which is enough to tell if a task allocates per
+ * fragment or per trace rather than up front. Replacing operator new affects
+ * the whole program, which is why this is opt-in.
+ */
+
+namespace one {
+
+namespace {
+
+thread_local std::size_t allocations = 0;
+
+}
+
+std::size_t thread_allocations() noexcept (true) {
+    return allocations;
+}
+
+#ifdef ONESEISMIC_COUNT_ALLOCATIONS
+
+namespace {
+
+void* counted_alloc(std::size_t size) noexcept (true) {
+    allocations += 1;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+}
+
+#endif // ONESEISMIC_COUNT_ALLOCATIONS
+
+}
+
+#ifdef ONESEISMIC_COUNT_ALLOCATIONS
+
+void* operator new(std::size_t size) noexcept (false) {
+    void* p = one::counted_alloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) noexcept (false) {
+    void* p = one::counted_alloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept (true) {
+    return one::counted_alloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept (true) {
+    return one::counted_alloc(size);
+}
+
+void operator delete(void* p) noexcept (true) {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept (true) {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept (true) {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept (true) {
+    std::free(p);
+}
+
+#endif // ONESEISMIC_COUNT_ALLOCATIONS
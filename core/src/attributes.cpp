@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/format.h>
+
+#include <oneseismic/attributes.hpp>
+
+namespace one {
+
+namespace {
+
+/*
+ * Fold n samples with op, in lanes independent accumulators, which are then
+ * combined. The fixed-size inner loop over the lanes is what the compiler
+ * turns into vector instructions - a plain accumulation loop would be a
+ * dependency chain that can only be vectorised with -ffast-math.
+ */
+constexpr std::size_t lanes = 8;
+
+template < typename Op, typename Combine >
+float fold(
+        const float* x,
+        std::size_t n,
+        float init,
+        Op op,
+        Combine combine)
+noexcept (true) {
+    float acc[lanes];
+    std::fill(acc, acc + lanes, init);
+
+    std::size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+        for (std::size_t l = 0; l < lanes; ++l)
+            acc[l] = op(acc[l], x[i + l]);
+    }
+    for (; i < n; ++i)
+        acc[0] = op(acc[0], x[i]);
+
+    float result = init;
+    for (std::size_t l = 0; l < lanes; ++l)
+        result = combine(result, acc[l]);
+    return result;
+}
+
+float sum(float acc, float x) noexcept (true) {
+    return acc + x;
+}
+
+float max(float acc, float x) noexcept (true) {
+    return std::max(acc, x);
+}
+
+float rms(const float* x, std::size_t n) noexcept (true) {
+    const auto squares = fold(x, n, 0.0f, [](float acc, float v) {
+        return acc + v * v;
+    }, sum);
+    return std::sqrt(squares / n);
+}
+
+float mean(const float* x, std::size_t n) noexcept (true) {
+    return fold(x, n, 0.0f, sum, sum) / n;
+}
+
+float maxabs(const float* x, std::size_t n) noexcept (true) {
+    return fold(x, n, 0.0f, [](float acc, float v) {
+        return std::max(acc, std::abs(v));
+    }, max);
+}
+
+float sumpos(const float* x, std::size_t n) noexcept (true) {
+    return fold(x, n, 0.0f, [](float acc, float v) {
+        return acc + std::max(v, 0.0f);
+    }, sum);
+}
+
+float sumneg(const float* x, std::size_t n) noexcept (true) {
+    return fold(x, n, 0.0f, [](float acc, float v) {
+        return acc + std::min(v, 0.0f);
+    }, sum);
+}
+
+template < typename Kernel >
+void reduce_windows(
+        Kernel kernel,
+        const float* src,
+        std::size_t n,
+        std::size_t window,
+        float* dst)
+noexcept (true) {
+    for (std::size_t i = 0; i < n; i += window)
+        *dst++ = kernel(src + i, std::min(window, n - i));
+}
+
+}
+
+attribute parse_attribute(const std::string& name) noexcept (false) {
+    if (name == "none")   return attribute::none;
+    if (name == "rms")    return attribute::rms;
+    if (name == "mean")   return attribute::mean;
+    if (name == "maxabs") return attribute::maxabs;
+    if (name == "sumpos") return attribute::sumpos;
+    if (name == "sumneg") return attribute::sumneg;
+
+    const auto msg = "unknown attribute '{}', expected one of "
+                     "none, rms, mean, maxabs, sumpos, sumneg";
+    throw std::invalid_argument(fmt::format(msg, name));
+}
+
+const char* to_string(attribute a) noexcept (true) {
+    switch (a) {
+        case attribute::none:   return "none";
+        case attribute::rms:    return "rms";
+        case attribute::mean:   return "mean";
+        case attribute::maxabs: return "maxabs";
+        case attribute::sumpos: return "sumpos";
+        case attribute::sumneg: return "sumneg";
+    }
+    return "unknown";
+}
+
+void reduce(
+        attribute a,
+        const float* src,
+        std::size_t n,
+        std::size_t window,
+        float* dst)
+noexcept (false) {
+    if (window == 0)
+        throw std::invalid_argument("reduce: window must be > 0");
+
+    switch (a) {
+        case attribute::rms:
+            return reduce_windows(rms,    src, n, window, dst);
+        case attribute::mean:
+            return reduce_windows(mean,   src, n, window, dst);
+        case attribute::maxabs:
+            return reduce_windows(maxabs, src, n, window, dst);
+        case attribute::sumpos:
+            return reduce_windows(sumpos, src, n, window, dst);
+        case attribute::sumneg:
+            return reduce_windows(sumneg, src, n, window, dst);
+        case attribute::none:
+            break;
+    }
+
+    throw std::logic_error("reduce() called with attribute none");
+}
+
+}
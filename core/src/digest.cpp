@@ -0,0 +1,185 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <oneseismic/digest.hpp>
+
+namespace one {
+
+namespace {
+
+std::uint32_t rol(std::uint32_t x, int n) noexcept (true) {
+    return (x << n) | (x >> (32 - n));
+}
+
+std::uint32_t ror(std::uint32_t x, int n) noexcept (true) {
+    return (x >> n) | (x << (32 - n));
+}
+
+/*
+ * The 16 big-endian words of a block
+ */
+void load_words(const unsigned char* p, std::uint32_t* w) noexcept (true) {
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (std::uint32_t(p[4*i + 0]) << 24)
+             | (std::uint32_t(p[4*i + 1]) << 16)
+             | (std::uint32_t(p[4*i + 2]) <<  8)
+             | (std::uint32_t(p[4*i + 3]) <<  0)
+             ;
+    }
+}
+
+template < std::size_t N, std::size_t W >
+std::array< unsigned char, N > store_words(const std::uint32_t (&h)[W])
+noexcept (true) {
+    static_assert(N == 4 * W, "digest size must match the state");
+    std::array< unsigned char, N > out;
+    for (std::size_t i = 0; i < N; ++i)
+        out[i] = (unsigned char)(h[i / 4] >> (24 - 8 * (i % 4)));
+    return out;
+}
+
+const std::uint32_t sha256_k[64] = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+    0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+    0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+    0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+    0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+    0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+    0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+    0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+    0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+}
+
+void sha1_state::block(const unsigned char* p) noexcept (true) {
+    std::uint32_t w[80];
+    load_words(p, w);
+    for (int i = 16; i < 80; ++i)
+        w[i] = rol(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+
+    auto a = this->h[0];
+    auto b = this->h[1];
+    auto c = this->h[2];
+    auto d = this->h[3];
+    auto e = this->h[4];
+    for (int i = 0; i < 80; ++i) {
+        std::uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        const auto t = rol(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol(b, 30);
+        b = a;
+        a = t;
+    }
+    this->h[0] += a;
+    this->h[1] += b;
+    this->h[2] += c;
+    this->h[3] += d;
+    this->h[4] += e;
+}
+
+void sha1_state::update(const char* data, std::size_t len) noexcept (true) {
+    this->message.update(data, len, [this](const unsigned char* p) {
+        this->block(p);
+    });
+}
+
+sha1_state::digest sha1_state::finish() noexcept (true) {
+    this->message.pad([this](const unsigned char* p) {
+        this->block(p);
+    });
+    return store_words< 20 >(this->h);
+}
+
+void sha256_state::block(const unsigned char* p) noexcept (true) {
+    std::uint32_t w[64];
+    load_words(p, w);
+    for (int i = 16; i < 64; ++i) {
+        const auto s0 = ror(w[i-15], 7) ^ ror(w[i-15], 18) ^ (w[i-15] >> 3);
+        const auto s1 = ror(w[i-2], 17) ^ ror(w[i-2],  19) ^ (w[i-2] >> 10);
+        w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+
+    auto a = this->h[0];
+    auto b = this->h[1];
+    auto c = this->h[2];
+    auto d = this->h[3];
+    auto e = this->h[4];
+    auto f = this->h[5];
+    auto g = this->h[6];
+    auto h = this->h[7];
+    for (int i = 0; i < 64; ++i) {
+        const auto s1 = ror(e, 6) ^ ror(e, 11) ^ ror(e, 25);
+        const auto ch = (e & f) ^ (~e & g);
+        const auto t1 = h + s1 + ch + sha256_k[i] + w[i];
+        const auto s0 = ror(a, 2) ^ ror(a, 13) ^ ror(a, 22);
+        const auto maj = (a & b) ^ (a & c) ^ (b & c);
+        const auto t2 = s0 + maj;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    this->h[0] += a;
+    this->h[1] += b;
+    this->h[2] += c;
+    this->h[3] += d;
+    this->h[4] += e;
+    this->h[5] += f;
+    this->h[6] += g;
+    this->h[7] += h;
+}
+
+void sha256_state::update(const char* data, std::size_t len) noexcept (true) {
+    this->message.update(data, len, [this](const unsigned char* p) {
+        this->block(p);
+    });
+}
+
+sha256_state::digest sha256_state::finish() noexcept (true) {
+    this->message.pad([this](const unsigned char* p) {
+        this->block(p);
+    });
+    return store_words< 32 >(this->h);
+}
+
+sha1_state::digest sha1_digest(const char* data, std::size_t len)
+noexcept (true) {
+    sha1_state state;
+    state.update(data, len);
+    return state.finish();
+}
+
+sha256_state::digest sha256_digest(const char* data, std::size_t len)
+noexcept (true) {
+    sha256_state state;
+    state.update(data, len);
+    return state.finish();
+}
+
+}
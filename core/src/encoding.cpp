@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/format.h>
+
+#include <oneseismic/encoding.hpp>
+
+namespace one {
+
+namespace {
+
+std::uint32_t bits(float x) noexcept (true) {
+    std::uint32_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    return u;
+}
+
+float from_bits(std::uint32_t u) noexcept (true) {
+    float x;
+    std::memcpy(&x, &u, sizeof(x));
+    return x;
+}
+
+/*
+ * f32 -> f16 with round-to-nearest-even, including subnormals, inf and nan.
+ * This is the branch-light conversion by Fabian Giesen [1], which compilers
+ * turn into blends when the loop is vectorised.
+ *
+ * [1] https://gist.github.com/rygorous/2156668
+ */
+std::uint16_t to_f16(float x) noexcept (true) {
+    std::uint32_t u = bits(x);
+    const std::uint32_t sign = u & 0x80000000u;
+    u ^= sign;
+
+    std::uint16_t o;
+    if (u >= 0x47800000u) {
+        /* overflows to inf, or is inf or nan already */
+        o = (u > 0x7F800000u) ? 0x7E00 : 0x7C00;
+    } else if (u < 0x38800000u) {
+        /*
+         * Subnormal (or zero) in f16 - let the fpu do the rounding by adding
+         * a magic number that aligns the 10 mantissa bits at the bottom
+         */
+        const std::uint32_t magic = 126u << 23;
+        o = std::uint16_t(bits(from_bits(u) + from_bits(magic)) - magic);
+    } else {
+        const std::uint32_t odd = (u >> 13) & 1;
+        u += (std::uint32_t(15 - 127) << 23) + 0xFFF;
+        u += odd;
+        o = std::uint16_t(u >> 13);
+    }
+
+    return std::uint16_t((sign >> 16) | o);
+}
+
+float from_f16(std::uint16_t h) noexcept (true) {
+    const std::uint32_t shifted_exp = 0x7C00u << 13;
+    std::uint32_t o = std::uint32_t(h & 0x7FFF) << 13;
+    const std::uint32_t exp = shifted_exp & o;
+    o += std::uint32_t(127 - 15) << 23;
+
+    if (exp == shifted_exp) {
+        /* inf or nan */
+        o += std::uint32_t(128 - 16) << 23;
+    } else if (exp == 0) {
+        /* zero or subnormal - renormalise */
+        o += 1u << 23;
+        o = bits(from_bits(o) - from_bits(113u << 23));
+    }
+
+    o |= std::uint32_t(h & 0x8000) << 16;
+    return from_bits(o);
+}
+
+std::uint16_t to_bf16(float x) noexcept (true) {
+    const std::uint32_t u = bits(x);
+    /* keep nans as (quiet) nans, they would otherwise round to inf */
+    if ((u & 0x7FFFFFFFu) > 0x7F800000u)
+        return std::uint16_t((u >> 16) | 0x40);
+
+    const std::uint32_t rounding = 0x7FFF + ((u >> 16) & 1);
+    return std::uint16_t((u + rounding) >> 16);
+}
+
+float from_bf16(std::uint16_t h) noexcept (true) {
+    return from_bits(std::uint32_t(h) << 16);
+}
+
+std::int16_t as_signed(std::uint16_t x) noexcept (true) {
+    std::int16_t s;
+    std::memcpy(&s, &x, sizeof(s));
+    return s;
+}
+
+std::uint16_t as_unsigned(std::int16_t x) noexcept (true) {
+    std::uint16_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    return u;
+}
+
+/*
+ * Linearly quantise the samples to [-levels, levels] around the midpoint of
+ * the tile. The range is symmetric so that 0 is a valid code, which maps to
+ * the midpoint exactly.
+ *
+ * Non-finite samples (nan, inf) do not take part in the range, and are
+ * encoded as the otherwise unused code -(levels + 1), which decodes to nan.
+ */
+void quantise(
+    const float* src,
+    std::size_t n,
+    std::int16_t* dst,
+    float levels,
+    float& scale,
+    float& offset)
+noexcept (true) {
+    if (n == 0) {
+        scale  = 1;
+        offset = 0;
+        return;
+    }
+
+    /*
+     * Plain min/max loop rather than std::minmax_element, which is a lot
+     * harder for compilers to vectorise as it tracks iterators, not values
+     */
+    const float maxf = std::numeric_limits< float >::max();
+    float lo =  maxf;
+    float hi = -maxf;
+    for (std::size_t i = 0; i < n; ++i) {
+        const bool finite = std::isfinite(src[i]);
+        lo = std::min(lo, finite ? src[i] : lo);
+        hi = std::max(hi, finite ? src[i] : hi);
+    }
+
+    if (lo > hi) {
+        /* no finite samples at all */
+        lo = hi = 0;
+    }
+
+    /*
+     * Halve before subtracting, as hi - lo overflows for samples close to
+     * the limits of float
+     */
+    offset = lo / 2 + hi / 2;
+    scale  = (hi / 2 - lo / 2) / levels;
+    if (scale == 0) {
+        /* constant tile, every sample is exactly the offset */
+        scale = 1;
+    }
+
+    const float inv = 1 / scale;
+    const auto nonfinite = std::int16_t(-levels - 1);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (not std::isfinite(src[i])) {
+            dst[i] = nonfinite;
+            continue;
+        }
+        float q = (src[i] - offset) * inv;
+        q = std::min(std::max(q, -levels), levels);
+        q = q < 0 ? q - 0.5f : q + 0.5f;
+        dst[i] = std::int16_t(q);
+    }
+}
+
+void dequantise(
+    const std::int16_t* src,
+    std::size_t n,
+    float* dst,
+    float levels,
+    float scale,
+    float offset)
+noexcept (true) {
+    const auto nonfinite = std::int16_t(-levels - 1);
+    const auto nan = std::numeric_limits< float >::quiet_NaN();
+    for (std::size_t i = 0; i < n; ++i) {
+        dst[i] = src[i] == nonfinite
+               ? nan
+               : offset + scale * float(src[i])
+               ;
+    }
+}
+
+}
+
+encoding parse_encoding(const std::string& name) noexcept (false) {
+    if (name == "f32")  return encoding::f32;
+    if (name == "f16")  return encoding::f16;
+    if (name == "bf16") return encoding::bf16;
+    if (name == "i16")  return encoding::i16;
+    if (name == "i8")   return encoding::i8;
+
+    const auto msg = "unknown encoding '{}', expected one of "
+                     "f32, f16, bf16, i16, i8";
+    throw std::invalid_argument(fmt::format(msg, name));
+}
+
+const char* to_string(encoding e) noexcept (true) {
+    switch (e) {
+        case encoding::f32:  return "f32";
+        case encoding::f16:  return "f16";
+        case encoding::bf16: return "bf16";
+        case encoding::i16:  return "i16";
+        case encoding::i8:   return "i8";
+    }
+    return "unknown";
+}
+
+void encode(
+    encoding e,
+    const float* src,
+    std::size_t n,
+    std::int16_t* dst,
+    float& scale,
+    float& offset)
+noexcept (false) {
+    switch (e) {
+        case encoding::f16:
+            for (std::size_t i = 0; i < n; ++i)
+                dst[i] = as_signed(to_f16(src[i]));
+            scale  = 1;
+            offset = 0;
+            return;
+
+        case encoding::bf16:
+            for (std::size_t i = 0; i < n; ++i)
+                dst[i] = as_signed(to_bf16(src[i]));
+            scale  = 1;
+            offset = 0;
+            return;
+
+        case encoding::i16:
+            quantise(src, n, dst, 32767, scale, offset);
+            return;
+
+        case encoding::i8:
+            quantise(src, n, dst, 127, scale, offset);
+            return;
+
+        case encoding::f32:
+            break;
+    }
+
+    throw std::logic_error("encode() called with f32, which is not encoded");
+}
+
+void decode(
+    encoding e,
+    const std::int16_t* src,
+    std::size_t n,
+    float* dst,
+    float scale,
+    float offset)
+noexcept (false) {
+    switch (e) {
+        case encoding::f16:
+            for (std::size_t i = 0; i < n; ++i)
+                dst[i] = from_f16(as_unsigned(src[i]));
+            return;
+
+        case encoding::bf16:
+            for (std::size_t i = 0; i < n; ++i)
+                dst[i] = from_bf16(as_unsigned(src[i]));
+            return;
+
+        case encoding::i16:
+            dequantise(src, n, dst, 32767, scale, offset);
+            return;
+
+        case encoding::i8:
+            dequantise(src, n, dst, 127, scale, offset);
+            return;
+
+        case encoding::f32:
+            break;
+    }
+
+    throw std::logic_error("decode() called with f32, which is not encoded");
+}
+
+}
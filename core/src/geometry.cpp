@@ -1,8 +1,10 @@
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <functional>
 #include <iostream>
 #include <numeric>
+#include <stdexcept>
 #include <vector>
 
 #include <fmt/core.h>
@@ -351,6 +353,67 @@ gvt< ND >::slice(Dimension dim, std::size_t no) noexcept (false) {
     return result;
 }
 
+template < std::size_t ND >
+std::vector< FID< ND > >
+gvt< ND >::slice(
+        Dimension dim,
+        std::size_t no,
+        const std::array< std::size_t, ND >& begin,
+        const std::array< std::size_t, ND >& end,
+        const std::array< std::size_t, ND >& stride)
+noexcept (false) {
+    if (no >= this->global_dims[dim.v])
+        throw std::invalid_argument("dimension out-of-range");
+
+    std::array< std::size_t, ND > ends;
+    std::array< std::size_t, ND > first;
+    std::array< std::size_t, ND > last;
+    for (std::size_t i = 0; i < ND; ++i) {
+        const auto fragment = this->fragment_dims[i];
+        if (i == dim.v) {
+            first[i] = no / fragment;
+            last[i]  = first[i] + 1;
+            continue;
+        }
+
+        ends[i] = std::min(end[i], this->global_dims[i]);
+        if (begin[i] >= ends[i])
+            throw std::invalid_argument("empty region of interest");
+        if (stride[i] < 1)
+            throw std::invalid_argument("stride < 1");
+
+        first[i] = begin[i] / fragment;
+        last[i]  = (ends[i] - 1) / fragment + 1;
+    }
+
+    /*
+     * With strides larger than 1, a fragment can be inside the region without
+     * having any of the samples begin + k * stride, and is not needed.
+     */
+    const auto sampled = [&](const std::array< std::size_t, ND >& id) {
+        for (std::size_t i = 0; i < ND; ++i) {
+            if (i == dim.v) continue;
+
+            const auto fragment = this->fragment_dims[i];
+            const auto lo = std::max(id[i] * fragment, begin[i]);
+            const auto hi = std::min((id[i] + 1) * fragment, ends[i]);
+            const auto k  = (lo - begin[i] + stride[i] - 1) / stride[i];
+            if (begin[i] + k * stride[i] >= hi)
+                return false;
+        }
+        return true;
+    };
+
+    auto result = std::vector< FID< ND > >();
+    auto push_back = [&](const auto& val) {
+        if (sampled(val))
+            result.emplace_back(val);
+    };
+
+    cartesian_product(push_back, first, last);
+    return result;
+}
+
 namespace {
 
 template < typename Point, typename Dim >
@@ -444,6 +507,82 @@ const noexcept (true) {
     return one::squeeze(d, *this);
 }
 
+lerp_cell interpolation_cell(float x, std::size_t n) noexcept (true) {
+    assert(n > 0);
+    assert(0 <= x and x <= float(n - 1));
+
+    if (n == 1)
+        return { 0, 0, 0.0f };
+
+    const auto lower = std::min(std::size_t(x), n - 2);
+    return { lower, lower + 1, x - float(lower) };
+}
+
+world_transform::world_transform(const std::array< double, 6 >& t)
+noexcept (false) : fwd(t) {
+    const auto det = t[1] * t[5] - t[2] * t[4];
+    if (not std::isfinite(det) or det == 0) {
+        const auto msg = "singular world transform [{}]";
+        throw std::invalid_argument(fmt::format(msg, fmt::join(t, ", ")));
+    }
+
+    this->inv = {
+         t[5] / det, -t[2] / det,
+        -t[4] / det,  t[1] / det,
+    };
+}
+
+namespace {
+
+void affine(
+        const std::array< double, 6 >& t,
+        const double* a,
+        const double* b,
+        std::size_t n,
+        double* x,
+        double* y)
+noexcept (true) {
+    for (std::size_t k = 0; k < n; ++k) {
+        const auto ak = a[k];
+        const auto bk = b[k];
+        x[k] = t[0] + t[1] * ak + t[2] * bk;
+        y[k] = t[3] + t[4] * ak + t[5] * bk;
+    }
+}
+
+}
+
+void world_transform::to_world(
+        const double* i,
+        const double* j,
+        std::size_t n,
+        double* x,
+        double* y)
+const noexcept (true) {
+    affine(this->fwd, i, j, n, x, y);
+}
+
+void world_transform::to_grid(
+        const double* x,
+        const double* y,
+        std::size_t n,
+        double* i,
+        double* j)
+const noexcept (true) {
+    /*
+     * Translate to the origin first, which keeps the precision of the large
+     * world coordinates.
+     */
+    const auto& t = this->fwd;
+    const auto& v = this->inv;
+    for (std::size_t k = 0; k < n; ++k) {
+        const auto dx = x[k] - t[0];
+        const auto dy = y[k] - t[3];
+        i[k] = v[0] * dx + v[1] * dy;
+        j[k] = v[2] * dx + v[3] * dy;
+    }
+}
+
 template class gvt< 3 >;
 template class gvt< 2 >;
 template class CS < 3 >;
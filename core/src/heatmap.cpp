@@ -0,0 +1,360 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <oneseismic/heatmap.hpp>
+
+namespace one {
+namespace heatmap {
+
+namespace {
+
+std::atomic< recorder* > current(nullptr);
+std::atomic< int > current_sites(0);
+
+constexpr char magic[] = "OSHEAT01";
+constexpr std::uint64_t empty = 0;
+constexpr int maxid = 0xFFFF;
+
+/*
+ * Keys pack the cube handle and fragment id into 16 bits each. The cube is
+ * stored off by one so that no key is ever 0, which marks empty slots.
+ */
+std::uint64_t pack(int cube, int i, int j, int k) noexcept (true) {
+    return (std::uint64_t(cube + 1) << 48)
+         | (std::uint64_t(i)        << 32)
+         | (std::uint64_t(j)        << 16)
+         | (std::uint64_t(k)        <<  0)
+    ;
+}
+
+entry unpack(std::uint64_t key, std::uint64_t count) noexcept (true) {
+    entry e;
+    e.cube  = int((key >> 48) & 0xFFFF) - 1;
+    e.i     = int((key >> 32) & 0xFFFF);
+    e.j     = int((key >> 16) & 0xFFFF);
+    e.k     = int((key >>  0) & 0xFFFF);
+    e.count = count;
+    return e;
+}
+
+std::size_t slot(std::uint64_t key) noexcept (true) {
+    /* fibonacci hashing, to spread neighbouring fragments over the table */
+    return std::size_t((key * 0x9E3779B97F4A7C15ull) >> 16);
+}
+
+template < typename T >
+void put(std::ostream& os, T x) noexcept (false) {
+    char buf[sizeof(T)];
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+        buf[i] = char((std::uint64_t(x) >> (8 * i)) & 0xFF);
+    os.write(buf, sizeof(buf));
+}
+
+template < typename T >
+T get(std::istream& is) noexcept (false) {
+    unsigned char buf[sizeof(T)];
+    if (!is.read(reinterpret_cast< char* >(buf), sizeof(buf)))
+        throw std::invalid_argument("heatmap: unexpected end of snapshot");
+
+    std::uint64_t x = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+        x |= std::uint64_t(buf[i]) << (8 * i);
+    return T(x);
+}
+
+}
+
+recorder::recorder(std::size_t capacity) noexcept (false) :
+    dropped(0)
+{
+    std::size_t size = 1;
+    while (size < capacity)
+        size *= 2;
+
+    this->mask   = size - 1;
+    this->keys   .reset(new std::atomic< std::uint64_t >[size]);
+    this->counts .reset(new std::atomic< std::uint64_t >[size]);
+    for (std::size_t i = 0; i < size; ++i) {
+        this->keys[i].store(empty, std::memory_order_relaxed);
+        this->counts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+int recorder::cube(const std::string& key) noexcept (false) {
+    std::lock_guard< std::mutex > lock(this->mtx);
+    const auto itr = this->handles.find(key);
+    if (itr != this->handles.end())
+        return itr->second;
+
+    const auto handle = int(this->names.size());
+    if (handle >= maxid) {
+        const auto msg = "heatmap: too many cubes (max {})";
+        throw std::length_error(fmt::format(msg, maxid));
+    }
+    this->names.push_back(key);
+    this->handles.emplace(key, handle);
+    return handle;
+}
+
+void recorder::record(int cube, int i, int j, int k) noexcept (true) {
+    const auto outside = [](int x) { return x < 0 or x > maxid; };
+    if (outside(cube) or outside(i) or outside(j) or outside(k)) {
+        this->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const auto key = pack(cube, i, j, k);
+    auto pos = slot(key) & this->mask;
+    for (std::size_t probe = 0; probe <= this->mask; ++probe) {
+        auto& slotkey = this->keys[pos];
+        auto current = slotkey.load(std::memory_order_acquire);
+        if (current == empty) {
+            if (slotkey.compare_exchange_strong(current, key))
+                current = key;
+        }
+
+        if (current == key) {
+            this->counts[pos].fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        pos = (pos + 1) & this->mask;
+    }
+
+    this->dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+snapshot recorder::collect() const noexcept (false) {
+    snapshot snap;
+    {
+        std::lock_guard< std::mutex > lock(this->mtx);
+        snap.cubes = this->names;
+    }
+
+    for (std::size_t i = 0; i <= this->mask; ++i) {
+        const auto key = this->keys[i].load(std::memory_order_acquire);
+        if (key == empty) continue;
+        const auto count = this->counts[i].load(std::memory_order_relaxed);
+        /*
+         * A slot can be claimed before it is counted, in which case it is
+         * left for the next snapshot.
+         */
+        if (count == 0) continue;
+        snap.entries.push_back(unpack(key, count));
+    }
+    snap.dropped = this->dropped.load(std::memory_order_relaxed);
+    return snap;
+}
+
+void recorder::write(std::ostream& os) const noexcept (false) {
+    const auto snap = this->collect();
+
+    os.write(magic, sizeof(magic) - 1);
+    put< std::uint32_t >(os, snap.cubes.size());
+    for (const auto& name : snap.cubes) {
+        put< std::uint32_t >(os, name.size());
+        os.write(name.data(), name.size());
+    }
+
+    put< std::uint64_t >(os, snap.entries.size());
+    for (const auto& e : snap.entries) {
+        put< std::uint16_t >(os, e.cube);
+        put< std::uint16_t >(os, e.i);
+        put< std::uint16_t >(os, e.j);
+        put< std::uint16_t >(os, e.k);
+        put< std::uint64_t >(os, e.count);
+    }
+    put< std::uint64_t >(os, snap.dropped);
+}
+
+std::string cube_key(
+        const std::string& guid,
+        const std::string& shape,
+        int decimation)
+noexcept (false) {
+    if (decimation == 1)
+        return fmt::format("{}/src/{}", guid, shape);
+    else
+        return fmt::format("{}/lod{}/{}", guid, decimation, shape);
+}
+
+void install(recorder* rec, int sites) noexcept (true) {
+    current_sites.store(sites);
+    current.store(rec);
+}
+
+recorder* installed(site s) noexcept (true) {
+    if (not (current_sites.load(std::memory_order_relaxed) & s))
+        return nullptr;
+    return current.load(std::memory_order_relaxed);
+}
+
+flusher::flusher(
+        const recorder& rec,
+        std::string path,
+        std::chrono::milliseconds interval)
+noexcept (false) :
+    rec(rec),
+    path(std::move(path)),
+    interval(interval)
+{
+    this->worker = std::thread([this] {
+        std::unique_lock< std::mutex > lock(this->mtx);
+        while (true) {
+            this->cv.wait_for(lock, this->interval, [this] {
+                return this->done;
+            });
+            try {
+                this->flush();
+            } catch (...) {
+                /* try again on the next interval */
+            }
+            if (this->done) return;
+        }
+    });
+}
+
+flusher::~flusher() {
+    {
+        std::lock_guard< std::mutex > lock(this->mtx);
+        this->done = true;
+    }
+    this->cv.notify_all();
+    this->worker.join();
+}
+
+void flusher::flush() const noexcept (false) {
+    const auto tmp = this->path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("heatmap: unable to open " + tmp);
+        this->rec.write(out);
+        if (!out)
+            throw std::runtime_error("heatmap: unable to write " + tmp);
+    }
+
+    if (std::rename(tmp.c_str(), this->path.c_str()) != 0)
+        throw std::runtime_error("heatmap: unable to rename " + tmp);
+}
+
+snapshot read(std::istream& is) noexcept (false) {
+    char head[sizeof(magic) - 1];
+    if (!is.read(head, sizeof(head))
+        or not std::equal(head, head + sizeof(head), magic))
+        throw std::invalid_argument("heatmap: not a heatmap snapshot");
+
+    snapshot snap;
+    const auto ncubes = get< std::uint32_t >(is);
+    for (std::uint32_t i = 0; i < ncubes; ++i) {
+        std::string name(get< std::uint32_t >(is), '\0');
+        if (!is.read(&name[0], name.size()))
+            throw std::invalid_argument("heatmap: unexpected end of snapshot");
+        snap.cubes.push_back(std::move(name));
+    }
+
+    const auto nentries = get< std::uint64_t >(is);
+    for (std::uint64_t n = 0; n < nentries; ++n) {
+        entry e;
+        e.cube  = get< std::uint16_t >(is);
+        e.i     = get< std::uint16_t >(is);
+        e.j     = get< std::uint16_t >(is);
+        e.k     = get< std::uint16_t >(is);
+        e.count = get< std::uint64_t >(is);
+        if (e.cube >= int(snap.cubes.size()))
+            throw std::invalid_argument("heatmap: entry of unknown cube");
+        snap.entries.push_back(e);
+    }
+    snap.dropped = get< std::uint64_t >(is);
+    return snap;
+}
+
+double static_hit_rate(std::vector< std::uint64_t > counts, std::size_t capacity)
+noexcept (false) {
+    const auto total = std::accumulate(
+        counts.begin(),
+        counts.end(),
+        std::uint64_t(0)
+    );
+    if (total == 0) return 0;
+
+    /*
+     * The first access of every cached fragment is still a miss
+     */
+    const auto n = std::min(capacity, counts.size());
+    std::partial_sort(
+        counts.begin(),
+        counts.begin() + n,
+        counts.end(),
+        std::greater< std::uint64_t >()
+    );
+    std::uint64_t hits = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        hits += counts[i] - 1;
+    return double(hits) / total;
+}
+
+double lru_hit_rate(const std::vector< std::uint64_t >& counts, std::size_t capacity)
+noexcept (false) {
+    const auto total = std::accumulate(
+        counts.begin(),
+        counts.end(),
+        std::uint64_t(0)
+    );
+    if (total == 0 or capacity == 0) return 0;
+    if (capacity >= counts.size())
+        return double(total - counts.size()) / total;
+
+    /*
+     * Find the characteristic time T (in accesses) where the expected number
+     * of distinct fragments accessed is the capacity,
+     *
+     *      sum(1 - exp(-p T)) = capacity
+     *
+     * by bisection, as the left hand side is increasing in T.
+     */
+    const auto occupancy = [&](double T) {
+        double x = 0;
+        for (const auto c : counts)
+            x += 1 - std::exp(-double(c) / total * T);
+        return x;
+    };
+
+    double lo = 0;
+    double hi = 1;
+    while (occupancy(hi) < capacity)
+        hi *= 2;
+    for (int i = 0; i < 100; ++i) {
+        const auto mid = (lo + hi) / 2;
+        if (occupancy(mid) < capacity) lo = mid;
+        else                           hi = mid;
+    }
+
+    /*
+     * The first access of a fragment is always a miss, which the model does
+     * not know about, so the hit probability of a fragment is capped at
+     * (count - 1) / count.
+     */
+    double hit = 0;
+    for (const auto c : counts) {
+        if (c == 0) continue;
+        const auto p = double(c) / total;
+        const auto cap = double(c - 1) / c;
+        hit += p * std::min(1 - std::exp(-p * hi), cap);
+    }
+    return hit;
+}
+
+}
+}
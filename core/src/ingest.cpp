@@ -0,0 +1,1022 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#ifdef HAVE_SYS_STAT_H
+    #include <sys/stat.h>
+    #include <sys/types.h>
+#endif
+
+#include <oneseismic/geometry.hpp>
+#include <oneseismic/ingest.hpp>
+
+namespace one {
+
+namespace {
+
+std::uint32_t bswap(std::uint32_t x) noexcept (true) {
+    return ((x & 0xFF000000u) >> 24)
+         | ((x & 0x00FF0000u) >>  8)
+         | ((x & 0x0000FF00u) <<  8)
+         | ((x & 0x000000FFu) << 24)
+         ;
+}
+
+/*
+ * IBM float is sign, 7-bit base-16 exponent biased by 64, and a 24-bit
+ * fraction with the radix point before the first digit, i.e.
+ *
+ *      x = (-1)^sign * 16^(exp - 64) * frac / 2^24
+ *        = (-1)^sign * frac * 2^(4 * exp - 280)
+ *
+ * The fraction fits a float exactly, and the scale is a power of two that
+ * always fits a double, so the conversion is exact (and agrees with segyio)
+ * except for results in the float denormal range, which are rounded rather
+ * than truncated. There are no branches, so the loops over this function are
+ * vectorised by the compiler.
+ */
+float ibm2ieee(std::uint32_t x) noexcept (true) {
+    const std::uint64_t sign = x >> 31;
+    const std::uint64_t exp  = (x >> 24) & 0x7F;
+    const std::uint32_t frac = x & 0x00FFFFFF;
+    const std::uint64_t bits = (sign << 63) | ((4 * exp - 280 + 1023) << 52);
+    double scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return float(double(frac) * scale);
+}
+
+template < typename Fn >
+void decode(float* out, const char* in, std::size_t n, Fn fn)
+noexcept (true) {
+    for (std::size_t i = 0; i < n; ++i) {
+        std::uint32_t x;
+        std::memcpy(&x, in + i * sizeof(x), sizeof(x));
+        out[i] = fn(x);
+    }
+}
+
+/*
+ * Read the 2- or 4-byte header word
+ */
+std::int32_t read_word(const char* p, int size, bool big_endian)
+noexcept (true) {
+    const auto* u = reinterpret_cast< const unsigned char* >(p);
+    std::uint32_t x = 0;
+    for (int i = 0; i < size; ++i) {
+        const auto byte = big_endian ? u[i] : u[size - 1 - i];
+        x = (x << 8) | byte;
+    }
+    if (size == 2)
+        return std::int16_t(x);
+    return std::int32_t(x);
+}
+
+}
+
+void decode_samples(
+        float* out,
+        const char* in,
+        std::size_t n,
+        int format,
+        bool big_endian)
+noexcept (false) {
+    /*
+     * The samples of fragments are stored as little endian floats, and like
+     * the rest of oneseismic this assumes a little endian host
+     */
+    switch (format) {
+        case 1:
+            if (big_endian)
+                decode(out, in, n, [](std::uint32_t x) {
+                    return ibm2ieee(bswap(x));
+                });
+            else
+                decode(out, in, n, ibm2ieee);
+            return;
+
+        case 5:
+            if (big_endian)
+                decode(out, in, n, [](std::uint32_t x) {
+                    float f;
+                    x = bswap(x);
+                    std::memcpy(&f, &x, sizeof(f));
+                    return f;
+                });
+            else
+                std::memcpy(out, in, n * sizeof(float));
+            return;
+
+        default: {
+            const auto msg = "unsupported SEG-Y format {}, expected "
+                             "1 (IBM float) or 5 (IEEE float)";
+            throw std::invalid_argument(fmt::format(msg, format));
+        }
+    }
+}
+
+int header_word_size(int word) noexcept (false) {
+    /*
+     * The 4-byte fields of the trace header (SEG-Y rev 1), and every other
+     * field is 2 bytes
+     */
+    static const int words4[] = {
+          1,   5,   9,  13,  17,  21,  25,
+         37,  41,  45,  49,  53,  57,  61,  65,
+         73,  77,  81,  85,
+        181, 185, 189, 193, 197,
+        205, 219, 225, 233, 237,
+    };
+    const auto end = std::end(words4);
+    if (std::find(std::begin(words4), end, word) != end)
+        return 4;
+
+    /*
+     * The 2-byte fields are at odd offsets, between and after the 4-byte
+     * fields, and never inside of one
+     */
+    const auto inside = std::any_of(std::begin(words4), end, [word](int w) {
+        return w < word and word < w + 4;
+    });
+    if (1 <= word and word < 240 and word % 2 == 1 and not inside)
+        return 2;
+
+    const auto msg = "no trace header field at byte offset {}";
+    throw std::invalid_argument(fmt::format(msg, word));
+}
+
+filesystem_sink::filesystem_sink(std::string root) :
+    root(std::move(root))
+{}
+
+#ifdef HAVE_SYS_STAT_H
+
+namespace {
+
+void mkdirs(const std::string& path) noexcept (false) {
+    for (auto pos = path.find('/', 1);
+         pos != std::string::npos;
+         pos = path.find('/', pos + 1))
+    {
+        const auto dir = path.substr(0, pos);
+        if (::mkdir(dir.c_str(), 0777) == -1 and errno != EEXIST)
+            throw std::system_error(errno, std::generic_category(), dir);
+    }
+}
+
+}
+
+void filesystem_sink::put(
+        const std::string& path,
+        const char* data,
+        std::size_t size)
+noexcept (false) {
+    const auto fullpath = this->root.empty() ? path : this->root + "/" + path;
+    mkdirs(fullpath);
+
+    std::unique_ptr< std::FILE, decltype(&std::fclose) > fp(
+        std::fopen(fullpath.c_str(), "wb"),
+        &std::fclose
+    );
+    if (!fp)
+        throw std::system_error(errno, std::generic_category(), fullpath);
+    if (std::fwrite(data, 1, size, fp.get()) != size)
+        throw std::system_error(errno, std::generic_category(), fullpath);
+}
+
+#else
+
+void filesystem_sink::put(const std::string&, const char*, std::size_t)
+noexcept (false) {
+    throw std::logic_error("filesystem_sink: not supported on this platform");
+}
+
+#endif // HAVE_SYS_STAT_H
+
+namespace {
+
+/*
+ * The layout of the traces in the SEG-Y file, from the scan manifest
+ */
+struct segy_layout {
+    std::size_t first;
+    std::size_t samples;
+    std::size_t tracelen;
+    int         format;
+    bool        big_endian;
+    std::size_t word1;
+    std::size_t word2;
+    int size1;
+    int size2;
+};
+
+/*
+ * The memory budget of the fragment buffers. A lane reserves the memory for
+ * all of its fragments when it is opened, and releases it when it is
+ * written, so the budget covers both open lanes and lanes queued for the
+ * writers.
+ */
+class budget {
+public:
+    explicit budget(std::size_t limit) : limit(limit) {}
+
+    /*
+     * Reserve size bytes, waiting for the writers to finish lanes if that
+     * would make room. Returns false if the lane does not fit, even when
+     * all written lanes are released.
+     */
+    bool reserve(std::size_t size) noexcept (true) {
+        std::unique_lock< std::mutex > lock(this->mtx);
+        this->cv.wait(lock, [this, size] {
+            return this->used + size <= this->limit or this->writing == 0;
+        });
+        if (this->used + size > this->limit)
+            return false;
+        this->used += size;
+        return true;
+    }
+
+    void writing_lane() noexcept (true) {
+        std::lock_guard< std::mutex > lock(this->mtx);
+        this->writing += 1;
+    }
+
+    void written_lane(std::size_t size) noexcept (true) {
+        {
+            std::lock_guard< std::mutex > lock(this->mtx);
+            this->used    -= size;
+            this->writing -= 1;
+        }
+        this->cv.notify_all();
+    }
+
+private:
+    std::size_t limit;
+    std::size_t used    = 0;
+    std::size_t writing = 0;
+    std::mutex mtx;
+    std::condition_variable cv;
+};
+
+/*
+ * The fragments of a lane, as columns of fragments (j), each with the
+ * fragments (k) back-to-back. Columns are allocated when their first trace
+ * is put, so columns without traces are not stored.
+ */
+struct lane {
+    std::size_t i;
+    std::size_t reserved;
+    std::vector< std::vector< float > > columns;
+    /*
+     * The traced (i, j) positions in the fragments of every column, for the
+     * fragment stats
+     */
+    std::vector< std::vector< char > > traced;
+};
+
+enum class lane_state {
+    pending,
+    open,
+    deferred,
+    done,
+};
+
+/*
+ * A level is the full resolution cube (decimation 1) or an overview level,
+ * like the fileset in upload.py. A level is sampled on a regular grid with
+ * the same origin as the full resolution cube, i.e. every decimation'th
+ * line and sample.
+ */
+class level {
+public:
+    level(
+        const nlohmann::json& manifest,
+        const std::string& prefix,
+        const one::FS< 3 >& fragment_shape,
+        int decimation,
+        int statsbins)
+    noexcept (false);
+
+    /*
+     * The lane of the trace, opening it if this is its first trace in the
+     * pass, or nullptr if the trace is not on the grid of this level, or its
+     * lane is not open in this pass.
+     */
+    lane* admit(std::int32_t key1, std::int32_t key2, budget&)
+        noexcept (false);
+    void put(lane&, std::int32_t key1, std::int32_t key2, const float*)
+        noexcept (false);
+    /*
+     * The lane of key1 if the trace at traceno is its last trace, which is
+     * then done.
+     */
+    std::unique_ptr< lane > commit(std::size_t traceno, std::int32_t key1)
+        noexcept (true);
+
+    void begin_pass() noexcept (true);
+    std::vector< std::unique_ptr< lane > > end_pass() noexcept (true);
+    bool done() const noexcept (true);
+
+    /*
+     * Write the fragments of the lane, and its fragment stats
+     */
+    std::size_t write(const lane&, fragment_sink&) noexcept (false);
+
+    std::size_t lane_size() const noexcept (true);
+    std::string mask() const noexcept (false);
+
+    int decimation;
+    int statsbins;
+    std::string prefix;
+    one::gvt< 3 > gvt;
+    /*
+     * The fragment stats sidecar, with one record per fragment
+     */
+    std::vector< char > stats;
+
+private:
+    std::unordered_map< std::int32_t, std::size_t > index1s;
+    std::unordered_map< std::int32_t, std::size_t > index2s;
+    std::vector< std::size_t > limits;
+    std::vector< lane_state > states;
+    std::vector< std::unique_ptr< lane > > lanes;
+    /*
+     * The (i, j) fragment columns with at least one trace
+     */
+    std::vector< char > columns;
+
+    std::size_t ncolumns;
+    std::size_t nsections;
+    std::size_t fragment_size;
+
+    std::size_t record_size() const noexcept (true);
+    void summarise(const lane&, std::size_t j, std::size_t k)
+        noexcept (true);
+};
+
+std::vector< std::int32_t > decimated(const nlohmann::json& keys, int d)
+noexcept (false) {
+    std::vector< std::int32_t > xs;
+    for (std::size_t i = 0; i < keys.size(); i += d)
+        xs.push_back(keys[i].get< std::int32_t >());
+    return xs;
+}
+
+level::level(
+        const nlohmann::json& manifest,
+        const std::string& prefix,
+        const one::FS< 3 >& fragment_shape,
+        int decimation,
+        int statsbins)
+noexcept (false) :
+    decimation(decimation),
+    statsbins(statsbins),
+    prefix(prefix)
+{
+    const auto& dimensions = manifest.at("dimensions");
+    const auto key1s = decimated(dimensions.at(0), decimation);
+    const auto key2s = decimated(dimensions.at(1), decimation);
+    const auto key3s = decimated(dimensions.at(2), decimation);
+    for (std::size_t i = 0; i < key1s.size(); ++i)
+        this->index1s.emplace(key1s[i], i);
+    for (std::size_t i = 0; i < key2s.size(); ++i)
+        this->index2s.emplace(key2s[i], i);
+
+    this->gvt = one::gvt< 3 >(
+        one::CS< 3 >(key1s.size(), key2s.size(), key3s.size()),
+        fragment_shape
+    );
+    const auto nlanes  = this->gvt.fragment_count(dimension< 3 >(0));
+    this->ncolumns     = this->gvt.fragment_count(dimension< 3 >(1));
+    this->nsections    = this->gvt.fragment_count(dimension< 3 >(2));
+    this->fragment_size = fragment_shape[0]
+                        * fragment_shape[1]
+                        * fragment_shape[2]
+                        ;
+
+    /*
+     * The last trace of a lane is the last trace of any of its lines
+     */
+    this->limits.assign(nlanes, 0);
+    for (const auto& item : manifest.at("key1-last-trace").items()) {
+        const auto itr = this->index1s.find(std::stoi(item.key()));
+        if (itr == this->index1s.end())
+            continue;
+        auto& limit = this->limits[itr->second / fragment_shape[0]];
+        limit = std::max(limit, item.value().get< std::size_t >());
+    }
+
+    this->states.assign(nlanes, lane_state::pending);
+    this->lanes.resize(nlanes);
+    this->columns.assign(nlanes * this->ncolumns, 0);
+    if (this->statsbins > 0)
+        this->stats.assign(
+            nlanes * this->ncolumns * this->nsections * this->record_size(),
+            0
+        );
+}
+
+std::size_t level::lane_size() const noexcept (true) {
+    return this->ncolumns
+         * this->nsections
+         * this->fragment_size
+         * sizeof(float)
+         ;
+}
+
+std::size_t level::record_size() const noexcept (true) {
+    return 4 * sizeof(float) + (1 + this->statsbins) * sizeof(std::uint32_t);
+}
+
+lane* level::admit(std::int32_t key1, std::int32_t key2, budget& mem)
+noexcept (false) {
+    const auto itr1 = this->index1s.find(key1);
+    const auto itr2 = this->index2s.find(key2);
+    if (itr1 == this->index1s.end() or itr2 == this->index2s.end())
+        return nullptr;
+
+    const auto i = itr1->second / this->gvt.fragment_shape()[0];
+    switch (this->states[i]) {
+        case lane_state::open:
+            return this->lanes[i].get();
+
+        case lane_state::deferred:
+        case lane_state::done:
+            return nullptr;
+
+        case lane_state::pending:
+            break;
+    }
+
+    /*
+     * A lane is opened on its first trace in a pass, or not at all in the
+     * pass, so that an open lane always gets all of its traces
+     */
+    const auto size = this->lane_size();
+    if (not mem.reserve(size)) {
+        this->states[i] = lane_state::deferred;
+        return nullptr;
+    }
+
+    auto l = std::make_unique< lane >();
+    l->i = i;
+    l->reserved = size;
+    l->columns.resize(this->ncolumns);
+    l->traced.resize(this->ncolumns);
+    this->lanes[i] = std::move(l);
+    this->states[i] = lane_state::open;
+    return this->lanes[i].get();
+}
+
+void level::put(
+        lane& l,
+        std::int32_t key1,
+        std::int32_t key2,
+        const float* trace)
+noexcept (false) {
+    const auto cp = one::CP< 3 >(
+        this->index1s.at(key1),
+        this->index2s.at(key2),
+        0
+    );
+    const auto id = this->gvt.frag_id(cp);
+    const auto fp = this->gvt.to_local(cp);
+    const auto& fs = this->gvt.fragment_shape();
+
+    const auto j = id[1];
+    auto& column = l.columns[j];
+    if (column.empty()) {
+        column.assign(this->nsections * this->fragment_size, 0);
+        l.traced[j].assign(fs[0] * fs[1], 0);
+        this->columns[l.i * this->ncolumns + j] = 1;
+    }
+    l.traced[j][fp[0] * fs[1] + fp[1]] = 1;
+
+    const auto samples = this->gvt.nsamples(dimension< 3 >(2));
+    const auto offset  = fs.to_offset(fp);
+    const auto d = std::size_t(this->decimation);
+    for (std::size_t k = 0; k < this->nsections; ++k) {
+        const auto z0 = k * fs[2];
+        const auto n  = std::min(std::size_t(fs[2]), samples - z0);
+        float* dst = column.data() + k * this->fragment_size + offset;
+        for (std::size_t z = 0; z < n; ++z)
+            dst[z] = trace[(z0 + z) * d];
+    }
+}
+
+std::unique_ptr< lane > level::commit(std::size_t traceno, std::int32_t key1)
+noexcept (true) {
+    const auto itr = this->index1s.find(key1);
+    if (itr == this->index1s.end())
+        return nullptr;
+
+    const auto i = itr->second / this->gvt.fragment_shape()[0];
+    if (this->limits[i] != traceno)
+        return nullptr;
+
+    switch (this->states[i]) {
+        case lane_state::open:
+            this->states[i] = lane_state::done;
+            return std::move(this->lanes[i]);
+
+        case lane_state::pending:
+            /*
+             * All traces of the lane are off the grid of this level
+             */
+            this->states[i] = lane_state::done;
+            return nullptr;
+
+        case lane_state::deferred:
+        case lane_state::done:
+            return nullptr;
+    }
+    return nullptr;
+}
+
+void level::begin_pass() noexcept (true) {
+    for (auto& state : this->states) {
+        if (state == lane_state::deferred)
+            state = lane_state::pending;
+    }
+}
+
+std::vector< std::unique_ptr< lane > > level::end_pass() noexcept (true) {
+    /*
+     * All lanes should be committed by their last trace, but a manifest
+     * with the wrong last traces should not leave lanes behind. Lanes that
+     * were never touched have no traces on this level.
+     */
+    std::vector< std::unique_ptr< lane > > leftover;
+    for (std::size_t i = 0; i < this->states.size(); ++i) {
+        auto& state = this->states[i];
+        if (state == lane_state::open)
+            leftover.push_back(std::move(this->lanes[i]));
+        if (state != lane_state::deferred)
+            state = lane_state::done;
+    }
+    return leftover;
+}
+
+bool level::done() const noexcept (true) {
+    return std::all_of(
+        this->states.begin(),
+        this->states.end(),
+        [](lane_state state) { return state == lane_state::done; }
+    );
+}
+
+/*
+ * The stats of the traced samples of the fragment, in the record layout of
+ * the fragment stats sidecar (see the summary proc in process.cpp). The
+ * histogram is computed like numpy.histogram, so the sidecar is the same as
+ * the one written by upload.py.
+ */
+void level::summarise(const lane& l, std::size_t j, std::size_t k)
+noexcept (true) {
+    const auto& fs = this->gvt.fragment_shape();
+    const auto samples = this->gvt.nsamples(dimension< 3 >(2));
+    const auto nz = std::min(std::size_t(fs[2]), samples - k * fs[2]);
+    const float* fragment = l.columns[j].data() + k * this->fragment_size;
+    const auto& traced = l.traced[j];
+
+    std::uint32_t count = 0;
+    float lo = 0;
+    float hi = 0;
+    double sum   = 0;
+    double sumsq = 0;
+    for (std::size_t t = 0; t < traced.size(); ++t) {
+        if (not traced[t]) continue;
+        const float* trace = fragment + t * fs[2];
+        for (std::size_t z = 0; z < nz; ++z) {
+            const auto x = trace[z];
+            lo = count == 0 ? x : std::min(lo, x);
+            hi = count == 0 ? x : std::max(hi, x);
+            sum   += x;
+            sumsq += double(x) * x;
+            count += 1;
+        }
+    }
+
+    const auto id = (l.i * this->ncolumns + j) * this->nsections + k;
+    char* record = this->stats.data() + id * this->record_size();
+    if (count == 0)
+        return;
+
+    std::vector< std::uint32_t > hist(this->statsbins, 0);
+    const auto bins = this->statsbins;
+    const auto norm = double(bins) / (double(hi) - double(lo));
+    for (std::size_t t = 0; t < traced.size(); ++t) {
+        if (not traced[t]) continue;
+        const float* trace = fragment + t * fs[2];
+        for (std::size_t z = 0; z < nz; ++z) {
+            /*
+             * numpy makes the range [lo - 0.5, hi + 0.5] when lo == hi, so
+             * all samples are in the middle bin
+             */
+            const auto bin = lo == hi
+                ? bins / 2
+                : std::min(int((trace[z] - double(lo)) * norm), bins - 1)
+                ;
+            hist[bin] += 1;
+        }
+    }
+
+    const float values[] = {
+        lo,
+        hi,
+        float(sum / count),
+        float(std::sqrt(sumsq / count)),
+    };
+    std::memcpy(record, values, sizeof(values));
+    record += sizeof(values);
+    std::memcpy(record, &count, sizeof(count));
+    record += sizeof(count);
+    std::memcpy(record, hist.data(), hist.size() * sizeof(std::uint32_t));
+}
+
+std::size_t level::write(const lane& l, fragment_sink& sink) noexcept (false) {
+    std::size_t written = 0;
+    for (std::size_t j = 0; j < l.columns.size(); ++j) {
+        const auto& column = l.columns[j];
+        if (column.empty())
+            continue;
+
+        for (std::size_t k = 0; k < this->nsections; ++k) {
+            if (this->statsbins > 0)
+                this->summarise(l, j, k);
+
+            const auto id = one::FID< 3 >(l.i, j, k);
+            const auto path = fmt::format("{}/{}.f32", this->prefix, id.string());
+            const auto* fragment = column.data() + k * this->fragment_size;
+            sink.put(
+                path,
+                reinterpret_cast< const char* >(fragment),
+                this->fragment_size * sizeof(float)
+            );
+            written += 1;
+        }
+    }
+    return written;
+}
+
+/*
+ * Bit n = i * columns(j) + j is set when the column is stored, and is bit n %
+ * 8 (least significant first) of byte n / 8, as hex. See fragment_mask in
+ * messages.hpp.
+ */
+std::string level::mask() const noexcept (false) {
+    std::vector< unsigned char > bytes((this->columns.size() + 7) / 8, 0);
+    for (std::size_t n = 0; n < this->columns.size(); ++n) {
+        if (this->columns[n])
+            bytes[n / 8] |= 1 << (n % 8);
+    }
+
+    std::string hex;
+    for (const auto byte : bytes)
+        hex += fmt::format("{:02x}", byte);
+    return hex;
+}
+
+struct job {
+    level* lvl;
+    std::unique_ptr< lane > l;
+};
+
+/*
+ * The writer threads write committed lanes, in commit order, and release
+ * their memory. The first error is kept and rethrown by finish(), and once
+ * a writer has failed, the remaining lanes are dropped.
+ */
+class writers {
+public:
+    writers(int threads, fragment_sink& sink, budget& mem) noexcept (false);
+    ~writers();
+
+    void submit(level&, std::unique_ptr< lane >) noexcept (false);
+    bool failed() noexcept (true);
+    std::size_t finish() noexcept (false);
+
+private:
+    fragment_sink& sink;
+    budget& mem;
+
+    std::vector< std::thread > threads;
+    std::queue< job > jobs;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool closed = false;
+    std::exception_ptr error;
+    std::size_t fragments = 0;
+
+    void run() noexcept (true);
+};
+
+writers::writers(int threads, fragment_sink& sink, budget& mem)
+noexcept (false) :
+    sink(sink),
+    mem(mem)
+{
+    if (threads < 1)
+        throw std::invalid_argument("ingest: threads must be >= 1");
+    for (int i = 0; i < threads; ++i)
+        this->threads.emplace_back([this] { this->run(); });
+}
+
+writers::~writers() {
+    {
+        std::lock_guard< std::mutex > lock(this->mtx);
+        this->closed = true;
+    }
+    this->cv.notify_all();
+    for (auto& thread : this->threads) {
+        if (thread.joinable())
+            thread.join();
+    }
+}
+
+void writers::submit(level& lvl, std::unique_ptr< lane > l) noexcept (false) {
+    this->mem.writing_lane();
+    {
+        std::lock_guard< std::mutex > lock(this->mtx);
+        this->jobs.push(job { &lvl, std::move(l) });
+    }
+    this->cv.notify_one();
+}
+
+bool writers::failed() noexcept (true) {
+    std::lock_guard< std::mutex > lock(this->mtx);
+    return bool(this->error);
+}
+
+void writers::run() noexcept (true) {
+    while (true) {
+        job next;
+        {
+            std::unique_lock< std::mutex > lock(this->mtx);
+            this->cv.wait(lock, [this] {
+                return this->closed or not this->jobs.empty();
+            });
+            if (this->jobs.empty())
+                return;
+            next = std::move(this->jobs.front());
+            this->jobs.pop();
+            if (this->error) {
+                this->mem.written_lane(next.l->reserved);
+                continue;
+            }
+        }
+
+        try {
+            const auto n = next.lvl->write(*next.l, this->sink);
+            std::lock_guard< std::mutex > lock(this->mtx);
+            this->fragments += n;
+        } catch (...) {
+            std::lock_guard< std::mutex > lock(this->mtx);
+            if (not this->error)
+                this->error = std::current_exception();
+        }
+
+        const auto reserved = next.l->reserved;
+        next.l.reset();
+        this->mem.written_lane(reserved);
+    }
+}
+
+std::size_t writers::finish() noexcept (false) {
+    {
+        std::lock_guard< std::mutex > lock(this->mtx);
+        this->closed = true;
+    }
+    this->cv.notify_all();
+    for (auto& thread : this->threads)
+        thread.join();
+
+    if (this->error)
+        std::rethrow_exception(this->error);
+    return this->fragments;
+}
+
+segy_layout layout(const nlohmann::json& manifest, std::size_t len)
+noexcept (false) {
+    segy_layout x;
+    x.first      = manifest.at("byteoffset-first-trace").get< std::size_t >();
+    x.samples    = manifest.at("dimensions").at(2).size();
+    x.format     = manifest.at("format").get< int >();
+    x.big_endian = manifest.value("byteorder", "big") == "big";
+    x.tracelen   = 240 + x.samples * 4;
+
+    const auto& words = manifest.at("key-words");
+    x.word1 = words.at(0).get< std::size_t >();
+    x.word2 = words.at(1).get< std::size_t >();
+    x.size1 = header_word_size(int(x.word1));
+    x.size2 = header_word_size(int(x.word2));
+
+    if (x.format != 1 and x.format != 5) {
+        const auto msg = "unsupported SEG-Y format {}, expected "
+                         "1 (IBM float) or 5 (IEEE float)";
+        throw std::invalid_argument(fmt::format(msg, x.format));
+    }
+
+    if (len < x.first or (len - x.first) % x.tracelen != 0) {
+        const auto msg = "SEG-Y file of {} bytes is not {} bytes of headers "
+                         "and traces of {} bytes";
+        throw std::invalid_argument(
+            fmt::format(msg, len, x.first, x.tracelen)
+        );
+    }
+    return x;
+}
+
+}
+
+std::string ingest(
+        const char* segy,
+        std::size_t len,
+        const std::string& manifest,
+        fragment_sink& sink,
+        const ingest_options& opts,
+        ingest_stats* stats)
+noexcept (false) {
+    auto doc = nlohmann::json::parse(manifest);
+    const auto file = layout(doc, len);
+    const auto ntraces = (len - file.first) / file.tracelen;
+    const auto guid = doc.at("guid").get< std::string >();
+
+    if (opts.fragment_shape.size() != 3) {
+        const auto msg = "expected fragment shape of 3 elements, was {}";
+        throw std::invalid_argument(
+            fmt::format(msg, opts.fragment_shape.size())
+        );
+    }
+    for (const auto x : opts.fragment_shape) {
+        if (x < 1)
+            throw std::invalid_argument("fragment shape must be positive");
+    }
+    const auto fs = one::FS< 3 >(
+        opts.fragment_shape[0],
+        opts.fragment_shape[1],
+        opts.fragment_shape[2]
+    );
+    const auto shapeident = fs.string();
+
+    std::vector< int > decimations;
+    for (const auto d : opts.decimations) {
+        if (d > 1) decimations.push_back(d);
+    }
+    std::sort(decimations.begin(), decimations.end());
+    decimations.erase(
+        std::unique(decimations.begin(), decimations.end()),
+        decimations.end()
+    );
+
+    /*
+     * The stats are only of the full resolution cube, which is the first
+     * level
+     */
+    std::vector< std::unique_ptr< level > > levels;
+    levels.push_back(std::make_unique< level >(
+        doc,
+        fmt::format("{}/src/{}", guid, shapeident),
+        fs,
+        1,
+        opts.statsbins
+    ));
+    for (const auto d : decimations) {
+        levels.push_back(std::make_unique< level >(
+            doc,
+            fmt::format("{}/lod{}/{}", guid, d, shapeident),
+            fs,
+            d,
+            0
+        ));
+    }
+
+    const auto lane_size = levels.front()->lane_size();
+    if (lane_size > opts.memory) {
+        const auto msg = "memory budget of {} bytes is less than a lane "
+                         "({} bytes)";
+        throw std::invalid_argument(fmt::format(msg, opts.memory, lane_size));
+    }
+
+    budget mem(opts.memory);
+    writers pool(opts.threads, sink, mem);
+    std::vector< float > trace(file.samples);
+    std::vector< lane* > targets(levels.size());
+
+    int passes = 0;
+    const auto done = [&levels] {
+        return std::all_of(levels.begin(), levels.end(), [](const auto& lvl) {
+            return lvl->done();
+        });
+    };
+    while (not done() and not pool.failed()) {
+        passes += 1;
+        for (auto& lvl : levels)
+            lvl->begin_pass();
+
+        for (std::size_t t = 0; t < ntraces; ++t) {
+            const char* header = segy
+                               + file.first
+                               + t * file.tracelen
+                               ;
+            const auto key1 = read_word(
+                header + file.word1 - 1,
+                file.size1,
+                file.big_endian
+            );
+            const auto key2 = read_word(
+                header + file.word2 - 1,
+                file.size2,
+                file.big_endian
+            );
+
+            bool wanted = false;
+            for (std::size_t n = 0; n < levels.size(); ++n) {
+                targets[n] = levels[n]->admit(key1, key2, mem);
+                wanted = wanted or targets[n];
+            }
+
+            /*
+             * The trace is decoded once, and only when it goes into at least
+             * one of the open lanes
+             */
+            if (wanted) {
+                decode_samples(
+                    trace.data(),
+                    header + 240,
+                    file.samples,
+                    file.format,
+                    file.big_endian
+                );
+            }
+
+            for (std::size_t n = 0; n < levels.size(); ++n) {
+                auto& lvl = *levels[n];
+                if (targets[n])
+                    lvl.put(*targets[n], key1, key2, trace.data());
+                auto l = lvl.commit(t, key1);
+                if (l)
+                    pool.submit(lvl, std::move(l));
+            }
+
+            if (pool.failed())
+                break;
+        }
+
+        for (auto& lvl : levels) {
+            for (auto& l : lvl->end_pass())
+                pool.submit(*lvl, std::move(l));
+        }
+    }
+    const auto fragments = pool.finish();
+
+    doc["decimations"] = decimations;
+    auto masks = nlohmann::json::object();
+    for (const auto& lvl : levels)
+        masks[std::to_string(lvl->decimation)] = lvl->mask();
+    doc["fragment-mask"] = masks;
+    doc["fill-value"] = 0;
+
+    const auto& src = *levels.front();
+    if (opts.statsbins > 0) {
+        sink.put(
+            src.prefix + "/stats.bin",
+            src.stats.data(),
+            src.stats.size()
+        );
+        doc["fragment-stats"] = {
+            { "shape", opts.fragment_shape },
+            { "bins",  opts.statsbins      },
+        };
+    }
+
+    const auto out = doc.dump();
+    sink.put(guid + "/manifest.json", out.data(), out.size());
+
+    if (stats) {
+        stats->traces    = ntraces;
+        stats->fragments = fragments;
+        stats->bytes     = fragments * fs[0] * fs[1] * fs[2] * sizeof(float);
+        stats->passes    = passes;
+    }
+    return out;
+}
+
+}
@@ -1,9 +1,14 @@
+#include <cmath>
+#include <limits>
 #include <string>
 
 #include <fmt/format.h>
 #include <nlohmann/json.hpp>
 
+#include <oneseismic/attributes.hpp>
+#include <oneseismic/encoding.hpp>
 #include <oneseismic/messages.hpp>
+#include <oneseismic/tracing.hpp>
 
 namespace one {
 
@@ -17,6 +22,14 @@ void to_json(nlohmann::json& doc, const common_task& task) noexcept (false) {
     doc["shape"]            = task.shape;
     doc["shape-cube"]       = task.shape_cube;
     doc["function"]         = task.function;
+    doc["format"]           = task.format;
+    doc["decimation"]       = task.decimation;
+    doc["attribute"]        = task.attribute;
+    doc["attribute-window"] = task.attribute_window;
+    if (not task.fragment_mask.empty()) {
+        doc["fragment-mask"] = task.fragment_mask;
+        doc["fill-value"]    = task.fill_value;
+    }
 }
 
 void from_json(const nlohmann::json& doc, common_task& task) noexcept (false) {
@@ -28,13 +41,97 @@ void from_json(const nlohmann::json& doc, common_task& task) noexcept (false) {
     doc.at("shape")           .get_to(task.shape);
     doc.at("shape-cube")      .get_to(task.shape_cube);
     doc.at("function")        .get_to(task.function);
+    task.format     = doc.value("format", "f32");
+    task.decimation = doc.value("decimation", 1);
+    if (task.decimation < 1) {
+        const auto msg = "expected decimation (= {}) >= 1";
+        throw bad_message(fmt::format(msg, task.decimation));
+    }
+
+    task.attribute        = doc.value("attribute", "none");
+    task.attribute_window = doc.value("attribute-window", 1);
+    if (task.attribute_window < 1) {
+        const auto msg = "expected attribute-window (= {}) >= 1";
+        throw bad_message(fmt::format(msg, task.attribute_window));
+    }
+
+    task.fragment_mask = doc.value("fragment-mask", "");
+    task.fill_value    = doc.value("fill-value", 0.0f);
+
+    try {
+        parse_encoding(task.format);
+        parse_attribute(task.attribute);
+    } catch (const std::invalid_argument& e) {
+        throw bad_message(e.what());
+    }
+}
+
+fragment_mask::fragment_mask(const common_task& task) noexcept (false) {
+    if (task.fragment_mask.empty())
+        return;
+
+    const auto count = [&task](int dim) {
+        return (task.shape_cube[dim] + task.shape[dim] - 1) / task.shape[dim];
+    };
+    this->columns = count(1);
+    const auto n = std::size_t(count(0) * this->columns);
+
+    const auto& hex = task.fragment_mask;
+    if (hex.size() != 2 * ((n + 7) / 8)) {
+        const auto msg = "expected fragment-mask of {} columns ({} chars), was {}";
+        throw bad_message(fmt::format(msg, n, 2 * ((n + 7) / 8), hex.size()));
+    }
+
+    const auto nibble = [&hex](std::size_t i) {
+        const auto c = hex[i];
+        if ('0' <= c and c <= '9') return c - '0';
+        if ('a' <= c and c <= 'f') return c - 'a' + 10;
+        if ('A' <= c and c <= 'F') return c - 'A' + 10;
+        const auto msg = "expected hex in fragment-mask, was '{}'";
+        throw bad_message(fmt::format(msg, c));
+    };
+
+    this->bits.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto byte = nibble(2 * (i / 8)) * 16 + nibble(2 * (i / 8) + 1);
+        this->bits[i] = (byte >> (i % 8)) & 1;
+    }
+}
+
+bool fragment_mask::stored(int i, int j) const noexcept (true) {
+    if (this->bits.empty())
+        return true;
+    return this->bits[i * this->columns + j];
+}
+
+void to_json(nlohmann::json& doc, const process_phase& phase) noexcept (false) {
+    doc["ntasks"]     = phase.ntasks;
+    doc["decimation"] = phase.decimation;
+    doc["shape"]      = phase.shape;
+    doc["index"]      = phase.index;
+    if (phase.lineno != std::numeric_limits< int >::min())
+        doc["lineno"] = phase.lineno;
+}
+
+void from_json(const nlohmann::json& doc, process_phase& phase) noexcept (false) {
+    doc.at("ntasks")    .get_to(phase.ntasks);
+    doc.at("decimation").get_to(phase.decimation);
+    doc.at("shape")     .get_to(phase.shape);
+    doc.at("index")     .get_to(phase.index);
+    phase.lineno = doc.value("lineno", std::numeric_limits< int >::min());
 }
 
 void to_json(nlohmann::json& doc, const process_header& head) noexcept (false) {
-    doc["pid"]    = head.pid;
-    doc["ntasks"] = head.ntasks;
-    doc["shape"]  = head.shape;
-    doc["index"]  = head.index;
+    doc["pid"]        = head.pid;
+    doc["ntasks"]     = head.ntasks;
+    doc["shape"]      = head.shape;
+    doc["index"]      = head.index;
+    doc["format"]     = head.format;
+    doc["decimation"] = head.decimation;
+    doc["phases"]     = head.phases;
+    if (head.lineno != std::numeric_limits< int >::min())
+        doc["lineno"] = head.lineno;
+    doc["fill-value"] = head.fill_value;
 }
 
 void from_json(const nlohmann::json& doc, process_header& head) noexcept (false) {
@@ -42,14 +139,26 @@ void from_json(const nlohmann::json& doc, process_header& head) noexcept (false)
     doc.at("ntasks").get_to(head.ntasks);
     doc.at("shape") .get_to(head.shape);
     doc.at("index") .get_to(head.index);
+    head.format     = doc.value("format", "f32");
+    head.decimation = doc.value("decimation", 1);
+    if (doc.find("phases") != doc.end())
+        doc.at("phases").get_to(head.phases);
+    head.lineno = doc.value("lineno", std::numeric_limits< int >::min());
+    head.fill_value = doc.value("fill-value", 0.0f);
 }
 
 void to_json(nlohmann::json& doc, const slice_task& task) noexcept (false) {
     to_json(doc, static_cast< const common_task& >(task));
     doc["function"] = "slice";
     auto& params = doc["params"];
-    params["dim"]    = task.dim;
-    params["lineno"] = task.lineno;
+    params["dim"]          = task.dim;
+    params["lineno"]       = task.lineno;
+    params["target_shape"] = task.target_shape;
+    params["progressive"]  = task.progressive;
+    params["zmin"]         = task.zmin;
+    params["zmax"]         = task.zmax;
+    params["roi"]          = task.roi;
+    params["stride"]       = task.stride;
 }
 
 void from_json(const nlohmann::json& doc, slice_task& task) noexcept (false) {
@@ -63,14 +172,50 @@ void from_json(const nlohmann::json& doc, slice_task& task) noexcept (false) {
     const auto& params = doc.at("params");
     params.at("dim")   .get_to(task.dim);
     params.at("lineno").get_to(task.lineno);
+    task.target_shape = params.value("target_shape", std::vector< int >());
+    task.progressive  = params.value("progressive", false);
+    task.zmin = params.value("zmin", std::numeric_limits< int >::min());
+    task.zmax = params.value("zmax", std::numeric_limits< int >::max());
+    task.roi    = params.value("roi",    std::vector< std::array< int, 2 > >());
+    task.stride = params.value("stride", std::vector< int >());
+
+    if (task.zmin > task.zmax) {
+        const auto msg = "expected zmin (= {}) <= zmax (= {})";
+        throw bad_message(fmt::format(msg, task.zmin, task.zmax));
+    }
+
+    if (not task.roi.empty() and task.roi.size() != 2) {
+        const auto msg = "expected roi of 2 ranges, was {}";
+        throw bad_message(fmt::format(msg, task.roi.size()));
+    }
+    for (const auto& range : task.roi) {
+        if (range[0] > range[1]) {
+            const auto msg = "expected roi first (= {}) <= last (= {})";
+            throw bad_message(fmt::format(msg, range[0], range[1]));
+        }
+    }
+
+    if (not task.stride.empty() and task.stride.size() != 2) {
+        const auto msg = "expected stride of 2 elements, was {}";
+        throw bad_message(fmt::format(msg, task.stride.size()));
+    }
+    for (const auto stride : task.stride) {
+        if (stride < 1) {
+            const auto msg = "expected stride >= 1, was {}";
+            throw bad_message(fmt::format(msg, stride));
+        }
+    }
 }
 
 void to_json(nlohmann::json& doc, const curtain_task& task) noexcept (false) {
     to_json(doc, static_cast< const common_task& >(task));
     doc["function"] = "curtain";
     auto& params = doc["params"];
-    params["dim0s"] = task.dim0s;
-    params["dim1s"] = task.dim1s;
+    params["dim0s"]        = task.dim0s;
+    params["dim1s"]        = task.dim1s;
+    params["target_shape"] = task.target_shape;
+    params["zmin"]         = task.zmin;
+    params["zmax"]         = task.zmax;
 }
 
 void from_json(const nlohmann::json& doc, curtain_task& task) noexcept (false) {
@@ -84,15 +229,283 @@ void from_json(const nlohmann::json& doc, curtain_task& task) noexcept (false) {
     const auto& params = doc.at("params");
     params.at("dim0s").get_to(task.dim0s);
     params.at("dim1s").get_to(task.dim1s);
+    task.target_shape = params.value("target_shape", std::vector< int >());
+    task.zmin = params.value("zmin", std::numeric_limits< int >::min());
+    task.zmax = params.value("zmax", std::numeric_limits< int >::max());
+
+    if (task.zmin > task.zmax) {
+        const auto msg = "expected zmin (= {}) <= zmax (= {})";
+        throw bad_message(fmt::format(msg, task.zmin, task.zmax));
+    }
+}
+
+void to_json(nlohmann::json& doc, const horizon_task& task) noexcept (false) {
+    to_json(doc, static_cast< const common_task& >(task));
+    doc["function"] = "horizon";
+    auto& params = doc["params"];
+    params["dim0s"]   = task.dim0s;
+    params["dim1s"]   = task.dim1s;
+    params["surface"] = task.surface;
+    params["window"]  = task.window;
+}
+
+void from_json(const nlohmann::json& doc, horizon_task& task) noexcept (false) {
+    from_json(doc, static_cast< common_task& >(task));
+
+    if (task.function != "horizon") {
+        const auto msg = "expected task 'horizon', got {}";
+        throw bad_message(fmt::format(msg, task.function));
+    }
+
+    const auto& params = doc.at("params");
+    params.at("dim0s")  .get_to(task.dim0s);
+    params.at("dim1s")  .get_to(task.dim1s);
+    params.at("surface").get_to(task.surface);
+    task.window = params.value("window", 0);
+
+    if (task.window < 0) {
+        const auto msg = "expected window (= {}) >= 0";
+        throw bad_message(fmt::format(msg, task.window));
+    }
+
+    const auto points = task.dim0s.size() * task.dim1s.size();
+    if (task.surface.size() != points) {
+        const auto msg = "expected surface of {}x{} (= {}) points, was {}";
+        throw bad_message(fmt::format(
+            msg,
+            task.dim0s.size(),
+            task.dim1s.size(),
+            points,
+            task.surface.size()
+        ));
+    }
+}
+
+void to_json(nlohmann::json& doc, const wellpath_task& task) noexcept (false) {
+    to_json(doc, static_cast< const common_task& >(task));
+    doc["function"] = "wellpath";
+    auto& params = doc["params"];
+    params["points"]      = task.points;
+    params["coordinates"] = task.coordinates;
+}
+
+void from_json(const nlohmann::json& doc, wellpath_task& task) noexcept (false) {
+    from_json(doc, static_cast< common_task& >(task));
+
+    if (task.function != "wellpath") {
+        const auto msg = "expected task 'wellpath', got {}";
+        throw bad_message(fmt::format(msg, task.function));
+    }
+
+    const auto& params = doc.at("params");
+    params.at("points").get_to(task.points);
+    task.coordinates = params.value("coordinates", "label");
+
+    if (task.coordinates != "grid"
+    and task.coordinates != "label"
+    and task.coordinates != "world") {
+        const auto msg = "expected coordinates 'grid', 'label' or 'world', "
+                         "got {}";
+        throw bad_message(fmt::format(msg, task.coordinates));
+    }
+}
+
+void to_json(nlohmann::json& doc, const points_task& task) noexcept (false) {
+    to_json(doc, static_cast< const common_task& >(task));
+    doc["function"] = "points";
+    auto& params = doc["params"];
+    params["dim0s"]       = task.dim0s;
+    params["dim1s"]       = task.dim1s;
+    params["dim2s"]       = task.dim2s;
+    params["coordinates"] = task.coordinates;
+}
+
+void from_json(const nlohmann::json& doc, points_task& task) noexcept (false) {
+    from_json(doc, static_cast< common_task& >(task));
+
+    if (task.function != "points") {
+        const auto msg = "expected task 'points', got {}";
+        throw bad_message(fmt::format(msg, task.function));
+    }
+
+    const auto& params = doc.at("params");
+    params.at("dim0s").get_to(task.dim0s);
+    params.at("dim1s").get_to(task.dim1s);
+    params.at("dim2s").get_to(task.dim2s);
+    task.coordinates = params.value("coordinates", "grid");
+
+    if (task.coordinates != "grid" and task.coordinates != "label") {
+        const auto msg = "expected coordinates 'grid' or 'label', got {}";
+        throw bad_message(fmt::format(msg, task.coordinates));
+    }
+
+    if (task.dim0s.size() != task.dim1s.size()
+     or task.dim0s.size() != task.dim2s.size()) {
+        const auto msg = "expected dim0s, dim1s, dim2s of the same size, "
+                         "were {}, {}, {}";
+        throw bad_message(fmt::format(
+            msg,
+            task.dim0s.size(),
+            task.dim1s.size(),
+            task.dim2s.size()
+        ));
+    }
+}
+
+void to_json(nlohmann::json& doc, const polyline_task& task) noexcept (false) {
+    to_json(doc, static_cast< const common_task& >(task));
+    doc["function"] = "polyline";
+    auto& params = doc["params"];
+    params["points"]      = task.points;
+    params["spacing"]     = task.spacing;
+    params["coordinates"] = task.coordinates;
+}
+
+void from_json(const nlohmann::json& doc, polyline_task& task) noexcept (false) {
+    from_json(doc, static_cast< common_task& >(task));
+
+    if (task.function != "polyline") {
+        const auto msg = "expected task 'polyline', got {}";
+        throw bad_message(fmt::format(msg, task.function));
+    }
+
+    const auto& params = doc.at("params");
+    params.at("points").get_to(task.points);
+    task.spacing     = params.value("spacing", 1.0f);
+    task.coordinates = params.value("coordinates", "label");
+
+    if (task.coordinates != "grid"
+    and task.coordinates != "label"
+    and task.coordinates != "world") {
+        const auto msg = "expected coordinates 'grid', 'label' or 'world', "
+                         "got {}";
+        throw bad_message(fmt::format(msg, task.coordinates));
+    }
+
+    if (not std::isfinite(task.spacing) or task.spacing <= 0) {
+        const auto msg = "expected spacing (= {}) > 0";
+        throw bad_message(fmt::format(msg, task.spacing));
+    }
+}
+
+void to_json(nlohmann::json& doc, const area_task& task) noexcept (false) {
+    to_json(doc, static_cast< const common_task& >(task));
+    doc["function"] = "area";
+    auto& params = doc["params"];
+    params["polygon"]     = task.polygon;
+    params["coordinates"] = task.coordinates;
+    params["zmin"]        = task.zmin;
+    params["zmax"]        = task.zmax;
+}
+
+void from_json(const nlohmann::json& doc, area_task& task) noexcept (false) {
+    from_json(doc, static_cast< common_task& >(task));
+
+    if (task.function != "area") {
+        const auto msg = "expected task 'area', got {}";
+        throw bad_message(fmt::format(msg, task.function));
+    }
+
+    const auto& params = doc.at("params");
+    params.at("polygon").get_to(task.polygon);
+    task.coordinates = params.value("coordinates", "label");
+    task.zmin = params.value("zmin", std::numeric_limits< int >::min());
+    task.zmax = params.value("zmax", std::numeric_limits< int >::max());
+
+    if (task.coordinates != "grid"
+    and task.coordinates != "label"
+    and task.coordinates != "world") {
+        const auto msg = "expected coordinates 'grid', 'label' or 'world', "
+                         "got {}";
+        throw bad_message(fmt::format(msg, task.coordinates));
+    }
+
+    if (task.polygon.size() < 3) {
+        const auto msg = "expected polygon of at least 3 points, was {}";
+        throw bad_message(fmt::format(msg, task.polygon.size()));
+    }
+
+    if (task.zmin > task.zmax) {
+        const auto msg = "expected zmin (= {}) <= zmax (= {})";
+        throw bad_message(fmt::format(msg, task.zmin, task.zmax));
+    }
+}
+
+void to_json(nlohmann::json& doc, const stats_task& task) noexcept (false) {
+    to_json(doc, static_cast< const common_task& >(task));
+    doc["function"] = "stats";
+    auto& params = doc["params"];
+    params["dim"]    = task.dim;
+    params["lineno"] = task.lineno;
+    params["bins"]   = task.bins;
+}
+
+void from_json(const nlohmann::json& doc, stats_task& task) noexcept (false) {
+    from_json(doc, static_cast< common_task& >(task));
+
+    if (task.function != "stats") {
+        const auto msg = "expected task 'stats', got {}";
+        throw bad_message(fmt::format(msg, task.function));
+    }
+
+    const auto params = doc.value("params", nlohmann::json::object());
+    task.dim    = params.value("dim", -1);
+    task.lineno = params.value("lineno", 0);
+    task.bins   = params.value("bins", 64);
+
+    if (task.dim < -1) {
+        const auto msg = "expected dim (= {}) >= -1";
+        throw bad_message(fmt::format(msg, task.dim));
+    }
+
+    if (task.bins < 1) {
+        const auto msg = "expected bins (= {}) >= 1";
+        throw bad_message(fmt::format(msg, task.bins));
+    }
+}
+
+void to_json(nlohmann::json& doc, const batch_task& task) noexcept (false) {
+    to_json(doc, static_cast< const common_task& >(task));
+    doc["function"] = "batch";
+    auto& tasks = doc["params"]["tasks"];
+    tasks = nlohmann::json::array();
+    for (const auto& t : task.tasks)
+        tasks.push_back(nlohmann::json::parse(t));
+}
+
+void from_json(const nlohmann::json& doc, batch_task& task) noexcept (false) {
+    from_json(doc, static_cast< common_task& >(task));
+
+    if (task.function != "batch") {
+        const auto msg = "expected task 'batch', got {}";
+        throw bad_message(fmt::format(msg, task.function));
+    }
+
+    const auto& tasks = doc.at("params").at("tasks");
+    if (not tasks.is_array() or tasks.empty())
+        throw bad_message("expected non-empty array of tasks");
+
+    task.tasks.clear();
+    for (const auto& t : tasks) {
+        if (not t.is_object())
+            throw bad_message("expected batched task to be an object");
+        task.tasks.push_back(t.dump());
+    }
 }
 
 void to_json(nlohmann::json& doc, const slice_fetch& task) noexcept (false) {
     to_json(doc, static_cast< const slice_task& >(task));
+    doc["begin"]      = task.begin;
+    doc["end"]        = task.end;
+    doc["step"]       = task.step;
     doc["ids"]        = task.ids;
 }
 
 void from_json(const nlohmann::json& doc, slice_fetch& task) noexcept (false) {
     from_json(doc, static_cast< slice_task& >(task));
+    doc.at("begin")     .get_to(task.begin);
+    doc.at("end")       .get_to(task.end);
+    doc.at("step")      .get_to(task.step);
     doc.at("ids")       .get_to(task.ids);
 
     if (task.ids.empty()) {
@@ -123,7 +536,14 @@ void to_json(nlohmann::json& doc, const tile& tile) noexcept (false) {
     doc["initial-skip"] = tile.initial_skip;
     doc["superstride"]  = tile.superstride;
     doc["substride"]    = tile.substride;
-    doc["v"]            = tile.v;
+
+    if (tile.encoded.empty()) {
+        doc["v"]        = tile.v;
+    } else {
+        doc["v"]        = tile.encoded;
+        doc["scale"]    = tile.scale;
+        doc["offset"]   = tile.offset;
+    }
 }
 
 void from_json(const nlohmann::json& doc, tile& tile) noexcept (false) {
@@ -132,17 +552,56 @@ void from_json(const nlohmann::json& doc, tile& tile) noexcept (false) {
     doc.at("initial-skip").get_to(tile.initial_skip);
     doc.at("superstride") .get_to(tile.superstride);
     doc.at("substride")   .get_to(tile.substride);
-    doc.at("v")           .get_to(tile.v);
+
+    /*
+     * Encoded tiles always carry scale and offset, so use that to determine
+     * how to read the values. Decoding requires the format, which is a
+     * property of the full message, and is done by from_json(slice_tiles).
+     */
+    if (doc.find("scale") == doc.end()) {
+        doc.at("v").get_to(tile.v);
+    } else {
+        doc.at("v")     .get_to(tile.encoded);
+        doc.at("scale") .get_to(tile.scale);
+        doc.at("offset").get_to(tile.offset);
+    }
+}
+
+namespace {
+
+/*
+ * Decode the samples in-place, so that v holds the (lossy) samples regardless
+ * of the encoding. This is mostly useful for testing, as the packed messages
+ * are consumed by clients.
+ */
+template < typename T >
+void decode_inplace(const std::string& format, T& x) noexcept (false) {
+    const auto enc = parse_encoding(format);
+    if (enc == encoding::f32)
+        return;
+
+    x.v.resize(x.encoded.size());
+    const auto n = x.encoded.size();
+    decode(enc, x.encoded.data(), n, x.v.data(), x.scale, x.offset);
+}
+
 }
 
 void to_json(nlohmann::json& doc, const slice_tiles& tiles) noexcept (false) {
-    doc["shape"] = tiles.shape;
-    doc["tiles"] = tiles.tiles;
+    doc["shape"]      = tiles.shape;
+    doc["tiles"]      = tiles.tiles;
+    doc["format"]     = tiles.format;
+    doc["decimation"] = tiles.decimation;
 }
 
 void from_json(const nlohmann::json& doc, slice_tiles& tiles) noexcept (false) {
     doc.at("shape").get_to(tiles.shape);
     doc.at("tiles").get_to(tiles.tiles);
+    tiles.format     = doc.value("format", "f32");
+    tiles.decimation = doc.value("decimation", 1);
+
+    for (auto& tile : tiles.tiles)
+        decode_inplace(tiles.format, tile);
 }
 
 void to_json(nlohmann::json& doc, const single& single) noexcept (false) {
@@ -157,30 +616,392 @@ void from_json(const nlohmann::json& doc, single& single) noexcept (false) {
 
 void to_json(nlohmann::json& doc, const curtain_fetch& curtain) noexcept (false) {
     to_json(doc, static_cast< const curtain_task& >(curtain));
-    doc["ids"] = curtain.ids;
+    doc["zbegin"] = curtain.zbegin;
+    doc["zend"]   = curtain.zend;
+    doc["ids"]    = curtain.ids;
 }
 
 void from_json(const nlohmann::json& doc, curtain_fetch& curtain) noexcept (false) {
     from_json(doc, static_cast< curtain_task& >(curtain));
-    doc.at("ids").get_to(curtain.ids);
+    doc.at("zbegin").get_to(curtain.zbegin);
+    doc.at("zend")  .get_to(curtain.zend);
+    doc.at("ids")   .get_to(curtain.ids);
 }
 
 void to_json(nlohmann::json& doc, const trace& trace) noexcept (false) {
     doc["coordinates"] = trace.coordinates;
-    doc["v"]           = trace.v;
+
+    if (trace.encoded.empty()) {
+        doc["v"]      = trace.v;
+    } else {
+        doc["v"]      = trace.encoded;
+        doc["scale"]  = trace.scale;
+        doc["offset"] = trace.offset;
+    }
 }
 
 void from_json(const nlohmann::json& doc, trace& trace) noexcept (false) {
     doc.at("coordinates").get_to(trace.coordinates);
-    doc.at("v")          .get_to(trace.v);
+
+    if (doc.find("scale") == doc.end()) {
+        doc.at("v").get_to(trace.v);
+    } else {
+        doc.at("v")     .get_to(trace.encoded);
+        doc.at("scale") .get_to(trace.scale);
+        doc.at("offset").get_to(trace.offset);
+    }
 }
 
 void to_json(nlohmann::json& doc, const curtain_traces& traces) noexcept (false) {
     doc["traces"] = traces.traces;
+    doc["format"] = traces.format;
 }
 
 void from_json(const nlohmann::json& doc, curtain_traces& traces) noexcept (false) {
     doc.at("traces").get_to(traces.traces);
+    traces.format = doc.value("format", "f32");
+
+    for (auto& trace : traces.traces)
+        decode_inplace(traces.format, trace);
+}
+
+void to_json(nlohmann::json& doc, const horizon_column& column)
+noexcept (false) {
+    doc["id"]     = column.id;
+    doc["ks"]     = column.ks;
+    doc["points"] = column.points;
+}
+
+void from_json(const nlohmann::json& doc, horizon_column& column)
+noexcept (false) {
+    doc.at("id")    .get_to(column.id);
+    doc.at("ks")    .get_to(column.ks);
+    doc.at("points").get_to(column.points);
+}
+
+void to_json(nlohmann::json& doc, const horizon_fetch& horizon)
+noexcept (false) {
+    to_json(doc, static_cast< const horizon_task& >(horizon));
+    doc["ids"] = horizon.ids;
+}
+
+void from_json(const nlohmann::json& doc, horizon_fetch& horizon)
+noexcept (false) {
+    from_json(doc, static_cast< horizon_task& >(horizon));
+    doc.at("ids").get_to(horizon.ids);
+}
+
+void to_json(nlohmann::json& doc, const horizon_values& values)
+noexcept (false) {
+    doc["index"]  = values.index;
+    doc["window"] = values.window;
+    doc["format"] = values.format;
+
+    if (values.encoded.empty()) {
+        doc["v"]      = values.v;
+    } else {
+        doc["v"]      = values.encoded;
+        doc["scale"]  = values.scale;
+        doc["offset"] = values.offset;
+    }
+}
+
+void from_json(const nlohmann::json& doc, horizon_values& values)
+noexcept (false) {
+    doc.at("index") .get_to(values.index);
+    doc.at("window").get_to(values.window);
+    values.format = doc.value("format", "f32");
+
+    if (doc.find("scale") == doc.end()) {
+        doc.at("v").get_to(values.v);
+    } else {
+        doc.at("v")     .get_to(values.encoded);
+        doc.at("scale") .get_to(values.scale);
+        doc.at("offset").get_to(values.offset);
+    }
+    decode_inplace(values.format, values);
+}
+
+void to_json(nlohmann::json& doc, const area_column& column)
+noexcept (false) {
+    doc["id"]   = column.id;
+    doc["ks"]   = column.ks;
+    doc["mask"] = column.mask;
+}
+
+void from_json(const nlohmann::json& doc, area_column& column)
+noexcept (false) {
+    doc.at("id")  .get_to(column.id);
+    doc.at("ks")  .get_to(column.ks);
+    doc.at("mask").get_to(column.mask);
+}
+
+void to_json(nlohmann::json& doc, const area_fetch& area) noexcept (false) {
+    to_json(doc, static_cast< const area_task& >(area));
+    doc["zbegin"] = area.zbegin;
+    doc["zend"]   = area.zend;
+    doc["ids"]    = area.ids;
+}
+
+void from_json(const nlohmann::json& doc, area_fetch& area) noexcept (false) {
+    from_json(doc, static_cast< area_task& >(area));
+    doc.at("zbegin").get_to(area.zbegin);
+    doc.at("zend")  .get_to(area.zend);
+    doc.at("ids")   .get_to(area.ids);
+}
+
+void to_json(nlohmann::json& doc, const area_traces& traces)
+noexcept (false) {
+    doc["dim0s"]   = traces.dim0s;
+    doc["dim1s"]   = traces.dim1s;
+    doc["samples"] = traces.samples;
+    doc["format"]  = traces.format;
+
+    if (traces.encoded.empty()) {
+        doc["v"]      = traces.v;
+    } else {
+        doc["v"]      = traces.encoded;
+        doc["scale"]  = traces.scale;
+        doc["offset"] = traces.offset;
+    }
+}
+
+void from_json(const nlohmann::json& doc, area_traces& traces)
+noexcept (false) {
+    doc.at("dim0s")  .get_to(traces.dim0s);
+    doc.at("dim1s")  .get_to(traces.dim1s);
+    doc.at("samples").get_to(traces.samples);
+    traces.format = doc.value("format", "f32");
+
+    if (doc.find("scale") == doc.end()) {
+        doc.at("v").get_to(traces.v);
+    } else {
+        doc.at("v")     .get_to(traces.encoded);
+        doc.at("scale") .get_to(traces.scale);
+        doc.at("offset").get_to(traces.offset);
+    }
+    decode_inplace(traces.format, traces);
+}
+
+void to_json(nlohmann::json& doc, const batch_query& query) noexcept (false) {
+    doc["pid"]      = query.pid;
+    doc["part"]     = query.part;
+    doc["function"] = query.function;
+    doc["fetch"]    = nlohmann::json::parse(query.fetch);
+}
+
+void from_json(const nlohmann::json& doc, batch_query& query) noexcept (false) {
+    doc.at("pid")     .get_to(query.pid);
+    doc.at("part")    .get_to(query.part);
+    doc.at("function").get_to(query.function);
+    query.fetch = doc.at("fetch").dump();
+}
+
+void to_json(nlohmann::json& doc, const batch_fetch& batch) noexcept (false) {
+    to_json(doc, static_cast< const common_task& >(batch));
+    doc["function"] = "batch";
+    doc["queries"]  = batch.queries;
+}
+
+void from_json(const nlohmann::json& doc, batch_fetch& batch) noexcept (false) {
+    from_json(doc, static_cast< common_task& >(batch));
+    doc.at("queries").get_to(batch.queries);
+}
+
+/*
+ * The body is already packed, and is stored as a (binary) string
+ */
+void to_json(nlohmann::json& doc, const batch_result& result) noexcept (false) {
+    doc["pid"]  = result.pid;
+    doc["part"] = result.part;
+    doc["body"] = result.body;
+}
+
+void from_json(const nlohmann::json& doc, batch_result& result)
+noexcept (false) {
+    doc.at("pid") .get_to(result.pid);
+    doc.at("part").get_to(result.part);
+    doc.at("body").get_to(result.body);
+}
+
+void to_json(nlohmann::json& doc, const batch_results& results)
+noexcept (false) {
+    doc["results"] = results.results;
+}
+
+void from_json(const nlohmann::json& doc, batch_results& results)
+noexcept (false) {
+    doc.at("results").get_to(results.results);
+}
+
+void to_json(nlohmann::json& doc, const wellpath_fetch& wellpath)
+noexcept (false) {
+    to_json(doc, static_cast< const wellpath_task& >(wellpath));
+    doc["index"] = wellpath.index;
+    doc["ids"]   = wellpath.ids;
+}
+
+void from_json(const nlohmann::json& doc, wellpath_fetch& wellpath)
+noexcept (false) {
+    from_json(doc, static_cast< wellpath_task& >(wellpath));
+    doc.at("index").get_to(wellpath.index);
+    doc.at("ids")  .get_to(wellpath.ids);
+
+    if (wellpath.index.size() != wellpath.points.size()) {
+        const auto msg = "expected index of {} points, was {}";
+        throw bad_message(fmt::format(
+            msg,
+            wellpath.points.size(),
+            wellpath.index.size()
+        ));
+    }
+}
+
+void to_json(nlohmann::json& doc, const polyline_fetch& polyline)
+noexcept (false) {
+    to_json(doc, static_cast< const polyline_task& >(polyline));
+    doc["index"] = polyline.index;
+    doc["ids"]   = polyline.ids;
+}
+
+void from_json(const nlohmann::json& doc, polyline_fetch& polyline)
+noexcept (false) {
+    from_json(doc, static_cast< polyline_task& >(polyline));
+    doc.at("index").get_to(polyline.index);
+    doc.at("ids")  .get_to(polyline.ids);
+
+    if (polyline.index.size() != polyline.points.size()) {
+        const auto msg = "expected index of {} points, was {}";
+        throw bad_message(fmt::format(
+            msg,
+            polyline.points.size(),
+            polyline.index.size()
+        ));
+    }
+}
+
+void to_json(nlohmann::json& doc, const polyline_traces& traces)
+noexcept (false) {
+    doc["index"]   = traces.index;
+    doc["points"]  = traces.points;
+    doc["samples"] = traces.samples;
+    doc["format"]  = traces.format;
+
+    if (traces.encoded.empty()) {
+        doc["v"]      = traces.v;
+    } else {
+        doc["v"]      = traces.encoded;
+        doc["scale"]  = traces.scale;
+        doc["offset"] = traces.offset;
+    }
+}
+
+void from_json(const nlohmann::json& doc, polyline_traces& traces)
+noexcept (false) {
+    doc.at("index")  .get_to(traces.index);
+    doc.at("points") .get_to(traces.points);
+    doc.at("samples").get_to(traces.samples);
+    traces.format = doc.value("format", "f32");
+
+    if (doc.find("scale") == doc.end()) {
+        doc.at("v").get_to(traces.v);
+    } else {
+        doc.at("v")     .get_to(traces.encoded);
+        doc.at("scale") .get_to(traces.scale);
+        doc.at("offset").get_to(traces.offset);
+    }
+    decode_inplace(traces.format, traces);
+}
+
+void to_json(nlohmann::json& doc, const points_fragment& fragment)
+noexcept (false) {
+    doc["id"]      = fragment.id;
+    doc["offsets"] = fragment.offsets;
+    doc["index"]   = fragment.index;
+}
+
+void from_json(const nlohmann::json& doc, points_fragment& fragment)
+noexcept (false) {
+    doc.at("id")     .get_to(fragment.id);
+    doc.at("offsets").get_to(fragment.offsets);
+    doc.at("index")  .get_to(fragment.index);
+}
+
+void to_json(nlohmann::json& doc, const points_fetch& points)
+noexcept (false) {
+    to_json(doc, static_cast< const points_task& >(points));
+    doc["ids"] = points.ids;
+}
+
+void from_json(const nlohmann::json& doc, points_fetch& points)
+noexcept (false) {
+    from_json(doc, static_cast< points_task& >(points));
+    doc.at("ids").get_to(points.ids);
+}
+
+void to_json(nlohmann::json& doc, const point_values& values)
+noexcept (false) {
+    doc["index"]  = values.index;
+    doc["format"] = values.format;
+
+    if (values.encoded.empty()) {
+        doc["v"]      = values.v;
+    } else {
+        doc["v"]      = values.encoded;
+        doc["scale"]  = values.scale;
+        doc["offset"] = values.offset;
+    }
+}
+
+void from_json(const nlohmann::json& doc, point_values& values)
+noexcept (false) {
+    doc.at("index").get_to(values.index);
+    values.format = doc.value("format", "f32");
+
+    if (doc.find("scale") == doc.end()) {
+        doc.at("v").get_to(values.v);
+    } else {
+        doc.at("v")     .get_to(values.encoded);
+        doc.at("scale") .get_to(values.scale);
+        doc.at("offset").get_to(values.offset);
+    }
+    decode_inplace(values.format, values);
+}
+
+void to_json(nlohmann::json& doc, const stats_fetch& stats)
+noexcept (false) {
+    to_json(doc, static_cast< const stats_task& >(stats));
+    doc["layer"]        = stats.layer;
+    doc["sidecar-bins"] = stats.sidecar_bins;
+}
+
+void from_json(const nlohmann::json& doc, stats_fetch& stats)
+noexcept (false) {
+    from_json(doc, static_cast< stats_task& >(stats));
+    doc.at("layer")       .get_to(stats.layer);
+    doc.at("sidecar-bins").get_to(stats.sidecar_bins);
+}
+
+void to_json(nlohmann::json& doc, const stats_values& values)
+noexcept (false) {
+    doc["count"]  = values.count;
+    doc["min"]    = values.min;
+    doc["max"]    = values.max;
+    doc["mean"]   = values.mean;
+    doc["rms"]    = values.rms;
+    doc["edges"]  = values.edges;
+    doc["counts"] = values.counts;
+}
+
+void from_json(const nlohmann::json& doc, stats_values& values)
+noexcept (false) {
+    doc.at("count") .get_to(values.count);
+    doc.at("min")   .get_to(values.min);
+    doc.at("max")   .get_to(values.max);
+    doc.at("mean")  .get_to(values.mean);
+    doc.at("rms")   .get_to(values.rms);
+    doc.at("edges") .get_to(values.edges);
+    doc.at("counts").get_to(values.counts);
 }
 
 /*
@@ -189,74 +1010,316 @@ void from_json(const nlohmann::json& doc, curtain_traces& traces) noexcept (fals
  * easier to pack/unpack, and far easier to inspect and debug.
  */
 void common_task::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "common_task::unpack");
     const auto doc = nlohmann::json::parse(fst, lst);
     *this = doc.get< common_task >();
 }
 
 std::string common_task::pack() const {
+    ONESEISMIC_TRACE("message", "common_task::pack");
     return nlohmann::json(*this).dump();
 }
 
 void process_header::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "process_header::unpack");
     const auto doc = nlohmann::json::parse(fst, lst);
     *this = doc.get< process_header >();
 }
 
 std::string process_header::pack() const {
+    ONESEISMIC_TRACE("message", "process_header::pack");
     return nlohmann::json(*this).dump();
 }
 
 void slice_task::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "slice_task::unpack");
     const auto doc = nlohmann::json::parse(fst, lst);
     *this = doc.get< slice_task >();
 }
 
 std::string slice_task::pack() const {
+    ONESEISMIC_TRACE("message", "slice_task::pack");
     return nlohmann::json(*this).dump();
 }
 
 void slice_fetch::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "slice_fetch::unpack");
     const auto doc = nlohmann::json::parse(fst, lst);
     *this = doc.get< slice_fetch >();
 }
 
 std::string slice_fetch::pack() const {
+    ONESEISMIC_TRACE("message", "slice_fetch::pack");
     return nlohmann::json(*this).dump();
 }
 
 void slice_tiles::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "slice_tiles::unpack");
     *this = nlohmann::json::from_msgpack(fst, lst).get< slice_tiles >();
 }
 
 std::string slice_tiles::pack() const {
+    ONESEISMIC_TRACE("message", "slice_tiles::pack");
     const auto doc = nlohmann::json(*this);
     const auto msg = nlohmann::json::to_msgpack(doc);
     return std::string(msg.begin(), msg.end());
 }
 
 void curtain_fetch::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "curtain_fetch::unpack");
     const auto doc = nlohmann::json::parse(fst, lst);
     *this = doc.get< curtain_fetch >();
 }
 
 std::string curtain_fetch::pack() const {
+    ONESEISMIC_TRACE("message", "curtain_fetch::pack");
     return nlohmann::json(*this).dump();
 }
 
 void curtain_task::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "curtain_task::unpack");
     const auto doc = nlohmann::json::parse(fst, lst);
     *this = doc.get< curtain_task >();
 }
 
 std::string curtain_task::pack() const {
+    ONESEISMIC_TRACE("message", "curtain_task::pack");
     return nlohmann::json(*this).dump();
 }
 
 void curtain_traces::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "curtain_traces::unpack");
     *this = nlohmann::json::from_msgpack(fst, lst).get< curtain_traces >();
 }
 
 std::string curtain_traces::pack() const {
+    ONESEISMIC_TRACE("message", "curtain_traces::pack");
+    const auto doc = nlohmann::json(*this);
+    const auto msg = nlohmann::json::to_msgpack(doc);
+    return std::string(msg.begin(), msg.end());
+}
+
+void horizon_task::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "horizon_task::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< horizon_task >();
+}
+
+std::string horizon_task::pack() const {
+    ONESEISMIC_TRACE("message", "horizon_task::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void horizon_fetch::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "horizon_fetch::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< horizon_fetch >();
+}
+
+std::string horizon_fetch::pack() const {
+    ONESEISMIC_TRACE("message", "horizon_fetch::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void horizon_values::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "horizon_values::unpack");
+    *this = nlohmann::json::from_msgpack(fst, lst).get< horizon_values >();
+}
+
+std::string horizon_values::pack() const {
+    ONESEISMIC_TRACE("message", "horizon_values::pack");
+    const auto doc = nlohmann::json(*this);
+    const auto msg = nlohmann::json::to_msgpack(doc);
+    return std::string(msg.begin(), msg.end());
+}
+
+void wellpath_task::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "wellpath_task::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< wellpath_task >();
+}
+
+std::string wellpath_task::pack() const {
+    ONESEISMIC_TRACE("message", "wellpath_task::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void wellpath_fetch::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "wellpath_fetch::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< wellpath_fetch >();
+}
+
+std::string wellpath_fetch::pack() const {
+    ONESEISMIC_TRACE("message", "wellpath_fetch::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void point_values::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "point_values::unpack");
+    *this = nlohmann::json::from_msgpack(fst, lst).get< point_values >();
+}
+
+std::string point_values::pack() const {
+    ONESEISMIC_TRACE("message", "point_values::pack");
+    const auto doc = nlohmann::json(*this);
+    const auto msg = nlohmann::json::to_msgpack(doc);
+    return std::string(msg.begin(), msg.end());
+}
+
+void points_task::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "points_task::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< points_task >();
+}
+
+std::string points_task::pack() const {
+    ONESEISMIC_TRACE("message", "points_task::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void points_fetch::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "points_fetch::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< points_fetch >();
+}
+
+std::string points_fetch::pack() const {
+    ONESEISMIC_TRACE("message", "points_fetch::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void stats_task::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "stats_task::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< stats_task >();
+}
+
+std::string stats_task::pack() const {
+    ONESEISMIC_TRACE("message", "stats_task::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void stats_fetch::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "stats_fetch::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< stats_fetch >();
+}
+
+std::string stats_fetch::pack() const {
+    ONESEISMIC_TRACE("message", "stats_fetch::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void stats_values::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "stats_values::unpack");
+    *this = nlohmann::json::from_msgpack(fst, lst).get< stats_values >();
+}
+
+std::string stats_values::pack() const {
+    ONESEISMIC_TRACE("message", "stats_values::pack");
+    const auto doc = nlohmann::json(*this);
+    const auto msg = nlohmann::json::to_msgpack(doc);
+    return std::string(msg.begin(), msg.end());
+}
+
+void polyline_task::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "polyline_task::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< polyline_task >();
+}
+
+std::string polyline_task::pack() const {
+    ONESEISMIC_TRACE("message", "polyline_task::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void polyline_fetch::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "polyline_fetch::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< polyline_fetch >();
+}
+
+std::string polyline_fetch::pack() const {
+    ONESEISMIC_TRACE("message", "polyline_fetch::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void polyline_traces::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "polyline_traces::unpack");
+    *this = nlohmann::json::from_msgpack(fst, lst).get< polyline_traces >();
+}
+
+std::string polyline_traces::pack() const {
+    ONESEISMIC_TRACE("message", "polyline_traces::pack");
+    const auto doc = nlohmann::json(*this);
+    const auto msg = nlohmann::json::to_msgpack(doc);
+    return std::string(msg.begin(), msg.end());
+}
+
+void area_task::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "area_task::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< area_task >();
+}
+
+std::string area_task::pack() const {
+    ONESEISMIC_TRACE("message", "area_task::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void area_fetch::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "area_fetch::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< area_fetch >();
+}
+
+std::string area_fetch::pack() const {
+    ONESEISMIC_TRACE("message", "area_fetch::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void area_traces::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "area_traces::unpack");
+    *this = nlohmann::json::from_msgpack(fst, lst).get< area_traces >();
+}
+
+std::string area_traces::pack() const {
+    ONESEISMIC_TRACE("message", "area_traces::pack");
+    const auto doc = nlohmann::json(*this);
+    const auto msg = nlohmann::json::to_msgpack(doc);
+    return std::string(msg.begin(), msg.end());
+}
+
+void batch_task::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "batch_task::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< batch_task >();
+}
+
+std::string batch_task::pack() const {
+    ONESEISMIC_TRACE("message", "batch_task::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void batch_fetch::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "batch_fetch::unpack");
+    const auto doc = nlohmann::json::parse(fst, lst);
+    *this = doc.get< batch_fetch >();
+}
+
+std::string batch_fetch::pack() const {
+    ONESEISMIC_TRACE("message", "batch_fetch::pack");
+    return nlohmann::json(*this).dump();
+}
+
+void batch_results::unpack(const char* fst, const char* lst) noexcept (false) {
+    ONESEISMIC_TRACE("message", "batch_results::unpack");
+    *this = nlohmann::json::from_msgpack(fst, lst).get< batch_results >();
+}
+
+std::string batch_results::pack() const {
+    ONESEISMIC_TRACE("message", "batch_results::pack");
     const auto doc = nlohmann::json(*this);
     const auto msg = nlohmann::json::to_msgpack(doc);
     return std::string(msg.begin(), msg.end());
@@ -1,18 +1,145 @@
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <fmt/format.h>
 #include <nlohmann/json.hpp>
 
+#include <oneseismic/attributes.hpp>
+#include <oneseismic/digest.hpp>
 #include <oneseismic/geometry.hpp>
+#include <oneseismic/heatmap.hpp>
 #include <oneseismic/messages.hpp>
 #include <oneseismic/plan.hpp>
+#include <oneseismic/tracing.hpp>
 
 namespace {
 
+/*
+ * Call fn(i, j, k) for every fragment read by an element of the ids of a
+ * planned fetch.
+ */
+template < typename Fn >
+void for_each_fragment(const std::vector< int >& id, Fn&& fn) {
+    fn(id[0], id[1], id[2]);
+}
+
+template < typename Fn >
+void for_each_fragment(const one::single& single, Fn&& fn) {
+    for_each_fragment(single.id, fn);
+}
+
+template < typename Fn >
+void for_each_fragment(const one::points_fragment& fragment, Fn&& fn) {
+    for_each_fragment(fragment.id, fn);
+}
+
+template < typename Fn >
+void for_each_fragment(const one::horizon_column& column, Fn&& fn) {
+    for (const auto k : column.ks)
+        fn(column.id[0], column.id[1], k);
+}
+
+template < typename Fn >
+void for_each_fragment(const one::area_column& column, Fn&& fn) {
+    for (const auto k : column.ks)
+        fn(column.id[0], column.id[1], k);
+}
+
+/*
+ * Sparse cubes
+ * ------------
+ * Surveys are rarely rectangular, and irregular surveys can have large holes
+ * without any traces. The upload does not store the fragments of such holes,
+ * and records the fragment columns that are stored in the manifest, as a
+ * fragment-existence bitmap per level:
+ *
+ *  "fragment-mask": { "<decimation>": "<hex>" }, "fill-value": <float>
+ *
+ * The planner drops the elements of the ids that read absent fragments, so
+ * they are never downloaded, and leaves their samples out of the result.
+ * Slices and curtains are filled with the fill-value of the process header by
+ * the client, horizons and points get holes, and areas have no traces there.
+ * Well paths and polylines interpolate across holes, and read the samples of
+ * absent fragments as fill-value. Cubes without a bitmap for the level have
+ * all their fragments stored.
+ */
+float fill_value(const nlohmann::json& manifest) noexcept (false) {
+    return manifest.value("fill-value", 0.0f);
+}
+
+/*
+ * The fragment-existence bitmap of the level with decimation, or the empty
+ * string (all fragments stored) when the manifest has none.
+ */
+std::string level_fragment_mask(const nlohmann::json& manifest, int decimation)
+noexcept (false) {
+    const auto masks = manifest.find("fragment-mask");
+    if (masks == manifest.end() or masks->is_null())
+        return "";
+
+    const auto mask = masks->find(std::to_string(decimation));
+    if (mask == masks->end())
+        return "";
+
+    return mask->get< std::string >();
+}
+
+template < typename Fetch >
+void mask_fragments(Fetch& fetch, const nlohmann::json& manifest)
+noexcept (false) {
+    one::common_task& task = fetch;
+    task.fragment_mask = level_fragment_mask(manifest, task.decimation);
+    if (task.fragment_mask.empty())
+        return;
+
+    task.fill_value = fill_value(manifest);
+
+    const auto stored = one::fragment_mask{ task };
+    const auto absent = [&stored](const auto& x) {
+        bool absent = false;
+        for_each_fragment(x, [&stored, &absent](int i, int j, int) {
+            absent = absent or not stored.stored(i, j);
+        });
+        return absent;
+    };
+    auto& ids = fetch.ids;
+    ids.erase(std::remove_if(ids.begin(), ids.end(), absent), ids.end());
+}
+
+/*
+ * Count the fragments of the planned fetch in the access heatmap, if one is
+ * installed.
+ */
+template < typename Fetch >
+void record_accesses(const Fetch& fetch) noexcept (false) {
+    auto* heat = one::heatmap::installed(one::heatmap::at_plan);
+    if (!heat) return;
+
+    const auto cube = heat->cube(one::heatmap::cube_key(
+        fetch.guid,
+        fmt::format("{}", fmt::join(fetch.shape, "-")),
+        fetch.decimation
+    ));
+    for (const auto& x : fetch.ids) {
+        for_each_fragment(x, [heat, cube](int i, int j, int k) {
+            heat->record(cube, i, j, k);
+        });
+    }
+}
+
 one::gvt< 3 > geometry(
         const nlohmann::json& dimensions,
         const nlohmann::json& shape) noexcept (false) {
@@ -28,8 +155,13 @@ one::gvt< 3 > geometry(
 
 int task_count(int jobs, int task_size) {
     /*
-     * Return the number of task-size'd tasks needed to process all jobs
+     * Return the number of task-size'd tasks needed to process all jobs. A
+     * process without jobs, e.g. when all its fragments are absent, still
+     * gets a single, empty task, so that it completes.
      */
+    if (jobs == 0)
+        return 1;
+
     const auto x = (jobs + (task_size - 1)) / task_size;
     assert(x != 0);
     if (x <= 0) {
@@ -39,6 +171,197 @@ int task_count(int jobs, int task_size) {
     return x;
 }
 
+/*
+ * Overview levels
+ * ---------------
+ * Alongside the full resolution source cube, the ingest can store a set of
+ * decimated overview levels, listed by their decimation factor in the
+ * manifest. Sample (i, j, k) in the level with decimation d corresponds to
+ * sample (i*d, j*d, k*d) in the source cube, so the line labels of a level are
+ * the source labels with stride d.
+ *
+ * Zoomed-out views, which are shown at screen resolution, only need a fraction
+ * of the samples, and should be served from the coarsest level that still
+ * gives enough samples. This saves both fetches and work for the workers.
+ */
+nlohmann::json decimate(const nlohmann::json& dimensions, int decimation)
+noexcept (false) {
+    if (decimation == 1)
+        return dimensions;
+
+    auto decimated = nlohmann::json::array();
+    for (const auto& dimension : dimensions) {
+        auto labels = nlohmann::json::array();
+        for (std::size_t i = 0; i < dimension.size(); i += decimation)
+            labels.push_back(dimension[i]);
+        decimated.push_back(std::move(labels));
+    }
+    return decimated;
+}
+
+/*
+ * The available decimations, coarsest first. The full resolution cube (1) is
+ * always available, and always last.
+ */
+std::vector< int > decimations(const nlohmann::json& manifest)
+noexcept (false) {
+    auto xs = manifest.value("decimations", std::vector< int >());
+    xs.erase(
+        std::remove_if(xs.begin(), xs.end(), [](int x) { return x <= 1; }),
+        xs.end()
+    );
+    std::sort(xs.begin(), xs.end(), std::greater< int >());
+    xs.push_back(1);
+    return xs;
+}
+
+/*
+ * Pick the coarsest decimation where the output shape is still at least the
+ * target shape. The shape function gives the output shape for a decimation,
+ * and the target shape must have the same number of elements. An empty target
+ * always gives the full resolution.
+ */
+template < typename Shape >
+int coarsest_decimation(
+        const nlohmann::json& manifest,
+        const std::vector< int >& target,
+        Shape&& shape)
+noexcept (false) {
+    if (target.empty())
+        return 1;
+
+    for (const auto decimation : decimations(manifest)) {
+        const std::vector< int > output = shape(decimation);
+        if (output.size() != target.size()) {
+            const auto msg = "expected target_shape of {} elements, was {}";
+            throw one::bad_message(
+                fmt::format(msg, output.size(), target.size())
+            );
+        }
+
+        const auto adequate = std::equal(
+            output.begin(),
+            output.end(),
+            target.begin(),
+            std::greater_equal< int >()
+        );
+
+        if (adequate)
+            return decimation;
+    }
+
+    return 1;
+}
+
+/*
+ * Attributes reduce z in windows of attribute_window samples, which must
+ * divide the fragment height so that the reduced fragments are still a
+ * regular grid. The reduced z-axis is labelled by the first sample of every
+ * window.
+ */
+bool reduces(const one::common_task& task) noexcept (false) {
+    return one::parse_attribute(task.attribute) != one::attribute::none;
+}
+
+void check_attribute_window(const one::common_task& task, int zheight)
+noexcept (false) {
+    if (not reduces(task))
+        return;
+
+    if (zheight % task.attribute_window != 0) {
+        const auto msg = "attribute-window (= {}) must divide the fragment "
+                         "height (= {})";
+        throw one::bad_message(
+            fmt::format(msg, task.attribute_window, zheight)
+        );
+    }
+}
+
+int reduced_size(const one::common_task& task, int n) noexcept (false) {
+    if (not reduces(task))
+        return n;
+    return (n + task.attribute_window - 1) / task.attribute_window;
+}
+
+std::vector< int > reduced_labels(
+        const one::common_task& task,
+        const nlohmann::json& labels)
+noexcept (false) {
+    const auto step = reduces(task) ? task.attribute_window : 1;
+    std::vector< int > xs;
+    for (std::size_t i = 0; i < labels.size(); i += step)
+        xs.push_back(labels[i]);
+    return xs;
+}
+
+/*
+ * The samples [zbegin, zend) of the sample labels in [zmin, zmax]. Throws
+ * not_found if the range has no samples.
+ */
+std::array< int, 2 > sample_range(
+        const std::vector< int >& samples,
+        int zmin,
+        int zmax)
+noexcept (false) {
+    const auto fst = std::lower_bound(samples.begin(), samples.end(), zmin);
+    const auto lst = std::upper_bound(samples.begin(), samples.end(), zmax);
+    if (fst >= lst) {
+        const auto msg = "no samples in [{}, {}]";
+        throw one::not_found(fmt::format(msg, zmin, zmax));
+    }
+
+    return {
+        int(std::distance(samples.begin(), fst)),
+        int(std::distance(samples.begin(), lst)),
+    };
+}
+
+/*
+ * The z-range [zmin, zmax] of a slice or curtain, in the samples of the
+ * (decimated) cube. Attributes are computed over whole windows, so when
+ * reducing, the range is widened to the windows it intersects.
+ */
+std::array< int, 2 > z_range(
+        const one::common_task& task,
+        const nlohmann::json& samples,
+        int zmin,
+        int zmax)
+noexcept (false) {
+    auto range = sample_range(
+        samples.get< std::vector< int > >(),
+        zmin,
+        zmax
+    );
+
+    if (reduces(task)) {
+        const auto window = task.attribute_window;
+        range[0] -= range[0] % window;
+        range[1]  = std::min(
+            int(samples.size()),
+            (range[1] + window - 1) / window * window
+        );
+    }
+    return range;
+}
+
+/*
+ * The number of samples in [zmin, zmax] when read from an overview level,
+ * for picking the decimation.
+ */
+int samples_in_range(
+        const nlohmann::json& samples,
+        int decimation,
+        int zmin,
+        int zmax)
+noexcept (false) {
+    int n = 0;
+    for (std::size_t i = 0; i < samples.size(); i += decimation) {
+        const int z = samples[i];
+        n += (zmin <= z and z <= zmax);
+    }
+    return n;
+}
+
 /*
  * Scheduling
  * ----------
@@ -124,6 +447,13 @@ struct schedule_maker {
      */
     std::vector< std::string >
     schedule(const char* doc, int len, int task_size) noexcept (false);
+
+    /*
+     * Make a schedule() from an already parsed input. The header is still the
+     * last element.
+     */
+    std::vector< std::string >
+    schedule(const Input&, int task_size) noexcept (false);
 };
 
 template < typename Input, typename Output >
@@ -132,6 +462,7 @@ schedule_maker< Input, Output >::partition(
         Output& output,
         int task_size
 ) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "partition");
     if (task_size < 1) {
         const auto msg = fmt::format("task_size (= {}) < 1", task_size);
         throw std::logic_error(msg);
@@ -165,22 +496,165 @@ schedule_maker< Input, Output >::schedule(
 noexcept (false) {
     Input in;
     in.unpack(doc, doc + len);
+    return this->schedule(in, task_size);
+}
+
+template < typename Input, typename Output >
+std::vector< std::string >
+schedule_maker< Input, Output >::schedule(
+        const Input& in,
+        int task_size)
+noexcept (false) {
     const auto manifest = nlohmann::json::parse(in.manifest);
     auto fetch = this->build(in, manifest);
     auto sched = this->partition(fetch, task_size);
 
     const auto ntasks = int(sched.size());
-    const auto head   = this->header(in, manifest, ntasks);
+    auto head = this->header(in, manifest, ntasks);
+    head.fill_value = fill_value(manifest);
     sched.push_back(head.pack());
     return sched;
 }
 
+/*
+ * The label range [first, last] of the dimension axis of a slice, from the
+ * region of interest, and [zmin, zmax] for z.
+ */
+std::array< int, 2 > slice_bounds(
+        const one::slice_task& task,
+        int axis,
+        bool z)
+noexcept (true) {
+    auto bounds = std::array< int, 2 > {
+        std::numeric_limits< int >::min(),
+        std::numeric_limits< int >::max(),
+    };
+    if (not task.roi.empty())
+        bounds = task.roi[axis];
+    if (z) {
+        bounds[0] = std::max(bounds[0], task.zmin);
+        bounds[1] = std::min(bounds[1], task.zmax);
+    }
+    return bounds;
+}
+
+/*
+ * The dimensions of the cube that are the (two) axes of the slice
+ */
+std::array< int, 2 > slice_axes(const one::slice_task& task) noexcept (true) {
+    std::array< int, 2 > axes;
+    for (int i = 0, axis = 0; i < 3; ++i) {
+        if (i != task.dim)
+            axes[axis++] = i;
+    }
+    return axes;
+}
+
+int slice_decimation(
+        const one::slice_task& task,
+        const nlohmann::json& manifest)
+noexcept (false) {
+    const auto& mdims = manifest["dimensions"];
+    const auto zdim   = int(mdims.size()) - 1;
+    const auto axes   = slice_axes(task);
+    const auto shape = [&](int decimation) {
+        std::vector< int > xs;
+        for (int i = 0; i < 2; ++i) {
+            const auto bounds = slice_bounds(task, i, axes[i] == zdim);
+            const auto n = samples_in_range(
+                mdims[axes[i]],
+                decimation,
+                bounds[0],
+                bounds[1]
+            );
+            const auto stride = task.stride.empty() ? 1 : task.stride[i];
+            xs.push_back((n + stride - 1) / stride);
+        }
+        return xs;
+    };
+
+    return coarsest_decimation(manifest, task.target_shape, shape);
+}
+
+/*
+ * The region of interest of a slice, in the samples of the (decimated)
+ * dimensions. Slices along z are not cropped by [zmin, zmax], as the line
+ * itself picks the sample, and when reducing to an attribute, z is on whole
+ * windows and can not be strided.
+ */
+struct slice_region {
+    std::array< int, 2 > begin;
+    std::array< int, 2 > end;
+    std::array< int, 2 > step;
+};
+
+slice_region slice_roi(
+        const one::slice_task& task,
+        const nlohmann::json& dimensions)
+noexcept (false) {
+    const auto zdim = int(dimensions.size()) - 1;
+    if (task.dim == zdim) {
+        if (task.zmin != std::numeric_limits< int >::min()
+         or task.zmax != std::numeric_limits< int >::max()) {
+            const auto msg = "zmin/zmax given, but slice is along z";
+            throw one::bad_message(msg);
+        }
+    }
+
+    const auto axes = slice_axes(task);
+    slice_region region;
+    for (int i = 0; i < 2; ++i) {
+        const auto& labels = dimensions[axes[i]];
+        const auto bounds = slice_bounds(task, i, axes[i] == zdim);
+        const auto range = axes[i] == zdim
+            ? z_range(task, labels, bounds[0], bounds[1])
+            : sample_range(labels.get< std::vector< int > >(), bounds[0], bounds[1])
+        ;
+
+        region.begin[i] = range[0];
+        region.end[i]   = range[1];
+        region.step[i]  = task.stride.empty() ? 1 : task.stride[i];
+        if (axes[i] == zdim and reduces(task) and region.step[i] != 1) {
+            const auto msg = "attribute {} can not be strided in z";
+            throw one::bad_message(fmt::format(msg, task.attribute));
+        }
+    }
+    return region;
+}
+
+/*
+ * The pin is the index of the line of the slice in the cube with decimation.
+ * Overview levels only have every decimation'th line, so the closest line at
+ * or before the requested one is picked, and the header tells the client
+ * which line that is.
+ */
+int slice_pin(
+        const one::slice_task& task,
+        const nlohmann::json& manifest,
+        int decimation)
+noexcept (false) {
+    /*
+     * TODO:
+     * faster to not make vector, but rather parse-and-compare individual
+     * integers?
+     */
+    const auto& dimensions = manifest["dimensions"];
+    const auto index = dimensions[task.dim].get< std::vector< int > >();
+    const auto itr = std::find(index.begin(), index.end(), task.lineno);
+    if (itr == index.end()) {
+        const auto msg = "line (= {}) not found in index";
+        throw one::not_found(fmt::format(msg, task.lineno));
+    }
+    return int(std::distance(index.begin(), itr)) / decimation;
+}
+
 template <>
 one::slice_fetch
 schedule_maker< one::slice_task, one::slice_fetch >::build(
     const one::slice_task& task,
     const nlohmann::json& manifest)
 {
+    ONESEISMIC_TRACE("plan", "build");
     auto out = one::slice_fetch(task);
 
     const auto& manifest_dimensions = manifest["dimensions"];
@@ -193,35 +667,52 @@ schedule_maker< one::slice_task, one::slice_fetch >::build(
         throw one::not_found(msg);
     }
 
-    /*
-     * TODO:
-     * faster to not make vector, but rather parse-and-compare individual
-     * integers?
-     */
-    const auto index = manifest_dimensions[task.dim].get< std::vector< int > >();
-    const auto itr = std::find(index.begin(), index.end(), task.lineno);
-    if (itr == index.end()) {
-        const auto msg = "line (= {}) not found in index";
-        throw one::not_found(fmt::format(msg, task.lineno));
-    }
+    out.decimation = slice_decimation(task, manifest);
+    const auto pin = slice_pin(task, manifest, out.decimation);
+    const auto dimensions = decimate(manifest_dimensions, out.decimation);
+    auto gvt = geometry(dimensions, task.shape);
 
-    const auto pin = std::distance(index.begin(), itr);
-    auto gvt = geometry(manifest_dimensions, task.shape);
+    const auto zdim = int(manifest_dimensions.size()) - 1;
+    if (reduces(task) and task.dim == zdim) {
+        const auto msg = "attribute {} needs a z-axis, but slice is along z";
+        throw one::bad_message(fmt::format(msg, task.attribute));
+    }
+    check_attribute_window(task, gvt.fragment_shape()[zdim]);
 
-    // TODO: name loop
-    for (const auto& dimension : manifest_dimensions)
+    out.shape_cube.clear();
+    for (const auto& dimension : dimensions)
         out.shape_cube.push_back(dimension.size());
 
     const auto to_vec = [](const auto& x) {
         return std::vector< int > { int(x[0]), int(x[1]), int(x[2]) };
     };
 
+    /*
+     * Only the fragments with samples in the region of interest are read
+     */
+    const auto region = slice_roi(task, dimensions);
+    out.begin = region.begin;
+    out.end   = region.end;
+    out.step  = region.step;
+
+    std::array< std::size_t, 3 > begin  = {};
+    std::array< std::size_t, 3 > end    = {};
+    std::array< std::size_t, 3 > stride = { 1, 1, 1 };
+    const auto axes = slice_axes(task);
+    for (int i = 0; i < 2; ++i) {
+        begin [axes[i]] = region.begin[i];
+        end   [axes[i]] = region.end[i];
+        stride[axes[i]] = region.step[i];
+    }
+
     out.lineno = pin % gvt.fragment_shape()[task.dim];
-    const auto ids = gvt.slice(gvt.mkdim(task.dim), pin);
+    const auto ids = gvt.slice(gvt.mkdim(task.dim), pin, begin, end, stride);
     // TODO: name loop
     for (const auto& id : ids)
         out.ids.push_back(to_vec(id));
 
+    mask_fragments(out, manifest);
+    record_accesses(out);
     return out;
 }
 
@@ -232,34 +723,100 @@ schedule_maker< one::slice_task, one::slice_fetch >::header(
     const nlohmann::json& manifest,
     int ntasks
 ) noexcept (false) {
-    const auto& mdims = manifest["dimensions"];
-    const auto gvt  = geometry(mdims, task.shape);
-    const auto dim  = gvt.mkdim(task.dim);
-    const auto gvt2 = gvt.squeeze(dim);
-    const auto fs2  = gvt2.fragment_shape();
+    ONESEISMIC_TRACE("plan", "header");
+    const auto decimation = slice_decimation(task, manifest);
+    const auto mdims = decimate(manifest["dimensions"], decimation);
+    const auto zdim  = int(mdims.size()) - 1;
 
     one::process_header head;
     head.pid    = task.pid;
     head.ntasks = ntasks;
+    head.format = task.format;
+    head.decimation = decimation;
+    const auto pin = slice_pin(task, manifest, decimation);
+    head.lineno = mdims[task.dim][pin].get< int >();
 
     /*
-     * The shape of a slice are the dimensions of the survey squeezed in that
-     * dimension.
+     * Build the index from the line numbers for the directions !=
+     * params.lineno, restricted to the region of interest. The shape of a
+     * slice is the size of the index.
      */
-    for (std::size_t i = 0; i < fs2.size(); ++i) {
-        const auto dim = gvt2.mkdim(i);
-        head.shape.push_back(gvt2.nsamples(dim));
+    const auto region = slice_roi(task, mdims);
+    const auto axes   = slice_axes(task);
+    for (int i = 0; i < 2; ++i) {
+        const auto& labels = mdims[axes[i]];
+        const auto window = axes[i] == zdim and reduces(task)
+                          ? task.attribute_window
+                          : 1
+                          ;
+        const auto step = region.step[i] * window;
+
+        std::vector< int > index;
+        for (auto x = region.begin[i]; x < region.end[i]; x += step)
+            index.push_back(labels[x]);
+
+        head.shape.push_back(index.size());
+        head.index.push_back(std::move(index));
     }
+    return head;
+}
+
+/*
+ * Progressive slices
+ * ------------------
+ * A progressive slice is scheduled as two phases: a coarse preview read from
+ * the coarsest overview level, followed by the slice as requested. The
+ * preview is usually a single fragment or two, and since tasks are queued in
+ * the order they are scheduled, the preview is processed before the rest of
+ * the slice. Clients can then render the preview while waiting for the full
+ * result.
+ *
+ * The phases are the plain schedules of each level, concatenated, with a
+ * single header that describes both. When the coarsest level is already the
+ * one the request would be read from, or the cube has no overview levels, the
+ * slice is scheduled as a regular single-phase slice.
+ */
+one::process_phase phase_of(const one::process_header& head) {
+    one::process_phase phase;
+    phase.ntasks     = head.ntasks;
+    phase.decimation = head.decimation;
+    phase.shape      = head.shape;
+    phase.index      = head.index;
+    phase.lineno     = head.lineno;
+    return phase;
+}
 
+std::vector< std::string >
+schedule_progressive_slice(const one::slice_task& task, int task_size)
+noexcept (false) {
+    auto coarse = task;
+    auto fine   = task;
+    coarse.progressive = false;
+    fine.progressive   = false;
     /*
-     * Build the index from the line numbers for the directions !=
-     * params.lineno
+     * Any level covers a 1x1 target, so this picks the coarsest level
      */
-    for (std::size_t i = 0; i < mdims.size(); ++i) {
-        if (i == task.dim) continue;
-        head.index.push_back(mdims[i]);
-    }
-    return head;
+    coarse.target_shape = { 1, 1 };
+
+    auto maker = schedule_maker< one::slice_task, one::slice_fetch >{};
+    const auto manifest = nlohmann::json::parse(task.manifest);
+    if (slice_decimation(coarse, manifest) == slice_decimation(fine, manifest))
+        return maker.schedule(fine, task_size);
+
+    auto coarse_fetch = maker.build(coarse, manifest);
+    auto fine_fetch   = maker.build(fine,   manifest);
+    auto preview = maker.partition(coarse_fetch, task_size);
+    auto sched   = maker.partition(fine_fetch,   task_size);
+
+    const auto preview_head = maker.header(coarse, manifest, preview.size());
+    auto head = maker.header(fine, manifest, sched.size());
+    head.phases = { phase_of(preview_head), phase_of(head) };
+    head.ntasks = preview_head.ntasks + head.ntasks;
+    head.fill_value = fill_value(manifest);
+
+    sched.insert(sched.begin(), preview.begin(), preview.end());
+    sched.push_back(head.pack());
+    return sched;
 }
 
 /*
@@ -278,8 +835,8 @@ noexcept (false) {
 
     auto indexof = [&labels](auto x) {
         const auto itr = std::lower_bound(labels.begin(), labels.end(), x);
-        if (*itr != x) {
-            const auto msg = fmt::format("lineno {} not in index");
+        if (itr == labels.end() or *itr != x) {
+            const auto msg = fmt::format("lineno {} not in index", x);
             throw one::not_found(msg);
         }
         return std::distance(labels.begin(), itr);
@@ -288,12 +845,119 @@ noexcept (false) {
     std::transform(xs.begin(), xs.end(), xs.begin(), indexof);
 }
 
+/*
+ * The world transform of the cube (see one::world_transform), which is stored
+ * in the manifest as the 6 coefficients of the transform from the grid of the
+ * first two dimensions, e.g.
+ *
+ *      "transform": [456000.0, 10.8, -12.5, 6780000.0, 6.25, 21.6]
+ *
+ * Cubes without trace coordinates have no transform, and can not be queried
+ * with world coordinates.
+ */
+one::world_transform manifest_transform(const nlohmann::json& manifest)
+noexcept (false) {
+    const auto itr = manifest.find("transform");
+    if (itr == manifest.end() or itr->is_null()) {
+        const auto msg = "world coordinates given, but cube has no transform";
+        throw one::bad_message(msg);
+    }
+
+    try {
+        return one::world_transform(itr->get< std::array< double, 6 > >());
+    } catch (const std::invalid_argument& e) {
+        throw one::bad_message(e.what());
+    }
+}
+
+/*
+ * Map the world coordinates (x, y) of points to grid coordinates, in place.
+ * The points can have more components, e.g. z, which are left as-is.
+ */
+template < std::size_t N >
+void world_to_grid_inplace(
+    const nlohmann::json& manifest,
+    std::vector< std::array< double, N > >& points)
+noexcept (false) {
+    const auto transform = manifest_transform(manifest);
+    const auto n = points.size();
+
+    std::vector< double > xs(n);
+    std::vector< double > ys(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        xs[i] = points[i][0];
+        ys[i] = points[i][1];
+    }
+
+    std::vector< double > is(n);
+    std::vector< double > js(n);
+    transform.to_grid(xs.data(), ys.data(), n, is.data(), js.data());
+    for (std::size_t i = 0; i < n; ++i) {
+        points[i][0] = is[i];
+        points[i][1] = js[i];
+    }
+}
+
+/*
+ * Map a curtain path, in cartesian coordinates, onto the grid of a decimated
+ * level. Consecutive points that end up on the same trace in the decimated
+ * level are collapsed, so a curtain read from an overview level is also
+ * shorter.
+ */
+void decimate_path_inplace(
+    std::vector< int >& dim0s,
+    std::vector< int >& dim1s,
+    int decimation)
+noexcept (false) {
+    assert(dim0s.size() == dim1s.size());
+    if (decimation == 1)
+        return;
+
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < dim0s.size(); ++i) {
+        const auto x = dim0s[i] / decimation;
+        const auto y = dim1s[i] / decimation;
+        if (n > 0 and dim0s[n - 1] == x and dim1s[n - 1] == y)
+            continue;
+
+        dim0s[n] = x;
+        dim1s[n] = y;
+        ++n;
+    }
+
+    dim0s.resize(n);
+    dim1s.resize(n);
+}
+
+/*
+ * Pick the decimation for a curtain, from a task where the path has already
+ * been mapped to cartesian coordinates.
+ */
+int curtain_decimation(
+        const one::curtain_task& task,
+        const nlohmann::json& manifest)
+noexcept (false) {
+    const auto& zsamples = manifest["dimensions"].back();
+    const auto shape = [&](int decimation) {
+        auto dim0s = task.dim0s;
+        auto dim1s = task.dim1s;
+        decimate_path_inplace(dim0s, dim1s, decimation);
+        return std::vector< int > {
+            int(dim0s.size()),
+            samples_in_range(zsamples, decimation, task.zmin, task.zmax),
+        };
+    };
+
+    return coarsest_decimation(manifest, task.target_shape, shape);
+}
+
 template <>
 one::curtain_fetch
 schedule_maker< one::curtain_task, one::curtain_fetch >::build(
     const one::curtain_task& task,
     const nlohmann::json& manifest)
 {
+    ONESEISMIC_TRACE("plan", "build");
     const auto less = [](const auto& lhs, const auto& rhs) noexcept (true) {
         return std::lexicographical_compare(
             lhs.id.begin(),
@@ -309,13 +973,30 @@ schedule_maker< one::curtain_task, one::curtain_fetch >::build(
     auto out = one::curtain_fetch(task);
     to_cartesian_inplace(manifest["dimensions"][0], out.dim0s);
     to_cartesian_inplace(manifest["dimensions"][1], out.dim1s);
+    out.decimation = curtain_decimation(out, manifest);
+    decimate_path_inplace(out.dim0s, out.dim1s, out.decimation);
+
     auto& ids = out.ids;
     const auto& dim0s = out.dim0s;
     const auto& dim1s = out.dim1s;
 
-    auto gvt = geometry(manifest["dimensions"], task.shape);
-    const auto zfrags  = gvt.fragment_count(gvt.mkdim(2));
+    const auto dimensions = decimate(manifest["dimensions"], out.decimation);
+    out.shape_cube.clear();
+    for (const auto& dimension : dimensions)
+        out.shape_cube.push_back(dimension.size());
+
+    auto gvt = geometry(dimensions, task.shape);
     const auto zheight = gvt.fragment_shape()[2];
+    check_attribute_window(task, zheight);
+
+    /*
+     * Only the fragments of the column that overlap the z-range are read
+     */
+    const auto range = z_range(task, dimensions.back(), task.zmin, task.zmax);
+    out.zbegin = range[0];
+    out.zend   = range[1];
+    const auto kfst   = int(out.zbegin / zheight);
+    const auto zfrags = int((out.zend - 1) / zheight) - kfst + 1;
 
     /*
      * Guess the number of coordinates per fragment. A reasonable assumption is
@@ -330,7 +1011,8 @@ schedule_maker< one::curtain_task, one::curtain_fetch >::build(
     /*
      * Pre-allocate the id objects by scanning the input and build the
      * one::single objects, sorted by id lexicographically. All fragments in
-     * the column (z-axis) are generated from the x-y pair. This is essentially
+     * the column (z-axis) that overlap the z-range are generated from the x-y
+     * pair, and the column is looked up by its first fragment. This is essentially
      * constructing the "buckets" in advance, as many x/y pairs will end up in
      * the same "bin"/fragment.
      *
@@ -345,7 +1027,7 @@ schedule_maker< one::curtain_task, one::curtain_fetch >::build(
         auto top_point = one::CP< 3 > {
             std::size_t(dim0s[i]),
             std::size_t(dim1s[i]),
-            std::size_t(0),
+            std::size_t(out.zbegin),
         };
         const auto fid = gvt.frag_id(top_point);
 
@@ -356,7 +1038,7 @@ schedule_maker< one::curtain_task, one::curtain_fetch >::build(
             top.coordinates.reserve(approx_coordinates_per_fragment);
             itr = ids.insert(itr, zfrags, top);
             for (int z = 0; z < zfrags; ++z, ++itr)
-                itr->id[2] = z;
+                itr->id[2] = kfst + z;
         }
     }
 
@@ -368,7 +1050,7 @@ schedule_maker< one::curtain_task, one::curtain_fetch >::build(
         const auto cp = one::CP< 3 > {
             std::size_t(dim0s[i]),
             std::size_t(dim1s[i]),
-            std::size_t(0),
+            std::size_t(out.zbegin),
         };
         const auto fid = gvt.frag_id(cp);
         const auto lid = gvt.to_local(cp);
@@ -379,6 +1061,8 @@ schedule_maker< one::curtain_task, one::curtain_fetch >::build(
         }
     }
 
+    mask_fragments(out, manifest);
+    record_accesses(out);
     return out;
 }
 
@@ -389,44 +1073,1570 @@ schedule_maker< one::curtain_task, one::curtain_fetch >::header(
     const nlohmann::json& manifest,
     int ntasks
 ) noexcept (false) {
-    const auto& mdims = manifest["dimensions"];
+    ONESEISMIC_TRACE("plan", "header");
+    const auto& src = manifest["dimensions"];
+
+    auto path = task;
+    to_cartesian_inplace(src[0], path.dim0s);
+    to_cartesian_inplace(src[1], path.dim1s);
+    const auto decimation = curtain_decimation(path, manifest);
+    decimate_path_inplace(path.dim0s, path.dim1s, decimation);
+    const auto mdims = decimate(src, decimation);
 
     one::process_header head;
     head.pid    = task.pid;
     head.ntasks = ntasks;
+    head.format = task.format;
+    head.decimation = decimation;
 
-    const auto gvt  = geometry(mdims, task.shape);
-    const auto zpad = gvt.nsamples_padded(gvt.mkdim(gvt.ndims - 1));
+    /*
+     * Traces are cropped to the z-range, but when the range is the whole
+     * trace they are padded to the fragment height, like the fragments.
+     */
+    const auto gvt   = geometry(mdims, task.shape);
+    const auto zpad  = gvt.nsamples_padded(gvt.mkdim(gvt.ndims - 1));
+    const auto range = z_range(task, mdims.back(), task.zmin, task.zmax);
+    const auto whole = range[0] == 0 and range[1] == int(mdims.back().size());
     head.shape = {
-        int(task.dim0s.size()),
-        int(zpad),
+        int(path.dim0s.size()),
+        reduced_size(task, whole ? int(zpad) : range[1] - range[0]),
     };
 
-    head.index.push_back(task.dim0s);
-    head.index.push_back(task.dim1s);
-    head.index.push_back(mdims.back());
-    to_cartesian_inplace(mdims[0], head.index[0]);
-    to_cartesian_inplace(mdims[1], head.index[1]);
+    const auto samples = nlohmann::json(std::vector< int >(
+        mdims.back().begin() + range[0],
+        mdims.back().begin() + range[1]
+    ));
+    head.index.push_back(path.dim0s);
+    head.index.push_back(path.dim1s);
+    head.index.push_back(reduced_labels(task, samples));
     return head;
 }
 
-}
+/*
+ * Horizons
+ * --------
+ * A horizon only touches the fragments around the surface, which for most
+ * surfaces is a thin band of one or two fragments in every column. The
+ * fragments are planned by column (i, j), with the k of the fragments
+ * intersected by the surface +- window, and the points of the surface in the
+ * column.
+ *
+ * The surface is in the units of the last dimension, and is snapped to the
+ * nearest sample. Points outside the cube are holes, and are not planned.
+ */
+int horizon_sample(
+        float z,
+        const std::vector< int >& samples)
+noexcept (true) {
+    if (not std::isfinite(z) or samples.empty())
+        return -1;
 
-namespace one {
+    const auto dz = samples.size() > 1 ? samples[1] - samples[0] : 1;
+    const auto k = std::lround((z - samples.front()) / double(dz));
+    if (k < 0 or k >= long(samples.size()))
+        return -1;
+    return int(k);
+}
 
-std::vector< std::string >
-mkschedule(const char* doc, int len, int task_size) noexcept (false) {
-    const auto document = nlohmann::json::parse(doc, doc + len);
+template <>
+one::horizon_fetch
+schedule_maker< one::horizon_task, one::horizon_fetch >::build(
+    const one::horizon_task& task,
+    const nlohmann::json& manifest)
+{
+    ONESEISMIC_TRACE("plan", "build");
+    const auto less = [](const auto& lhs, const auto& rhs) noexcept (true) {
+        return std::lexicographical_compare(
+            lhs.id.begin(),
+            lhs.id.end(),
+            rhs.begin(),
+            rhs.end()
+        );
+    };
+    const auto equal = [](const auto& lhs, const auto& rhs) noexcept (true) {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    };
+
+    const auto& dimensions = manifest["dimensions"];
+    auto dim0s = task.dim0s;
+    auto dim1s = task.dim1s;
+    to_cartesian_inplace(dimensions[0], dim0s);
+    to_cartesian_inplace(dimensions[1], dim1s);
+    const auto samples = dimensions[2].get< std::vector< int > >();
+
+    auto out = one::horizon_fetch(task);
+    out.dim0s.clear();
+    out.dim1s.clear();
+    out.surface.clear();
+    out.decimation = 1;
+    out.shape_cube.clear();
+    for (const auto& dimension : dimensions)
+        out.shape_cube.push_back(dimension.size());
+
+    auto gvt = geometry(dimensions, task.shape);
+    const auto zheight = int(gvt.fragment_shape()[2]);
+    const auto nz = int(samples.size());
+
+    auto& ids = out.ids;
+    const auto n1 = dim1s.size();
+    for (std::size_t r = 0; r < dim0s.size(); ++r) {
+        for (std::size_t c = 0; c < n1; ++c) {
+            const auto pos = int(r * n1 + c);
+            const auto k = horizon_sample(task.surface[pos], samples);
+            if (k < 0) continue;
+
+            const auto cp = one::CP< 3 > {
+                std::size_t(dim0s[r]),
+                std::size_t(dim1s[c]),
+                std::size_t(k),
+            };
+            const auto fid = gvt.frag_id(cp);
+            const auto lid = gvt.to_local(cp);
+            const auto col = std::vector< int > { int(fid[0]), int(fid[1]) };
+
+            auto itr = std::lower_bound(ids.begin(), ids.end(), col, less);
+            if (itr == ids.end() or (not equal(itr->id, col))) {
+                one::horizon_column column;
+                column.id = col;
+                itr = ids.insert(itr, column);
+            }
+
+            const auto top    = std::max(0,      k - task.window);
+            const auto bottom = std::min(nz - 1, k + task.window);
+            for (auto z = top / zheight; z <= bottom / zheight; ++z)
+                itr->ks.push_back(z);
+            itr->points.push_back({ pos, int(lid[0]), int(lid[1]), k });
+        }
+    }
+
+    for (auto& column : ids) {
+        auto& ks = column.ks;
+        std::sort(ks.begin(), ks.end());
+        ks.erase(std::unique(ks.begin(), ks.end()), ks.end());
+    }
+
+    mask_fragments(out, manifest);
+    record_accesses(out);
+    return out;
+}
+
+/*
+ * Horizon columns are never split across tasks, since every point needs all
+ * the fragments of its window, so tasks are filled with whole columns until
+ * they have at least task_size fragments.
+ */
+template < typename Fetch >
+std::vector< std::string > partition_columns(Fetch& output, int task_size)
+noexcept (false) {
+    if (task_size < 1) {
+        const auto msg = fmt::format("task_size (= {}) < 1", task_size);
+        throw std::logic_error(msg);
+    }
+
+    const auto ids = std::move(output.ids);
+    std::vector< std::string > xs;
+    auto fst = ids.begin();
+    while (fst != ids.end()) {
+        auto lst = fst;
+        int fragments = 0;
+        while (lst != ids.end() and fragments < task_size) {
+            fragments += lst->ks.size();
+            ++lst;
+        }
+
+        output.ids.assign(fst, lst);
+        xs.push_back(output.pack());
+        fst = lst;
+    }
+
+    /*
+     * Processes without columns still get an empty task, see task_count()
+     */
+    if (xs.empty())
+        xs.push_back(output.pack());
+
+    return xs;
+}
+
+template <>
+std::vector< std::string >
+schedule_maker< one::horizon_task, one::horizon_fetch >::partition(
+        one::horizon_fetch& output,
+        int task_size
+) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "partition");
+    return partition_columns(output, task_size);
+}
+
+template <>
+one::process_header
+schedule_maker< one::horizon_task, one::horizon_fetch >::header(
+    const one::horizon_task& task,
+    const nlohmann::json&,
+    int ntasks
+) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "header");
+    one::process_header head;
+    head.pid    = task.pid;
+    head.ntasks = ntasks;
+    head.format = task.format;
+    head.decimation = 1;
+
+    /*
+     * The shape of a horizon is the grid, and the window when there is one.
+     * The window is indexed by the sample offset from the surface. Attributes
+     * reduce the whole window, which gives a map.
+     */
+    head.shape = { int(task.dim0s.size()), int(task.dim1s.size()) };
+    head.index.push_back(task.dim0s);
+    head.index.push_back(task.dim1s);
+
+    if (task.window > 0 and not reduces(task)) {
+        head.shape.push_back(2 * task.window + 1);
+        std::vector< int > offsets;
+        for (int i = -task.window; i <= task.window; ++i)
+            offsets.push_back(i);
+        head.index.push_back(offsets);
+    }
+    return head;
+}
+
+/*
+ * Well paths
+ * ----------
+ * The samples of a well path are interpolated from the 8 samples around every
+ * point, which may be in up to 8 different fragments when the point is close
+ * to a fragment boundary. Points are kept in order, and tasks are made from
+ * consecutive points, so the fragments of a task are the fragments of a
+ * stretch of the path.
+ */
+
+/*
+ * Map a label (line number or sample label) to a fractional index, by linear
+ * interpolation between the neighbouring labels. Returns -1 for labels outside
+ * the labels.
+ */
+double fractional_index(const std::vector< int >& labels, double x)
+noexcept (true) {
+    if (not std::isfinite(x) or labels.empty())
+        return -1;
+
+    const auto itr = std::upper_bound(labels.begin(), labels.end(), x);
+    if (itr == labels.begin())
+        return -1;
+    if (itr == labels.end())
+        return x == labels.back() ? double(labels.size() - 1) : -1;
+
+    const auto i  = std::distance(labels.begin(), itr) - 1;
+    const auto lo = double(labels[i]);
+    const auto hi = double(labels[i + 1]);
+    return double(i) + (x - lo) / (hi - lo);
+}
+
+/*
+ * The fragments of the samples around a point, in grid coordinates, sorted
+ * and without duplicates.
+ */
+std::vector< std::vector< int > > cell_fragments(
+        const one::gvt< 3 >& gvt,
+        const std::array< double, 3 >& point)
+noexcept (false) {
+    const auto& cs = gvt.cube_shape();
+    const auto x = one::interpolation_cell(point[0], cs[0]);
+    const auto y = one::interpolation_cell(point[1], cs[1]);
+    const auto z = one::interpolation_cell(point[2], cs[2]);
+
+    std::vector< std::vector< int > > ids;
+    for (const auto i : { x.lower, x.upper })
+    for (const auto j : { y.lower, y.upper })
+    for (const auto k : { z.lower, z.upper }) {
+        const auto fid = gvt.frag_id(one::CP< 3 > { i, j, k });
+        ids.push_back({ int(fid[0]), int(fid[1]), int(fid[2]) });
+    }
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+template <>
+one::wellpath_fetch
+schedule_maker< one::wellpath_task, one::wellpath_fetch >::build(
+    const one::wellpath_task& task,
+    const nlohmann::json& manifest)
+{
+    ONESEISMIC_TRACE("plan", "build");
+    const auto& dimensions = manifest["dimensions"];
+    std::vector< std::vector< int > > labels;
+    for (const auto& dimension : dimensions)
+        labels.push_back(dimension.get< std::vector< int > >());
+
+    auto out = one::wellpath_fetch(task);
+    out.points.clear();
+    out.coordinates = "grid";
+    out.decimation  = 1;
+    out.shape_cube.clear();
+    for (const auto& dimension : labels)
+        out.shape_cube.push_back(dimension.size());
+
+    const auto gvt = geometry(dimensions, task.shape);
+    const auto inside = [&labels](double x, int dim) noexcept (true) {
+        return std::isfinite(x)
+           and 0 <= x
+           and x <= double(labels[dim].size() - 1)
+        ;
+    };
+
+    auto points = task.points;
+    if (task.coordinates == "world")
+        world_to_grid_inplace(manifest, points);
+
+    std::vector< std::vector< int > > ids;
+    for (int i = 0; i < int(points.size()); ++i) {
+        auto point = points[i];
+        if (task.coordinates == "label") {
+            for (int dim = 0; dim < 3; ++dim)
+                point[dim] = fractional_index(labels[dim], point[dim]);
+        }
+        if (task.coordinates == "world")
+            point[2] = fractional_index(labels[2], point[2]);
+
+        if (not (inside(point[0], 0)
+             and inside(point[1], 1)
+             and inside(point[2], 2)))
+            continue;
+
+        out.points.push_back(point);
+        out.index.push_back(i);
+        const auto cell = cell_fragments(gvt, point);
+        ids.insert(ids.end(), cell.begin(), cell.end());
+    }
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    out.ids = std::move(ids);
+
+    mask_fragments(out, manifest);
+    record_accesses(out);
+    return out;
+}
+
+/*
+ * Paths (well paths, polylines) are partitioned into stretches of the path,
+ * which are cut when the next point would make the task read more than
+ * task_size fragments. cells(gvt, point) are the fragments needed for a
+ * point, of which only the stored fragments are read.
+ */
+template < typename Fetch, typename Cells >
+std::vector< std::string > partition_path(
+        Fetch& output,
+        int task_size,
+        Cells cells)
+noexcept (false) {
+    if (task_size < 1) {
+        const auto msg = fmt::format("task_size (= {}) < 1", task_size);
+        throw std::logic_error(msg);
+    }
+
+    const auto gvt = one::gvt< 3 > {
+        { std::size_t(output.shape_cube[0]),
+          std::size_t(output.shape_cube[1]),
+          std::size_t(output.shape_cube[2]), },
+        { std::size_t(output.shape[0]),
+          std::size_t(output.shape[1]),
+          std::size_t(output.shape[2]), }
+    };
+
+    const auto points = std::move(output.points);
+    const auto index  = std::move(output.index);
+    const auto mask   = one::fragment_mask(output);
+    const auto absent = [&mask](const std::vector< int >& id) {
+        return not mask.stored(id[0], id[1]);
+    };
+
+    std::vector< std::string > xs;
+    const auto flush = [&]() {
+        auto& ids = output.ids;
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        xs.push_back(output.pack());
+        output.points.clear();
+        output.index.clear();
+        output.ids.clear();
+    };
+
+    output.ids.clear();
+    std::set< std::vector< int > > current;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        auto cell = cells(gvt, points[i]);
+        cell.erase(std::remove_if(cell.begin(), cell.end(), absent), cell.end());
+        const auto added = std::count_if(
+            cell.begin(),
+            cell.end(),
+            [&current](const auto& id) { return current.count(id) == 0; }
+        );
+
+        if (not current.empty() and int(current.size() + added) > task_size) {
+            flush();
+            current.clear();
+        }
+
+        current.insert(cell.begin(), cell.end());
+        output.points.push_back(points[i]);
+        output.index.push_back(index[i]);
+        output.ids.insert(output.ids.end(), cell.begin(), cell.end());
+    }
+
+    /*
+     * Processes without points still get an empty task, see task_count()
+     */
+    if (not output.points.empty() or xs.empty())
+        flush();
+
+    return xs;
+}
+
+template <>
+std::vector< std::string >
+schedule_maker< one::wellpath_task, one::wellpath_fetch >::partition(
+        one::wellpath_fetch& output,
+        int task_size
+) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "partition");
+    return partition_path(output, task_size, cell_fragments);
+}
+
+template <>
+one::process_header
+schedule_maker< one::wellpath_task, one::wellpath_fetch >::header(
+    const one::wellpath_task& task,
+    const nlohmann::json&,
+    int ntasks
+) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "header");
+    one::process_header head;
+    head.pid    = task.pid;
+    head.ntasks = ntasks;
+    head.format = task.format;
+    head.decimation = 1;
+
+    /*
+     * The well path is indexed by the position of the point in the path
+     */
+    const auto npoints = int(task.points.size());
+    head.shape = { npoints };
+    std::vector< int > positions(npoints);
+    std::iota(positions.begin(), positions.end(), 0);
+    head.index.push_back(positions);
+    return head;
+}
+
+/*
+ * Polylines
+ * ---------
+ * A polyline is densified to points evenly spaced along the line, and every
+ * point is a trace interpolated from the 4 traces around it. The traces are
+ * read whole, so a point needs every fragment in the (up to 4) fragment
+ * columns of its traces. Like well paths, tasks are stretches of the path.
+ */
+/*
+ * Traces closer than a tenth of the distance between neighbouring traces are
+ * practically the same trace, so spacings below that are rejected. The number
+ * of points in a path is capped, which with the minimum spacing still allows
+ * a path across surveys of more than 10000 x 10000 traces.
+ */
+constexpr double min_spacing = 0.1;
+constexpr std::size_t max_path_points = 1 << 18;
+
+/*
+ * Densify the polyline of the control points to points spacing apart,
+ * measured along the line and across the control points. The last control
+ * point always ends the path.
+ *
+ * The points of a segment are counted up front, and placed at their offset
+ * from the start of the segment, rather than by stepping the offset, which
+ * stops advancing when spacing is small relative to the offset.
+ */
+std::vector< std::array< double, 2 > > densify(
+        const std::vector< std::array< double, 2 > >& control,
+        double spacing)
+noexcept (false) {
+    if (control.size() < 2)
+        return control;
+
+    /*
+     * offset is the distance from the start of the current segment to the
+     * next point
+     */
+    std::vector< std::array< double, 2 > > path = { control.front() };
+    double offset = spacing;
+    for (std::size_t i = 1; i < control.size(); ++i) {
+        const auto& a = control[i - 1];
+        const auto& b = control[i];
+        const auto dx = b[0] - a[0];
+        const auto dy = b[1] - a[1];
+        const auto length = std::hypot(dx, dy);
+
+        if (offset >= length) {
+            offset -= length;
+            continue;
+        }
+
+        const auto n = std::ceil((length - offset) / spacing);
+        if (path.size() + n >= max_path_points) {
+            const auto msg = "polyline with spacing {} has more than {} points";
+            throw one::bad_message(fmt::format(msg, spacing, max_path_points));
+        }
+
+        const auto npoints = std::size_t(n);
+        for (std::size_t k = 0; k < npoints; ++k) {
+            const auto t = (offset + k * spacing) / length;
+            path.push_back({ a[0] + t * dx, a[1] + t * dy });
+        }
+        offset += npoints * spacing - length;
+    }
+
+    path.push_back(control.back());
+    return path;
+}
+
+/*
+ * The distance between neighbouring traces in the units of the coordinates of
+ * the polyline, which for world coordinates is the shortest of the inline and
+ * crossline distance.
+ */
+double trace_distance(
+        const one::polyline_task& task,
+        const nlohmann::json& manifest)
+noexcept (false) {
+    if (task.coordinates != "world")
+        return 1.0;
+
+    /* throws if the cube has no transform */
+    manifest_transform(manifest);
+    const auto t = manifest["transform"].get< std::array< double, 6 > >();
+    return std::min(std::hypot(t[1], t[4]), std::hypot(t[2], t[5]));
+}
+
+/*
+ * The densified path of the polyline, in grid coordinates. The polyline is
+ * walked in the coordinates it is given in, so that the spacing is in world
+ * units for world coordinates.
+ */
+std::vector< std::array< double, 2 > > polyline_path(
+        const one::polyline_task& task,
+        const nlohmann::json& manifest)
+noexcept (false) {
+    const auto& dimensions = manifest["dimensions"];
+    const std::vector< int > labels[] = {
+        dimensions[0].get< std::vector< int > >(),
+        dimensions[1].get< std::vector< int > >(),
+    };
+
+    auto grid = task.points;
+    if (task.coordinates == "label") {
+        for (auto& point : grid)
+        for (int dim = 0; dim < 2; ++dim)
+            point[dim] = fractional_index(labels[dim], point[dim]);
+    }
+    if (task.coordinates == "world")
+        world_to_grid_inplace(manifest, grid);
+
+    for (std::size_t i = 0; i < grid.size(); ++i) {
+        for (int dim = 0; dim < 2; ++dim) {
+            const auto x = grid[i][dim];
+            if (not (std::isfinite(x)
+                 and 0 <= x
+                 and x <= double(labels[dim].size() - 1))) {
+                const auto msg = "point {} (= ({}, {})) not in cube";
+                throw one::not_found(fmt::format(
+                    msg,
+                    i,
+                    task.points[i][0],
+                    task.points[i][1]
+                ));
+            }
+        }
+    }
+
+    const auto floor = min_spacing * trace_distance(task, manifest);
+    if (not (task.spacing >= floor)) {
+        const auto msg = "spacing (= {}) < {}, a tenth of the trace distance";
+        throw one::bad_message(fmt::format(msg, task.spacing, floor));
+    }
+
+    if (task.coordinates != "world")
+        return densify(grid, task.spacing);
+
+    auto path = densify(task.points, task.spacing);
+    world_to_grid_inplace(manifest, path);
+    /*
+     * The path is inside the cube since the control points are, but the
+     * round trip through world coordinates can put points on the edge of the
+     * cube just outside it.
+     */
+    for (auto& point : path)
+    for (int dim = 0; dim < 2; ++dim) {
+        const auto last = double(labels[dim].size() - 1);
+        point[dim] = std::min(std::max(point[dim], 0.0), last);
+    }
+    return path;
+}
+
+/*
+ * The fragments of the 4 traces around a point, in grid coordinates, sorted
+ * and without duplicates.
+ */
+std::vector< std::vector< int > > column_fragments(
+        const one::gvt< 3 >& gvt,
+        const std::array< double, 2 >& point)
+noexcept (false) {
+    const auto& cs = gvt.cube_shape();
+    const auto x = one::interpolation_cell(point[0], cs[0]);
+    const auto y = one::interpolation_cell(point[1], cs[1]);
+    const auto zfrags = int(gvt.fragment_count(gvt.mkdim(2)));
+
+    std::vector< std::vector< int > > ids;
+    for (const auto i : { x.lower, x.upper })
+    for (const auto j : { y.lower, y.upper }) {
+        const auto fid = gvt.frag_id(one::CP< 3 > { i, j, 0 });
+        for (int k = 0; k < zfrags; ++k)
+            ids.push_back({ int(fid[0]), int(fid[1]), k });
+    }
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+template <>
+one::polyline_fetch
+schedule_maker< one::polyline_task, one::polyline_fetch >::build(
+    const one::polyline_task& task,
+    const nlohmann::json& manifest)
+{
+    ONESEISMIC_TRACE("plan", "build");
+    const auto& dimensions = manifest["dimensions"];
+
+    auto out = one::polyline_fetch(task);
+    out.points      = polyline_path(task, manifest);
+    out.coordinates = "grid";
+    out.decimation  = 1;
+    out.shape_cube.clear();
+    for (const auto& dimension : dimensions)
+        out.shape_cube.push_back(dimension.size());
+
+    const auto gvt = geometry(dimensions, task.shape);
+    check_attribute_window(task, gvt.fragment_shape()[2]);
+
+    out.index.resize(out.points.size());
+    std::iota(out.index.begin(), out.index.end(), 0);
+
+    std::vector< std::vector< int > > ids;
+    for (const auto& point : out.points) {
+        const auto cell = column_fragments(gvt, point);
+        ids.insert(ids.end(), cell.begin(), cell.end());
+    }
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    out.ids = std::move(ids);
+
+    mask_fragments(out, manifest);
+    record_accesses(out);
+    return out;
+}
+
+template <>
+std::vector< std::string >
+schedule_maker< one::polyline_task, one::polyline_fetch >::partition(
+        one::polyline_fetch& output,
+        int task_size
+) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "partition");
+    return partition_path(output, task_size, column_fragments);
+}
+
+template <>
+one::process_header
+schedule_maker< one::polyline_task, one::polyline_fetch >::header(
+    const one::polyline_task& task,
+    const nlohmann::json& manifest,
+    int ntasks
+) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "header");
+    const auto& dimensions = manifest["dimensions"];
+    const auto npoints = int(polyline_path(task, manifest).size());
+
+    one::process_header head;
+    head.pid    = task.pid;
+    head.ntasks = ntasks;
+    head.format = task.format;
+    head.decimation = 1;
+    head.shape = {
+        npoints,
+        reduced_size(task, int(dimensions.back().size())),
+    };
+
+    /*
+     * The traces are indexed by their position in the densified path. The
+     * grid coordinates of every trace are in the response.
+     */
+    std::vector< int > positions(npoints);
+    std::iota(positions.begin(), positions.end(), 0);
+    head.index.push_back(positions);
+    head.index.push_back(reduced_labels(task, dimensions.back()));
+    return head;
+}
+
+/*
+ * Areas
+ * -----
+ * The polygon of an area is rasterised onto the grid, one row (dim0) at a
+ * time, as the spans of the traces inside the polygon. The traces are then
+ * binned by fragment column into bitmasks, so columns without any traces
+ * inside are never read, and a task only carries a few bits per trace.
+ */
+
+/*
+ * Map a label to a fractional index like fractional_index, but extrapolate
+ * linearly from the first and last labels, as polygon vertices may be outside
+ * the cube.
+ */
+double extrapolated_index(const std::vector< int >& labels, double x)
+noexcept (true) {
+    if (labels.size() < 2)
+        return x - labels.front();
+    if (x < labels.front())
+        return (x - labels[0]) / (labels[1] - labels[0]);
+
+    const auto n = labels.size();
+    if (x > labels.back())
+        return (n - 1) + (x - labels[n - 1]) / (labels[n - 1] - labels[n - 2]);
+    return fractional_index(labels, x);
+}
+
+std::vector< std::array< double, 2 > > area_polygon(
+        const one::area_task& task,
+        const nlohmann::json& manifest)
+noexcept (false) {
+    auto polygon = task.polygon;
+    if (task.coordinates == "world")
+        world_to_grid_inplace(manifest, polygon);
+
+    if (task.coordinates == "label") {
+        const auto& dimensions = manifest["dimensions"];
+        const std::vector< int > labels[] = {
+            dimensions[0].get< std::vector< int > >(),
+            dimensions[1].get< std::vector< int > >(),
+        };
+        for (auto& vertex : polygon)
+        for (int dim = 0; dim < 2; ++dim)
+            vertex[dim] = extrapolated_index(labels[dim], vertex[dim]);
+    }
+
+    for (std::size_t i = 0; i < polygon.size(); ++i) {
+        if (not (std::isfinite(polygon[i][0]) and std::isfinite(polygon[i][1]))) {
+            const auto msg = "polygon vertex {} (= ({}, {})) is not finite";
+            throw one::bad_message(fmt::format(
+                msg,
+                i,
+                task.polygon[i][0],
+                task.polygon[i][1]
+            ));
+        }
+    }
+    return polygon;
+}
+
+/*
+ * The traces [first, last] of row (dim0) i that are inside the polygon
+ */
+struct span {
+    int i;
+    int first;
+    int last;
+};
+
+std::vector< span > rasterise(
+        const std::vector< std::array< double, 2 > >& polygon,
+        int rows,
+        int columns)
+noexcept (false) {
+    double lo = polygon.front()[0];
+    double hi = polygon.front()[0];
+    for (const auto& vertex : polygon) {
+        lo = std::min(lo, vertex[0]);
+        hi = std::max(hi, vertex[0]);
+    }
+
+    const auto first = std::max(0,        int(std::ceil(lo)));
+    const auto last  = std::min(rows - 1, int(std::floor(hi)));
+
+    std::vector< span > spans;
+    std::vector< double > crossings;
+    std::vector< std::array< int, 2 > > runs;
+    for (int i = first; i <= last; ++i) {
+        /*
+         * The crossings of the row with the edges. Edges are half-open in
+         * dim0, so that a row through a vertex crosses exactly one of its
+         * edges, or none when it only touches it.
+         */
+        crossings.clear();
+        runs.clear();
+        for (std::size_t e = 0; e < polygon.size(); ++e) {
+            const auto& a = polygon[e];
+            const auto& b = polygon[(e + 1) % polygon.size()];
+            if (a[0] == i) {
+                /*
+                 * Traces on the boundary are inside, which the crossings miss
+                 * for vertices and edges that only touch the row.
+                 */
+                const auto lo = std::min(a[1], b[0] == i ? b[1] : a[1]);
+                const auto hi = std::max(a[1], b[0] == i ? b[1] : a[1]);
+                runs.push_back({ int(std::ceil(lo)), int(std::floor(hi)) });
+            }
+
+            if ((a[0] <= i) == (b[0] <= i))
+                continue;
+
+            const auto t = (i - a[0]) / (b[0] - a[0]);
+            crossings.push_back(a[1] + t * (b[1] - a[1]));
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        for (std::size_t c = 0; c + 1 < crossings.size(); c += 2) {
+            runs.push_back({
+                int(std::ceil(crossings[c])),
+                int(std::floor(crossings[c + 1])),
+            });
+        }
+
+        /* merge the overlapping runs, so that every trace is output once */
+        std::sort(runs.begin(), runs.end());
+        for (const auto& run : runs) {
+            const auto fst = std::max(0,           run[0]);
+            const auto lst = std::min(columns - 1, run[1]);
+            if (fst > lst)
+                continue;
+
+            if (not spans.empty() and spans.back().i == i
+                                  and spans.back().last + 1 >= fst)
+                spans.back().last = std::max(spans.back().last, lst);
+            else
+                spans.push_back({ i, fst, lst });
+        }
+    }
+
+    return spans;
+}
+
+template <>
+one::area_fetch
+schedule_maker< one::area_task, one::area_fetch >::build(
+    const one::area_task& task,
+    const nlohmann::json& manifest)
+{
+    ONESEISMIC_TRACE("plan", "build");
+    const auto& dimensions = manifest["dimensions"];
+
+    auto out = one::area_fetch(task);
+    out.decimation = 1;
+    out.shape_cube.clear();
+    for (const auto& dimension : dimensions)
+        out.shape_cube.push_back(dimension.size());
+
+    const auto zrange = sample_range(
+        manifest["dimensions"].back().get< std::vector< int > >(),
+        task.zmin,
+        task.zmax
+    );
+    out.zbegin = zrange[0];
+    out.zend   = zrange[1];
+
+    const auto gvt = geometry(dimensions, task.shape);
+    const auto& fs = gvt.fragment_shape();
+    const auto bits  = fs[0] * fs[1];
+    const auto words = (bits + 63) / 64;
+
+    std::vector< int > ks;
+    for (auto k = out.zbegin / fs[2]; k <= (out.zend - 1) / fs[2]; ++k)
+        ks.push_back(k);
+
+    const auto polygon = area_polygon(task, manifest);
+    const auto spans = rasterise(
+        polygon,
+        int(dimensions[0].size()),
+        int(dimensions[1].size())
+    );
+
+    std::map< std::array< int, 2 >, std::vector< std::uint64_t > > columns;
+    for (const auto& span : spans) {
+        for (int j = span.first; j <= span.last; ++j) {
+            const auto col = std::array< int, 2 > {
+                int(span.i / fs[0]),
+                int(j / fs[1]),
+            };
+            auto& mask = columns[col];
+            if (mask.empty())
+                mask.assign(words, 0);
+
+            const auto bit = (span.i % fs[0]) * fs[1] + (j % fs[1]);
+            mask[bit / 64] |= std::uint64_t(1) << (bit % 64);
+        }
+    }
+
+    for (auto& column : columns) {
+        one::area_column c;
+        c.id   = { column.first[0], column.first[1] };
+        c.ks   = ks;
+        c.mask = std::move(column.second);
+        out.ids.push_back(std::move(c));
+    }
+
+    mask_fragments(out, manifest);
+    record_accesses(out);
+    return out;
+}
+
+template <>
+std::vector< std::string >
+schedule_maker< one::area_task, one::area_fetch >::partition(
+        one::area_fetch& output,
+        int task_size
+) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "partition");
+    return partition_columns(output, task_size);
+}
+
+template <>
+one::process_header
+schedule_maker< one::area_task, one::area_fetch >::header(
+    const one::area_task& task,
+    const nlohmann::json& manifest,
+    int ntasks
+) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "header");
+    const auto& dimensions = manifest["dimensions"];
+    const auto zrange = sample_range(
+        manifest["dimensions"].back().get< std::vector< int > >(),
+        task.zmin,
+        task.zmax
+    );
+    const auto spans  = rasterise(
+        area_polygon(task, manifest),
+        int(dimensions[0].size()),
+        int(dimensions[1].size())
+    );
+
+    /*
+     * The columns of absent fragments are not planned (see build), so their
+     * traces are not a part of the result
+     */
+    one::common_task level(task);
+    level.decimation = 1;
+    level.shape_cube.clear();
+    for (const auto& dimension : dimensions)
+        level.shape_cube.push_back(dimension.size());
+    level.fragment_mask = level_fragment_mask(manifest, level.decimation);
+    const auto stored = one::fragment_mask{ level };
+    const auto& fs = level.shape;
+
+    int ntraces = 0;
+    for (const auto& span : spans) {
+        for (int j = span.first; j <= span.last; ++j)
+            ntraces += stored.stored(span.i / fs[0], j / fs[1]);
+    }
+
+    one::process_header head;
+    head.pid    = task.pid;
+    head.ntasks = ntasks;
+    head.format = task.format;
+    head.decimation = 1;
+    head.shape = { ntraces, zrange[1] - zrange[0] };
+
+    /*
+     * The traces carry their own (dim0, dim1) position, so the traces are
+     * indexed by position only. The samples are indexed by their labels.
+     */
+    std::vector< int > positions(ntraces);
+    std::iota(positions.begin(), positions.end(), 0);
+    const auto& samples = dimensions.back();
+    head.index.push_back(positions);
+    head.index.push_back(std::vector< int >(
+        samples.begin() + zrange[0],
+        samples.begin() + zrange[1]
+    ));
+    return head;
+}
+
+/*
+ * Points
+ * ------
+ * Points are binned by fragment by sorting (fragment, position) pairs, with
+ * the fragment id packed into a single integer, so that binning millions of
+ * points is a single sort of integers rather than a search per point. Sorting
+ * on the position too keeps the points of a fragment in request order.
+ */
+std::uint64_t packed_fragment_id(const one::FID< 3 >& id) noexcept (true) {
+    return (std::uint64_t(id[0]) << 42)
+         | (std::uint64_t(id[1]) << 21)
+         | (std::uint64_t(id[2]) <<  0)
+    ;
+}
+
+template <>
+one::points_fetch
+schedule_maker< one::points_task, one::points_fetch >::build(
+    const one::points_task& task,
+    const nlohmann::json& manifest)
+{
+    ONESEISMIC_TRACE("plan", "build");
+    const auto& dimensions = manifest["dimensions"];
+
+    auto out = one::points_fetch(task);
+    if (out.coordinates == "label") {
+        to_cartesian_inplace(dimensions[0], out.dim0s);
+        to_cartesian_inplace(dimensions[1], out.dim1s);
+        to_cartesian_inplace(dimensions[2], out.dim2s);
+    }
+
+    out.decimation = 1;
+    out.shape_cube.clear();
+    for (const auto& dimension : dimensions)
+        out.shape_cube.push_back(dimension.size());
+
+    const auto gvt = geometry(dimensions, task.shape);
+    const auto& cs = gvt.cube_shape();
+    const auto& fs = gvt.fragment_shape();
+    const auto npoints = out.dim0s.size();
+
+    std::vector< std::pair< std::uint64_t, int > > bins(npoints);
+    std::vector< int > offsets(npoints);
+    for (std::size_t i = 0; i < npoints; ++i) {
+        const auto x = out.dim0s[i];
+        const auto y = out.dim1s[i];
+        const auto z = out.dim2s[i];
+        if (x < 0 or y < 0 or z < 0
+            or std::size_t(x) >= cs[0]
+            or std::size_t(y) >= cs[1]
+            or std::size_t(z) >= cs[2]) {
+            const auto msg = "point {} (= ({}, {}, {})) not in cube";
+            throw one::not_found(fmt::format(msg, i, x, y, z));
+        }
+
+        const auto cp = one::CP< 3 > {
+            std::size_t(x),
+            std::size_t(y),
+            std::size_t(z),
+        };
+        bins[i] = { packed_fragment_id(gvt.frag_id(cp)), int(i) };
+        offsets[i] = int(fs.to_offset(gvt.to_local(cp)));
+    }
+    std::sort(bins.begin(), bins.end());
+
+    out.dim0s.clear();
+    out.dim1s.clear();
+    out.dim2s.clear();
+    out.coordinates = "grid";
+
+    auto& ids = out.ids;
+    for (std::size_t i = 0; i < bins.size(); ++i) {
+        const auto position = bins[i].second;
+        if (i == 0 or bins[i].first != bins[i - 1].first) {
+            const auto key = bins[i].first;
+            one::points_fragment fragment;
+            fragment.id = {
+                int((key >> 42) & 0x1FFFFF),
+                int((key >> 21) & 0x1FFFFF),
+                int((key >>  0) & 0x1FFFFF),
+            };
+            ids.push_back(std::move(fragment));
+        }
+
+        ids.back().offsets.push_back(offsets[position]);
+        ids.back().index.push_back(position);
+    }
+
+    mask_fragments(out, manifest);
+    record_accesses(out);
+    return out;
+}
+
+template <>
+one::process_header
+schedule_maker< one::points_task, one::points_fetch >::header(
+    const one::points_task& task,
+    const nlohmann::json&,
+    int ntasks
+) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "header");
+    one::process_header head;
+    head.pid    = task.pid;
+    head.ntasks = ntasks;
+    head.format = task.format;
+    head.decimation = 1;
+
+    /*
+     * The points are indexed by their position in the request
+     */
+    const auto npoints = int(task.dim0s.size());
+    head.shape = { npoints };
+    std::vector< int > positions(npoints);
+    std::iota(positions.begin(), positions.end(), 0);
+    head.index.push_back(positions);
+    return head;
+}
+
+/*
+ * Statistics
+ * ----------
+ * The upload writes the summary statistics (count, min, max, mean, rms, and a
+ * coarse histogram) of every fragment of the full resolution cube to a
+ * sidecar object, stats.bin, next to the fragments (see process.cpp), and
+ * lists it in the manifest with the fragment shape and histogram bins it was
+ * written for:
+ *
+ *  "fragment-stats": { "shape": [64, 64, 64], "bins": 16 }
+ *
+ * The stats of the cube, or of a line, are merged from the stats of its
+ * fragments by a single task that reads only the sidecar, so histograms and
+ * colour scales are available without reading any samples.
+ */
+template <>
+one::stats_fetch
+schedule_maker< one::stats_task, one::stats_fetch >::build(
+    const one::stats_task& task,
+    const nlohmann::json& manifest)
+{
+    ONESEISMIC_TRACE("plan", "build");
+    const auto sidecar = manifest.find("fragment-stats");
+    if (sidecar == manifest.end() or sidecar->is_null())
+        throw one::not_found("no fragment stats for cube");
+
+    const auto shape = sidecar->at("shape").get< std::vector< int > >();
+    if (shape != task.shape) {
+        const auto msg = "no fragment stats for fragment shape {}";
+        throw one::not_found(fmt::format(msg, fmt::join(task.shape, "-")));
+    }
+
+    const auto& dimensions = manifest["dimensions"];
+    auto out = one::stats_fetch(task);
+    out.decimation = 1;
+    out.sidecar_bins = sidecar->value("bins", 16);
+    out.shape_cube.clear();
+    for (const auto& dimension : dimensions)
+        out.shape_cube.push_back(dimension.size());
+
+    if (task.dim == -1)
+        return out;
+
+    if (task.dim >= int(dimensions.size())) {
+        const auto msg = fmt::format(
+            "param.dimension (= {}) not in [0, {})",
+            task.dim,
+            dimensions.size()
+        );
+        throw one::not_found(msg);
+    }
+
+    const auto index = dimensions[task.dim].get< std::vector< int > >();
+    const auto itr = std::find(index.begin(), index.end(), task.lineno);
+    if (itr == index.end()) {
+        const auto msg = "line (= {}) not found in index";
+        throw one::not_found(fmt::format(msg, task.lineno));
+    }
+    out.layer = std::distance(index.begin(), itr) / shape[task.dim];
+    return out;
+}
+
+template <>
+one::process_header
+schedule_maker< one::stats_task, one::stats_fetch >::header(
+    const one::stats_task& task,
+    const nlohmann::json&,
+    int ntasks
+) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "header");
+    one::process_header head;
+    head.pid    = task.pid;
+    head.ntasks = ntasks;
+    head.format = task.format;
+    head.decimation = 1;
+    head.shape = { task.bins };
+    return head;
+}
+
+/*
+ * The stats are always a single task, since they read a single object
+ */
+template <>
+std::vector< std::string >
+schedule_maker< one::stats_task, one::stats_fetch >::partition(
+    one::stats_fetch& output,
+    int task_size
+) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "partition");
+    if (task_size < 1) {
+        const auto msg = fmt::format("task_size (= {}) < 1", task_size);
+        throw std::logic_error(msg);
+    }
+    return { output.pack() };
+}
+
+/*
+ * Batches
+ * -------
+ * A batch is many queries against the same cube, e.g. a fence of curtains or
+ * a set of inlines, which as separate processes would read largely the same
+ * fragments. The queries are built as usual, and the union of their fragments
+ * is partitioned into tasks, with every fragment in exactly one task. A task
+ * carries the share of every query that reads its fragments, so a fragment is
+ * only downloaded once, and the worker extracts from it for all the queries.
+ *
+ * Like for horizons, fragment columns are never split across tasks, since
+ * the elements of the ids of some functions read whole columns. The results
+ * are written to the processes of the queries, and every query gets its own
+ * header, where ntasks is the number of batch tasks it has a share in.
+ * Queries without elements, e.g. when all their fragments are absent, get an
+ * empty share in the first task, so that they complete.
+ *
+ * Well paths and polylines interpolate between neighbouring columns, and
+ * progressive slices are scheduled in phases, so they can not be batched.
+ */
+
+/*
+ * A built query of a batch, with the type of its fetch erased
+ */
+class batched_query {
+public:
+    virtual ~batched_query() = default;
+
+    /* The fetch, as planned. The ids are not included */
+    virtual const one::common_task& task() const noexcept (true) = 0;
+    /* The number of elements in the ids of the fetch */
+    virtual std::size_t size() const noexcept (true) = 0;
+    /* The fragments (i, j, k) read by element n of the ids */
+    virtual std::vector< std::array< int, 3 > > fragments(std::size_t n)
+        const noexcept (false) = 0;
+    /* Pack the fetch, with the ids restricted to the elements */
+    virtual std::string pack(const std::vector< std::size_t >& elements)
+        noexcept (false) = 0;
+    virtual one::process_header header(int ntasks) noexcept (false) = 0;
+};
+
+template < typename Input, typename Output >
+class batched : public batched_query {
+public:
+    explicit batched(const std::string& doc) noexcept (false) {
+        this->input.unpack(doc.data(), doc.data() + doc.size());
+        this->manifest = nlohmann::json::parse(this->input.manifest);
+        this->fetch = this->maker.build(this->input, this->manifest);
+        this->ids.swap(this->fetch.ids);
+        /*
+         * The workers need neither the manifest nor the token of the query,
+         * and the manifest can be large. The token of the batch is used to
+         * read the fragments.
+         */
+        this->fetch.manifest.clear();
+        this->fetch.token.clear();
+    }
+
+    const one::common_task& task() const noexcept (true) override {
+        return this->fetch;
+    }
+
+    std::size_t size() const noexcept (true) override {
+        return this->ids.size();
+    }
+
+    std::vector< std::array< int, 3 > > fragments(std::size_t n)
+    const noexcept (false) override {
+        std::vector< std::array< int, 3 > > xs;
+        for_each_fragment(this->ids[n], [&xs](int i, int j, int k) {
+            xs.push_back({ i, j, k });
+        });
+        return xs;
+    }
+
+    std::string pack(const std::vector< std::size_t >& elements)
+    noexcept (false) override {
+        this->fetch.ids.clear();
+        for (const auto n : elements)
+            this->fetch.ids.push_back(this->ids[n]);
+        return this->fetch.pack();
+    }
+
+    one::process_header header(int ntasks) noexcept (false) override {
+        auto head = this->maker.header(this->input, this->manifest, ntasks);
+        head.fill_value = fill_value(this->manifest);
+        return head;
+    }
+
+private:
+    Input input;
+    nlohmann::json manifest;
+    Output fetch;
+    decltype(Output::ids) ids;
+    schedule_maker< Input, Output > maker;
+};
+
+std::unique_ptr< batched_query > make_batched(const std::string& doc)
+noexcept (false) {
+    const auto document = nlohmann::json::parse(doc);
+    const std::string function = document.at("function");
+    if (function == "slice") {
+        if (document.at("params").value("progressive", false))
+            throw one::bad_message("progressive slices can not be batched");
+        using slice = batched< one::slice_task, one::slice_fetch >;
+        return std::make_unique< slice >(doc);
+    }
+    if (function == "curtain") {
+        using curtain = batched< one::curtain_task, one::curtain_fetch >;
+        return std::make_unique< curtain >(doc);
+    }
+    if (function == "horizon") {
+        using horizon = batched< one::horizon_task, one::horizon_fetch >;
+        return std::make_unique< horizon >(doc);
+    }
+    if (function == "area") {
+        using area = batched< one::area_task, one::area_fetch >;
+        return std::make_unique< area >(doc);
+    }
+    if (function == "points") {
+        using points = batched< one::points_task, one::points_fetch >;
+        return std::make_unique< points >(doc);
+    }
+
+    const auto msg = "function {} can not be batched";
+    throw one::bad_message(fmt::format(msg, function));
+}
+
+/*
+ * Query hashing
+ * -------------
+ * Identical queries, e.g. the default inline of a popular cube, are common,
+ * and should share a process rather than being planned, fetched and assembled
+ * again. A query is normalised by a round trip through its task type, which
+ * fills in the defaults of optional parameters, and removes the fields that
+ * are unique to the request (pid, token). The manifest is parsed, so its
+ * formatting does not matter. Keys are sorted in nlohmann::json, which gives
+ * a canonical document.
+ *
+ * The canonical document is hashed with SHA-256. The hash decides whose
+ * result a query is served, so it must be collision resistant, or a crafted
+ * query could be made to share the process of another, popular query.
+ */
+template < typename Task >
+nlohmann::json canonical(const char* doc, int len) noexcept (false) {
+    Task task;
+    task.unpack(doc, doc + len);
+    auto normalised = nlohmann::json::parse(task.pack());
+    normalised.erase("pid");
+    normalised.erase("token");
+    normalised["manifest"] = nlohmann::json::parse(task.manifest);
+    return normalised;
+}
+
+}
+
+namespace one {
+
+std::vector< std::string >
+mkschedule(const char* doc, int len, int task_size) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "mkschedule");
+    const auto document = nlohmann::json::parse(doc, doc + len);
     const std::string function = document["function"];
     if (function == "slice") {
+        slice_task task;
+        task.unpack(doc, doc + len);
+        if (task.progressive)
+            return schedule_progressive_slice(task, task_size);
+
         auto slice = schedule_maker< slice_task, slice_fetch >{};
-        return slice.schedule(doc, len, task_size);
+        return slice.schedule(task, task_size);
     }
     if (function == "curtain") {
         auto curtain = schedule_maker< curtain_task, curtain_fetch >{};
         return curtain.schedule(doc, len, task_size);
     }
+    if (function == "horizon") {
+        auto horizon = schedule_maker< horizon_task, horizon_fetch >{};
+        return horizon.schedule(doc, len, task_size);
+    }
+    if (function == "wellpath") {
+        auto wellpath = schedule_maker< wellpath_task, wellpath_fetch >{};
+        return wellpath.schedule(doc, len, task_size);
+    }
+    if (function == "polyline") {
+        auto polyline = schedule_maker< polyline_task, polyline_fetch >{};
+        return polyline.schedule(doc, len, task_size);
+    }
+    if (function == "area") {
+        auto area = schedule_maker< area_task, area_fetch >{};
+        return area.schedule(doc, len, task_size);
+    }
+    if (function == "points") {
+        auto points = schedule_maker< points_task, points_fetch >{};
+        return points.schedule(doc, len, task_size);
+    }
+    if (function == "stats") {
+        auto stats = schedule_maker< stats_task, stats_fetch >{};
+        return stats.schedule(doc, len, task_size);
+    }
     throw std::logic_error("No handler for function " + function);
 }
 
+std::vector< std::string >
+mkbatch(const char* doc, int len, int task_size) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "mkbatch");
+    if (task_size < 1) {
+        const auto msg = fmt::format("task_size (= {}) < 1", task_size);
+        throw std::logic_error(msg);
+    }
+
+    batch_task batch;
+    batch.unpack(doc, doc + len);
+
+    std::vector< std::unique_ptr< batched_query > > queries;
+    for (const auto& task : batch.tasks) {
+        queries.push_back(make_batched(task));
+        const auto& query = queries.back()->task();
+        if (query.guid != batch.guid or query.shape != batch.shape) {
+            const auto msg = "expected batched tasks to read {} with fragment "
+                             "shape {}, but {} reads {} with shape {}";
+            throw bad_message(fmt::format(
+                msg,
+                batch.guid,
+                fmt::join(batch.shape, "-"),
+                query.pid,
+                query.guid,
+                fmt::join(query.shape, "-")
+            ));
+        }
+    }
+
+    /*
+     * The fragment columns (decimation, i, j) of the batch, with the
+     * fragments (k) of every column, and the column of every element of the
+     * queries. Queries may read from different overview levels, so the
+     * decimation is a part of the column.
+     */
+    using column = std::array< int, 3 >;
+    std::map< column, std::set< int > > columns;
+    std::vector< std::vector< column > > elements(queries.size());
+    for (std::size_t q = 0; q < queries.size(); ++q) {
+        const auto& query = *queries[q];
+        const auto decimation = query.task().decimation;
+        for (std::size_t n = 0; n < query.size(); ++n) {
+            const auto fragments = query.fragments(n);
+            assert(not fragments.empty());
+            const auto& fst = fragments.front();
+            const auto key = column { decimation, fst[0], fst[1] };
+            auto& ks = columns[key];
+            for (const auto& id : fragments)
+                ks.insert(id[2]);
+            elements[q].push_back(key);
+        }
+    }
+
+    /*
+     * Fill tasks with whole columns until they have at least task_size
+     * fragments
+     */
+    std::map< column, int > task_of;
+    int ntasks = 0;
+    int nfragments = 0;
+    for (const auto& col : columns) {
+        task_of[col.first] = ntasks;
+        nfragments += col.second.size();
+        if (nfragments >= task_size) {
+            ntasks += 1;
+            nfragments = 0;
+        }
+    }
+    if (nfragments > 0 or ntasks == 0)
+        ntasks += 1;
+
+    /*
+     * The share of every query in every task, as indices into the ids of the
+     * query
+     */
+    using share = std::vector< std::size_t >;
+    std::vector< std::vector< share > > shares(
+        ntasks,
+        std::vector< share >(queries.size())
+    );
+    std::vector< int > parts(queries.size(), 0);
+    for (std::size_t q = 0; q < queries.size(); ++q) {
+        if (elements[q].empty())
+            parts[q] = 1;
+
+        for (std::size_t n = 0; n < elements[q].size(); ++n) {
+            auto& s = shares[task_of.at(elements[q][n])][q];
+            if (s.empty())
+                parts[q] += 1;
+            s.push_back(n);
+        }
+    }
+
+    batch_fetch fetch(batch);
+    fetch.function = "batch";
+    fetch.manifest.clear();
+
+    std::vector< std::string > sched;
+    std::vector< int > part(queries.size(), 0);
+    for (std::size_t t = 0; t < shares.size(); ++t) {
+        const auto& task = shares[t];
+        fetch.queries.clear();
+        for (std::size_t q = 0; q < queries.size(); ++q) {
+            const auto empty = t == 0 and elements[q].empty();
+            if (task[q].empty() and not empty)
+                continue;
+
+            auto& query = *queries[q];
+            batch_query x;
+            x.pid      = query.task().pid;
+            x.part     = fmt::format("{}/{}", part[q]++, parts[q]);
+            x.function = query.task().function;
+            x.fetch    = query.pack(task[q]);
+            fetch.queries.push_back(std::move(x));
+        }
+        sched.push_back(fetch.pack());
+    }
+
+    for (std::size_t q = 0; q < queries.size(); ++q)
+        sched.push_back(queries[q]->header(parts[q]).pack());
+    return sched;
+}
+
+std::string query_hash(const char* doc, int len) noexcept (false) {
+    ONESEISMIC_TRACE("plan", "query_hash");
+    const auto document = nlohmann::json::parse(doc, doc + len);
+    const std::string function = document["function"];
+
+    nlohmann::json normalised;
+    if (function == "slice")
+        normalised = canonical< slice_task >(doc, len);
+    else if (function == "curtain")
+        normalised = canonical< curtain_task >(doc, len);
+    else if (function == "horizon")
+        normalised = canonical< horizon_task >(doc, len);
+    else if (function == "wellpath")
+        normalised = canonical< wellpath_task >(doc, len);
+    else if (function == "polyline")
+        normalised = canonical< polyline_task >(doc, len);
+    else if (function == "area")
+        normalised = canonical< area_task >(doc, len);
+    else if (function == "points")
+        normalised = canonical< points_task >(doc, len);
+    else if (function == "stats")
+        normalised = canonical< stats_task >(doc, len);
+    else
+        throw std::logic_error("No handler for function " + function);
+
+    const auto canonical = normalised.dump();
+    return hex(sha256_digest(canonical.data(), canonical.size()));
+}
+
 }
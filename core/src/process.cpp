@@ -1,9 +1,20 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
 #include <numeric>
 #include <string>
 #include <vector>
 
 #include <fmt/format.h>
 
+#include <oneseismic/attributes.hpp>
+#include <oneseismic/encoding.hpp>
 #include <oneseismic/geometry.hpp>
 #include <oneseismic/messages.hpp>
 #include <oneseismic/process.hpp>
@@ -41,11 +52,82 @@ one::gvt< 3 > gvt3(const one::common_task& task) {
     return { cs, fs };
 }
 
+/*
+ * Encode the extracted samples of a tile or trace in-place, if the requested
+ * output format is not f32. This is done as part of add(), while the samples
+ * are still hot in cache, and releases the f32 buffer.
+ */
+template < typename T >
+void encode_inplace(one::encoding enc, T& x) noexcept (false) {
+    if (enc == one::encoding::f32)
+        return;
+
+    x.encoded.resize(x.v.size());
+    one::encode(
+        enc,
+        x.v.data(),
+        x.v.size(),
+        x.encoded.data(),
+        x.scale,
+        x.offset
+    );
+    x.v.clear();
+    x.v.shrink_to_fit();
+}
+
+/*
+ * Reduce the z-axis of rows of zheight samples to the attribute, in-place.
+ * Only the first valid samples of every row are reduced, so that the padding
+ * at the bottom of the cube does not contribute to the attribute. The
+ * reduced windows of the padding are 0.
+ */
+void reduce_rows(
+        one::attribute attr,
+        std::vector< float >& v,
+        int zheight,
+        int valid,
+        int window,
+        std::vector< float >& buffer)
+noexcept (false) {
+    const auto rows = v.size() / zheight;
+    const auto width = zheight / window;
+    buffer.assign(rows * width, 0);
+    for (std::size_t r = 0; r < rows; ++r) {
+        one::reduce(
+            attr,
+            v.data() + r * zheight,
+            valid,
+            window,
+            buffer.data() + r * width
+        );
+    }
+    v.swap(buffer);
+}
+
+/*
+ * a = (1 - w) * a + w * b, element-wise
+ */
+void lerp_inplace(float* a, const float* b, const float* w, std::size_t n)
+noexcept (true) {
+    for (std::size_t i = 0; i < n; ++i)
+        a[i] += (b[i] - a[i]) * w[i];
+}
+
+/*
+ * a = (1 - w) * a + w * b, element-wise, with the same weight for all elements
+ */
+void lerp_inplace(float* a, const float* b, float w, std::size_t n)
+noexcept (true) {
+    for (std::size_t i = 0; i < n; ++i)
+        a[i] += (b[i] - a[i]) * w;
+}
+
 class slice : public proc {
-public:
-    void init(const char* msg, int len) override;
-    virtual void add(int, const char* chunk, int len) override;
-    std::string pack() override;
+protected:
+    void do_init(const char* msg, int len) override;
+    void do_add(int, const char* chunk, int len) override;
+    std::string do_pack() override;
+    std::vector< std::vector< int > > do_prefetch(int direction) const override;
 
 private:
     one::slice_fetch input;
@@ -53,21 +135,190 @@ private:
 
     one::dimension< 3 > dim = one::dimension< 3 >(0);
     int idx;
+    /* The number of fragment layers along dim */
+    int layers;
     one::slice_layout layout;
     one::gvt< 2 > gvt;
+    one::encoding enc = one::encoding::f32;
+    /*
+     * The geometry of the output, which is the gvt with z reduced by the
+     * attribute window when the slice is reduced to an attribute.
+     */
+    one::gvt< 2 > outgvt;
+    one::attribute attr = one::attribute::none;
+    std::vector< float > reduced;
+    /*
+     * The region of interest [begin, end) of the slice in output samples,
+     * i.e. z is reduced when the slice is reduced to an attribute, with every
+     * step'th sample. When the region is not the whole slice the tiles are
+     * cropped.
+     */
+    std::array< int, 2 > begin;
+    std::array< int, 2 > end;
+    std::array< int, 2 > step;
+    bool cropped = false;
 };
 
 class curtain : public proc {
-public:
-    void init(const char* msg, int len) override;
-    virtual void add(int, const char* chunk, int len) override;
-    std::string pack() override;
+protected:
+    void do_init(const char* msg, int len) override;
+    void do_add(int, const char* chunk, int len) override;
+    std::string do_pack() override;
 
 private:
     one::curtain_fetch  input;
     one::curtain_traces output;
     one::gvt< 3 >       gvt;
     std::vector< int >  traceindex;
+    one::encoding       enc = one::encoding::f32;
+    one::attribute      attr = one::attribute::none;
+    /* The z-range, see slice */
+    int                 zbegin;
+    int                 zend;
+    bool                cropped = false;
+};
+
+class horizon : public proc {
+protected:
+    void do_init(const char* msg, int len) override;
+    void do_add(int, const char* chunk, int len) override;
+    std::string do_pack() override;
+
+private:
+    void reduce_windows();
+
+    one::horizon_fetch  input;
+    one::horizon_values output;
+    one::gvt< 3 >       gvt;
+    /*
+     * The (column, k) of every fragment, by key, and the position in the
+     * output of the first point of every column.
+     */
+    std::vector< std::array< int, 2 > > keys;
+    std::vector< int >                  pointindex;
+    one::encoding                       enc = one::encoding::f32;
+    one::attribute                      attr = one::attribute::none;
+};
+
+class wellpath : public proc {
+protected:
+    void do_init(const char* msg, int len) override;
+    void do_add(int, const char* chunk, int len) override;
+    std::string do_pack() override;
+
+private:
+    one::wellpath_fetch input;
+    one::point_values   output;
+    one::gvt< 3 >       gvt;
+    /*
+     * The samples around every point are gathered in corners, as 8 arrays of
+     * one sample per point, together with the weights of the points along
+     * every axis. gathers [key] is the (corner slot, offset in fragment) of
+     * every sample to read from the fragment key.
+     */
+    std::vector< std::vector< std::array< std::size_t, 2 > > > gathers;
+    std::vector< float > corners;
+    std::array< std::vector< float >, 3 > weights;
+    one::encoding enc = one::encoding::f32;
+};
+
+class polyline : public proc {
+protected:
+    void do_init(const char* msg, int len) override;
+    void do_add(int, const char* chunk, int len) override;
+    std::string do_pack() override;
+
+private:
+    one::polyline_fetch  input;
+    one::polyline_traces output;
+    one::gvt< 3 >        gvt;
+    /*
+     * The 4 traces around every point are gathered in corners, as 4 arrays of
+     * one trace per point, together with the weights of the points along x
+     * and y. gathers [key] is the (position in corners, offset in fragment,
+     * samples) of every trace segment to copy from the fragment key.
+     */
+    std::vector< std::vector< std::array< std::size_t, 3 > > > gathers;
+    std::vector< float > corners;
+    std::array< std::vector< float >, 2 > weights;
+    one::encoding  enc  = one::encoding::f32;
+    one::attribute attr = one::attribute::none;
+};
+
+class points : public proc {
+protected:
+    void do_init(const char* msg, int len) override;
+    void do_add(int, const char* chunk, int len) override;
+    std::string do_pack() override;
+
+private:
+    one::points_fetch  input;
+    one::point_values  output;
+    /* the position in the output of the first point of every fragment */
+    std::vector< int > pointindex;
+    one::encoding      enc = one::encoding::f32;
+};
+
+class area : public proc {
+protected:
+    void do_init(const char* msg, int len) override;
+    void do_add(int, const char* chunk, int len) override;
+    std::string do_pack() override;
+
+private:
+    one::area_fetch    input;
+    one::area_traces   output;
+    one::gvt< 3 >      gvt;
+    /*
+     * The (column, k) of every fragment, by key, and the position in the
+     * output of the first trace of every column.
+     */
+    std::vector< std::array< int, 2 > > keys;
+    std::vector< int >                  traceindex;
+    one::encoding                       enc = one::encoding::f32;
+};
+
+/*
+ * The summary proc (function stats) reads the fragment stats sidecar, and
+ * merges the stats of the fragments of the query. The sidecar is a packed
+ * array of one record per fragment of the full resolution cube, in (i, j, k)
+ * order, where k is the fastest. All values are little endian, and a record is:
+ *
+ *  float32 min, max, mean, rms
+ *  uint32  count
+ *  uint32  histogram[bins], evenly spaced between min and max
+ *
+ * Fragments without samples, e.g. holes in the survey, have count 0.
+ */
+class summary : public proc {
+protected:
+    void do_init(const char* msg, int len) override;
+    void do_add(int, const char* chunk, int len) override;
+    std::string do_pack() override;
+
+private:
+    one::stats_fetch  input;
+    one::stats_values output;
+    one::gvt< 3 >     gvt;
+};
+
+/*
+ * The batch proc runs a proc for every query in the task, and registers the
+ * union of their fragments, so that a fragment read by many queries is only
+ * downloaded once. Added fragments are passed on to all the procs that read
+ * them, and the result is the packed result of every query.
+ */
+class batch : public proc {
+protected:
+    void do_init(const char* msg, int len) override;
+    void do_add(int, const char* chunk, int len) override;
+    std::string do_pack() override;
+
+private:
+    one::batch_fetch input;
+    std::vector< std::unique_ptr< proc > > procs;
+    /* The (proc, key) of every reader of a fragment, by key */
+    std::vector< std::vector< std::array< int, 2 > > > readers;
 };
 
 }
@@ -77,12 +328,40 @@ std::unique_ptr< proc > proc::make(const std::string& kind) noexcept (false) {
         return std::make_unique< slice >();
     if (kind == "curtain")
         return std::make_unique< curtain >();
+    if (kind == "horizon")
+        return std::make_unique< horizon >();
+    if (kind == "wellpath")
+        return std::make_unique< wellpath >();
+    if (kind == "polyline")
+        return std::make_unique< polyline >();
+    if (kind == "points")
+        return std::make_unique< points >();
+    if (kind == "area")
+        return std::make_unique< area >();
+    if (kind == "stats")
+        return std::make_unique< summary >();
+    if (kind == "batch")
+        return std::make_unique< batch >();
     else
         return nullptr;
 }
 
-void proc::set_fragment_shape(const std::string& shape) noexcept (false) {
-    this->prefix = "src/" + shape + "/";
+void proc::set_fragment_shape(
+        const common_task& task,
+        const std::string& shape)
+noexcept (false) {
+    if (task.decimation == 1)
+        this->prefix = "src/" + shape + "/";
+    else
+        this->prefix = fmt::format("lod{}/{}/", task.decimation, shape);
+
+    this->heat = heatmap::installed(heatmap::at_proc);
+    if (this->heat)
+        this->heatcube = this->heat->cube(
+            heatmap::cube_key(task.guid, shape, task.decimation)
+        );
+
+    this->mask = fragment_mask(task);
 }
 
 void proc::add_fragment(const std::string& id) noexcept (false) {
@@ -93,16 +372,109 @@ void proc::add_fragment(const std::string& id) noexcept (false) {
     this->frags += id;
 }
 
+void proc::add_fragment(const std::vector< int >& id) noexcept (false) {
+    this->add_fragment(fmt::format("{}.f32", fmt::join(id, "-")));
+    if (this->heat and id.size() == 3)
+        this->heat->record(this->heatcube, id[0], id[1], id[2]);
+}
+
 void proc::clear() noexcept (true) {
     this->prefix.clear();
     this->frags.clear();
+    this->heat = nullptr;
+    this->heatcube = -1;
+    this->mask = fragment_mask();
 }
 
 const std::string& proc::fragments() const {
     return this->frags;
 }
 
-void slice::init(const char* msg, int len) {
+std::string proc::prefetch(int direction) const noexcept (false) {
+    std::string ids;
+    for (const auto& id : this->do_prefetch(direction)) {
+        if (not this->mask.stored(id[0], id[1]))
+            continue;
+        if (not ids.empty())
+            ids.push_back(';');
+        ids += this->prefix;
+        ids += fmt::format("{}.f32", fmt::join(id, "-"));
+    }
+    return ids;
+}
+
+std::vector< std::vector< int > > proc::do_prefetch(int) const {
+    return {};
+}
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+double ms_since(clock::time_point start) noexcept (true) {
+    const auto elapsed = clock::now() - start;
+    return std::chrono::duration< double, std::milli >(elapsed).count();
+}
+
+}
+
+void proc::init(const char* msg, int len) noexcept (false) {
+    this->statistics = proc_stats();
+    this->spans.clear();
+    tracing::scope trace(&this->spans);
+    ONESEISMIC_TRACE("proc", "init");
+
+    const auto allocs = thread_allocations();
+    const auto start = clock::now();
+
+    this->do_init(msg, len);
+
+    this->statistics.init_ms = ms_since(start);
+    this->statistics.allocations += thread_allocations() - allocs;
+}
+
+void proc::add(int key, const char* chunk, int len) noexcept (false) {
+    tracing::scope trace(&this->spans);
+    ONESEISMIC_TRACE("proc", "add");
+
+    const auto allocs = thread_allocations();
+    const auto start = clock::now();
+
+    this->do_add(key, chunk, len);
+
+    const auto elapsed = ms_since(start);
+    auto& st = this->statistics;
+    st.add_ms += elapsed;
+    st.add_max_ms = std::max(st.add_max_ms, elapsed);
+    st.adds += 1;
+    st.bytes_in += len;
+    st.allocations += thread_allocations() - allocs;
+}
+
+std::string proc::pack() noexcept (false) {
+    tracing::scope trace(&this->spans);
+    ONESEISMIC_TRACE("proc", "pack");
+
+    const auto allocs = thread_allocations();
+    const auto start = clock::now();
+
+    auto packed = this->do_pack();
+
+    this->statistics.pack_ms = ms_since(start);
+    this->statistics.bytes_out = packed.size();
+    this->statistics.allocations += thread_allocations() - allocs;
+    return packed;
+}
+
+const proc_stats& proc::stats() const noexcept (true) {
+    return this->statistics;
+}
+
+const tracing::recorder& proc::tracer() const noexcept (true) {
+    return this->spans;
+}
+
+void slice::do_init(const char* msg, int len) {
     this->clear();
     this->input.unpack(msg, msg + len);
     this->output.tiles.resize(this->input.ids.size());
@@ -111,26 +483,101 @@ void slice::init(const char* msg, int len) {
     const auto& fragment_shape = g3.fragment_shape();
     const auto& cube_shape     = g3.cube_shape();
 
-    this->set_fragment_shape(fmt::format("{}", fmt::join(fragment_shape, "-")));
+    this->set_fragment_shape(
+        this->input,
+        fmt::format("{}", fmt::join(fragment_shape, "-"))
+    );
     this->dim = g3.mkdim(this->input.dim);
     this->idx = this->input.lineno;
+    this->layers = int(g3.fragment_count(this->dim));
     this->layout = fragment_shape.slice_stride(this->dim);
     this->gvt = one::gvt< 2 >(
         cube_shape.squeeze(this->dim),
         fragment_shape.squeeze(this->dim)
     );
 
-    const auto& cs = this->gvt.cube_shape();
+    /*
+     * Slices along z are rejected by the planner when reducing, so z is always
+     * the last dimension of the squeezed geometry here.
+     */
+    this->attr = one::parse_attribute(this->input.attribute);
+    this->outgvt = this->gvt;
+    if (this->attr != one::attribute::none) {
+        const auto window = std::size_t(this->input.attribute_window);
+        auto cs = this->gvt.cube_shape();
+        auto fs = this->gvt.fragment_shape();
+        cs[1] = (cs[1] + window - 1) / window;
+        fs[1] = fs[1] / window;
+        this->outgvt = one::gvt< 2 >(cs, fs);
+    }
+
+    const auto& cs = this->outgvt.cube_shape();
     this->output.shape.assign(cs.begin(), cs.end());
 
+    /*
+     * The planner puts z on whole attribute windows, which then map to whole
+     * samples of the reduced output.
+     */
+    this->cropped = false;
+    for (int i = 0; i < 2; ++i) {
+        const auto n = int(this->gvt.cube_shape()[i]);
+        const auto window = i == 1 and this->attr != one::attribute::none
+                          ? this->input.attribute_window
+                          : 1
+                          ;
+        this->begin[i] = this->input.begin[i] / window;
+        this->end[i]   = (std::min(this->input.end[i], n) + window - 1) / window;
+        this->step[i]  = this->input.step[i];
+        this->cropped  = this->cropped
+                      or this->begin[i] > 0
+                      or this->end[i] < int(cs[i])
+                      or this->step[i] > 1
+                      ;
+    }
+
+    if (this->cropped) {
+        for (int i = 0; i < 2; ++i) {
+            const auto n = this->end[i] - this->begin[i];
+            this->output.shape[i] = (n + this->step[i] - 1) / this->step[i];
+        }
+    }
+
+    this->enc = one::parse_encoding(this->input.format);
+    this->output.format = one::to_string(this->enc);
+    this->output.decimation = this->input.decimation;
+
     for (const auto& id : this->input.ids)
-        this->add_fragment(fmt::format("{}.f32", fmt::join(id, "-")));
+        this->add_fragment(id);
+}
+
+std::vector< std::vector< int > > slice::do_prefetch(int direction) const {
+    /*
+     * The next line in direction is (usually) in the same fragments, but
+     * lineno +- fragment depth is in the neighbouring layer of fragments, which
+     * is what would be downloaded the next time a step crosses a fragment
+     * boundary. Only the fragments of this task are prefetched, so that the
+     * prefetch is split across the tasks (and workers) of the slice.
+     */
+    const auto d = std::size_t(this->dim);
+    std::vector< std::vector< int > > ids;
+    for (const auto step : { -1, 1 }) {
+        if (direction != 0 and step != direction)
+            continue;
+
+        for (auto id : this->input.ids) {
+            id[d] += step;
+            if (id[d] < 0 or id[d] >= this->layers)
+                continue;
+            ids.push_back(std::move(id));
+        }
+    }
+    return ids;
 }
 
-void slice::add(int key, const char* chunk, int len) {
+void slice::do_add(int key, const char* chunk, int len) {
     auto& t = this->output.tiles[key];
     const auto squeezed_id = id3(this->input.ids[key]).squeeze(this->dim);
-    const auto tile_layout = this->gvt.injection_stride(squeezed_id);
+    const auto tile_layout = this->outgvt.injection_stride(squeezed_id);
     t.iterations   = tile_layout.iterations;
     t.chunk_size   = tile_layout.chunk_size;
     t.initial_skip = tile_layout.initial_skip;
@@ -145,24 +592,83 @@ void slice::add(int key, const char* chunk, int len) {
         dst += this->layout.substride * sizeof(float);
         src += this->layout.superstride * sizeof(float);
     }
+
+    if (this->attr != one::attribute::none) {
+        const auto zheight = int(this->gvt.fragment_shape()[1]);
+        const auto nz      = int(this->gvt.cube_shape()[1]);
+        const auto z0      = int(squeezed_id[1]) * zheight;
+        reduce_rows(
+            this->attr,
+            t.v,
+            zheight,
+            std::min(zheight, nz - z0),
+            this->input.attribute_window,
+            this->reduced
+        );
+    }
+
+    if (this->cropped) {
+        /*
+         * Crop the tile to the rows and columns of the region of interest
+         * that are on-stride, and place it in the output relative to the
+         * start of the region.
+         */
+        const auto& fs = this->outgvt.fragment_shape();
+        std::array< int, 2 > first;
+        std::array< int, 2 > count;
+        std::array< int, 2 > offset;
+        for (int i = 0; i < 2; ++i) {
+            const auto f0 = int(squeezed_id[i] * fs[i]);
+            const auto lo = std::max(f0, this->begin[i]);
+            const auto hi = std::min(f0 + int(fs[i]), this->end[i]);
+            const auto k  = (lo - this->begin[i] + this->step[i] - 1)
+                          / this->step[i];
+            const auto x  = this->begin[i] + k * this->step[i];
+            first[i]  = x - f0;
+            count[i]  = x < hi ? (hi - x + this->step[i] - 1) / this->step[i] : 0;
+            offset[i] = k;
+        }
+
+        const auto width = int(fs[1]);
+        std::vector< float >& v = t.v;
+        for (int r = 0; r < count[0]; ++r) {
+            const auto* src = v.data()
+                            + (first[0] + r * this->step[0]) * width
+                            + first[1];
+            auto* dst = v.data() + r * count[1];
+            for (int c = 0; c < count[1]; ++c)
+                dst[c] = src[c * this->step[1]];
+        }
+        v.resize(count[0] * count[1]);
+
+        const auto outwidth = this->output.shape[1];
+        t.iterations   = count[0];
+        t.chunk_size   = count[1];
+        t.substride    = count[1];
+        t.superstride  = outwidth;
+        t.initial_skip = offset[0] * outwidth + offset[1];
+    }
+
+    encode_inplace(this->enc, t);
 }
 
-std::string slice::pack() {
+std::string slice::do_pack() {
     return this->output.pack();
 }
 
-void curtain::init(const char* msg, int len) {
+void curtain::do_init(const char* msg, int len) {
     this->clear();
     this->input.unpack(msg, msg + len);
     this->gvt = gvt3(this->input);
     this->set_fragment_shape(
+        this->input,
         fmt::format("{}", fmt::join(this->gvt.fragment_shape(), "-"))
     );
 
     const auto& ids = this->input.ids;
 
     for (const auto& single : ids)
-        this->add_fragment(fmt::format("{}.f32", fmt::join(single.id, "-")));
+        this->add_fragment(single.id);
 
     /*
      * The curtain call uses an auxillary table to figure out where to write
@@ -196,9 +702,17 @@ void curtain::init(const char* msg, int len) {
 
     const auto ntraces = this->traceindex.back();
     this->output.traces.resize(ntraces);
+    this->enc = one::parse_encoding(this->input.format);
+    this->output.format = one::to_string(this->enc);
+    this->attr = one::parse_attribute(this->input.attribute);
+
+    const auto nz = int(this->gvt.cube_shape()[2]);
+    this->zbegin  = this->input.zbegin;
+    this->zend    = std::min(this->input.zend, nz);
+    this->cropped = this->zbegin > 0 or this->zend < nz;
 }
 
-void curtain::add(int key, const char* chunk, int len) {
+void curtain::do_add(int key, const char* chunk, int len) {
     const auto& id = this->input.ids[key];
     assert(
            this->traceindex[key] + int(id.coordinates.size())
@@ -209,6 +723,16 @@ void curtain::add(int key, const char* chunk, int len) {
     auto out = this->output.traces.begin() + this->traceindex[key];
     const auto fid = id3(id.id);
     const auto zheight = this->gvt.fragment_shape()[2];
+    const auto nz      = this->gvt.cube_shape()[2];
+    const auto window  = this->input.attribute_window;
+
+    /*
+     * Traces are cropped to the z-range, and placed relative to zbegin in the
+     * output. Attributes are planned with the z-range on whole windows.
+     */
+    const auto z0 = int(fid[2] * zheight);
+    const auto lo = std::max(z0, this->zbegin) - z0;
+    const auto hi = std::min(z0 + int(zheight), this->zend) - z0;
 
     for (const auto& coord : id.coordinates) {
         const auto fp = one::FP< 3 > {
@@ -219,13 +743,724 @@ void curtain::add(int key, const char* chunk, int len) {
         const auto global = this->gvt.to_global(fid, fp);
         out->coordinates.assign(global.begin(), global.end());
         const auto off = this->gvt.fragment_shape().to_offset(fp);
-        out->v.assign(fchunk + off, fchunk + off + zheight);
+        const auto* trace = fchunk + off;
+
+        if (this->cropped) {
+            out->coordinates[2] = z0 + lo - this->zbegin;
+            trace += lo;
+        }
+
+        if (this->attr == one::attribute::none and this->cropped) {
+            out->v.assign(trace, trace + (hi - lo));
+        } else if (this->attr == one::attribute::none) {
+            out->v.assign(trace, trace + zheight);
+        } else if (this->cropped) {
+            out->v.assign((hi - lo + window - 1) / window, 0);
+            one::reduce(this->attr, trace, hi - lo, window, out->v.data());
+            out->coordinates[2] /= window;
+        } else {
+            /* the padding below the cube is not part of the attribute */
+            const auto valid = std::min(zheight, nz - global[2]);
+            out->v.assign(zheight / window, 0);
+            one::reduce(this->attr, trace, valid, window, out->v.data());
+            out->coordinates[2] /= window;
+        }
+        encode_inplace(this->enc, *out);
         ++out;
     }
 }
 
-std::string curtain::pack() {
+std::string curtain::do_pack() {
+    return this->output.pack();
+}
+
+void horizon::do_init(const char* msg, int len) {
+    this->clear();
+    this->input.unpack(msg, msg + len);
+    this->gvt = gvt3(this->input);
+    this->set_fragment_shape(
+        this->input,
+        fmt::format("{}", fmt::join(this->gvt.fragment_shape(), "-"))
+    );
+
+    const auto& columns = this->input.ids;
+    this->keys.clear();
+    this->pointindex.assign(1, 0);
+    this->output.index.clear();
+    for (int i = 0; i < int(columns.size()); ++i) {
+        const auto& column = columns[i];
+        for (const auto k : column.ks) {
+            const auto id = std::vector< int > { column.id[0], column.id[1], k };
+            this->add_fragment(id);
+            this->keys.push_back({ i, k });
+        }
+
+        for (const auto& point : column.points)
+            this->output.index.push_back(point[0]);
+        this->pointindex.push_back(this->output.index.size());
+    }
+
+    /*
+     * Like the curtain, every add() writes to a different part of the output,
+     * which is allocated up front. Fragments only cover a part of the window
+     * of a point, and samples of the window outside the cube are left as 0.
+     */
+    this->output.window = 2 * this->input.window + 1;
+    this->output.v.assign(this->output.index.size() * this->output.window, 0);
+    this->enc = one::parse_encoding(this->input.format);
+    this->output.format = one::to_string(this->enc);
+    this->attr = one::parse_attribute(this->input.attribute);
+}
+
+void horizon::do_add(int key, const char* chunk, int len) {
+    const auto column = this->keys[key][0];
+    const auto fk     = this->keys[key][1];
+    const auto& points = this->input.ids[column].points;
+
+    const auto* fchunk = reinterpret_cast< const float* >(chunk);
+    const auto& fs = this->gvt.fragment_shape();
+    const auto zheight = int(fs[2]);
+    const auto nz = int(this->gvt.cube_shape()[2]);
+    const auto zfst = fk * zheight;
+    const auto zlst = std::min(zfst + zheight, nz);
+
+    const auto window = this->output.window;
+    const auto above  = this->input.window;
+    auto out = this->output.v.begin() + this->pointindex[column] * window;
+
+    for (const auto& point : points) {
+        const auto fp = one::FP< 3 > {
+            std::size_t(point[1]),
+            std::size_t(point[2]),
+            std::size_t(0),
+        };
+        const auto* trace = fchunk + fs.to_offset(fp);
+
+        /* clip the window to the samples in this fragment */
+        const auto fst = std::max(point[3] - above, zfst);
+        const auto lst = std::min(point[3] - above + window, zlst);
+        for (auto z = fst; z < lst; ++z)
+            out[z - (point[3] - above)] = trace[z - zfst];
+        out += window;
+    }
+}
+
+/*
+ * Reduce the window of every point to the attribute. The window is clipped to
+ * the cube, so that the samples above and below the cube, which are 0, do not
+ * contribute.
+ */
+void horizon::reduce_windows() {
+    const auto window = this->output.window;
+    const auto above  = this->input.window;
+    const auto nz     = int(this->gvt.cube_shape()[2]);
+
+    auto& v = this->output.v;
+    auto out = v.begin();
+    auto src = v.begin();
+    for (const auto& column : this->input.ids) {
+        for (const auto& point : column.points) {
+            const auto fst = std::max(0, above - point[3]);
+            const auto lst = std::min(window, nz - point[3] + above);
+            one::reduce(this->attr, &*src + fst, lst - fst, lst - fst, &*out);
+            src += window;
+            ++out;
+        }
+    }
+
+    v.erase(out, v.end());
+    this->output.window = 1;
+}
+
+std::string horizon::do_pack() {
+    /*
+     * Unlike slices and curtains, the samples of a point are written by
+     * several add()s, so the output is encoded once it is complete.
+     */
+    if (this->attr != one::attribute::none and this->output.window > 1)
+        this->reduce_windows();
+    if (this->output.encoded.empty())
+        encode_inplace(this->enc, this->output);
+    return this->output.pack();
+}
+
+void wellpath::do_init(const char* msg, int len) {
+    this->clear();
+    this->input.unpack(msg, msg + len);
+    this->gvt = gvt3(this->input);
+    this->set_fragment_shape(
+        this->input,
+        fmt::format("{}", fmt::join(this->gvt.fragment_shape(), "-"))
+    );
+
+    const auto& ids = this->input.ids;
+    for (const auto& id : ids)
+        this->add_fragment(id);
+
+    const auto& points = this->input.points;
+    const auto npoints = points.size();
+    const auto& cs = this->gvt.cube_shape();
+    const auto& fs = this->gvt.fragment_shape();
+
+    /*
+     * Absent fragments are not planned, and their corners keep the fill
+     * value
+     */
+    const auto mask = one::fragment_mask(this->input);
+    this->gathers.assign(ids.size(), {});
+    this->corners.assign(8 * npoints, this->input.fill_value);
+    for (auto& w : this->weights)
+        w.resize(npoints);
+
+    for (std::size_t p = 0; p < npoints; ++p) {
+        const auto x = one::interpolation_cell(points[p][0], cs[0]);
+        const auto y = one::interpolation_cell(points[p][1], cs[1]);
+        const auto z = one::interpolation_cell(points[p][2], cs[2]);
+        this->weights[0][p] = x.weight;
+        this->weights[1][p] = y.weight;
+        this->weights[2][p] = z.weight;
+
+        /*
+         * The corners are numbered by the bits (i, j, k), so corner 0 is
+         * (lower, lower, lower) and corner 7 is (upper, upper, upper)
+         */
+        std::size_t corner = 0;
+        for (const auto i : { x.lower, x.upper })
+        for (const auto j : { y.lower, y.upper })
+        for (const auto k : { z.lower, z.upper }) {
+            const auto cp  = one::CP< 3 > { i, j, k };
+            const auto fid = this->gvt.frag_id(cp);
+            const auto id  = std::vector< int > {
+                int(fid[0]), int(fid[1]), int(fid[2])
+            };
+            const auto itr = std::lower_bound(ids.begin(), ids.end(), id);
+            if (itr == ids.end() or *itr != id) {
+                if (not mask.stored(id[0], id[1])) {
+                    ++corner;
+                    continue;
+                }
+                const auto msg = "fragment {} of point {} not in task";
+                throw std::logic_error(fmt::format(
+                    msg,
+                    fmt::join(id, "-"),
+                    this->input.index[p]
+                ));
+            }
+
+            const auto key = std::distance(ids.begin(), itr);
+            const auto off = fs.to_offset(this->gvt.to_local(cp));
+            this->gathers[key].push_back({ corner * npoints + p, off });
+            ++corner;
+        }
+    }
+
+    this->output.index = this->input.index;
+    this->enc = one::parse_encoding(this->input.format);
+    this->output.format = one::to_string(this->enc);
+}
+
+void wellpath::do_add(int key, const char* chunk, int len) {
+    const auto* fchunk = reinterpret_cast< const float* >(chunk);
+    for (const auto& gather : this->gathers[key])
+        this->corners[gather[0]] = fchunk[gather[1]];
+}
+
+std::string wellpath::do_pack() {
+    /*
+     * Interpolate all points at once, one axis at a time. The corners and
+     * weights are laid out as one array per corner and axis, so every step is
+     * a plain loop over contiguous arrays, which the compiler vectorises.
+     * Doing all axes in a single loop reads too many arrays for the compiler
+     * to prove they do not alias.
+     *
+     * The corners are interpolated in-place, as do_init() gathers them anew
+     * for every task.
+     */
+    const auto n = this->input.points.size();
+    auto* c = this->corners.data();
+    const auto corner = [c, n](int i) { return c + i * n; };
+    const auto* wx = this->weights[0].data();
+    const auto* wy = this->weights[1].data();
+    const auto* wz = this->weights[2].data();
+
+    lerp_inplace(corner(0), corner(1), wz, n);
+    lerp_inplace(corner(2), corner(3), wz, n);
+    lerp_inplace(corner(4), corner(5), wz, n);
+    lerp_inplace(corner(6), corner(7), wz, n);
+    lerp_inplace(corner(0), corner(2), wy, n);
+    lerp_inplace(corner(4), corner(6), wy, n);
+    lerp_inplace(corner(0), corner(4), wx, n);
+    this->output.v.assign(corner(0), corner(0) + n);
+
+    this->output.encoded.clear();
+    encode_inplace(this->enc, this->output);
+    return this->output.pack();
+}
+
+void polyline::do_init(const char* msg, int len) {
+    this->clear();
+    this->input.unpack(msg, msg + len);
+    this->gvt = gvt3(this->input);
+    this->set_fragment_shape(
+        this->input,
+        fmt::format("{}", fmt::join(this->gvt.fragment_shape(), "-"))
+    );
+
+    const auto& ids = this->input.ids;
+    for (const auto& id : ids)
+        this->add_fragment(id);
+
+    const auto& points = this->input.points;
+    const auto npoints = points.size();
+    const auto& cs = this->gvt.cube_shape();
+    const auto& fs = this->gvt.fragment_shape();
+    const auto nz      = cs[2];
+    const auto zheight = fs[2];
+
+    /*
+     * Absent fragments are not planned, and their traces keep the fill value,
+     * like for well paths
+     */
+    const auto mask = one::fragment_mask(this->input);
+    this->gathers.assign(ids.size(), {});
+    this->corners.assign(4 * npoints * nz, this->input.fill_value);
+    for (auto& w : this->weights)
+        w.resize(npoints);
+
+    for (std::size_t p = 0; p < npoints; ++p) {
+        const auto x = one::interpolation_cell(points[p][0], cs[0]);
+        const auto y = one::interpolation_cell(points[p][1], cs[1]);
+        this->weights[0][p] = x.weight;
+        this->weights[1][p] = y.weight;
+
+        /*
+         * The corners are numbered by the bits (i, j), so corner 0 is the
+         * trace (lower, lower) and corner 3 is (upper, upper)
+         */
+        std::size_t corner = 0;
+        for (const auto i : { x.lower, x.upper })
+        for (const auto j : { y.lower, y.upper }) {
+            for (std::size_t z = 0; z < nz; z += zheight) {
+                const auto cp  = one::CP< 3 > { i, j, z };
+                const auto fid = this->gvt.frag_id(cp);
+                const auto id  = std::vector< int > {
+                    int(fid[0]), int(fid[1]), int(fid[2])
+                };
+                const auto itr = std::lower_bound(ids.begin(), ids.end(), id);
+                if (itr == ids.end() or *itr != id) {
+                    if (not mask.stored(id[0], id[1]))
+                        continue;
+                    const auto msg = "fragment {} of point {} not in task";
+                    throw std::logic_error(fmt::format(
+                        msg,
+                        fmt::join(id, "-"),
+                        this->input.index[p]
+                    ));
+                }
+
+                const auto key = std::distance(ids.begin(), itr);
+                const auto off = fs.to_offset(this->gvt.to_local(cp));
+                const auto pos = (corner * npoints + p) * nz + z;
+                const auto samples = std::min(zheight, nz - z);
+                this->gathers[key].push_back({ pos, off, samples });
+            }
+            ++corner;
+        }
+    }
+
+    this->output.index = this->input.index;
+    this->output.points.clear();
+    for (const auto& point : points)
+        this->output.points.push_back({ float(point[0]), float(point[1]) });
+    this->enc = one::parse_encoding(this->input.format);
+    this->output.format = one::to_string(this->enc);
+    this->attr = one::parse_attribute(this->input.attribute);
+}
+
+void polyline::do_add(int key, const char* chunk, int len) {
+    const auto* fchunk = reinterpret_cast< const float* >(chunk);
+    for (const auto& gather : this->gathers[key]) {
+        const auto* trace = fchunk + gather[1];
+        std::copy(trace, trace + gather[2], this->corners.data() + gather[0]);
+    }
+}
+
+std::string polyline::do_pack() {
+    /*
+     * Interpolate one trace at a time, first along y and then along x. Every
+     * step is a plain loop over the samples of a trace, with the same weight
+     * for the whole trace. The corners are interpolated in-place, like for
+     * well paths.
+     */
+    const auto n  = this->input.points.size();
+    const auto nz = this->gvt.cube_shape()[2];
+    auto* c = this->corners.data();
+    const auto trace = [c, n, nz](int corner, std::size_t p) {
+        return c + (corner * n + p) * nz;
+    };
+    const auto& wx = this->weights[0];
+    const auto& wy = this->weights[1];
+
+    for (std::size_t p = 0; p < n; ++p) {
+        lerp_inplace(trace(0, p), trace(1, p), wy[p], nz);
+        lerp_inplace(trace(2, p), trace(3, p), wy[p], nz);
+        lerp_inplace(trace(0, p), trace(2, p), wx[p], nz);
+    }
+
+    if (this->attr == one::attribute::none) {
+        this->output.samples = nz;
+        this->output.v.assign(trace(0, 0), trace(0, 0) + n * nz);
+    } else {
+        const auto window  = this->input.attribute_window;
+        const auto samples = (nz + window - 1) / window;
+        this->output.samples = samples;
+        this->output.v.assign(n * samples, 0);
+        for (std::size_t p = 0; p < n; ++p) {
+            one::reduce(
+                this->attr,
+                trace(0, p),
+                nz,
+                window,
+                this->output.v.data() + p * samples
+            );
+        }
+    }
+
+    this->output.encoded.clear();
+    encode_inplace(this->enc, this->output);
+    return this->output.pack();
+}
+
+void points::do_init(const char* msg, int len) {
+    this->clear();
+    this->input.unpack(msg, msg + len);
+    const auto gvt = gvt3(this->input);
+    this->set_fragment_shape(
+        this->input,
+        fmt::format("{}", fmt::join(gvt.fragment_shape(), "-"))
+    );
+
+    this->pointindex.assign(1, 0);
+    this->output.index.clear();
+    for (const auto& fragment : this->input.ids) {
+        this->add_fragment(fragment.id);
+        auto& index = this->output.index;
+        index.insert(index.end(), fragment.index.begin(), fragment.index.end());
+        this->pointindex.push_back(index.size());
+    }
+
+    this->output.v.assign(this->output.index.size(), 0);
+    this->output.encoded.clear();
+    this->enc = one::parse_encoding(this->input.format);
+    this->output.format = one::to_string(this->enc);
+}
+
+void points::do_add(int key, const char* chunk, int len) {
+    const auto* fchunk = reinterpret_cast< const float* >(chunk);
+    const auto& offsets = this->input.ids[key].offsets;
+    auto* out = this->output.v.data() + this->pointindex[key];
+    for (std::size_t i = 0; i < offsets.size(); ++i)
+        out[i] = fchunk[offsets[i]];
+}
+
+std::string points::do_pack() {
+    if (this->output.encoded.empty())
+        encode_inplace(this->enc, this->output);
     return this->output.pack();
 }
 
+void area::do_init(const char* msg, int len) {
+    this->clear();
+    this->input.unpack(msg, msg + len);
+    this->gvt = gvt3(this->input);
+    this->set_fragment_shape(
+        this->input,
+        fmt::format("{}", fmt::join(this->gvt.fragment_shape(), "-"))
+    );
+
+    /*
+     * The traces of a column are the set bits of its mask, in bit order, i.e.
+     * row-major in the column. They are written to the output in that order,
+     * with the (dim0, dim1) of every trace.
+     */
+    const auto& fs = this->gvt.fragment_shape();
+    const auto& columns = this->input.ids;
+    this->keys.clear();
+    this->traceindex.assign(1, 0);
+    this->output.dim0s.clear();
+    this->output.dim1s.clear();
+    for (int i = 0; i < int(columns.size()); ++i) {
+        const auto& column = columns[i];
+        for (const auto k : column.ks) {
+            const auto id = std::vector< int > { column.id[0], column.id[1], k };
+            this->add_fragment(id);
+            this->keys.push_back({ i, k });
+        }
+
+        for (std::size_t w = 0; w < column.mask.size(); ++w) {
+            auto word = column.mask[w];
+            while (word) {
+                const auto bit = int(w * 64) + __builtin_ctzll(word);
+                word &= word - 1;
+                this->output.dim0s.push_back(column.id[0] * fs[0] + bit / fs[1]);
+                this->output.dim1s.push_back(column.id[1] * fs[1] + bit % fs[1]);
+            }
+        }
+        this->traceindex.push_back(this->output.dim0s.size());
+    }
+
+    this->output.samples = this->input.zend - this->input.zbegin;
+    this->output.v.assign(this->output.dim0s.size() * this->output.samples, 0);
+    this->output.encoded.clear();
+    this->enc = one::parse_encoding(this->input.format);
+    this->output.format = one::to_string(this->enc);
+}
+
+void area::do_add(int key, const char* chunk, int len) {
+    const auto column = this->keys[key][0];
+    const auto fk     = this->keys[key][1];
+    const auto& mask  = this->input.ids[column].mask;
+
+    const auto* fchunk = reinterpret_cast< const float* >(chunk);
+    const auto zheight = int(this->gvt.fragment_shape()[2]);
+    const auto zbegin  = this->input.zbegin;
+    const auto samples = this->output.samples;
+
+    /* the samples of this fragment that are in [zbegin, zend) */
+    const auto lo = std::max(fk * zheight, zbegin);
+    const auto hi = std::min((fk + 1) * zheight, this->input.zend);
+    if (lo >= hi)
+        return;
+
+    auto t = this->traceindex[column];
+    for (std::size_t w = 0; w < mask.size(); ++w) {
+        auto word = mask[w];
+        while (word) {
+            const auto bit = int(w * 64) + __builtin_ctzll(word);
+            word &= word - 1;
+            std::copy(
+                fchunk + bit * zheight + (lo - fk * zheight),
+                fchunk + bit * zheight + (hi - fk * zheight),
+                this->output.v.begin() + t * samples + (lo - zbegin)
+            );
+            ++t;
+        }
+    }
+}
+
+std::string area::do_pack() {
+    if (this->output.encoded.empty())
+        encode_inplace(this->enc, this->output);
+    return this->output.pack();
+}
+
+void summary::do_init(const char* msg, int len) {
+    this->clear();
+    this->input.unpack(msg, msg + len);
+    this->output = one::stats_values();
+    this->gvt = gvt3(this->input);
+
+    this->set_fragment_shape(
+        this->input,
+        fmt::format("{}", fmt::join(this->gvt.fragment_shape(), "-"))
+    );
+    this->add_fragment("stats.bin");
+}
+
+namespace {
+
+struct fragment_stats {
+    float         min;
+    float         max;
+    float         mean;
+    float         rms;
+    std::uint32_t count;
+};
+
+}
+
+void summary::do_add(int, const char* chunk, int len) {
+    const auto bins = std::size_t(this->input.sidecar_bins);
+    const auto record = 4 * sizeof(float) + (1 + bins) * sizeof(std::uint32_t);
+    const auto nfragments = this->gvt.fragment_count(dimension< 3 >(0))
+                          * this->gvt.fragment_count(dimension< 3 >(1))
+                          * this->gvt.fragment_count(dimension< 3 >(2))
+                          ;
+    if (std::size_t(len) != nfragments * record) {
+        const auto msg = "expected stats sidecar of {} fragments ({} bytes), "
+                         "was {} bytes";
+        throw std::invalid_argument(
+            fmt::format(msg, nfragments, nfragments * record, len)
+        );
+    }
+
+    const auto ncols = this->gvt.fragment_count(dimension< 3 >(1));
+    const auto nk    = this->gvt.fragment_count(dimension< 3 >(2));
+    const auto in_layer = [this, ncols, nk](std::size_t n) {
+        const int id[] = {
+            int(n / (ncols * nk)),
+            int(n / nk % ncols),
+            int(n % nk),
+        };
+        return this->input.dim == -1
+            or id[this->input.dim] == this->input.layer
+            ;
+    };
+
+    /*
+     * The stats are merged in two passes, since the edges of the output
+     * histogram are only known after the min and max of all the fragments
+     */
+    std::vector< fragment_stats > fragments;
+    std::vector< std::size_t >    offsets;
+    double sum   = 0;
+    double sumsq = 0;
+    auto& out = this->output;
+    for (std::size_t n = 0; n < nfragments; ++n) {
+        if (not in_layer(n))
+            continue;
+
+        fragment_stats st;
+        std::memcpy(&st, chunk + n * record, 4 * sizeof(float));
+        std::memcpy(
+            &st.count,
+            chunk + n * record + 4 * sizeof(float),
+            sizeof(std::uint32_t)
+        );
+        if (st.count == 0)
+            continue;
+
+        out.min = out.count == 0 ? st.min : std::min(out.min, st.min);
+        out.max = out.count == 0 ? st.max : std::max(out.max, st.max);
+        out.count += st.count;
+        sum   += double(st.count) * st.mean;
+        sumsq += double(st.count) * st.rms * st.rms;
+        fragments.push_back(st);
+        offsets.push_back(
+            n * record + 4 * sizeof(float) + sizeof(std::uint32_t)
+        );
+    }
+
+    const auto nbins = std::size_t(this->input.bins);
+    out.edges.resize(nbins + 1);
+    for (std::size_t i = 0; i <= nbins; ++i)
+        out.edges[i] = out.min + (out.max - out.min) * (double(i) / nbins);
+    out.counts.assign(nbins, 0);
+    if (out.count == 0)
+        return;
+
+    out.mean = sum / out.count;
+    out.rms  = std::sqrt(sumsq / out.count);
+
+    /*
+     * Spread the count of every fragment bin evenly across the output bins
+     * it overlaps
+     */
+    const double width = (double(out.max) - out.min) / nbins;
+    const auto bin_of = [&out, width, nbins](double x) {
+        if (width == 0) return std::size_t(0);
+        const auto i = std::size_t(std::max(0.0, (x - out.min) / width));
+        return std::min(i, nbins - 1);
+    };
+
+    std::vector< double > counts(nbins, 0.0);
+    for (std::size_t f = 0; f < fragments.size(); ++f) {
+        const auto& st = fragments[f];
+        const double step = (double(st.max) - st.min) / bins;
+        for (std::size_t b = 0; b < bins; ++b) {
+            std::uint32_t c;
+            std::memcpy(
+                &c,
+                chunk + offsets[f] + b * sizeof(std::uint32_t),
+                sizeof(std::uint32_t)
+            );
+            if (c == 0)
+                continue;
+
+            const double lo = st.min + step * b;
+            const double hi = st.min + step * (b + 1);
+            const auto first = bin_of(lo);
+            const auto last  = bin_of(hi);
+            if (first == last or hi <= lo) {
+                counts[first] += c;
+                continue;
+            }
+
+            for (auto i = first; i <= last; ++i) {
+                const double l = std::max(lo, out.min + width * i);
+                const double h = std::min(hi, out.min + width * (i + 1));
+                if (h > l)
+                    counts[i] += c * (h - l) / (hi - lo);
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < nbins; ++i)
+        out.counts[i] = std::llround(counts[i]);
+}
+
+std::string summary::do_pack() {
+    return this->output.pack();
+}
+
+void batch::do_init(const char* msg, int len) {
+    this->clear();
+    this->input.unpack(msg, msg + len);
+
+    this->procs.clear();
+    this->readers.clear();
+    std::map< std::string, int > keys;
+    for (const auto& query : this->input.queries) {
+        auto p = proc::make(query.function);
+        if (!p) {
+            const auto what = "no process for batched function {}";
+            throw one::bad_message(fmt::format(what, query.function));
+        }
+        p->init(query.fetch.data(), query.fetch.size());
+
+        /*
+         * The fragments of a proc are already prefixed, so they are
+         * registered as-is, with the (empty) prefix set by clear()
+         */
+        const auto& fragments = p->fragments();
+        const auto pi = int(this->procs.size());
+        int key = 0;
+        std::size_t fst = 0;
+        while (fst < fragments.size()) {
+            auto lst = fragments.find(';', fst);
+            if (lst == std::string::npos)
+                lst = fragments.size();
+
+            const auto id = fragments.substr(fst, lst - fst);
+            const auto itr = keys.emplace(id, int(keys.size()));
+            if (itr.second) {
+                this->add_fragment(id);
+                this->readers.emplace_back();
+            }
+            this->readers[itr.first->second].push_back({ pi, key });
+            key += 1;
+            fst = lst + 1;
+        }
+
+        this->procs.push_back(std::move(p));
+    }
+}
+
+void batch::do_add(int key, const char* chunk, int len) {
+    for (const auto& reader : this->readers.at(key))
+        this->procs[reader[0]]->add(reader[1], chunk, len);
+}
+
+std::string batch::do_pack() {
+    one::batch_results output;
+    for (std::size_t i = 0; i < this->procs.size(); ++i) {
+        one::batch_result result;
+        result.pid  = this->input.queries[i].pid;
+        result.part = this->input.queries[i].part;
+        result.body = this->procs[i]->pack();
+        output.results.push_back(std::move(result));
+    }
+    return output.pack();
+}
+
 }
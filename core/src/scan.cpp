@@ -0,0 +1,412 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include <oneseismic/digest.hpp>
+#include <oneseismic/ingest.hpp>
+#include <oneseismic/scan.hpp>
+
+namespace one {
+
+namespace {
+
+/*
+ * The sha1 of the sha1s of the blocks of the file, with the blocks hashed in
+ * parallel. The block size is fixed, so that the digest does not depend on
+ * the number of threads.
+ */
+std::string sha1_tree(const char* data, std::size_t len, int threads)
+noexcept (false) {
+    const std::size_t blocksize = 64 * 1024 * 1024;
+    const auto nblocks = std::max(
+        std::size_t(1),
+        (len + blocksize - 1) / blocksize
+    );
+    std::vector< sha1_state::digest > digests(nblocks);
+
+    std::vector< std::future< void > > workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.push_back(std::async(std::launch::async, [&, t] {
+            for (std::size_t i = t; i < nblocks; i += threads) {
+                const auto begin = std::min(len, i * blocksize);
+                const auto end   = std::min(len, begin + blocksize);
+                digests[i] = sha1_digest(data + begin, end - begin);
+            }
+        }));
+    }
+    for (auto& worker : workers)
+        worker.get();
+
+    sha1_state state;
+    for (const auto& d : digests)
+        state.update(reinterpret_cast< const char* >(d.data()), d.size());
+    return hex(state.finish());
+}
+
+std::int32_t read_int(const char* p, int size, bool big_endian)
+noexcept (true) {
+    const auto* u = reinterpret_cast< const unsigned char* >(p);
+    std::uint32_t x = 0;
+    for (int i = 0; i < size; ++i) {
+        const auto byte = big_endian ? u[i] : u[size - 1 - i];
+        x = (x << 8) | byte;
+    }
+    if (size == 2)
+        return std::int16_t(x);
+    return std::int32_t(x);
+}
+
+/*
+ * Byte offsets (0-based) of the binary header fields in the file, and the
+ * trace header fields in the trace header, see segyio.su
+ */
+const std::size_t binary_interval = 3216;
+const std::size_t binary_samples  = 3220;
+const std::size_t binary_format   = 3224;
+const std::size_t binary_exth     = 3504;
+const std::size_t trace_scalco    = 70;
+const std::size_t trace_cdpx      = 180;
+const std::size_t trace_cdpy      = 184;
+const std::size_t trace_samples   = 114;
+const std::size_t trace_interval  = 116;
+const std::size_t header_size     = 240;
+
+struct origin {
+    std::int32_t key1;
+    std::int32_t key2;
+    double x;
+    double y;
+};
+
+/*
+ * The line numbers and coordinate sums of a chunk of traces
+ */
+struct partial {
+    std::unordered_set< std::int32_t > key1s;
+    std::unordered_set< std::int32_t > key2s;
+    std::unordered_map< std::int32_t, std::size_t > last1s;
+    std::array< double, 12 > sums {};
+};
+
+class headers {
+public:
+    headers(
+        const char* segy,
+        std::size_t first,
+        std::size_t tracelen,
+        const scan_options& opts)
+    : segy(segy), first(first), tracelen(tracelen), opts(opts),
+      size1(header_word_size(opts.primary)),
+      size2(header_word_size(opts.secondary))
+    {}
+
+    const char* header(std::size_t traceno) const noexcept (true) {
+        return this->segy + this->first + traceno * this->tracelen;
+    }
+
+    std::int32_t key1(const char* h) const noexcept (true) {
+        const auto endian = this->opts.big_endian;
+        return read_int(h + this->opts.primary - 1, this->size1, endian);
+    }
+
+    std::int32_t key2(const char* h) const noexcept (true) {
+        const auto endian = this->opts.big_endian;
+        return read_int(h + this->opts.secondary - 1, this->size2, endian);
+    }
+
+    /*
+     * The cdp-x and cdp-y of the trace, with the coordinate scalar applied
+     */
+    std::array< double, 2 > coordinates(const char* h) const noexcept (true) {
+        const auto endian = this->opts.big_endian;
+        const auto scalar = read_int(h + trace_scalco, 2, endian);
+        double x = read_int(h + trace_cdpx, 4, endian);
+        double y = read_int(h + trace_cdpy, 4, endian);
+        if (scalar > 0) {
+            x *= scalar;
+            y *= scalar;
+        } else if (scalar < 0) {
+            x /= -scalar;
+            y /= -scalar;
+        }
+        return { x, y };
+    }
+
+    partial scan(std::size_t begin, std::size_t end, const origin& o) const
+    noexcept (false);
+
+private:
+    const char* segy;
+    std::size_t first;
+    std::size_t tracelen;
+    const scan_options& opts;
+    int size1;
+    int size2;
+};
+
+partial headers::scan(std::size_t begin, std::size_t end, const origin& o)
+const noexcept (false) {
+    partial p;
+    for (std::size_t t = begin; t < end; ++t) {
+        const auto* h = this->header(t);
+        const auto key1 = this->key1(h);
+        const auto key2 = this->key2(h);
+        p.key1s.insert(key1);
+        p.key2s.insert(key2);
+        p.last1s[key1] = t;
+
+        /*
+         * The sums of the least-squares fit of the trace coordinates to the
+         * line numbers, relative to the first trace, like lineset in scan.py
+         */
+        const auto xy = this->coordinates(h);
+        const double k1 = key1 - o.key1;
+        const double k2 = key2 - o.key2;
+        const double dx = xy[0] - o.x;
+        const double dy = xy[1] - o.y;
+        const double terms[] = {
+            1, k1, k2, k1 * k1, k1 * k2, k2 * k2,
+            dx, k1 * dx, k2 * dx,
+            dy, k1 * dy, k2 * dy,
+        };
+        for (std::size_t i = 0; i < p.sums.size(); ++i)
+            p.sums[i] += terms[i];
+    }
+    return p;
+}
+
+/*
+ * Solve the 3x3 system A x = b with gaussian elimination and partial
+ * pivoting. Returns false if A is singular.
+ */
+bool solve(
+        std::array< std::array< double, 4 >, 3 > m,
+        std::array< double, 3 >& x)
+noexcept (true) {
+    for (int col = 0; col < 3; ++col) {
+        int pivot = col;
+        for (int row = col + 1; row < 3; ++row) {
+            if (std::abs(m[row][col]) > std::abs(m[pivot][col]))
+                pivot = row;
+        }
+        if (m[pivot][col] == 0)
+            return false;
+        std::swap(m[col], m[pivot]);
+
+        for (int row = col + 1; row < 3; ++row) {
+            const auto f = m[row][col] / m[col][col];
+            for (int k = col; k < 4; ++k)
+                m[row][k] -= f * m[col][k];
+        }
+    }
+
+    for (int row = 2; row >= 0; --row) {
+        auto acc = m[row][3];
+        for (int k = row + 1; k < 3; ++k)
+            acc -= m[row][k] * x[k];
+        x[row] = acc / m[row][row];
+    }
+    return true;
+}
+
+bool regular(const std::vector< std::int32_t >& keys) noexcept (true) {
+    const auto step = keys[1] - keys[0];
+    for (std::size_t i = 1; i < keys.size(); ++i) {
+        if (keys[i] - keys[i - 1] != step)
+            return false;
+    }
+    return true;
+}
+
+/*
+ * The affine transform from grid to world coordinates, see
+ * lineset.transform() in scan.py, or null if the line numbers are irregular
+ * or the coordinates are not usable.
+ */
+nlohmann::json transform(
+        const std::vector< std::int32_t >& key1s,
+        const std::vector< std::int32_t >& key2s,
+        const std::array< double, 12 >& sums,
+        const origin& o)
+noexcept (false) {
+    if (key1s.size() < 2 or key2s.size() < 2)
+        return nullptr;
+    if (not regular(key1s) or not regular(key2s))
+        return nullptr;
+
+    const auto step1 = key1s[1] - key1s[0];
+    const auto step2 = key2s[1] - key2s[0];
+    const auto n   = sums[0];
+    const auto s1  = sums[1];
+    const auto s2  = sums[2];
+    const auto s11 = sums[3];
+    const auto s12 = sums[4];
+    const auto s22 = sums[5];
+
+    std::array< double, 3 > cx;
+    std::array< double, 3 > cy;
+    const auto ok = solve({{
+        { n,  s1,  s2,  sums[6] },
+        { s1, s11, s12, sums[7] },
+        { s2, s12, s22, sums[8] },
+    }}, cx) and solve({{
+        { n,  s1,  s2,  sums[9]  },
+        { s1, s11, s12, sums[10] },
+        { s2, s12, s22, sums[11] },
+    }}, cy);
+    if (not ok)
+        return nullptr;
+
+    const double o1 = key1s[0] - o.key1;
+    const double o2 = key2s[0] - o.key2;
+    const std::array< double, 6 > t = {
+        o.x + cx[0] + cx[1] * o1 + cx[2] * o2,
+        cx[1] * step1,
+        cx[2] * step2,
+        o.y + cy[0] + cy[1] * o1 + cy[2] * o2,
+        cy[1] * step1,
+        cy[2] * step2,
+    };
+    if (t[1] * t[5] - t[2] * t[4] == 0)
+        return nullptr;
+    return t;
+}
+
+template < typename Set >
+std::vector< std::int32_t > sorted(const Set& xs) noexcept (false) {
+    std::vector< std::int32_t > out(xs.begin(), xs.end());
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+}
+
+std::string sha1(const char* data, std::size_t len) noexcept (true) {
+    return hex(sha1_digest(data, len));
+}
+
+std::string scan(const char* segy, std::size_t len, const scan_options& opts)
+noexcept (false) {
+    if (opts.digest != "sha1" and opts.digest != "sha1-tree") {
+        const auto msg = "unknown digest '{}', expected sha1 or sha1-tree";
+        throw std::invalid_argument(fmt::format(msg, opts.digest));
+    }
+    const auto threads = std::max(1, opts.threads);
+
+    if (len < 3600)
+        throw std::invalid_argument("file too small for the SEG-Y headers");
+
+    const auto endian = opts.big_endian;
+    const auto skip     = read_int(segy + binary_exth, 2, endian);
+    const auto format   = read_int(segy + binary_format, 2, endian);
+    auto samples  = read_int(segy + binary_samples, 2, endian) & 0xFFFF;
+    auto interval = read_int(segy + binary_interval, 2, endian);
+    if (format != 1 and format != 5) {
+        const auto msg = "only IBM float and 4-byte IEEE float supported, "
+                         "was {}";
+        throw std::invalid_argument(fmt::format(msg, format));
+    }
+
+    const auto first = std::size_t(3600 + skip * 3200);
+    if (len < first + header_size)
+        throw std::invalid_argument("file truncated at trace 0");
+
+    /*
+     * The samples and interval are not always set in the binary header, so
+     * fall back to the first trace header
+     */
+    const auto* h0 = segy + first;
+    if (samples == 0)
+        samples = read_int(h0 + trace_samples, 2, endian);
+    if (interval == 0)
+        interval = read_int(h0 + trace_interval, 2, endian);
+
+    const auto tracelen = header_size + std::size_t(samples) * 4;
+    const auto ntraces = (len - first) / tracelen;
+    if ((len - first) % tracelen != 0) {
+        const auto msg = "file truncated at trace {}";
+        throw std::invalid_argument(fmt::format(msg, ntraces));
+    }
+
+    const auto scanner = headers(segy, first, tracelen, opts);
+
+    /*
+     * The digest is of the whole file, and runs alongside the header scan
+     */
+    auto guid = std::async(std::launch::async, [&] {
+        if (opts.digest == "sha1")
+            return sha1(segy, len);
+        return sha1_tree(segy, len, threads);
+    });
+
+    const auto xy0 = scanner.coordinates(h0);
+    const auto o = origin {
+        scanner.key1(h0),
+        scanner.key2(h0),
+        xy0[0],
+        xy0[1],
+    };
+
+    std::vector< std::future< partial > > chunks;
+    const auto chunksize = (ntraces + threads - 1) / threads;
+    for (std::size_t begin = 0; begin < ntraces; begin += chunksize) {
+        const auto end = std::min(ntraces, begin + chunksize);
+        chunks.push_back(std::async(std::launch::async, [&, begin, end] {
+            return scanner.scan(begin, end, o);
+        }));
+    }
+
+    /*
+     * The chunks are merged in file order, so the last trace of a line is the
+     * one of the last chunk it is in
+     */
+    partial all;
+    for (auto& chunk : chunks) {
+        auto p = chunk.get();
+        all.key1s.insert(p.key1s.begin(), p.key1s.end());
+        all.key2s.insert(p.key2s.begin(), p.key2s.end());
+        for (const auto& last : p.last1s)
+            all.last1s[last.first] = last.second;
+        for (std::size_t i = 0; i < all.sums.size(); ++i)
+            all.sums[i] += p.sums[i];
+    }
+
+    const auto key1s = sorted(all.key1s);
+    const auto key2s = sorted(all.key2s);
+    std::vector< int > key3s;
+    for (int i = 0; i < samples; ++i)
+        key3s.push_back(i * interval);
+
+    auto last1s = nlohmann::json::object();
+    for (const auto& last : all.last1s)
+        last1s[std::to_string(last.first)] = last.second;
+
+    nlohmann::json report = {
+        { "byteorder",              endian ? "big" : "little" },
+        { "format",                 format },
+        { "samples",                samples },
+        { "sampleinterval",         interval },
+        { "byteoffset-first-trace", first },
+        { "dimensions",             { key1s, key2s, key3s } },
+        { "key1-last-trace",        last1s },
+        { "key-words",              { opts.primary, opts.secondary } },
+    };
+    const auto t = transform(key1s, key2s, all.sums, o);
+    if (not t.is_null())
+        report["transform"] = t;
+    report["guid"] = guid.get();
+    return report.dump();
+}
+
+}
@@ -0,0 +1,186 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fmt/format.h>
+
+#ifdef HAVE_SYS_MMAN_H
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <oneseismic/plan.hpp>
+#include <oneseismic/source.hpp>
+
+namespace one {
+
+namespace {
+
+std::string join(const std::string& root, const std::string& path) {
+    if (root.empty())
+        return path;
+    if (root.back() == '/')
+        return root + path;
+    return root + "/" + path;
+}
+
+[[noreturn]]
+void throw_errno(int err, const std::string& path) noexcept (false) {
+    if (err == ENOENT)
+        throw one::not_found(fmt::format("{}: no such object", path));
+    throw std::system_error(err, std::generic_category(), path);
+}
+
+std::shared_ptr< std::string > readfile(const std::string& path)
+noexcept (false) {
+    std::unique_ptr< std::FILE, decltype(&std::fclose) > fp(
+        std::fopen(path.c_str(), "rb"),
+        &std::fclose
+    );
+    if (!fp)
+        throw_errno(errno, path);
+
+    auto buffer = std::make_shared< std::string >();
+    char chunk[1 << 16];
+    std::size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), fp.get())) > 0)
+        buffer->append(chunk, n);
+
+    if (std::ferror(fp.get()))
+        throw_errno(errno, path);
+    return buffer;
+}
+
+blob as_blob(std::shared_ptr< std::string > buffer) noexcept (true) {
+    const auto* data = buffer->data();
+    const auto  size = buffer->size();
+    return blob(data, size, std::move(buffer));
+}
+
+}
+
+filesystem_source::filesystem_source(std::string root) :
+    root(std::move(root))
+{}
+
+blob filesystem_source::get(const std::string& path) noexcept (false) {
+    return as_blob(readfile(join(this->root, path)));
+}
+
+mmap_source::mmap_source(std::string root) :
+    root(std::move(root))
+{}
+
+#ifdef HAVE_SYS_MMAN_H
+
+namespace {
+
+struct mapping {
+    void* addr;
+    std::size_t len;
+
+    ~mapping() {
+        if (this->len > 0)
+            munmap(this->addr, this->len);
+    }
+};
+
+}
+
+blob mmap_source::get(const std::string& path) noexcept (false) {
+    std::lock_guard< std::mutex > lock(this->mtx);
+    auto itr = this->maps.find(path);
+    if (itr != this->maps.end())
+        return itr->second;
+
+    const auto fullpath = join(this->root, path);
+    const int fd = open(fullpath.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw_errno(errno, fullpath);
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        const auto err = errno;
+        close(fd);
+        throw_errno(err, fullpath);
+    }
+
+    /*
+     * mmap() of 0 bytes is an error, so empty objects are not mapped at all
+     */
+    auto m = std::make_shared< mapping >();
+    m->addr = nullptr;
+    m->len  = std::size_t(st.st_size);
+    if (m->len > 0) {
+        m->addr = mmap(nullptr, m->len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m->addr == MAP_FAILED) {
+            const auto err = errno;
+            m->len = 0;
+            close(fd);
+            throw_errno(err, fullpath);
+        }
+    }
+    close(fd);
+
+    const auto* data = static_cast< const char* >(m->addr);
+    const auto  size = m->len;
+    auto x = blob(data, size, std::move(m));
+    this->maps.emplace(path, x);
+    return x;
+}
+
+#else
+
+blob mmap_source::get(const std::string&) noexcept (false) {
+    throw std::logic_error("mmap_source: mmap not supported on this platform");
+}
+
+#endif // HAVE_SYS_MMAN_H
+
+memory_source::memory_source(std::string root) :
+    root(std::move(root))
+{}
+
+blob memory_source::get(const std::string& path) noexcept (false) {
+    std::lock_guard< std::mutex > lock(this->mtx);
+    auto itr = this->objects.find(path);
+    if (itr != this->objects.end())
+        return itr->second;
+
+    if (this->root.empty())
+        throw one::not_found(fmt::format("{}: no such object", path));
+
+    auto x = as_blob(readfile(join(this->root, path)));
+    this->objects.emplace(path, x);
+    return x;
+}
+
+void memory_source::put(const std::string& path, std::string bytes)
+noexcept (false) {
+    auto x = as_blob(std::make_shared< std::string >(std::move(bytes)));
+    std::lock_guard< std::mutex > lock(this->mtx);
+    this->objects[path] = std::move(x);
+}
+
+std::unique_ptr< fragment_source >
+make_source(const std::string& kind, const std::string& root) noexcept (false) {
+    if (kind == "filesystem")
+        return std::make_unique< filesystem_source >(root);
+    if (kind == "mmap")
+        return std::make_unique< mmap_source >(root);
+    if (kind == "memory")
+        return std::make_unique< memory_source >(root);
+
+    const auto msg = "unknown source '{}', expected one of "
+                     "filesystem, mmap, memory";
+    throw std::invalid_argument(fmt::format(msg, kind));
+}
+
+}
@@ -0,0 +1,156 @@
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <oneseismic/tracing.hpp>
+
+namespace one {
+namespace tracing {
+
+namespace {
+
+thread_local recorder* current_recorder = nullptr;
+
+/*
+ * Chrome trace pids and tids must be integers, so the oneseismic pid and part
+ * are hashed. The hash must be the same in every process that contributes to
+ * a trace, which rules out std::hash, so this is 32-bit FNV-1a [1].
+ *
+ * [1] http://www.isthe.com/chongo/tech/comp/fnv/index.html
+ */
+std::int64_t fnv1a(const std::string& s) noexcept (true) {
+    std::uint32_t hash = 2166136261u;
+    for (const auto c : s) {
+        hash ^= std::uint8_t(c);
+        hash *= 16777619u;
+    }
+    return std::int64_t(hash & 0x7FFFFFFF);
+}
+
+std::int64_t microseconds(std::chrono::system_clock::time_point t)
+noexcept (true) {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    return duration_cast< microseconds >(t.time_since_epoch()).count();
+}
+
+}
+
+void recorder::record(const event& ev) noexcept (false) {
+    std::lock_guard< std::mutex > lock(this->mtx);
+    this->evs.push_back(ev);
+}
+
+std::vector< event > recorder::events() const noexcept (false) {
+    std::lock_guard< std::mutex > lock(this->mtx);
+    return this->evs;
+}
+
+void recorder::clear() noexcept (true) {
+    std::lock_guard< std::mutex > lock(this->mtx);
+    this->evs.clear();
+}
+
+std::string recorder::chrome_json(
+        const std::string& pid,
+        const std::string& part)
+const noexcept (false) {
+    const auto evs = this->events();
+    auto doc = nlohmann::json::array();
+    if (evs.empty())
+        return doc.dump();
+
+    const auto p = fnv1a(pid);
+    const auto t = fnv1a(part);
+    doc.push_back({
+        { "name", "process_name" },
+        { "ph",   "M" },
+        { "pid",  p },
+        { "tid",  t },
+        { "args", { { "name", pid } } },
+    });
+    doc.push_back({
+        { "name", "thread_name" },
+        { "ph",   "M" },
+        { "pid",  p },
+        { "tid",  t },
+        { "args", { { "name", part } } },
+    });
+
+    for (const auto& ev : evs) {
+        doc.push_back({
+            { "name", ev.name },
+            { "cat",  ev.category },
+            { "ph",   "X" },
+            { "ts",   ev.ts },
+            { "dur",  ev.dur },
+            { "pid",  p },
+            { "tid",  t },
+            { "args", { { "pid", pid }, { "part", part } } },
+        });
+    }
+    return doc.dump();
+}
+
+scope::scope(recorder* rec) noexcept (true) : prev(current_recorder) {
+    current_recorder = rec;
+}
+
+scope::~scope() {
+    current_recorder = this->prev;
+}
+
+recorder* current() noexcept (true) {
+    return current_recorder;
+}
+
+span::span(const char* category, const char* name) noexcept (true) :
+    rec(current_recorder),
+    category(category),
+    name(name)
+{
+    if (!this->rec) return;
+    this->start  = std::chrono::system_clock::now();
+    this->steady = std::chrono::steady_clock::now();
+}
+
+span::~span() {
+    if (!this->rec) return;
+
+    /*
+     * The duration is measured with the steady clock, so that spans never get
+     * negative durations when the system clock is adjusted.
+     */
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    const auto elapsed = std::chrono::steady_clock::now() - this->steady;
+
+    event ev;
+    ev.category = this->category;
+    ev.name     = this->name;
+    ev.ts       = tracing::microseconds(this->start);
+    ev.dur      = duration_cast< microseconds >(elapsed).count();
+
+    try {
+        this->rec->record(ev);
+    } catch (...) {
+        /* losing a span is better than terminating in a destructor */
+    }
+}
+
+std::string merge(const std::vector< std::string >& traces) noexcept (false) {
+    auto doc = nlohmann::json::array();
+    for (const auto& trace : traces) {
+        if (trace.empty()) continue;
+        for (auto& ev : nlohmann::json::parse(trace))
+            doc.push_back(std::move(ev));
+    }
+    return doc.dump();
+}
+
+}
+}
@@ -0,0 +1,88 @@
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch/catch.hpp>
+
+#include <oneseismic/attributes.hpp>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+std::vector< float > reduce(
+        one::attribute attr,
+        const std::vector< float >& xs,
+        std::size_t window) {
+    std::vector< float > out((xs.size() + window - 1) / window);
+    one::reduce(attr, xs.data(), xs.size(), window, out.data());
+    return out;
+}
+
+}
+
+TEST_CASE("attributes can be parsed by name") {
+    CHECK(one::parse_attribute("none")   == one::attribute::none);
+    CHECK(one::parse_attribute("rms")    == one::attribute::rms);
+    CHECK(one::parse_attribute("mean")   == one::attribute::mean);
+    CHECK(one::parse_attribute("maxabs") == one::attribute::maxabs);
+    CHECK(one::parse_attribute("sumpos") == one::attribute::sumpos);
+    CHECK(one::parse_attribute("sumneg") == one::attribute::sumneg);
+    CHECK_THROWS_AS(one::parse_attribute("max"), std::invalid_argument);
+
+    for (const auto* name : { "none", "rms", "mean", "maxabs", "sumpos", "sumneg" })
+        CHECK(one::to_string(one::parse_attribute(name)) == std::string(name));
+}
+
+TEST_CASE("attributes are reduced over windows") {
+    /* 20 samples, so that both the lanes and the remainder are exercised */
+    std::vector< float > xs(20);
+    std::iota(xs.begin(), xs.end(), -10.0f);
+
+    SECTION("mean") {
+        const auto out = reduce(one::attribute::mean, xs, 10);
+        CHECK_THAT(out, Equals(std::vector< float >{ -5.5f, 4.5f }));
+    }
+
+    SECTION("rms") {
+        const auto out = reduce(one::attribute::rms, xs, 20);
+        double squares = 0;
+        for (const auto x : xs) squares += x * x;
+        REQUIRE(out.size() == 1);
+        CHECK(out[0] == Catch::Detail::Approx(std::sqrt(squares / 20)));
+    }
+
+    SECTION("maxabs") {
+        const auto out = reduce(one::attribute::maxabs, xs, 10);
+        CHECK_THAT(out, Equals(std::vector< float >{ 10, 9 }));
+    }
+
+    SECTION("sumpos and sumneg") {
+        const auto pos = reduce(one::attribute::sumpos, xs, 20);
+        const auto neg = reduce(one::attribute::sumneg, xs, 20);
+        CHECK_THAT(pos, Equals(std::vector< float >{  45 }));
+        CHECK_THAT(neg, Equals(std::vector< float >{ -55 }));
+    }
+
+    SECTION("the last window can be short") {
+        const auto out = reduce(one::attribute::mean, xs, 8);
+        CHECK_THAT(out, Equals(std::vector< float >{ -6.5f, 1.5f, 7.5f }));
+    }
+}
+
+TEST_CASE("reducing to no attribute fails") {
+    std::vector< float > xs(8, 1);
+    std::vector< float > out(8);
+    const auto none = one::attribute::none;
+    const auto mean = one::attribute::mean;
+    CHECK_THROWS_AS(
+        one::reduce(none, xs.data(), xs.size(), 4, out.data()),
+        std::logic_error
+    );
+    CHECK_THROWS_AS(
+        one::reduce(mean, xs.data(), xs.size(), 0, out.data()),
+        std::invalid_argument
+    );
+}
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <string>
+
+#include <catch/catch.hpp>
+
+#include <oneseismic/digest.hpp>
+
+namespace {
+
+const std::string two_blocks =
+    "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+
+template < typename State >
+std::string incremental(const std::string& msg, std::size_t chunk) {
+    State state;
+    for (std::size_t i = 0; i < msg.size(); i += chunk)
+        state.update(msg.data() + i, std::min(chunk, msg.size() - i));
+    return one::hex(state.finish());
+}
+
+}
+
+TEST_CASE("sha1 matches the FIPS 180 examples") {
+    const auto sha1 = [](const std::string& msg) {
+        return one::hex(one::sha1_digest(msg.data(), msg.size()));
+    };
+
+    CHECK(sha1("") == "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+    CHECK(sha1("abc") == "a9993e364706816aba3e25717850c26c9cd0d89d");
+    CHECK(sha1(two_blocks) == "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+}
+
+TEST_CASE("sha256 matches the FIPS 180 examples") {
+    const auto sha256 = [](const std::string& msg) {
+        return one::hex(one::sha256_digest(msg.data(), msg.size()));
+    };
+
+    CHECK(sha256("") ==
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    CHECK(sha256("abc") ==
+        "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    CHECK(sha256(two_blocks) ==
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+}
+
+TEST_CASE("digests do not depend on how the message is split") {
+    const auto msg = std::string(1000000, 'a');
+
+    SECTION("sha1") {
+        const auto expected = "34aa973cd4c4daa4f61eeb2bdbad27316534016f";
+        CHECK(incremental< one::sha1_state >(msg, msg.size()) == expected);
+        CHECK(incremental< one::sha1_state >(msg, 63) == expected);
+        CHECK(incremental< one::sha1_state >(msg, 1000) == expected);
+    }
+
+    SECTION("sha256") {
+        const auto expected =
+            "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0";
+        CHECK(incremental< one::sha256_state >(msg, msg.size()) == expected);
+        CHECK(incremental< one::sha256_state >(msg, 63) == expected);
+        CHECK(incremental< one::sha256_state >(msg, 1000) == expected);
+    }
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <catch/catch.hpp>
+
+#include <oneseismic/encoding.hpp>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+std::vector< float > roundtrip(
+        one::encoding enc,
+        const std::vector< float >& xs) {
+    std::vector< std::int16_t > encoded(xs.size());
+    float scale;
+    float offset;
+    one::encode(enc, xs.data(), xs.size(), encoded.data(), scale, offset);
+
+    std::vector< float > decoded(xs.size());
+    one::decode(enc, encoded.data(), xs.size(), decoded.data(), scale, offset);
+    return decoded;
+}
+
+}
+
+TEST_CASE("encodings can be parsed by name") {
+    CHECK(one::parse_encoding("f32")  == one::encoding::f32);
+    CHECK(one::parse_encoding("f16")  == one::encoding::f16);
+    CHECK(one::parse_encoding("bf16") == one::encoding::bf16);
+    CHECK(one::parse_encoding("i16")  == one::encoding::i16);
+    CHECK(one::parse_encoding("i8")   == one::encoding::i8);
+    CHECK_THROWS_AS(one::parse_encoding("f64"), std::invalid_argument);
+
+    for (const auto* name : { "f32", "f16", "bf16", "i16", "i8" })
+        CHECK(one::to_string(one::parse_encoding(name)) == std::string(name));
+}
+
+TEST_CASE("f16 round-trips exactly representable values") {
+    const auto xs = std::vector< float > {
+        0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 2048.0f, 65504.0f, -65504.0f,
+        /* smallest f16 subnormal */
+        5.9604645e-08f,
+    };
+    CHECK_THAT(roundtrip(one::encoding::f16, xs), Equals(xs));
+}
+
+TEST_CASE("f16 saturates to inf and keeps nans") {
+    const auto inf = std::numeric_limits< float >::infinity();
+    const auto nan = std::numeric_limits< float >::quiet_NaN();
+    const auto xs = std::vector< float > { 1e6f, -1e6f, inf, nan };
+    const auto ys = roundtrip(one::encoding::f16, xs);
+    CHECK(ys[0] ==  inf);
+    CHECK(ys[1] == -inf);
+    CHECK(ys[2] ==  inf);
+    CHECK(std::isnan(ys[3]));
+}
+
+TEST_CASE("f16 rounds to nearest") {
+    /* 1 + 2^-11 is exactly halfway, and ties to even (1.0) */
+    const auto xs = std::vector< float > { 1.00048828125f, 1.0007f, 3.14159f };
+    const auto ys = roundtrip(one::encoding::f16, xs);
+    CHECK(ys[0] == 1.0f);
+    CHECK(ys[1] == 1.0009765625f);
+    CHECK(ys[2] == Catch::Detail::Approx(3.14159f).epsilon(1e-3));
+}
+
+TEST_CASE("bf16 keeps the range of f32 with 8 bits of precision") {
+    const auto xs = std::vector< float > {
+        1.0f, -2.5f, 1e30f, -1e-30f, 12345.678f,
+    };
+    const auto ys = roundtrip(one::encoding::bf16, xs);
+    for (std::size_t i = 0; i < xs.size(); ++i)
+        CHECK(ys[i] == Catch::Detail::Approx(xs[i]).epsilon(1.0 / 256));
+}
+
+TEST_CASE("integer encodings are within half a quantisation step") {
+    auto xs = GENERATE(take(5, chunk(256, random(-10000.0f, 10000.0f))));
+
+    const auto lo = *std::min_element(xs.begin(), xs.end());
+    const auto hi = *std::max_element(xs.begin(), xs.end());
+
+    SECTION("i16") {
+        const auto ys = roundtrip(one::encoding::i16, xs);
+        const auto step = (hi - lo) / (2 * 32767.0f);
+        for (std::size_t i = 0; i < xs.size(); ++i)
+            CHECK(std::abs(ys[i] - xs[i]) <= step * 0.51f + 1e-3f);
+    }
+
+    SECTION("i8") {
+        const auto ys = roundtrip(one::encoding::i8, xs);
+        const auto step = (hi - lo) / (2 * 127.0f);
+        for (std::size_t i = 0; i < xs.size(); ++i)
+            CHECK(std::abs(ys[i] - xs[i]) <= step * 0.51f);
+    }
+}
+
+TEST_CASE("integer encoding of constant tiles is exact") {
+    const auto xs = std::vector< float >(10, 3.5f);
+    CHECK_THAT(roundtrip(one::encoding::i8,  xs), Equals(xs));
+    CHECK_THAT(roundtrip(one::encoding::i16, xs), Equals(xs));
+}
+
+TEST_CASE("i8 codes fit in a signed byte") {
+    const auto xs = std::vector< float > { -7.0f, 0.0f, 1.0f, 100.0f };
+    std::vector< std::int16_t > encoded(xs.size());
+    float scale, offset;
+    one::encode(
+        one::encoding::i8,
+        xs.data(),
+        xs.size(),
+        encoded.data(),
+        scale,
+        offset
+    );
+
+    for (const auto q : encoded) {
+        CHECK(q >= -127);
+        CHECK(q <=  127);
+    }
+    CHECK(encoded.front() == -127);
+    CHECK(encoded.back()  ==  127);
+}
+
+TEST_CASE("integer encodings keep non-finite samples as nan") {
+    const auto inf = std::numeric_limits< float >::infinity();
+    const auto nan = std::numeric_limits< float >::quiet_NaN();
+    const auto xs = std::vector< float > { nan, -1.0f, inf, 1.0f, -inf };
+
+    for (const auto e : { one::encoding::i16, one::encoding::i8 }) {
+        const auto ys = roundtrip(e, xs);
+        CHECK(std::isnan(ys[0]));
+        CHECK(ys[1] == Catch::Detail::Approx(-1.0f));
+        CHECK(std::isnan(ys[2]));
+        CHECK(ys[3] == Catch::Detail::Approx( 1.0f));
+        CHECK(std::isnan(ys[4]));
+    }
+}
+
+TEST_CASE("integer encoding of tiles without finite samples is all nan") {
+    const auto nan = std::numeric_limits< float >::quiet_NaN();
+    const auto xs = std::vector< float >(4, nan);
+
+    std::vector< std::int16_t > encoded(xs.size());
+    float scale, offset;
+    one::encode(
+        one::encoding::i8,
+        xs.data(),
+        xs.size(),
+        encoded.data(),
+        scale,
+        offset
+    );
+    CHECK(std::isfinite(scale));
+    CHECK(std::isfinite(offset));
+    for (const auto q : encoded)
+        CHECK(q == -128);
+
+    for (const auto y : roundtrip(one::encoding::i16, xs))
+        CHECK(std::isnan(y));
+}
+
+TEST_CASE("integer encodings handle ranges wider than float") {
+    /* hi - lo overflows float */
+    const auto big = std::numeric_limits< float >::max() * 0.75f;
+    const auto xs = std::vector< float > { -big, 0.0f, big };
+
+    const auto ys = roundtrip(one::encoding::i16, xs);
+    CHECK(ys[0] == Catch::Detail::Approx(-big));
+    CHECK(ys[1] == Catch::Detail::Approx(0).margin(big / 32767));
+    CHECK(ys[2] == Catch::Detail::Approx( big));
+}
@@ -1,3 +1,7 @@
+#include <array>
+#include <stdexcept>
+#include <vector>
+
 #include <catch/catch.hpp>
 
 #include <oneseismic/geometry.hpp>
@@ -249,6 +253,40 @@ TEST_CASE("Generate the fragments capturing a time slice") {
     CHECK_THAT(result, Equals(expected));
 }
 
+TEST_CASE("Generate the fragments capturing a region of an inline") {
+    auto cube = one::gvt< 3 > {
+        { 9, 15, 23 },
+        { 3,  9,  5 },
+    };
+    const auto dim = one::dimension< 3 >{0};
+
+    SECTION("inside the region") {
+        const auto result = cube.slice(dim, 4, { 0, 10, 7 }, { 0, 15, 13 }, { 1, 1, 1 });
+        const auto expected = decltype(result) {
+            { 1, 1, 1 },
+            { 1, 1, 2 },
+        };
+        CHECK_THAT(result, Equals(expected));
+    }
+
+    SECTION("without the fragments between the strided samples") {
+        /* samples 0, 12 and 24 (outside) of z, which skips 1 and 3 */
+        const auto result = cube.slice(dim, 4, { 0, 0, 0 }, { 0, 9, 23 }, { 1, 1, 12 });
+        const auto expected = decltype(result) {
+            { 1, 0, 0 },
+            { 1, 0, 2 },
+        };
+        CHECK_THAT(result, Equals(expected));
+    }
+
+    SECTION("and fails on empty regions") {
+        CHECK_THROWS_AS(
+            cube.slice(dim, 4, { 0, 15, 0 }, { 0, 20, 23 }, { 1, 1, 1 }),
+            std::invalid_argument
+        );
+    }
+}
+
 TEST_CASE("Figure out an global offset [0, len(survey)) from a point") {
     const auto cube = one::CS< 3 >(9, 15, 23);
     const auto expected = 2495;
@@ -790,3 +828,50 @@ TEST_CASE("Put a fragment slice into a cube slice (dimension 2)") {
 
     CHECK_THAT(out, Equals(expected));
 }
+
+TEST_CASE("interpolation cells are inside the axis") {
+    const auto mid = one::interpolation_cell(2.25f, 5);
+    CHECK(mid.lower  == 2);
+    CHECK(mid.upper  == 3);
+    CHECK(mid.weight == 0.25f);
+
+    const auto last = one::interpolation_cell(4.0f, 5);
+    CHECK(last.lower  == 3);
+    CHECK(last.upper  == 4);
+    CHECK(last.weight == 1.0f);
+
+    const auto single = one::interpolation_cell(0.0f, 1);
+    CHECK(single.lower == 0);
+    CHECK(single.upper == 0);
+}
+
+TEST_CASE("world coordinates round-trip through the grid") {
+    /* a rotated survey with 12.5m x 25m bins, far from the origin */
+    const auto transform = one::world_transform({
+        456000.0,  10.825317547305483, -12.5,
+        6780000.0,  6.25,               21.650635094610966,
+    });
+
+    const std::vector< double > is = { 0,  1.0, 10.5, 200 };
+    const std::vector< double > js = { 0, 10.0,  0.0, 300 };
+    std::vector< double > xs(4), ys(4);
+    transform.to_world(is.data(), js.data(), 4, xs.data(), ys.data());
+    CHECK(xs[0] == Catch::Detail::Approx(456000.0));
+    CHECK(ys[0] == Catch::Detail::Approx(6780000.0));
+    CHECK(xs[1] == Catch::Detail::Approx(456000.0 + 10.825317547305483 - 125));
+
+    std::vector< double > i(4), j(4);
+    transform.to_grid(xs.data(), ys.data(), 4, i.data(), j.data());
+    for (std::size_t k = 0; k < 4; ++k) {
+        CHECK(i[k] == Catch::Detail::Approx(is[k]).margin(1e-6));
+        CHECK(j[k] == Catch::Detail::Approx(js[k]).margin(1e-6));
+    }
+}
+
+TEST_CASE("singular world transforms are rejected") {
+    const auto zero = std::array< double, 6 > { 0, 0, 0, 0, 0, 0 };
+    CHECK_THROWS_AS(one::world_transform(zero), std::invalid_argument);
+
+    const auto line = std::array< double, 6 > { 0, 1, 2, 0, 2, 4 };
+    CHECK_THROWS_AS(one::world_transform(line), std::invalid_argument);
+}
@@ -0,0 +1,177 @@
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch/catch.hpp>
+
+#include <oneseismic/heatmap.hpp>
+#include <oneseismic/messages.hpp>
+#include <oneseismic/plan.hpp>
+#include <oneseismic/process.hpp>
+
+namespace {
+
+std::uint64_t count_of(
+        const one::heatmap::snapshot& snap,
+        int cube, int i, int j, int k) {
+    for (const auto& e : snap.entries) {
+        if (e.cube == cube and e.i == i and e.j == j and e.k == k)
+            return e.count;
+    }
+    return 0;
+}
+
+/*
+ * Install the recorder for the lifetime of the guard, so that failing tests
+ * do not leave it installed for the tests that follow
+ */
+struct installed {
+    explicit installed(one::heatmap::recorder& rec) {
+        one::heatmap::install(&rec);
+    }
+    ~installed() {
+        one::heatmap::install(nullptr);
+    }
+};
+
+}
+
+TEST_CASE("Accesses are counted per cube and fragment") {
+    one::heatmap::recorder rec(64);
+    const auto a = rec.cube("guid/src/64-64-64");
+    const auto b = rec.cube("guid/lod2/64-64-64");
+    CHECK(a != b);
+    CHECK(rec.cube("guid/src/64-64-64") == a);
+
+    rec.record(a, 0, 1, 2);
+    rec.record(a, 0, 1, 2);
+    rec.record(b, 0, 1, 2);
+    rec.record(a, 3, 4, 5);
+
+    const auto snap = rec.collect();
+    CHECK(snap.cubes.size() == 2);
+    CHECK(snap.entries.size() == 3);
+    CHECK(count_of(snap, a, 0, 1, 2) == 2);
+    CHECK(count_of(snap, b, 0, 1, 2) == 1);
+    CHECK(count_of(snap, a, 3, 4, 5) == 1);
+    CHECK(snap.dropped == 0);
+}
+
+TEST_CASE("Accesses are dropped when the table is full") {
+    one::heatmap::recorder rec(2);
+    const auto cube = rec.cube("guid/src/1-1-1");
+    rec.record(cube, 0, 0, 0);
+    rec.record(cube, 0, 0, 1);
+    rec.record(cube, 0, 0, 2);
+    rec.record(cube, 0, 0, 0);
+    rec.record(cube, -1, 0, 0);
+
+    const auto snap = rec.collect();
+    CHECK(snap.entries.size() == 2);
+    CHECK(snap.dropped == 2);
+}
+
+TEST_CASE("Concurrent accesses are all counted") {
+    one::heatmap::recorder rec(1024);
+    const auto cube = rec.cube("guid/src/64-64-64");
+
+    std::vector< std::thread > threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int n = 0; n < 1000; ++n)
+                rec.record(cube, n % 10, n % 7, 0);
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    std::uint64_t total = 0;
+    for (const auto& e : rec.collect().entries)
+        total += e.count;
+    CHECK(total == 4000);
+    CHECK(rec.collect().entries.size() == 70);
+}
+
+TEST_CASE("Snapshots survive a write-read roundtrip") {
+    one::heatmap::recorder rec(64);
+    const auto a = rec.cube("guid-a/src/64-64-64");
+    const auto b = rec.cube("guid-b/lod4/32-32-32");
+    rec.record(a, 1, 2, 3);
+    rec.record(b, 65535, 0, 7);
+    rec.record(b, 65535, 0, 7);
+
+    std::stringstream ss;
+    rec.write(ss);
+    const auto snap = one::heatmap::read(ss);
+
+    CHECK(snap.cubes == rec.collect().cubes);
+    CHECK(snap.entries.size() == 2);
+    CHECK(count_of(snap, a, 1, 2, 3) == 1);
+    CHECK(count_of(snap, b, 65535, 0, 7) == 2);
+
+    std::stringstream garbage("not a heatmap");
+    CHECK_THROWS_AS(one::heatmap::read(garbage), std::invalid_argument);
+}
+
+TEST_CASE("Planning and proc record fragment accesses when installed") {
+    one::slice_task task;
+    task.pid   = "pid";
+    task.guid  = "guid";
+    task.shape = { 2, 2, 2 };
+    task.shape_cube = { 4, 4, 4 };
+    task.function = "slice";
+    task.manifest = R"({
+        "dimensions": [[1, 2, 3, 4], [1, 2, 3, 4], [0, 4, 8, 12]]
+    })";
+    task.dim    = 0;
+    task.lineno = 1;
+    const auto packed = task.pack();
+
+    one::heatmap::recorder rec(64);
+    {
+        installed guard(rec);
+        const auto sched = one::mkschedule(packed.data(), packed.size(), 10);
+        auto slice = one::proc::make("slice");
+        slice->init(sched[0].data(), sched[0].size());
+    }
+    const auto cube = rec.cube(one::heatmap::cube_key("guid", "2-2-2", 1));
+
+    /* 2x2 fragments, each counted by the planner and by proc */
+    const auto snap = rec.collect();
+    CHECK(snap.entries.size() == 4);
+    CHECK(count_of(snap, cube, 0, 0, 0) == 2);
+    CHECK(count_of(snap, cube, 0, 1, 1) == 2);
+
+    SECTION("Nothing is recorded when uninstalled") {
+        const auto sched = one::mkschedule(packed.data(), packed.size(), 10);
+        CHECK(count_of(rec.collect(), cube, 0, 0, 0) == 2);
+    }
+}
+
+TEST_CASE("Static cache hit rate keeps the most popular fragments") {
+    const std::vector< std::uint64_t > counts = { 10, 1, 5, 4 };
+    CHECK(one::heatmap::static_hit_rate(counts, 0) == 0);
+    CHECK(one::heatmap::static_hit_rate(counts, 1) == Approx(9.0 / 20));
+    CHECK(one::heatmap::static_hit_rate(counts, 2) == Approx(13.0 / 20));
+    CHECK(one::heatmap::static_hit_rate(counts, 4) == Approx(16.0 / 20));
+    CHECK(one::heatmap::static_hit_rate(counts, 100) == Approx(16.0 / 20));
+}
+
+TEST_CASE("LRU hit rate is about bounded by the static hit rate") {
+    std::vector< std::uint64_t > counts;
+    for (int i = 1; i <= 100; ++i)
+        counts.push_back(1000 / i);
+
+    double previous = 0;
+    for (const std::size_t capacity : { 1, 5, 10, 50, 99 }) {
+        const auto lru = one::heatmap::lru_hit_rate(counts, capacity);
+        CHECK(lru > previous);
+        CHECK(lru <= one::heatmap::static_hit_rate(counts, capacity) + 1e-2);
+        previous = lru;
+    }
+    CHECK(one::heatmap::lru_hit_rate(counts, 0) == 0);
+    CHECK(one::heatmap::lru_hit_rate(counts, 100)
+       == Approx(one::heatmap::static_hit_rate(counts, 100)));
+}
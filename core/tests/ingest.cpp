@@ -0,0 +1,374 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <nlohmann/json.hpp>
+
+#include <oneseismic/ingest.hpp>
+
+namespace {
+
+/*
+ * Keep the objects in a map, for comparing the output of ingest() runs
+ */
+struct memory_sink : public one::fragment_sink {
+    void put(const std::string& path, const char* data, std::size_t size)
+    override {
+        std::lock_guard< std::mutex > lock(this->mtx);
+        this->objects[path] = std::string(data, size);
+    }
+
+    std::vector< float > fragment(const std::string& path) const {
+        const auto& obj = this->objects.at(path);
+        std::vector< float > xs(obj.size() / sizeof(float));
+        std::memcpy(xs.data(), obj.data(), obj.size());
+        return xs;
+    }
+
+    std::mutex mtx;
+    std::map< std::string, std::string > objects;
+};
+
+void put_be32(std::string& dst, std::size_t pos, std::uint32_t x) {
+    dst[pos + 0] = char(x >> 24);
+    dst[pos + 1] = char(x >> 16);
+    dst[pos + 2] = char(x >>  8);
+    dst[pos + 3] = char(x >>  0);
+}
+
+float value(int il, int xl, int z) {
+    return il * 100 + xl + z * 0.5f;
+}
+
+const std::vector< int > inlines    = { 1, 2, 3 };
+const std::vector< int > crosslines = { 10, 11, 12, 13 };
+const int samples = 5;
+
+/*
+ * A big endian, IEEE float SEG-Y file with the (inline, crossline) traces,
+ * in that order, and its scan manifest
+ */
+std::pair< std::string, std::string >
+mksegy(const std::vector< std::pair< int, int > >& traces) {
+    std::string segy(3600, '\0');
+    nlohmann::json last;
+    for (std::size_t t = 0; t < traces.size(); ++t) {
+        const auto il = traces[t].first;
+        const auto xl = traces[t].second;
+        std::string trace(240 + samples * 4, '\0');
+        put_be32(trace, 188, il);
+        put_be32(trace, 192, xl);
+        for (int z = 0; z < samples; ++z) {
+            const auto x = value(il, xl, z);
+            std::uint32_t bits;
+            std::memcpy(&bits, &x, sizeof(bits));
+            put_be32(trace, 240 + z * 4, bits);
+        }
+        segy += trace;
+        last[std::to_string(il)] = t;
+    }
+
+    nlohmann::json manifest = {
+        { "guid",                   "guid" },
+        { "format",                 5 },
+        { "byteorder",              "big" },
+        { "samples",                samples },
+        { "byteoffset-first-trace", 3600 },
+        { "key-words",              { 189, 193 } },
+        { "key1-last-trace",        last },
+        { "dimensions", {
+            inlines,
+            crosslines,
+            { 0, 4, 8, 12, 16 },
+        }},
+    };
+    return { segy, manifest.dump() };
+}
+
+std::vector< std::pair< int, int > > inline_sorted() {
+    std::vector< std::pair< int, int > > traces;
+    for (const auto il : inlines)
+        for (const auto xl : crosslines)
+            traces.emplace_back(il, xl);
+    return traces;
+}
+
+std::vector< std::pair< int, int > > crossline_sorted() {
+    std::vector< std::pair< int, int > > traces;
+    for (const auto xl : crosslines)
+        for (const auto il : inlines)
+            traces.emplace_back(il, xl);
+    return traces;
+}
+
+one::ingest_options small_fragments() {
+    one::ingest_options opts;
+    opts.fragment_shape = { 2, 2, 2 };
+    opts.decimations    = { 2 };
+    opts.memory         = 1 << 20;
+    return opts;
+}
+
+}
+
+TEST_CASE("IBM floats are decoded to IEEE floats") {
+    const unsigned char ibm[] = {
+        0xC2, 0x76, 0xA0, 0x00,
+        0x42, 0x64, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,
+        0x41, 0x10, 0x00, 0x00,
+    };
+    const auto* in = reinterpret_cast< const char* >(ibm);
+
+    float out[4];
+    one::decode_samples(out, in, 4, 1, true);
+    CHECK(out[0] == -118.625f);
+    CHECK(out[1] == 100.0f);
+    CHECK(out[2] == 0.0f);
+    CHECK(out[3] == 1.0f);
+}
+
+TEST_CASE("big endian IEEE floats are byte swapped") {
+    const unsigned char ieee[] = {
+        0x3F, 0x80, 0x00, 0x00,
+        0xC0, 0x00, 0x00, 0x00,
+    };
+    const auto* in = reinterpret_cast< const char* >(ieee);
+
+    float out[2];
+    one::decode_samples(out, in, 2, 5, true);
+    CHECK(out[0] ==  1.0f);
+    CHECK(out[1] == -2.0f);
+}
+
+TEST_CASE("unsupported SEG-Y formats are rejected") {
+    const char in[4] = {};
+    float out[1];
+    CHECK_THROWS_AS(
+        one::decode_samples(out, in, 1, 3, true),
+        std::invalid_argument
+    );
+}
+
+TEST_CASE("Traces are scattered into the fragments of all levels") {
+    const auto input = mksegy(inline_sorted());
+    memory_sink sink;
+    one::ingest_stats stats;
+    const auto manifest = one::ingest(
+        input.first.data(),
+        input.first.size(),
+        input.second,
+        sink,
+        small_fragments(),
+        &stats
+    );
+
+    /* 2 * 2 * 3 fragments in src, 1 * 1 * 2 in lod2 */
+    CHECK(stats.traces == 12);
+    CHECK(stats.fragments == 14);
+    CHECK(stats.passes == 1);
+
+    /* (inline 3, crosslines 12 and 13, sample 4), padded below and after */
+    const auto src = sink.fragment("guid/src/2-2-2/1-1-2.f32");
+    CHECK(src == std::vector< float > {
+        value(3, 12, 4), 0, value(3, 13, 4), 0,
+        0, 0, 0, 0,
+    });
+
+    /* every other line and sample, i.e. inline 1, 3 and crossline 10, 12 */
+    const auto lod = sink.fragment("guid/lod2/2-2-2/0-0-1.f32");
+    CHECK(lod == std::vector< float > {
+        value(1, 10, 4), 0, value(1, 12, 4), 0,
+        value(3, 10, 4), 0, value(3, 12, 4), 0,
+    });
+
+    const auto doc = nlohmann::json::parse(manifest);
+    CHECK(doc["decimations"] == nlohmann::json({ 2 }));
+    CHECK(doc["fragment-mask"]["1"] == "0f");
+    CHECK(doc["fragment-mask"]["2"] == "01");
+    CHECK(sink.objects.at("guid/manifest.json") == manifest);
+}
+
+TEST_CASE("Lanes that do not fit the budget are read in another pass") {
+    const auto inline_input = mksegy(inline_sorted());
+    memory_sink inline_sink;
+    one::ingest(
+        inline_input.first.data(),
+        inline_input.first.size(),
+        inline_input.second,
+        inline_sink,
+        small_fragments()
+    );
+
+    /*
+     * A src lane is 2 columns of 3 fragments of 8 floats, and with the
+     * budget of exactly one lane, only one lane is open at the time
+     */
+    auto opts = small_fragments();
+    opts.memory  = 2 * 3 * 8 * sizeof(float);
+    opts.threads = 3;
+
+    const auto crossline_input = mksegy(crossline_sorted());
+    memory_sink crossline_sink;
+    one::ingest_stats stats;
+    one::ingest(
+        crossline_input.first.data(),
+        crossline_input.first.size(),
+        crossline_input.second,
+        crossline_sink,
+        opts,
+        &stats
+    );
+    CHECK(stats.passes == 3);
+
+    /* the manifests differ in the last traces of the input */
+    inline_sink.objects.erase("guid/manifest.json");
+    crossline_sink.objects.erase("guid/manifest.json");
+    CHECK(inline_sink.objects == crossline_sink.objects);
+}
+
+TEST_CASE("2-byte key words are read with the size of their field") {
+    const auto input = mksegy(inline_sorted());
+    memory_sink sink;
+    one::ingest(
+        input.first.data(),
+        input.first.size(),
+        input.second,
+        sink,
+        small_fragments()
+    );
+
+    /*
+     * Move the line numbers to the 2-byte fields at bytes 29 and 35, and
+     * leave garbage in the bytes after them
+     */
+    auto segy = input.first;
+    const auto tracelen = 240 + samples * 4;
+    for (std::size_t t = 0; t < inline_sorted().size(); ++t) {
+        auto* header = &segy[3600 + t * tracelen];
+        header[28] = header[190];
+        header[29] = header[191];
+        header[30] = char(0xFF);
+        header[34] = header[194];
+        header[35] = header[195];
+        header[36] = char(0xFF);
+        std::memset(header + 188, 0, 8);
+    }
+    auto manifest = nlohmann::json::parse(input.second);
+    manifest["key-words"] = { 29, 35 };
+
+    memory_sink sink2;
+    one::ingest(
+        segy.data(),
+        segy.size(),
+        manifest.dump(),
+        sink2,
+        small_fragments()
+    );
+
+    sink.objects.erase("guid/manifest.json");
+    sink2.objects.erase("guid/manifest.json");
+    CHECK(sink.objects == sink2.objects);
+}
+
+TEST_CASE("Header words have the size of their trace header field") {
+    CHECK(one::header_word_size(189) == 4);
+    CHECK(one::header_word_size(193) == 4);
+    CHECK(one::header_word_size(29)  == 2);
+    CHECK(one::header_word_size(71)  == 2);
+    CHECK_THROWS_AS(one::header_word_size(190), std::invalid_argument);
+    CHECK_THROWS_AS(one::header_word_size(191), std::invalid_argument);
+    CHECK_THROWS_AS(one::header_word_size(0),   std::invalid_argument);
+    CHECK_THROWS_AS(one::header_word_size(241), std::invalid_argument);
+}
+
+TEST_CASE("Budgets smaller than a lane are rejected") {
+    const auto input = mksegy(inline_sorted());
+    auto opts = small_fragments();
+    opts.memory = 2 * 3 * 8 * sizeof(float) - 1;
+
+    memory_sink sink;
+    CHECK_THROWS_AS(
+        one::ingest(
+            input.first.data(),
+            input.first.size(),
+            input.second,
+            sink,
+            opts
+        ),
+        std::invalid_argument
+    );
+}
+
+TEST_CASE("Fragment columns without traces are not stored") {
+    auto traces = inline_sorted();
+    traces.erase(
+        std::remove_if(traces.begin(), traces.end(), [](const auto& t) {
+            return t.first == 3 and t.second >= 12;
+        }),
+        traces.end()
+    );
+    const auto input = mksegy(traces);
+
+    memory_sink sink;
+    const auto manifest = one::ingest(
+        input.first.data(),
+        input.first.size(),
+        input.second,
+        sink,
+        small_fragments()
+    );
+
+    CHECK(sink.objects.count("guid/src/2-2-2/1-0-0.f32") == 1);
+    CHECK(sink.objects.count("guid/src/2-2-2/1-1-0.f32") == 0);
+    const auto doc = nlohmann::json::parse(manifest);
+    CHECK(doc["fragment-mask"]["1"] == "07");
+    CHECK(doc["fill-value"] == 0);
+}
+
+TEST_CASE("Fragment stats are written for the full resolution cube") {
+    const auto input = mksegy(inline_sorted());
+    memory_sink sink;
+    const auto manifest = one::ingest(
+        input.first.data(),
+        input.first.size(),
+        input.second,
+        sink,
+        small_fragments()
+    );
+
+    const auto doc = nlohmann::json::parse(manifest);
+    CHECK(doc["fragment-stats"]["shape"] == nlohmann::json({ 2, 2, 2 }));
+    CHECK(doc["fragment-stats"]["bins"] == 16);
+
+    /* min, max, mean, rms, count, and 16 bins, for all 2 * 2 * 3 fragments */
+    const auto record = 4 * sizeof(float) + 17 * sizeof(std::uint32_t);
+    const auto& sidecar = sink.objects.at("guid/src/2-2-2/stats.bin");
+    REQUIRE(sidecar.size() == 12 * record);
+
+    /*
+     * fragment (0, 0, 0) is inline 1-2, crossline 10-11, sample 0-1, so
+     * the samples of inline 1 are in the first bin, and inline 2 in the last
+     */
+    float values[4];
+    std::uint32_t count;
+    std::uint32_t hist[16];
+    std::memcpy(values, sidecar.data(), sizeof(values));
+    std::memcpy(&count, sidecar.data() + sizeof(values), sizeof(count));
+    std::memcpy(hist, sidecar.data() + sizeof(values) + 4, sizeof(hist));
+    CHECK(values[0] == value(1, 10, 0));
+    CHECK(values[1] == value(2, 11, 1));
+    CHECK(count == 8);
+    CHECK(hist[0] == 4);
+    CHECK(hist[15] == 4);
+
+    /* fragment (0, 0, 2) only has sample 4 */
+    std::memcpy(&count, sidecar.data() + 2 * record + sizeof(values), 4);
+    CHECK(count == 4);
+}
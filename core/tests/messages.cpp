@@ -8,7 +8,7 @@
 
 using namespace Catch::Matchers;
 
-namespace {
+namespace one {
 
 bool operator == (const one::common_task& lhs, const one::common_task& rhs) {
     return lhs.token            == rhs.token
@@ -164,3 +164,95 @@ TEST_CASE("slice-fetch can round trip packing") {
 
     CHECK(task == unpacked);
 }
+
+TEST_CASE("task format defaults to f32 when not set") {
+    const auto doc = R"({
+        "pid": "some-pid",
+        "token": "on-behalf-of-token",
+        "guid": "object-id",
+        "manifest": "{}",
+        "storage_endpoint": "https://storage.com",
+        "shape": [64, 64, 64],
+        "shape-cube": [128, 128, 128],
+        "function": "slice",
+        "params": {
+            "dim": 0,
+            "lineno": 10
+        }
+    })";
+
+    one::slice_task task;
+    task.unpack(doc, doc + std::strlen(doc));
+    CHECK(task.format == "f32");
+}
+
+TEST_CASE("unpacking task with unknown format fails") {
+    const auto doc = R"({
+        "pid": "some-pid",
+        "token": "on-behalf-of-token",
+        "guid": "object-id",
+        "manifest": "{}",
+        "storage_endpoint": "https://storage.com",
+        "shape": [64, 64, 64],
+        "shape-cube": [128, 128, 128],
+        "function": "slice",
+        "format": "f64",
+        "params": {
+            "dim": 0,
+            "lineno": 10
+        }
+    })";
+
+    one::slice_task task;
+    CHECK_THROWS_AS(task.unpack(doc, doc + std::strlen(doc)), one::bad_message);
+}
+
+TEST_CASE("unpacking horizon-task with malformed surface fails") {
+    one::horizon_task task;
+    task.pid        = "some-pid";
+    task.function   = "horizon";
+    task.manifest   = "{}";
+    task.shape      = { 64, 64, 64 };
+    task.shape_cube = { 128, 128, 128 };
+    task.dim0s      = { 1, 2 };
+    task.dim1s      = { 10, 11, 12 };
+    task.surface    = std::vector< float >(6, 100);
+
+    SECTION("when the surface does not cover the grid") {
+        task.surface.pop_back();
+    }
+
+    SECTION("when the window is negative") {
+        task.window = -1;
+    }
+
+    const auto doc = task.pack();
+    one::horizon_task out;
+    const auto fst = doc.data();
+    const auto lst = doc.data() + doc.size();
+    CHECK_THROWS_AS(out.unpack(fst, lst), one::bad_message);
+}
+
+TEST_CASE("horizon-fetch can round trip packing") {
+    one::horizon_fetch fetch;
+    fetch.pid        = "some-pid";
+    fetch.function   = "horizon";
+    fetch.manifest   = "{}";
+    fetch.shape      = { 64, 64, 64 };
+    fetch.shape_cube = { 128, 128, 128 };
+    fetch.window     = 2;
+
+    one::horizon_column column;
+    column.id = { 1, 2 };
+    column.ks = { 3, 4 };
+    column.points = { { 7, 1, 2, 200 } };
+    fetch.ids = { column };
+
+    const auto doc = fetch.pack();
+    one::horizon_fetch out;
+    out.unpack(doc.data(), doc.data() + doc.size());
+    CHECK(out.window == 2);
+    REQUIRE(out.ids.size() == 1);
+    CHECK_THAT(out.ids[0].ks, Equals(column.ks));
+    CHECK(out.ids[0].points == column.points);
+}
@@ -0,0 +1,1173 @@
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <nlohmann/json.hpp>
+
+#include <oneseismic/messages.hpp>
+#include <oneseismic/plan.hpp>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+template < typename T >
+T unpack(const std::string& s) {
+    T t;
+    t.unpack(s.data(), s.data() + s.size());
+    return t;
+}
+
+std::vector< int > labels(int first, int n) {
+    std::vector< int > xs(n);
+    std::iota(xs.begin(), xs.end(), first);
+    return xs;
+}
+
+/*
+ * A 256 x 128 x 64 survey with inlines 1..256, crosslines 1000..1127 and
+ * overview levels 2, 4 and 8
+ */
+nlohmann::json default_manifest() {
+    nlohmann::json manifest;
+    manifest["dimensions"] = {
+        labels(1, 256),
+        labels(1000, 128),
+        labels(0, 64),
+    };
+    manifest["decimations"] = { 2, 4, 8 };
+    return manifest;
+}
+
+one::slice_task default_slice_task() {
+    one::slice_task task;
+    task.pid   = "some-pid";
+    task.token = "some-token";
+    task.guid  = "some-guid";
+    task.storage_endpoint = "some-endpoint";
+    task.manifest   = default_manifest().dump();
+    task.shape      = { 16, 16, 16 };
+    task.shape_cube = { 256, 128, 64 };
+    task.function   = "slice";
+    task.dim    = 0;
+    task.lineno = 17;
+    return task;
+}
+
+one::curtain_task default_curtain_task() {
+    one::curtain_task task;
+    task.pid   = "some-pid";
+    task.token = "some-token";
+    task.guid  = "some-guid";
+    task.storage_endpoint = "some-endpoint";
+    task.manifest   = default_manifest().dump();
+    task.shape      = { 16, 16, 16 };
+    task.shape_cube = { 256, 128, 64 };
+    task.function   = "curtain";
+    return task;
+}
+
+template < typename Task >
+std::vector< std::string > schedule(const Task& task, int task_size = 1000) {
+    const auto doc = task.pack();
+    return one::mkschedule(doc.data(), doc.size(), task_size);
+}
+
+}
+
+TEST_CASE("slice without target shape is read from full resolution") {
+    const auto task = default_slice_task();
+    const auto sched = schedule(task);
+    REQUIRE(sched.size() == 2);
+
+    const auto head  = unpack< one::process_header >(sched.back());
+    const auto fetch = unpack< one::slice_fetch >(sched.front());
+    CHECK(head.decimation  == 1);
+    CHECK(fetch.decimation == 1);
+    CHECK_THAT(head.shape, Equals(std::vector< int >{ 128, 64 }));
+    CHECK_THAT(fetch.shape_cube, Equals(std::vector< int >{ 256, 128, 64 }));
+    /* 8 x 4 fragments in the crossline/depth plane */
+    CHECK(fetch.ids.size() == 32);
+    CHECK(fetch.lineno == 0);
+    CHECK(head.lineno == 17);
+}
+
+TEST_CASE("slice picks the coarsest level that covers the target shape") {
+    auto task = default_slice_task();
+
+    SECTION("small targets pick the coarsest level") {
+        task.target_shape = { 10, 8 };
+        const auto sched = schedule(task);
+        const auto head  = unpack< one::process_header >(sched.back());
+        const auto fetch = unpack< one::slice_fetch >(sched.front());
+        CHECK(head.decimation  == 8);
+        CHECK(fetch.decimation == 8);
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 16, 8 }));
+        CHECK_THAT(fetch.shape_cube, Equals(std::vector< int >{ 32, 16, 8 }));
+        CHECK(fetch.ids.size() == 1);
+        /* inline 17 is index 16, which is index 2 in lod8 */
+        CHECK(fetch.lineno == 2);
+        CHECK(head.lineno == 17);
+        CHECK_THAT(head.index[0], Equals(std::vector< int >{
+            1000, 1008, 1016, 1024, 1032, 1040, 1048, 1056,
+            1064, 1072, 1080, 1088, 1096, 1104, 1112, 1120,
+        }));
+    }
+
+    SECTION("lines between the lines of the level give the line before") {
+        task.target_shape = { 10, 8 };
+        task.lineno = 20;
+        const auto sched = schedule(task);
+        const auto head  = unpack< one::process_header >(sched.back());
+        const auto fetch = unpack< one::slice_fetch >(sched.front());
+        /* inline 20 is index 19, and lod8 has index 16 (inline 17) */
+        CHECK(fetch.lineno == 2);
+        CHECK(head.lineno == 17);
+    }
+
+    SECTION("all dimensions must be covered") {
+        task.target_shape = { 10, 20 };
+        const auto sched = schedule(task);
+        const auto head  = unpack< one::process_header >(sched.back());
+        CHECK(head.decimation == 2);
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 64, 32 }));
+    }
+
+    SECTION("too large targets give full resolution") {
+        task.target_shape = { 1000, 1000 };
+        const auto sched = schedule(task);
+        const auto head  = unpack< one::process_header >(sched.back());
+        CHECK(head.decimation == 1);
+    }
+
+    SECTION("target shape with wrong dimensions fails") {
+        task.target_shape = { 10 };
+        CHECK_THROWS_AS(schedule(task), one::bad_message);
+    }
+}
+
+TEST_CASE("slice is read from full resolution without overview levels") {
+    auto task = default_slice_task();
+    auto manifest = default_manifest();
+    manifest.erase("decimations");
+    task.manifest = manifest.dump();
+    task.target_shape = { 1, 1 };
+
+    const auto sched = schedule(task);
+    const auto head  = unpack< one::process_header >(sched.back());
+    CHECK(head.decimation == 1);
+}
+
+TEST_CASE("the fragment mask of the level is forwarded to the fetch") {
+    auto task = default_slice_task();
+    auto manifest = default_manifest();
+    /* 16 x 8 fragment columns, where column (1, 0) is not stored */
+    const auto mask = "fffe" + std::string(28, 'f');
+    manifest["fragment-mask"] = { { "1", mask } };
+    manifest["fill-value"] = -1;
+    task.manifest = manifest.dump();
+
+    SECTION("with the fill value") {
+        const auto sched = schedule(task);
+        const auto fetch = unpack< one::slice_fetch >(sched.front());
+        CHECK(fetch.fragment_mask == mask);
+        CHECK(fetch.fill_value == -1);
+
+        const auto stored = one::fragment_mask(fetch);
+        CHECK(not stored.stored(1, 0));
+        CHECK(stored.stored(0, 0));
+        CHECK(stored.stored(1, 1));
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK(head.fill_value == -1);
+    }
+
+    SECTION("without the absent fragments") {
+        const auto sched = schedule(task);
+        const auto fetch = unpack< one::slice_fetch >(sched.front());
+        /* inline 17 is in the fragments (1, j, k) */
+        CHECK(fetch.ids.size() == 28);
+        for (const auto& id : fetch.ids)
+            CHECK(id[1] != 0);
+    }
+
+    SECTION("levels without a mask are dense") {
+        task.target_shape = { 10, 8 };
+        const auto sched = schedule(task);
+        const auto fetch = unpack< one::slice_fetch >(sched.front());
+        CHECK(fetch.decimation == 8);
+        CHECK(fetch.fragment_mask.empty());
+    }
+
+    SECTION("masks that do not fit the level fail") {
+        manifest["fragment-mask"] = { { "1", "ff" } };
+        task.manifest = manifest.dump();
+        CHECK_THROWS_AS(schedule(task), one::bad_message);
+    }
+}
+
+TEST_CASE("processes of only absent fragments have a single, empty task") {
+    auto manifest = default_manifest();
+    /* 16 x 8 fragment columns, where none are stored */
+    manifest["fragment-mask"] = { { "1", std::string(32, '0') } };
+    manifest["fill-value"] = -1;
+
+    SECTION("for slices") {
+        auto task = default_slice_task();
+        task.manifest = manifest.dump();
+        const auto sched = schedule(task, 10);
+        REQUIRE(sched.size() == 2);
+
+        const auto fetch = unpack< one::slice_fetch >(sched.front());
+        CHECK(fetch.ids.empty());
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK(head.ntasks == 1);
+        CHECK(head.fill_value == -1);
+    }
+
+    SECTION("for well paths") {
+        one::wellpath_task task(default_curtain_task());
+        task.function = "wellpath";
+        task.manifest = manifest.dump();
+        task.points = {
+            {  1.5f, 1000.5f, 10.5f },
+            { 16.5f, 1000.0f, 15.5f },
+        };
+        const auto sched = schedule(task, 10);
+        REQUIRE(sched.size() == 2);
+
+        const auto fetch = unpack< one::wellpath_fetch >(sched.front());
+        CHECK(fetch.ids.empty());
+        CHECK(fetch.points.size() == 2);
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK(head.ntasks == 1);
+    }
+
+    SECTION("for batches") {
+        auto slice = default_slice_task();
+        slice.pid      = "slice-pid";
+        slice.manifest = manifest.dump();
+        auto curtain = default_curtain_task();
+        curtain.pid      = "curtain-pid";
+        curtain.manifest = manifest.dump();
+        curtain.dim0s = { 18, 18 };
+        curtain.dim1s = { 1000, 1100 };
+
+        auto batch = one::batch_task(slice);
+        batch.pid   = "batch-pid";
+        batch.tasks = { slice.pack(), curtain.pack() };
+        const auto doc = batch.pack();
+        const auto sched = one::mkbatch(doc.data(), doc.size(), 10);
+        REQUIRE(sched.size() == 1 + 2);
+
+        const auto fetch = unpack< one::batch_fetch >(sched[0]);
+        REQUIRE(fetch.queries.size() == 2);
+        CHECK(fetch.queries[0].part == "0/1");
+        CHECK(fetch.queries[1].part == "0/1");
+        CHECK(unpack< one::slice_fetch >(fetch.queries[0].fetch).ids.empty());
+
+        CHECK(unpack< one::process_header >(sched[1]).ntasks == 1);
+        CHECK(unpack< one::process_header >(sched[2]).ntasks == 1);
+    }
+}
+
+TEST_CASE("areas leave out the traces of absent fragments") {
+    one::area_task task(default_curtain_task());
+    task.function    = "area";
+    task.coordinates = "grid";
+    /* the traces (15..17, 15..17), in the columns (0..1, 0..1) */
+    task.polygon = {
+        { 14.5, 14.5 },
+        { 14.5, 17.5 },
+        { 17.5, 17.5 },
+        { 17.5, 14.5 },
+    };
+    auto manifest = default_manifest();
+
+    SECTION("when some columns are absent") {
+        /* column (1, 0), with the traces (16, 15) and (17, 15), is absent */
+        manifest["fragment-mask"] = { { "1", "fffe" + std::string(28, 'f') } };
+        task.manifest = manifest.dump();
+        const auto sched = schedule(task);
+        REQUIRE(sched.size() == 2);
+
+        const auto fetch = unpack< one::area_fetch >(sched.front());
+        REQUIRE(fetch.ids.size() == 3);
+        for (const auto& column : fetch.ids)
+            CHECK(column.id != std::vector< int >{ 1, 0 });
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 7, 64 }));
+        CHECK(head.index[0].size() == 7);
+    }
+
+    SECTION("when all columns are absent") {
+        manifest["fragment-mask"] = { { "1", std::string(32, '0') } };
+        task.manifest = manifest.dump();
+        const auto sched = schedule(task);
+        REQUIRE(sched.size() == 2);
+
+        const auto fetch = unpack< one::area_fetch >(sched.front());
+        CHECK(fetch.ids.empty());
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK(head.ntasks == 1);
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 0, 64 }));
+    }
+}
+
+TEST_CASE("curtain paths are collapsed in overview levels") {
+    auto task = default_curtain_task();
+    task.dim0s = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    task.dim1s = { 1000, 1000, 1000, 1000, 1001, 1001, 1001, 1001 };
+
+    SECTION("to the coarsest level that covers the target") {
+        task.target_shape = { 2, 8 };
+        const auto sched = schedule(task);
+        const auto head  = unpack< one::process_header >(sched.back());
+        CHECK(head.decimation == 4);
+        CHECK_THAT(head.index[0], Equals(std::vector< int >{ 0, 1 }));
+        CHECK_THAT(head.index[1], Equals(std::vector< int >{ 0, 0 }));
+        CHECK(head.shape[0] == 2);
+
+        const auto fetch = unpack< one::curtain_fetch >(sched.front());
+        CHECK(fetch.decimation == 4);
+        CHECK_THAT(fetch.dim0s, Equals(std::vector< int >{ 0, 1 }));
+        CHECK_THAT(fetch.shape_cube, Equals(std::vector< int >{ 64, 32, 16 }));
+    }
+
+    SECTION("unless no target is given") {
+        const auto sched = schedule(task);
+        const auto head  = unpack< one::process_header >(sched.back());
+        CHECK(head.decimation == 1);
+        CHECK(head.shape[0] == 8);
+    }
+}
+
+TEST_CASE("progressive slices schedule a coarse preview first") {
+    auto task = default_slice_task();
+    task.progressive = true;
+
+    const auto sched = schedule(task);
+    const auto head  = unpack< one::process_header >(sched.back());
+    REQUIRE(head.phases.size() == 2);
+
+    const auto& preview = head.phases[0];
+    const auto& full    = head.phases[1];
+    CHECK(preview.decimation == 8);
+    CHECK(preview.ntasks == 1);
+    CHECK_THAT(preview.shape, Equals(std::vector< int >{ 16, 8 }));
+    CHECK(full.decimation == 1);
+    CHECK_THAT(full.shape, Equals(head.shape));
+    CHECK(head.decimation == 1);
+    CHECK(head.ntasks == preview.ntasks + full.ntasks);
+    CHECK(preview.lineno == 17);
+    CHECK(full.lineno == 17);
+    REQUIRE(sched.size() == std::size_t(head.ntasks + 1));
+
+    const auto first = unpack< one::slice_fetch >(sched.front());
+    const auto last  = unpack< one::slice_fetch >(sched[sched.size() - 2]);
+    CHECK(first.decimation == 8);
+    CHECK(last.decimation  == 1);
+}
+
+TEST_CASE("progressive slices without coarser levels have a single phase") {
+    auto task = default_slice_task();
+    task.progressive = true;
+
+    SECTION("when the cube has no overview levels") {
+        auto manifest = default_manifest();
+        manifest.erase("decimations");
+        task.manifest = manifest.dump();
+    }
+
+    SECTION("when the target is already read from the coarsest level") {
+        task.target_shape = { 1, 1 };
+    }
+
+    const auto sched = schedule(task);
+    const auto head  = unpack< one::process_header >(sched.back());
+    CHECK(head.phases.empty());
+    CHECK(sched.size() == std::size_t(head.ntasks + 1));
+}
+
+TEST_CASE("horizons are planned by the fragments around the surface") {
+    one::horizon_task task(default_curtain_task());
+    task.function = "horizon";
+    task.dim0s    = { 1, 2, 17 };
+    task.dim1s    = { 1000, 1001 };
+    task.window   = 2;
+    task.surface  = {
+        10, 10,
+        20, -999.25,
+        40, 40,
+    };
+
+    SECTION("with whole columns in every task") {
+        const auto sched = schedule(task, 1);
+        REQUIRE(sched.size() == 3);
+
+        const auto first  = unpack< one::horizon_fetch >(sched[0]);
+        const auto second = unpack< one::horizon_fetch >(sched[1]);
+        REQUIRE(first.ids.size()  == 1);
+        REQUIRE(second.ids.size() == 1);
+        CHECK(first.surface.empty());
+
+        const auto& column0 = first.ids[0];
+        CHECK_THAT(column0.id, Equals(std::vector< int >{ 0, 0 }));
+        CHECK_THAT(column0.ks, Equals(std::vector< int >{ 0, 1 }));
+        /* the hole at (2, 1001) is not planned */
+        REQUIRE(column0.points.size() == 3);
+        CHECK(column0.points[2] == std::array< int, 4 >{ 2, 1, 0, 20 });
+
+        const auto& column1 = second.ids[0];
+        CHECK_THAT(column1.id, Equals(std::vector< int >{ 1, 0 }));
+        CHECK_THAT(column1.ks, Equals(std::vector< int >{ 2 }));
+        CHECK(column1.points.size() == 2);
+    }
+
+    SECTION("with a header that describes the window") {
+        const auto sched = schedule(task);
+        REQUIRE(sched.size() == 2);
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK(head.ntasks == 1);
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 3, 2, 5 }));
+        CHECK_THAT(head.index[0], Equals(task.dim0s));
+        CHECK_THAT(head.index[2], Equals(std::vector< int >{ -2, -1, 0, 1, 2 }));
+    }
+
+    SECTION("without a window dimension for maps") {
+        task.window = 0;
+        const auto sched = schedule(task);
+        const auto head  = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 3, 2 }));
+        CHECK(head.index.size() == 2);
+    }
+
+    SECTION("and fails on unknown lines") {
+        task.dim0s = { 1, 2, 1000 };
+        CHECK_THROWS_AS(schedule(task), one::not_found);
+    }
+}
+
+TEST_CASE("attributes reduce the z-axis of the header") {
+    auto task = default_curtain_task();
+    task.dim0s = { 1, 2 };
+    task.dim1s = { 1000, 1000 };
+    task.attribute = "mean";
+
+    SECTION("by the window") {
+        task.attribute_window = 4;
+        const auto sched = schedule(task);
+        const auto head  = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 2, 16 }));
+        REQUIRE(head.index[2].size() == 16);
+        CHECK(head.index[2][1] == 4);
+    }
+
+    SECTION("unless the window does not divide the fragments") {
+        task.attribute_window = 5;
+        CHECK_THROWS_AS(schedule(task), one::bad_message);
+    }
+
+    SECTION("and cannot reduce slices along z") {
+        auto slice = default_slice_task();
+        slice.dim    = 2;
+        slice.lineno = 10;
+        slice.attribute = "rms";
+        CHECK_THROWS_AS(schedule(slice), one::bad_message);
+    }
+}
+
+TEST_CASE("z-ranges only plan the fragments that overlap the range") {
+    SECTION("for lateral slices") {
+        auto task = default_slice_task();
+        task.zmin = 20;
+        task.zmax = 40;
+        const auto sched = schedule(task);
+        const auto fetch = unpack< one::slice_fetch >(sched.front());
+        CHECK(fetch.begin[1] == 20);
+        CHECK(fetch.end[1]   == 41);
+        /* 8 crosslines x 2 of the 4 z-fragments */
+        REQUIRE(fetch.ids.size() == 16);
+        for (const auto& id : fetch.ids)
+            CHECK((id[2] == 1 or id[2] == 2));
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 128, 21 }));
+        CHECK(head.index[1].front() == 20);
+        CHECK(head.index[1].back()  == 40);
+    }
+
+    SECTION("but not slices along z") {
+        auto task = default_slice_task();
+        task.dim    = 2;
+        task.lineno = 10;
+        task.zmax   = 40;
+        CHECK_THROWS_AS(schedule(task), one::bad_message);
+    }
+
+    SECTION("for curtains") {
+        auto task = default_curtain_task();
+        task.dim0s = { 1, 2, 17 };
+        task.dim1s = { 1000, 1000, 1000 };
+        task.zmin  = 20;
+        task.zmax  = 40;
+        const auto sched = schedule(task);
+        const auto fetch = unpack< one::curtain_fetch >(sched.front());
+        CHECK(fetch.zbegin == 20);
+        CHECK(fetch.zend   == 41);
+        REQUIRE(fetch.ids.size() == 4);
+        CHECK_THAT(fetch.ids[0].id, Equals(std::vector< int >{ 0, 0, 1 }));
+        CHECK_THAT(fetch.ids[1].id, Equals(std::vector< int >{ 0, 0, 2 }));
+        CHECK_THAT(fetch.ids[2].id, Equals(std::vector< int >{ 1, 0, 1 }));
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 3, 21 }));
+    }
+
+    SECTION("widened to whole attribute windows") {
+        auto task = default_curtain_task();
+        task.dim0s = { 1 };
+        task.dim1s = { 1000 };
+        task.zmin  = 21;
+        task.zmax  = 38;
+        task.attribute = "mean";
+        task.attribute_window = 4;
+        const auto sched = schedule(task);
+        const auto fetch = unpack< one::curtain_fetch >(sched.front());
+        CHECK(fetch.zbegin == 20);
+        CHECK(fetch.zend   == 40);
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 1, 5 }));
+        CHECK_THAT(head.index[2], Equals(std::vector< int >{
+            20, 24, 28, 32, 36,
+        }));
+    }
+
+    SECTION("and fails on empty ranges") {
+        auto task = default_curtain_task();
+        task.dim0s = { 1 };
+        task.dim1s = { 1000 };
+        task.zmin  = 100;
+        CHECK_THROWS_AS(schedule(task), one::not_found);
+    }
+}
+
+TEST_CASE("slices only plan the fragments in the region of interest") {
+    auto task = default_slice_task();
+    task.roi = { { 1020, 1039 }, { 10, 50 } };
+
+    SECTION("inside the region") {
+        const auto sched = schedule(task);
+        const auto fetch = unpack< one::slice_fetch >(sched.front());
+        CHECK(fetch.begin == std::array< int, 2 >{ 20, 10 });
+        CHECK(fetch.end   == std::array< int, 2 >{ 40, 51 });
+        /* crosslines 1..2 x samples 0..3 */
+        CHECK(fetch.ids.size() == 8);
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 20, 41 }));
+        CHECK(head.index[0].front() == 1020);
+        CHECK(head.index[1].front() == 10);
+    }
+
+    SECTION("with every stride'th sample") {
+        task.roi    = { { 1000, 1127 }, { 10, 50 } };
+        task.stride = { 40, 1 };
+        const auto sched = schedule(task);
+        const auto fetch = unpack< one::slice_fetch >(sched.front());
+        CHECK(fetch.step == std::array< int, 2 >{ 40, 1 });
+        /* crosslines 0, 40, 80, 120 skip the fragments 1, 3, 4 and 6 */
+        REQUIRE(fetch.ids.size() == 16);
+        for (const auto& id : fetch.ids)
+            CHECK((id[1] == 0 or id[1] == 2 or id[1] == 5 or id[1] == 7));
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 4, 41 }));
+        CHECK_THAT(head.index[0], Equals(std::vector< int >{
+            1000, 1040, 1080, 1120,
+        }));
+    }
+
+    SECTION("intersected with the z-range") {
+        task.zmax = 20;
+        const auto sched = schedule(task);
+        const auto head  = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 20, 11 }));
+    }
+
+    SECTION("and not strided in z when reducing") {
+        task.stride = { 1, 2 };
+        task.attribute = "rms";
+        task.attribute_window = 4;
+        CHECK_THROWS_AS(schedule(task), one::bad_message);
+    }
+
+    SECTION("and fails on regions outside the cube") {
+        task.roi = { { 2000, 2010 }, { 10, 50 } };
+        CHECK_THROWS_AS(schedule(task), one::not_found);
+    }
+}
+
+TEST_CASE("well paths are planned with the fragments around every point") {
+    one::wellpath_task task(default_curtain_task());
+    task.function = "wellpath";
+    task.points = {
+        {   1.5f, 1000.5f, 10.5f },
+        {  16.5f, 1000.0f, 15.5f },
+        /* inline 0 is outside the cube */
+        {   0.0f, 1000.0f, 10.0f },
+        { 256.0f, 1127.0f, 63.0f },
+    };
+
+    SECTION("in a single task") {
+        const auto sched = schedule(task);
+        REQUIRE(sched.size() == 2);
+
+        const auto fetch = unpack< one::wellpath_fetch >(sched.front());
+        CHECK(fetch.coordinates == "grid");
+        CHECK_THAT(fetch.index, Equals(std::vector< int >{ 0, 1, 3 }));
+        CHECK(fetch.points[0] == std::array< double, 3 >{ 0.5, 0.5, 10.5 });
+        CHECK_THAT(fetch.ids, Equals(std::vector< std::vector< int > >{
+            { 0, 0, 0 },
+            { 0, 0, 1 },
+            { 1, 0, 0 },
+            { 1, 0, 1 },
+            { 15, 7, 3 },
+        }));
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 4 }));
+    }
+
+    SECTION("cut into stretches of task_size fragments") {
+        const auto sched = schedule(task, 1);
+        REQUIRE(sched.size() == 4);
+
+        const auto second = unpack< one::wellpath_fetch >(sched[1]);
+        CHECK_THAT(second.index, Equals(std::vector< int >{ 1 }));
+        CHECK(second.ids.size() == 4);
+    }
+}
+
+TEST_CASE("polylines are densified along the line") {
+    one::polyline_task task(default_curtain_task());
+    task.function = "polyline";
+
+    SECTION("with points spacing apart across the control points") {
+        task.coordinates = "grid";
+        task.spacing = 2;
+        task.points = {
+            { 0.0f, 0.0f },
+            { 4.0f, 3.0f },
+            { 4.0f, 4.0f },
+        };
+
+        const auto sched = schedule(task);
+        REQUIRE(sched.size() == 2);
+        const auto fetch = unpack< one::polyline_fetch >(sched.front());
+        REQUIRE(fetch.points.size() == 4);
+        CHECK(fetch.points[0][0] == Catch::Detail::Approx(0.0));
+        CHECK(fetch.points[1][0] == Catch::Detail::Approx(1.6));
+        CHECK(fetch.points[1][1] == Catch::Detail::Approx(1.2));
+        CHECK(fetch.points[2][0] == Catch::Detail::Approx(3.2));
+        CHECK(fetch.points[2][1] == Catch::Detail::Approx(2.4));
+        /* the last control point always ends the path */
+        CHECK(fetch.points[3][0] == Catch::Detail::Approx(4.0));
+        CHECK(fetch.points[3][1] == Catch::Detail::Approx(4.0));
+        CHECK_THAT(fetch.index, Equals(std::vector< int >{ 0, 1, 2, 3 }));
+        CHECK_THAT(fetch.ids, Equals(std::vector< std::vector< int > >{
+            { 0, 0, 0 },
+            { 0, 0, 1 },
+            { 0, 0, 2 },
+            { 0, 0, 3 },
+        }));
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 4, 64 }));
+    }
+
+    SECTION("and cut into stretches of task_size fragments") {
+        task.coordinates = "label";
+        task.spacing = 8;
+        task.points = {
+            {  1.0f, 1000.0f },
+            { 21.0f, 1000.0f },
+        };
+
+        const auto sched = schedule(task, 4);
+        REQUIRE(sched.size() == 3);
+        const auto first  = unpack< one::polyline_fetch >(sched[0]);
+        const auto second = unpack< one::polyline_fetch >(sched[1]);
+        CHECK_THAT(first.index,  Equals(std::vector< int >{ 0, 1 }));
+        CHECK_THAT(second.index, Equals(std::vector< int >{ 2, 3 }));
+        CHECK(second.points[0][0] == Catch::Detail::Approx(16.0));
+        CHECK(second.points[1][0] == Catch::Detail::Approx(20.0));
+        CHECK(second.ids.size() == 4);
+        CHECK(second.ids.front() == std::vector< int >{ 1, 0, 0 });
+    }
+
+    SECTION("and control points outside the cube are not found") {
+        task.points = {
+            {   1.0f, 1000.0f },
+            { 300.0f, 1000.0f },
+        };
+        CHECK_THROWS_AS(schedule(task), one::not_found);
+    }
+
+    SECTION("and the spacing must be positive") {
+        task.points  = { { 1.0f, 1000.0f } };
+        task.spacing = 0;
+        CHECK_THROWS_AS(schedule(task), one::bad_message);
+    }
+
+    SECTION("and the spacing must be at least a tenth of a trace") {
+        task.points  = { { 1.0f, 1000.0f }, { 2.0f, 1000.0f } };
+        task.spacing = 1e-30f;
+        CHECK_THROWS_AS(schedule(task), one::bad_message);
+        task.spacing = 0.05f;
+        CHECK_THROWS_AS(schedule(task), one::bad_message);
+    }
+
+    SECTION("and paths of too many points are rejected") {
+        /* back and forth across the cube, 110 * 255 traces long */
+        task.coordinates = "grid";
+        task.spacing = 0.1f;
+        task.points.clear();
+        for (int i = 0; i < 111; ++i)
+            task.points.push_back({ i % 2 == 0 ? 0.0 : 255.0, 0.0 });
+        CHECK_THROWS_AS(schedule(task), one::bad_message);
+    }
+}
+
+TEST_CASE("well paths and polylines accept world coordinates") {
+    /* 12.5m x 25m bins, with the first trace at (1000, 2000) */
+    auto manifest = default_manifest();
+    manifest["transform"] = { 1000.0, 12.5, 0.0, 2000.0, 0.0, 25.0 };
+
+    SECTION("well paths are mapped to the grid") {
+        one::wellpath_task task(default_curtain_task());
+        task.function    = "wellpath";
+        task.coordinates = "world";
+        task.manifest    = manifest.dump();
+        task.points = {
+            { 1000.0 + 12.5 * 1.5, 2000.0 + 25 * 0.5, 10.5 },
+        };
+
+        const auto sched = schedule(task);
+        const auto fetch = unpack< one::wellpath_fetch >(sched.front());
+        REQUIRE(fetch.points.size() == 1);
+        CHECK(fetch.points[0][0] == Catch::Detail::Approx(1.5));
+        CHECK(fetch.points[0][1] == Catch::Detail::Approx(0.5));
+        CHECK(fetch.points[0][2] == Catch::Detail::Approx(10.5));
+    }
+
+    SECTION("polylines are densified with the spacing in world units") {
+        one::polyline_task task(default_curtain_task());
+        task.function    = "polyline";
+        task.coordinates = "world";
+        task.manifest    = manifest.dump();
+        task.spacing     = 100;
+        task.points = {
+            { 1000.0,       2000.0 },
+            { 1000.0 + 250, 2000.0 },
+        };
+
+        const auto sched = schedule(task);
+        const auto fetch = unpack< one::polyline_fetch >(sched.front());
+        REQUIRE(fetch.points.size() == 4);
+        CHECK(fetch.points[1][0] == Catch::Detail::Approx(8.0));
+        CHECK(fetch.points[2][0] == Catch::Detail::Approx(16.0));
+        CHECK(fetch.points[3][0] == Catch::Detail::Approx(20.0));
+        CHECK(fetch.points[3][1] == Catch::Detail::Approx(0.0));
+    }
+
+    SECTION("polyline spacings are relative to the trace distance") {
+        one::polyline_task task(default_curtain_task());
+        task.function    = "polyline";
+        task.coordinates = "world";
+        task.manifest    = manifest.dump();
+        task.points = {
+            { 1000.0,       2000.0 },
+            { 1000.0 + 250, 2000.0 },
+        };
+        /* a tenth of the 12.5m inline distance */
+        task.spacing = 1.0f;
+        CHECK_THROWS_AS(schedule(task), one::bad_message);
+        task.spacing = 1.25f;
+        CHECK_NOTHROW(schedule(task));
+    }
+
+    SECTION("but not for cubes without a transform") {
+        one::polyline_task task(default_curtain_task());
+        task.function    = "polyline";
+        task.coordinates = "world";
+        task.points = { { 1000.0, 2000.0 } };
+        CHECK_THROWS_AS(schedule(task), one::bad_message);
+    }
+}
+
+TEST_CASE("points are binned by fragment in request order") {
+    one::points_task task(default_curtain_task());
+    task.function = "points";
+    task.dim0s = { 17,   0,  1, 255 };
+    task.dim1s = {  0,   1,  2, 127 };
+    task.dim2s = {  3,   4, 15,  63 };
+
+    SECTION("in a single task") {
+        const auto sched = schedule(task);
+        REQUIRE(sched.size() == 2);
+
+        const auto fetch = unpack< one::points_fetch >(sched.front());
+        CHECK(fetch.dim0s.empty());
+        REQUIRE(fetch.ids.size() == 3);
+
+        CHECK_THAT(fetch.ids[0].id,      Equals(std::vector< int >{ 0, 0, 0 }));
+        CHECK_THAT(fetch.ids[0].index,   Equals(std::vector< int >{ 1, 2 }));
+        CHECK_THAT(fetch.ids[0].offsets, Equals(std::vector< int >{
+            0 * 256 + 1 * 16 + 4,
+            1 * 256 + 2 * 16 + 15,
+        }));
+
+        CHECK_THAT(fetch.ids[1].id,      Equals(std::vector< int >{ 1, 0, 0 }));
+        CHECK_THAT(fetch.ids[1].index,   Equals(std::vector< int >{ 0 }));
+        CHECK_THAT(fetch.ids[1].offsets, Equals(std::vector< int >{
+            1 * 256 + 0 * 16 + 3,
+        }));
+
+        CHECK_THAT(fetch.ids[2].id,      Equals(std::vector< int >{ 15, 7, 3 }));
+        CHECK_THAT(fetch.ids[2].index,   Equals(std::vector< int >{ 3 }));
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 4 }));
+        CHECK_THAT(head.index.front(), Equals(std::vector< int >{ 0, 1, 2, 3 }));
+    }
+
+    SECTION("by their labels") {
+        task.coordinates = "label";
+        task.dim0s = {    2,    1 };
+        task.dim1s = { 1000, 1001 };
+        task.dim2s = {    0,   17 };
+        const auto sched = schedule(task);
+        const auto fetch = unpack< one::points_fetch >(sched.front());
+        REQUIRE(fetch.ids.size() == 2);
+        CHECK_THAT(fetch.ids[0].id,    Equals(std::vector< int >{ 0, 0, 0 }));
+        CHECK_THAT(fetch.ids[0].index, Equals(std::vector< int >{ 0 }));
+        CHECK_THAT(fetch.ids[1].id,    Equals(std::vector< int >{ 0, 0, 1 }));
+        CHECK_THAT(fetch.ids[1].index, Equals(std::vector< int >{ 1 }));
+    }
+
+    SECTION("and points outside the cube are not found") {
+        task.dim2s[3] = 64;
+        CHECK_THROWS_AS(schedule(task), one::not_found);
+    }
+}
+
+TEST_CASE("areas are planned by the fragment columns inside the polygon") {
+    one::area_task task(default_curtain_task());
+    task.function    = "area";
+    task.coordinates = "grid";
+    task.polygon = {
+        { 14.5, 14.5 },
+        { 14.5, 17.5 },
+        { 17.5, 17.5 },
+        { 17.5, 14.5 },
+    };
+
+    SECTION("with a mask of the traces of every column") {
+        const auto sched = schedule(task);
+        REQUIRE(sched.size() == 2);
+
+        const auto fetch = unpack< one::area_fetch >(sched.front());
+        CHECK(fetch.zbegin == 0);
+        CHECK(fetch.zend   == 64);
+        REQUIRE(fetch.ids.size() == 4);
+
+        const auto& column0 = fetch.ids[0];
+        CHECK_THAT(column0.id, Equals(std::vector< int >{ 0, 0 }));
+        CHECK_THAT(column0.ks, Equals(std::vector< int >{ 0, 1, 2, 3 }));
+        /* (15, 15) is bit 15 * 16 + 15 = 255 */
+        CHECK_THAT(column0.mask, Equals(std::vector< std::uint64_t >{
+            0, 0, 0, std::uint64_t(1) << 63,
+        }));
+
+        /* (16, 16), (16, 17), (17, 16) and (17, 17) */
+        const auto& column3 = fetch.ids[3];
+        CHECK_THAT(column3.id, Equals(std::vector< int >{ 1, 1 }));
+        CHECK_THAT(column3.mask, Equals(std::vector< std::uint64_t >{
+            0x30003, 0, 0, 0,
+        }));
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 9, 64 }));
+    }
+
+    SECTION("with whole columns in every task") {
+        const auto sched = schedule(task, 1);
+        CHECK(sched.size() == 5);
+    }
+
+    SECTION("with the samples in [zmin, zmax]") {
+        task.zmin = 20;
+        task.zmax = 40;
+        const auto sched = schedule(task);
+        const auto fetch = unpack< one::area_fetch >(sched.front());
+        CHECK(fetch.zbegin == 20);
+        CHECK(fetch.zend   == 41);
+        CHECK_THAT(fetch.ids[0].ks, Equals(std::vector< int >{ 1, 2 }));
+
+        const auto head = unpack< one::process_header >(sched.back());
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 9, 21 }));
+        CHECK(head.index[1].front() == 20);
+        CHECK(head.index[1].back()  == 40);
+    }
+
+    SECTION("with the traces on the boundary") {
+        task.coordinates = "label";
+        task.polygon = {
+            { 16, 1015 },
+            { 16, 1017 },
+            { 18, 1017 },
+            { 18, 1015 },
+        };
+        const auto sched = schedule(task);
+        const auto head  = unpack< one::process_header >(sched.back());
+        CHECK(head.shape.front() == 9);
+    }
+
+    SECTION("and clipped to the cube") {
+        task.polygon = {
+            {  -10,  -10 },
+            {  -10, 1000 },
+            { 1000, 1000 },
+            { 1000,  -10 },
+        };
+        const auto sched = schedule(task);
+        const auto head  = unpack< one::process_header >(sched.back());
+        CHECK(head.shape.front() == 256 * 128);
+    }
+
+    SECTION("and fails on empty z-ranges") {
+        task.zmin = 100;
+        task.zmax = 200;
+        CHECK_THROWS_AS(schedule(task), one::not_found);
+    }
+}
+
+TEST_CASE("stats are planned as a single read of the sidecar") {
+    one::stats_task task;
+    task.pid   = "some-pid";
+    task.token = "some-token";
+    task.guid  = "some-guid";
+    task.storage_endpoint = "some-endpoint";
+    task.shape      = { 16, 16, 16 };
+    task.shape_cube = { 256, 128, 64 };
+    task.function   = "stats";
+    task.bins = 32;
+
+    auto manifest = default_manifest();
+    manifest["fragment-stats"] = {
+        { "shape", { 16, 16, 16 } },
+        { "bins",  8 },
+    };
+    task.manifest = manifest.dump();
+
+    SECTION("for the whole cube") {
+        const auto sched = schedule(task, 1);
+        REQUIRE(sched.size() == 2);
+        const auto head  = unpack< one::process_header >(sched.back());
+        const auto fetch = unpack< one::stats_fetch >(sched.front());
+        CHECK(head.ntasks == 1);
+        CHECK_THAT(head.shape, Equals(std::vector< int >{ 32 }));
+        CHECK(fetch.dim == -1);
+        CHECK(fetch.sidecar_bins == 8);
+    }
+
+    SECTION("for the fragment layer of a line") {
+        task.dim    = 1;
+        task.lineno = 1040;
+        const auto sched = schedule(task);
+        const auto fetch = unpack< one::stats_fetch >(sched.front());
+        CHECK(fetch.dim == 1);
+        CHECK(fetch.layer == 2);
+    }
+
+    SECTION("unknown lines are not found") {
+        task.dim    = 1;
+        task.lineno = 1;
+        CHECK_THROWS_AS(schedule(task), one::not_found);
+    }
+
+    SECTION("cubes without a sidecar are not found") {
+        manifest.erase("fragment-stats");
+        task.manifest = manifest.dump();
+        CHECK_THROWS_AS(schedule(task), one::not_found);
+    }
+
+    SECTION("sidecars of other fragment shapes are not found") {
+        task.shape = { 64, 64, 64 };
+        CHECK_THROWS_AS(schedule(task), one::not_found);
+    }
+}
+
+TEST_CASE("batches plan every fragment in exactly one task") {
+    /*
+     * Inline 17, and a curtain along inline 18, which is in the same
+     * fragments. The slice reads the 8 columns of 4 fragments of the inline,
+     * and the curtain the columns of crosslines 1000 and 1100.
+     */
+    auto slice = default_slice_task();
+    slice.pid = "slice-pid";
+    auto curtain = default_curtain_task();
+    curtain.pid   = "curtain-pid";
+    curtain.dim0s = { 18, 18, 18 };
+    curtain.dim1s = { 1000, 1001, 1100 };
+
+    auto batch = one::batch_task(slice);
+    batch.pid   = "batch-pid";
+    batch.tasks = { slice.pack(), curtain.pack() };
+    const auto doc = batch.pack();
+    /* columns are not split, so tasks are 3 + 3 + 2 columns */
+    const auto sched = one::mkbatch(doc.data(), doc.size(), 10);
+    REQUIRE(sched.size() == 3 + 2);
+
+    const auto slicehead   = unpack< one::process_header >(sched[3]);
+    const auto curtainhead = unpack< one::process_header >(sched[4]);
+    CHECK(slicehead.pid      == "slice-pid");
+    CHECK(slicehead.ntasks   == 3);
+    CHECK_THAT(slicehead.shape, Equals(std::vector< int >{ 128, 64 }));
+    CHECK(curtainhead.pid    == "curtain-pid");
+    CHECK(curtainhead.ntasks == 2);
+
+    using fid = std::array< int, 3 >;
+    std::set< fid > seen;
+    std::vector< std::string > curtainparts;
+    for (int i = 0; i < 3; ++i) {
+        const auto fetch = unpack< one::batch_fetch >(sched[i]);
+        CHECK(fetch.pid == "batch-pid");
+        CHECK(fetch.manifest.empty());
+
+        std::set< fid > fragments;
+        for (const auto& query : fetch.queries) {
+            if (query.function == "slice") {
+                CHECK(query.pid  == "slice-pid");
+                CHECK(query.part == std::to_string(i) + "/3");
+                const auto x = unpack< one::slice_fetch >(query.fetch);
+                CHECK(x.manifest.empty());
+                for (const auto& id : x.ids)
+                    fragments.insert({ id[0], id[1], id[2] });
+            } else {
+                CHECK(query.pid == "curtain-pid");
+                curtainparts.push_back(query.part);
+                const auto x = unpack< one::curtain_fetch >(query.fetch);
+                for (const auto& single : x.ids) {
+                    const auto& id = single.id;
+                    fragments.insert({ id[0], id[1], id[2] });
+                }
+            }
+        }
+
+        for (const auto& id : fragments)
+            CHECK(seen.count(id) == 0);
+        seen.insert(fragments.begin(), fragments.end());
+    }
+
+    CHECK(seen.size() == 32);
+    CHECK_THAT(curtainparts, Equals(std::vector< std::string >{
+        "0/2", "1/2",
+    }));
+}
+
+TEST_CASE("batches only accept queries of the same cube") {
+    auto slice = default_slice_task();
+    auto batch = one::batch_task(slice);
+    batch.pid = "batch-pid";
+
+    SECTION("with the same guid") {
+        auto other = slice;
+        other.guid = "other-guid";
+        batch.tasks = { slice.pack(), other.pack() };
+        const auto doc = batch.pack();
+        CHECK_THROWS_AS(
+            one::mkbatch(doc.data(), doc.size(), 10),
+            one::bad_message
+        );
+    }
+
+    SECTION("that can be batched") {
+        auto progressive = slice;
+        progressive.progressive = true;
+        batch.tasks = { slice.pack(), progressive.pack() };
+        const auto doc = batch.pack();
+        CHECK_THROWS_AS(
+            one::mkbatch(doc.data(), doc.size(), 10),
+            one::bad_message
+        );
+    }
+}
+
+TEST_CASE("identical queries have the same hash") {
+    const auto hash = [](const std::string& doc) {
+        return one::query_hash(doc.data(), doc.size());
+    };
+
+    const auto task = default_slice_task();
+    const auto expected = hash(task.pack());
+    CHECK(expected.size() == 64);
+
+    SECTION("from different requests and users") {
+        auto other = task;
+        other.pid   = "other-pid";
+        other.token = "other-token";
+        CHECK(hash(other.pack()) == expected);
+    }
+
+    SECTION("with defaults given explicitly or not") {
+        auto doc = nlohmann::json::parse(task.pack());
+        doc["params"].erase("zmin");
+        doc["params"].erase("zmax");
+        doc["params"].erase("roi");
+        doc.erase("format");
+        CHECK(hash(doc.dump()) == expected);
+    }
+
+    SECTION("regardless of the formatting of the manifest") {
+        auto other = task;
+        other.manifest = default_manifest().dump(4);
+        CHECK(hash(other.pack()) == expected);
+    }
+
+    SECTION("but not for different queries") {
+        auto other = task;
+        other.lineno = 18;
+        CHECK(hash(other.pack()) != expected);
+
+        other = task;
+        other.format = "f16";
+        CHECK(hash(other.pack()) != expected);
+
+        auto curtain = default_curtain_task();
+        curtain.dim0s = { 17 };
+        curtain.dim1s = { 1000 };
+        CHECK(hash(curtain.pack()) != expected);
+    }
+
+    SECTION("or for a different cube") {
+        auto manifest = default_manifest();
+        manifest["dimensions"][2] = labels(0, 32);
+        auto other = task;
+        other.manifest = manifest.dump();
+        CHECK(hash(other.pack()) != expected);
+
+        other = task;
+        other.guid = "other-guid";
+        CHECK(hash(other.pack()) != expected);
+    }
+}
@@ -1,3 +1,7 @@
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
 #include <catch/catch.hpp>
 
 #include <oneseismic/geometry.hpp>
@@ -54,6 +58,56 @@ TEST_CASE("slice.fragments generates the right IDs from a task") {
         ;
         CHECK(slice->fragments() == expected);
     }
+
+    SECTION("From the overview level when decimated") {
+        input.decimation = 4;
+        input.ids = {
+            { 0, 1, 2 },
+        };
+        const auto msg = input.pack();
+        slice->init(msg.data(), msg.size());
+        CHECK(slice->fragments() == "lod4/64-64-64/0-1-2.f32");
+    }
+}
+
+TEST_CASE("slice.prefetch gives the neighbouring fragment layer") {
+    auto input = default_slice_fetch();
+    auto slice = one::proc::make("slice");
+    input.dim = 1;
+    input.ids = {
+        { 0, 0, 2 },
+        { 1, 0, 2 },
+    };
+
+    SECTION("In the scroll direction") {
+        input.lineno = 3 * 64 + 10;
+        input.ids[0][1] = input.ids[1][1] = 3;
+        const auto msg = input.pack();
+        slice->init(msg.data(), msg.size());
+        const auto up =
+            "src/64-64-64/0-4-2.f32" ";"
+            "src/64-64-64/1-4-2.f32"
+        ;
+        const auto down =
+            "src/64-64-64/0-2-2.f32" ";"
+            "src/64-64-64/1-2-2.f32"
+        ;
+        CHECK(slice->prefetch( 1) == up);
+        CHECK(slice->prefetch(-1) == down);
+        CHECK(slice->prefetch( 0) == std::string(down) + ";" + up);
+    }
+
+    SECTION("Only inside the cube") {
+        const auto msg = input.pack();
+        slice->init(msg.data(), msg.size());
+        CHECK(slice->prefetch(-1) == "");
+        CHECK(slice->prefetch( 0) == slice->prefetch(1));
+    }
+
+    SECTION("Is empty for other kinds") {
+        auto curtain = one::proc::make("curtain");
+        CHECK(curtain->prefetch(0) == "");
+    }
 }
 
 /*
@@ -154,6 +208,42 @@ TEST_CASE("slice.add is not sensitive to order") {
     CHECK_THAT(unpacked.tiles.at(1).v, Equals(expected[1]));
 }
 
+TEST_CASE("proc records stats of the task") {
+    auto input = default_slice_fetch();
+    input.ids = {
+        { 0, 0, 0 },
+        { 0, 0, 1 },
+    };
+    input.shape      = { 1, 1, 1 };
+    input.shape_cube = { 2, 2, 2 };
+
+    const auto msg = input.pack();
+    auto slice = one::proc::make("slice");
+    slice->init(msg.data(), msg.size());
+    CHECK(slice->stats().adds == 0);
+    CHECK(slice->stats().bytes_in == 0);
+
+    const float fragment[] = { 1 };
+    slice->add(0, (const char*)fragment, sizeof(fragment));
+    slice->add(1, (const char*)fragment, sizeof(fragment));
+    const auto packed = slice->pack();
+
+    const auto& stats = slice->stats();
+    CHECK(stats.adds == 2);
+    CHECK(stats.bytes_in == 2 * sizeof(float));
+    CHECK(stats.bytes_out == packed.size());
+    CHECK(stats.add_max_ms <= stats.add_ms);
+    CHECK(stats.init_ms >= 0);
+    CHECK(stats.pack_ms >= 0);
+
+    SECTION("init() resets the stats") {
+        slice->init(msg.data(), msg.size());
+        CHECK(slice->stats().adds == 0);
+        CHECK(slice->stats().bytes_in == 0);
+        CHECK(slice->stats().bytes_out == 0);
+    }
+}
+
 one::curtain_fetch default_curtain_fetch() {
     one::curtain_fetch input;
     input.pid   = "some-pid";
@@ -298,5 +388,774 @@ TEST_CASE("Curtains extracted from chunks matches hand-extracted curtain") {
 TEST_CASE("All process kinds can be constructed") {
     CHECK( one::proc::make("slice"));
     CHECK( one::proc::make("curtain"));
+    CHECK( one::proc::make("horizon"));
+    CHECK( one::proc::make("wellpath"));
+    CHECK( one::proc::make("points"));
+    CHECK( one::proc::make("polyline"));
+    CHECK( one::proc::make("area"));
+    CHECK( one::proc::make("batch"));
     CHECK(!one::proc::make("unknown"));
 }
+
+TEST_CASE("Slices are encoded with the requested format") {
+    auto input = default_slice_fetch();
+    input.dim    = 1;
+    input.lineno = 1;
+    input.ids = {
+        { 0, 0, 0 },
+        { 0, 0, 1 },
+    };
+    input.shape      = { 3, 3, 3 };
+    input.shape_cube = { 3, 3, 6 };
+    input.format     = "i16";
+
+    const auto msg = input.pack();
+    auto slice = one::proc::make("slice");
+    slice->init(msg.data(), msg.size());
+
+    auto expected = std::vector< float >();
+    for (int i = 0; i < int(input.ids.size()); ++i) {
+        auto blob = GENERATE(
+            take(1,
+                chunk(3 * 3 * 3, random(-10000.0f, 10000.0f))
+            )
+        );
+        slice->add(i,
+            reinterpret_cast< const char* >(blob.data()),
+            int(blob.size() * sizeof(float))
+        );
+        add_dim1_line(expected, blob);
+    }
+
+    auto output = unpack< one::slice_tiles >(slice->pack());
+    CHECK(output.format == "i16");
+
+    std::vector< float > extracted;
+    for (const auto& tile : output.tiles) {
+        CHECK(tile.encoded.size() == tile.v.size());
+        extracted.insert(extracted.end(), tile.v.begin(), tile.v.end());
+    }
+
+    REQUIRE(extracted.size() == expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i)
+        CHECK(extracted[i] == Catch::Detail::Approx(expected[i]).margin(0.5));
+}
+
+TEST_CASE("Curtains are encoded with the requested format") {
+    auto input = default_curtain_fetch();
+    input.ids = {
+        one::single { {0, 0, 0}, { {2, 1}, {0, 2} } },
+    };
+    input.shape      = { 3, 3, 3 };
+    input.shape_cube = { 3, 3, 3 };
+    input.format     = "f16";
+
+    const auto msg = input.pack();
+    auto curtain = one::proc::make("curtain");
+    curtain->init(msg.data(), msg.size());
+
+    std::vector< float > blob(3 * 3 * 3);
+    std::iota(blob.begin(), blob.end(), 0.0f);
+    curtain->add(0,
+        reinterpret_cast< const char* >(blob.data()),
+        int(blob.size() * sizeof(float))
+    );
+
+    auto output = unpack< one::curtain_traces >(curtain->pack());
+    CHECK(output.format == "f16");
+    REQUIRE(output.traces.size() == 2);
+    /* small integers are exactly representable in f16 */
+    CHECK_THAT(output.traces[0].v, Equals(std::vector< float >{ 21, 22, 23 }));
+    CHECK_THAT(output.traces[1].v, Equals(std::vector< float >{  6,  7,  8 }));
+}
+
+TEST_CASE("Slices are cropped to the z-range") {
+    auto input = default_slice_fetch();
+    input.dim    = 0;
+    input.lineno = 0;
+    input.shape      = { 2, 2, 4 };
+    input.shape_cube = { 2, 4, 8 };
+    input.begin[1] = 2;
+    input.end[1]   = 7;
+    input.ids = {
+        { 0, 0, 0 },
+        { 0, 0, 1 },
+        { 0, 1, 0 },
+        { 0, 1, 1 },
+    };
+
+    const auto msg = input.pack();
+    auto slice = one::proc::make("slice");
+    slice->init(msg.data(), msg.size());
+
+    /* fragment key holds 100 * key + offset */
+    for (int key = 0; key < 4; ++key) {
+        std::vector< float > blob(16);
+        std::iota(blob.begin(), blob.end(), float(100 * key));
+        slice->add(key,
+            reinterpret_cast< const char* >(blob.data()),
+            int(blob.size() * sizeof(float))
+        );
+    }
+
+    const auto output = unpack< one::slice_tiles >(slice->pack());
+    CHECK_THAT(output.shape, Equals(std::vector< int >{ 4, 5 }));
+
+    std::vector< float > extracted(4 * 5, -1);
+    for (const auto& tile : output.tiles) {
+        auto dst = tile.initial_skip;
+        auto src = 0;
+        for (int i = 0; i < tile.iterations; ++i) {
+            std::copy_n(
+                tile.v.begin() + src,
+                tile.chunk_size,
+                extracted.begin() + dst
+            );
+            src += tile.substride;
+            dst += tile.superstride;
+        }
+    }
+
+    std::vector< float > expected;
+    for (int j = 0; j < 4; ++j)
+    for (int z = 2; z < 7; ++z) {
+        const auto key = (j / 2) * 2 + (z / 4);
+        expected.push_back(100 * key + (j % 2) * 4 + (z % 4));
+    }
+    CHECK_THAT(extracted, Equals(expected));
+}
+
+TEST_CASE("Slices are cropped to the strided region of interest") {
+    auto input = default_slice_fetch();
+    input.dim    = 0;
+    input.lineno = 0;
+    input.shape      = { 2, 2, 4 };
+    input.shape_cube = { 2, 4, 8 };
+    input.begin = { 1, 1 };
+    input.end   = { 4, 8 };
+    input.step  = { 2, 3 };
+    /* crosslines 1, 3 and samples 1, 4, 7 */
+    input.ids = {
+        { 0, 0, 0 },
+        { 0, 0, 1 },
+        { 0, 1, 0 },
+        { 0, 1, 1 },
+    };
+
+    const auto msg = input.pack();
+    auto slice = one::proc::make("slice");
+    slice->init(msg.data(), msg.size());
+
+    for (int key = 0; key < 4; ++key) {
+        std::vector< float > blob(16);
+        std::iota(blob.begin(), blob.end(), float(100 * key));
+        slice->add(key,
+            reinterpret_cast< const char* >(blob.data()),
+            int(blob.size() * sizeof(float))
+        );
+    }
+
+    const auto output = unpack< one::slice_tiles >(slice->pack());
+    CHECK_THAT(output.shape, Equals(std::vector< int >{ 2, 3 }));
+
+    std::vector< float > extracted(2 * 3, -1);
+    for (const auto& tile : output.tiles) {
+        auto dst = tile.initial_skip;
+        auto src = 0;
+        for (int i = 0; i < tile.iterations; ++i) {
+            std::copy_n(
+                tile.v.begin() + src,
+                tile.chunk_size,
+                extracted.begin() + dst
+            );
+            src += tile.substride;
+            dst += tile.superstride;
+        }
+    }
+
+    CHECK_THAT(extracted, Equals(std::vector< float >{
+        /* (1, 1), (1, 4), (1, 7) */
+          0 + 4 + 1, 100 + 4 + 0, 100 + 4 + 3,
+        /* (3, 1), (3, 4), (3, 7) */
+        200 + 4 + 1, 300 + 4 + 0, 300 + 4 + 3,
+    }));
+}
+
+TEST_CASE("Curtains are cropped to the z-range") {
+    auto input = default_curtain_fetch();
+    input.shape      = { 2, 2, 4 };
+    input.shape_cube = { 2, 2, 8 };
+    input.zbegin = 3;
+    input.zend   = 6;
+    input.ids = {
+        one::single { { 0, 0, 0 }, { { 1, 1 } } },
+        one::single { { 0, 0, 1 }, { { 1, 1 } } },
+    };
+
+    const auto msg = input.pack();
+    auto curtain = one::proc::make("curtain");
+    curtain->init(msg.data(), msg.size());
+
+    for (int key = 0; key < 2; ++key) {
+        std::vector< float > blob(16);
+        std::iota(blob.begin(), blob.end(), float(100 * key));
+        curtain->add(key,
+            reinterpret_cast< const char* >(blob.data()),
+            int(blob.size() * sizeof(float))
+        );
+    }
+
+    /* trace (1, 1) is at offset 12 in the fragments */
+    const auto output = unpack< one::curtain_traces >(curtain->pack());
+    REQUIRE(output.traces.size() == 2);
+    CHECK_THAT(output.traces[0].coordinates, Equals(std::vector< int >{ 1, 1, 0 }));
+    CHECK_THAT(output.traces[0].v, Equals(std::vector< float >{ 15 }));
+    CHECK_THAT(output.traces[1].coordinates, Equals(std::vector< int >{ 1, 1, 1 }));
+    CHECK_THAT(output.traces[1].v, Equals(std::vector< float >{ 112, 113 }));
+}
+
+TEST_CASE("Horizons are assembled from the fragments of the window") {
+    auto input = one::horizon_fetch(one::horizon_task(default_curtain_fetch()));
+    input.function   = "horizon";
+    input.shape      = { 3, 3, 3 };
+    input.shape_cube = { 3, 3, 5 };
+    input.window     = 1;
+
+    one::horizon_column column;
+    column.id = { 0, 0 };
+    column.ks = { 0, 1 };
+    column.points = {
+        { 0, 1, 2, 2 },
+        { 3, 0, 0, 4 },
+    };
+    input.ids = { column };
+
+    const auto msg = input.pack();
+    auto horizon = one::proc::make("horizon");
+    horizon->init(msg.data(), msg.size());
+    CHECK(horizon->fragments() == "src/3-3-3/0-0-0.f32;src/3-3-3/0-0-1.f32");
+
+    std::vector< float > upper(3 * 3 * 3);
+    std::vector< float > lower(3 * 3 * 3);
+    std::iota(upper.begin(), upper.end(),   0.0f);
+    std::iota(lower.begin(), lower.end(), 100.0f);
+
+    /* add() is not sensitive to order */
+    horizon->add(1,
+        reinterpret_cast< const char* >(lower.data()),
+        int(lower.size() * sizeof(float))
+    );
+    horizon->add(0,
+        reinterpret_cast< const char* >(upper.data()),
+        int(upper.size() * sizeof(float))
+    );
+
+    const auto output = unpack< one::horizon_values >(horizon->pack());
+    CHECK(output.window == 3);
+    CHECK_THAT(output.index, Equals(std::vector< int >{ 0, 3 }));
+    /*
+     * The window of the first point crosses the fragment boundary, and the
+     * window of the second point goes below the cube
+     */
+    const auto expected = std::vector< float > {
+         16,  17, 115,
+        100, 101,   0,
+    };
+    CHECK_THAT(output.v, Equals(expected));
+}
+
+TEST_CASE("Slices are reduced to the requested attribute") {
+    auto input = default_slice_fetch();
+    input.dim    = 0;
+    input.lineno = 1;
+    input.ids = {
+        { 0, 0, 0 },
+        { 0, 0, 1 },
+    };
+    input.shape      = { 4, 4, 4 };
+    input.shape_cube = { 4, 4, 6 };
+    input.attribute  = "sumpos";
+    input.attribute_window = 2;
+
+    const auto msg = input.pack();
+    auto slice = one::proc::make("slice");
+    slice->init(msg.data(), msg.size());
+
+    for (int i = 0; i < int(input.ids.size()); ++i) {
+        std::vector< float > blob(4 * 4 * 4);
+        std::iota(blob.begin(), blob.end(), 100.0f * i);
+        slice->add(i,
+            reinterpret_cast< const char* >(blob.data()),
+            int(blob.size() * sizeof(float))
+        );
+    }
+
+    const auto output = unpack< one::slice_tiles >(slice->pack());
+    CHECK_THAT(output.shape, Equals(std::vector< int >{ 4, 3 }));
+    REQUIRE(output.tiles.size() == 2);
+
+    const auto& upper = output.tiles[0];
+    const auto& lower = output.tiles[1];
+    CHECK_THAT(upper.v, Equals(std::vector< float >{
+        33, 37, 41, 45, 49, 53, 57, 61,
+    }));
+    /* only 2 of the 4 samples of the lower fragment are in the cube */
+    CHECK_THAT(lower.v, Equals(std::vector< float >{
+        233, 0, 241, 0, 249, 0, 257, 0,
+    }));
+    CHECK(upper.chunk_size == 2);
+    CHECK(lower.chunk_size == 1);
+}
+
+TEST_CASE("Curtains are reduced to the requested attribute") {
+    auto input = default_curtain_fetch();
+    input.ids = {
+        one::single { {0, 0, 0}, { {2, 1} } },
+        one::single { {0, 0, 1}, { {2, 1} } },
+    };
+    input.shape      = { 3, 3, 3 };
+    input.shape_cube = { 3, 3, 5 };
+    input.attribute  = "maxabs";
+    input.attribute_window = 3;
+
+    const auto msg = input.pack();
+    auto curtain = one::proc::make("curtain");
+    curtain->init(msg.data(), msg.size());
+
+    std::vector< float > upper(3 * 3 * 3);
+    std::vector< float > lower(3 * 3 * 3);
+    std::iota(upper.begin(), upper.end(), -13.0f);
+    std::iota(lower.begin(), lower.end(), -30.0f);
+    curtain->add(0,
+        reinterpret_cast< const char* >(upper.data()),
+        int(upper.size() * sizeof(float))
+    );
+    curtain->add(1,
+        reinterpret_cast< const char* >(lower.data()),
+        int(lower.size() * sizeof(float))
+    );
+
+    const auto output = unpack< one::curtain_traces >(curtain->pack());
+    REQUIRE(output.traces.size() == 2);
+    CHECK_THAT(output.traces[0].v, Equals(std::vector< float >{ 10 }));
+    CHECK_THAT(output.traces[1].v, Equals(std::vector< float >{  9 }));
+    CHECK_THAT(
+        output.traces[1].coordinates,
+        Equals(std::vector< int >{ 2, 1, 1 })
+    );
+}
+
+TEST_CASE("Horizon windows are reduced to the requested attribute") {
+    auto input = one::horizon_fetch(one::horizon_task(default_curtain_fetch()));
+    input.function   = "horizon";
+    input.shape      = { 3, 3, 3 };
+    input.shape_cube = { 3, 3, 3 };
+    input.window     = 1;
+    input.attribute  = "mean";
+
+    one::horizon_column column;
+    column.id = { 0, 0 };
+    column.ks = { 0 };
+    column.points = {
+        { 0, 0, 0, 1 },
+        { 1, 0, 0, 2 },
+    };
+    input.ids = { column };
+
+    const auto msg = input.pack();
+    auto horizon = one::proc::make("horizon");
+    horizon->init(msg.data(), msg.size());
+
+    std::vector< float > blob(3 * 3 * 3);
+    std::iota(blob.begin(), blob.end(), 1.0f);
+    horizon->add(0,
+        reinterpret_cast< const char* >(blob.data()),
+        int(blob.size() * sizeof(float))
+    );
+
+    const auto output = unpack< one::horizon_values >(horizon->pack());
+    CHECK(output.window == 1);
+    /* the window of the second point is clipped to the cube */
+    CHECK_THAT(output.v, Equals(std::vector< float >{ 2, 2.5 }));
+}
+
+TEST_CASE("Well paths are interpolated across fragment boundaries") {
+    auto input = one::wellpath_fetch(one::wellpath_task(default_curtain_fetch()));
+    input.function    = "wellpath";
+    input.coordinates = "grid";
+    input.shape       = { 2, 2, 2 };
+    input.shape_cube  = { 4, 4, 4 };
+    input.points = {
+        { 1.5f,  1.5f, 1.5f },
+        { 0.25f, 3.0f, 2.0f },
+    };
+    input.index = { 4, 9 };
+    for (int i = 0; i < 2; ++i)
+    for (int j = 0; j < 2; ++j)
+    for (int k = 0; k < 2; ++k)
+        input.ids.push_back({ i, j, k });
+
+    const auto msg = input.pack();
+    auto wellpath = one::proc::make("wellpath");
+    wellpath->init(msg.data(), msg.size());
+
+    /*
+     * The samples are a linear function of the position, which trilinear
+     * interpolation reproduces exactly
+     */
+    const auto f = [](int i, int j, int k) {
+        return float(100 * i + 10 * j + k);
+    };
+    for (int key = 0; key < int(input.ids.size()); ++key) {
+        const auto& id = input.ids[key];
+        std::vector< float > blob;
+        for (int i = 0; i < 2; ++i)
+        for (int j = 0; j < 2; ++j)
+        for (int k = 0; k < 2; ++k)
+            blob.push_back(f(id[0] * 2 + i, id[1] * 2 + j, id[2] * 2 + k));
+
+        wellpath->add(key,
+            reinterpret_cast< const char* >(blob.data()),
+            int(blob.size() * sizeof(float))
+        );
+    }
+
+    const auto output = unpack< one::point_values >(wellpath->pack());
+    CHECK_THAT(output.index, Equals(std::vector< int >{ 4, 9 }));
+    REQUIRE(output.v.size() == 2);
+    CHECK(output.v[0] == Catch::Detail::Approx(166.5));
+    CHECK(output.v[1] == Catch::Detail::Approx(57));
+}
+
+TEST_CASE("Tasks of only absent fragments are packed without fragments") {
+    SECTION("slices have no tiles") {
+        auto input = default_slice_fetch();
+        input.dim    = 0;
+        input.lineno = 1;
+        input.ids.clear();
+        input.shape      = { 3, 3, 3 };
+        input.shape_cube = { 5, 5, 5 };
+        /* 2 x 2 columns, where none are stored */
+        input.fragment_mask = "00";
+        input.fill_value    = -1;
+
+        const auto msg = input.pack();
+        auto slice = one::proc::make("slice");
+        slice->init(msg.data(), msg.size());
+        CHECK(slice->fragments().empty());
+
+        const auto output = unpack< one::slice_tiles >(slice->pack());
+        CHECK(output.tiles.empty());
+        CHECK(slice->stats().adds == 0);
+    }
+
+    SECTION("well paths are the fill value") {
+        auto input = one::wellpath_fetch(
+            one::wellpath_task(default_curtain_fetch())
+        );
+        input.function    = "wellpath";
+        input.coordinates = "grid";
+        input.shape       = { 2, 2, 2 };
+        input.shape_cube  = { 4, 4, 4 };
+        input.points = {
+            { 1.5f,  1.5f, 1.5f },
+            { 0.25f, 3.0f, 2.0f },
+        };
+        input.index = { 4, 9 };
+        input.fragment_mask = "00";
+        input.fill_value    = -1;
+
+        const auto msg = input.pack();
+        auto wellpath = one::proc::make("wellpath");
+        wellpath->init(msg.data(), msg.size());
+        CHECK(wellpath->fragments().empty());
+
+        const auto output = unpack< one::point_values >(wellpath->pack());
+        CHECK_THAT(output.v, Equals(std::vector< float >{ -1, -1 }));
+    }
+}
+
+TEST_CASE("Polyline traces are interpolated across fragment boundaries") {
+    auto input = one::polyline_fetch(one::polyline_task(default_curtain_fetch()));
+    input.function    = "polyline";
+    input.coordinates = "grid";
+    input.shape       = { 2, 2, 2 };
+    input.shape_cube  = { 4, 4, 3 };
+    input.points = {
+        { 1.5f, 0.5f },
+        { 3.0f, 2.0f },
+    };
+    input.index = { 7, 8 };
+    for (int i = 0; i < 2; ++i)
+    for (int j = 0; j < 2; ++j)
+    for (int k = 0; k < 2; ++k)
+        input.ids.push_back({ i, j, k });
+
+    const auto msg = input.pack();
+    auto polyline = one::proc::make("polyline");
+    polyline->init(msg.data(), msg.size());
+
+    /*
+     * The samples are a linear function of the position, which bilinear
+     * interpolation reproduces exactly
+     */
+    const auto f = [](int i, int j, int k) {
+        return float(100 * i + 10 * j + k);
+    };
+    for (int key = 0; key < int(input.ids.size()); ++key) {
+        const auto& id = input.ids[key];
+        std::vector< float > blob;
+        for (int i = 0; i < 2; ++i)
+        for (int j = 0; j < 2; ++j)
+        for (int k = 0; k < 2; ++k)
+            blob.push_back(f(id[0] * 2 + i, id[1] * 2 + j, id[2] * 2 + k));
+
+        polyline->add(key,
+            reinterpret_cast< const char* >(blob.data()),
+            int(blob.size() * sizeof(float))
+        );
+    }
+
+    const auto output = unpack< one::polyline_traces >(polyline->pack());
+    CHECK_THAT(output.index, Equals(std::vector< int >{ 7, 8 }));
+    /* the padding below the cube is not part of the trace */
+    CHECK(output.samples == 3);
+    REQUIRE(output.v.size() == 6);
+    const auto expected = std::vector< float > {
+        155, 156, 157,
+        320, 321, 322,
+    };
+    for (std::size_t i = 0; i < expected.size(); ++i)
+        CHECK(output.v[i] == Catch::Detail::Approx(expected[i]));
+}
+
+TEST_CASE("Points are gathered from their fragments") {
+    auto input = one::points_fetch(one::points_task(default_curtain_fetch()));
+    input.function    = "points";
+    input.coordinates = "grid";
+    input.shape       = { 2, 2, 2 };
+    input.shape_cube  = { 4, 4, 4 };
+
+    one::points_fragment first;
+    first.id      = { 0, 0, 0 };
+    first.offsets = { 7, 0 };
+    first.index   = { 2, 5 };
+    one::points_fragment second;
+    second.id      = { 1, 0, 1 };
+    second.offsets = { 1 };
+    second.index   = { 3 };
+    input.ids = { first, second };
+
+    const auto msg = input.pack();
+    auto points = one::proc::make("points");
+    points->init(msg.data(), msg.size());
+
+    for (int key = 0; key < 2; ++key) {
+        std::vector< float > blob(8);
+        std::iota(blob.begin(), blob.end(), float(10 * key));
+        points->add(key,
+            reinterpret_cast< const char* >(blob.data()),
+            int(blob.size() * sizeof(float))
+        );
+    }
+
+    const auto output = unpack< one::point_values >(points->pack());
+    CHECK_THAT(output.index, Equals(std::vector< int >{ 2, 5, 3 }));
+    CHECK_THAT(output.v,     Equals(std::vector< float >{ 7, 0, 11 }));
+}
+
+TEST_CASE("Area traces are gathered from the masked fragments") {
+    auto input = one::area_fetch(one::area_task(default_curtain_fetch()));
+    input.function   = "area";
+    input.shape      = { 2, 2, 2 };
+    input.shape_cube = { 4, 4, 4 };
+    input.polygon    = { { 0, 0 }, { 0, 3 }, { 3, 3 } };
+    input.zbegin = 1;
+    input.zend   = 4;
+
+    /* the traces (0, 1) and (1, 0) of column (0, 0), and (2, 3) */
+    one::area_column first;
+    first.id   = { 0, 0 };
+    first.ks   = { 0, 1 };
+    first.mask = { 0b0110 };
+    one::area_column second;
+    second.id   = { 1, 1 };
+    second.ks   = { 0, 1 };
+    second.mask = { 0b0010 };
+    input.ids = { first, second };
+
+    const auto msg = input.pack();
+    auto area = one::proc::make("area");
+    area->init(msg.data(), msg.size());
+
+    /* fragment key holds 10 * key + offset, and the offset of (b, z) is 2b + z */
+    for (int key = 0; key < 4; ++key) {
+        std::vector< float > blob(8);
+        std::iota(blob.begin(), blob.end(), float(10 * key));
+        area->add(key,
+            reinterpret_cast< const char* >(blob.data()),
+            int(blob.size() * sizeof(float))
+        );
+    }
+
+    const auto output = unpack< one::area_traces >(area->pack());
+    CHECK_THAT(output.dim0s, Equals(std::vector< int >{ 0, 1, 2 }));
+    CHECK_THAT(output.dim1s, Equals(std::vector< int >{ 1, 0, 3 }));
+    CHECK(output.samples == 3);
+    CHECK_THAT(output.v, Equals(std::vector< float >{
+         3, 12, 13,
+         5, 14, 15,
+        23, 32, 33,
+    }));
+}
+
+TEST_CASE("Batches read shared fragments once for all the queries") {
+    /* inline 0, and a curtain along crossline 1 of inline 0 */
+    auto slice = default_slice_fetch();
+    slice.shape      = { 1, 1, 1 };
+    slice.shape_cube = { 2, 2, 2 };
+    slice.ids = {
+        { 0, 0, 0 },
+        { 0, 0, 1 },
+        { 0, 1, 0 },
+        { 0, 1, 1 },
+    };
+
+    auto curtain = default_curtain_fetch();
+    curtain.shape      = { 1, 1, 1 };
+    curtain.shape_cube = { 2, 2, 2 };
+    curtain.ids = {
+        one::single { { 0, 1, 0 }, { { 0, 0 } } },
+        one::single { { 0, 1, 1 }, { { 0, 0 } } },
+    };
+
+    auto input = one::batch_fetch(slice);
+    input.function = "batch";
+    input.queries = {
+        one::batch_query { "slice-pid",   "0/1", "slice",   slice.pack()   },
+        one::batch_query { "curtain-pid", "2/3", "curtain", curtain.pack() },
+    };
+
+    const auto msg = input.pack();
+    auto batch = one::proc::make("batch");
+    batch->init(msg.data(), msg.size());
+    const auto expected =
+        "src/1-1-1/0-0-0.f32" ";"
+        "src/1-1-1/0-0-1.f32" ";"
+        "src/1-1-1/0-1-0.f32" ";"
+        "src/1-1-1/0-1-1.f32"
+    ;
+    CHECK(batch->fragments() == expected);
+
+    /* the queries on their own, for reference */
+    const auto slicemsg   = slice.pack();
+    const auto curtainmsg = curtain.pack();
+    auto sliceproc   = one::proc::make("slice");
+    auto curtainproc = one::proc::make("curtain");
+    sliceproc  ->init(slicemsg.data(),   slicemsg.size());
+    curtainproc->init(curtainmsg.data(), curtainmsg.size());
+
+    for (int key = 0; key < 4; ++key) {
+        const auto blob = float(key);
+        const auto* chunk = reinterpret_cast< const char* >(&blob);
+        batch->add(key, chunk, sizeof(blob));
+        sliceproc->add(key, chunk, sizeof(blob));
+        if (key >= 2)
+            curtainproc->add(key - 2, chunk, sizeof(blob));
+    }
+
+    const auto output = unpack< one::batch_results >(batch->pack());
+    REQUIRE(output.results.size() == 2);
+    CHECK(output.results[0].pid  == "slice-pid");
+    CHECK(output.results[0].part == "0/1");
+    CHECK(output.results[0].body == sliceproc->pack());
+    CHECK(output.results[1].pid  == "curtain-pid");
+    CHECK(output.results[1].part == "2/3");
+    CHECK(output.results[1].body == curtainproc->pack());
+    CHECK(batch->stats().adds == 4);
+}
+
+namespace {
+
+/*
+ * A fragment stats sidecar record, see the summary proc
+ */
+void append_stats(
+    std::string& sidecar,
+    std::array< float, 4 > summary,
+    std::vector< std::uint32_t > histogram
+) {
+    const auto count = std::accumulate(
+        histogram.begin(),
+        histogram.end(),
+        std::uint32_t(0)
+    );
+    const auto* s = reinterpret_cast< const char* >(summary.data());
+    const auto* c = reinterpret_cast< const char* >(&count);
+    const auto* h = reinterpret_cast< const char* >(histogram.data());
+    sidecar.append(s, sizeof(summary));
+    sidecar.append(c, sizeof(count));
+    sidecar.append(h, histogram.size() * sizeof(std::uint32_t));
+}
+
+}
+
+TEST_CASE("Stats are merged from the fragment stats sidecar") {
+    one::stats_fetch input;
+    input.pid   = "some-pid";
+    input.token = "some-token";
+    input.guid  = "some-guid";
+    input.storage_endpoint = "some-endpoint";
+    input.function   = "stats";
+    input.shape      = { 1, 1, 1 };
+    input.shape_cube = { 2, 1, 1 };
+    input.sidecar_bins = 2;
+    input.bins = 4;
+
+    std::string sidecar;
+    append_stats(sidecar, { 0, 2, 1, 1.5 }, { 2, 2 });
+    append_stats(sidecar, { 2, 4, 3, 3.0 }, { 4, 0 });
+
+    auto stats = one::proc::make("stats");
+
+    SECTION("for the whole cube") {
+        const auto msg = input.pack();
+        stats->init(msg.data(), msg.size());
+        CHECK(stats->fragments() == "src/1-1-1/stats.bin");
+        stats->add(0, sidecar.data(), sidecar.size());
+
+        const auto output = unpack< one::stats_values >(stats->pack());
+        CHECK(output.count == 8);
+        CHECK(output.min  == 0);
+        CHECK(output.max  == 4);
+        CHECK(output.mean == 2);
+        const auto rms = std::sqrt((4 * 2.25 + 4 * 9.0) / 8);
+        CHECK(output.rms == Catch::Detail::Approx(rms));
+        CHECK_THAT(output.edges, Equals(std::vector< float >{ 0, 1, 2, 3, 4 }));
+        CHECK_THAT(output.counts, Equals(std::vector< std::int64_t >{
+            2, 2, 4, 0
+        }));
+    }
+
+    SECTION("for a layer of fragments") {
+        input.dim   = 0;
+        input.layer = 1;
+        input.bins  = 2;
+        const auto msg = input.pack();
+        stats->init(msg.data(), msg.size());
+        stats->add(0, sidecar.data(), sidecar.size());
+
+        const auto output = unpack< one::stats_values >(stats->pack());
+        CHECK(output.count == 4);
+        CHECK(output.min  == 2);
+        CHECK(output.mean == 3);
+        CHECK_THAT(output.edges, Equals(std::vector< float >{ 2, 3, 4 }));
+        CHECK_THAT(output.counts, Equals(std::vector< std::int64_t >{ 4, 0 }));
+    }
+
+    SECTION("sidecars of the wrong size fail") {
+        const auto msg = input.pack();
+        stats->init(msg.data(), msg.size());
+        CHECK_THROWS(stats->add(0, sidecar.data(), sidecar.size() - 1));
+    }
+}
@@ -0,0 +1,153 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <nlohmann/json.hpp>
+
+#include <oneseismic/scan.hpp>
+
+using namespace Catch::Matchers;
+
+namespace {
+
+void put(std::string& dst, std::size_t pos, int size, std::int32_t x,
+         bool big_endian) {
+    const auto u = std::uint32_t(x);
+    for (int i = 0; i < size; ++i) {
+        const auto shift = big_endian ? 8 * (size - 1 - i) : 8 * i;
+        dst[pos + i] = char(u >> shift);
+    }
+}
+
+/*
+ * A SEG-Y file of inline 1-3 and crossline 10-13, inline sorted, with 5
+ * samples of 4 ms and the trace coordinates
+ *
+ *      x = 100000 + 250 * (il - 1) +  10 * (xl - 10)
+ *      y = 200000 +   5 * (il - 1) + 250 * (xl - 10)
+ *
+ * stored in decimetres, with coordinate scalar -10
+ */
+std::string mksegy(bool big_endian, int binary_samples = 5) {
+    std::string segy(3600, '\0');
+    put(segy, 3216, 2, 4000,           big_endian);
+    put(segy, 3220, 2, binary_samples, big_endian);
+    put(segy, 3224, 2, 5,              big_endian);
+
+    for (int il = 1; il <= 3; ++il) {
+        for (int xl = 10; xl <= 13; ++xl) {
+            std::string trace(240 + 5 * 4, '\0');
+            put(trace, 188, 4, il, big_endian);
+            put(trace, 192, 4, xl, big_endian);
+            put(trace,  70, 2, -10, big_endian);
+            put(trace, 114, 2, 5, big_endian);
+            put(trace, 116, 2, 4000, big_endian);
+
+            const auto x = 100000 + 250 * (il - 1) +  10 * (xl - 10);
+            const auto y = 200000 +   5 * (il - 1) + 250 * (xl - 10);
+            put(trace, 180, 4, x * 10, big_endian);
+            put(trace, 184, 4, y * 10, big_endian);
+            segy += trace;
+        }
+    }
+    return segy;
+}
+
+nlohmann::json scan(const std::string& segy, const one::scan_options& opts) {
+    return nlohmann::json::parse(one::scan(segy.data(), segy.size(), opts));
+}
+
+}
+
+TEST_CASE("sha1 matches the FIPS 180 test vectors") {
+    CHECK(one::sha1("", 0) == "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+    CHECK(one::sha1("abc", 3) == "a9993e364706816aba3e25717850c26c9cd0d89d");
+
+    const std::string two_blocks =
+        "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    CHECK(one::sha1(two_blocks.data(), two_blocks.size())
+        == "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+
+    const std::string million(1000000, 'a');
+    CHECK(one::sha1(million.data(), million.size())
+        == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+}
+
+TEST_CASE("Scan reports the layout and line numbers of the file") {
+    const auto segy = mksegy(true);
+    const auto report = scan(segy, one::scan_options());
+
+    CHECK(report["byteorder"] == "big");
+    CHECK(report["format"] == 5);
+    CHECK(report["samples"] == 5);
+    CHECK(report["sampleinterval"] == 4000);
+    CHECK(report["byteoffset-first-trace"] == 3600);
+    CHECK(report["key-words"] == nlohmann::json({ 189, 193 }));
+    CHECK(report["dimensions"] == nlohmann::json({
+        { 1, 2, 3 },
+        { 10, 11, 12, 13 },
+        { 0, 4000, 8000, 12000, 16000 },
+    }));
+    CHECK(report["key1-last-trace"] == nlohmann::json({
+        { "1", 3 },
+        { "2", 7 },
+        { "3", 11 },
+    }));
+    CHECK(report["guid"] == one::sha1(segy.data(), segy.size()));
+
+    const auto t = report["transform"].get< std::vector< double > >();
+    REQUIRE(t.size() == 6);
+    CHECK_THAT(t[0], WithinAbs(100000, 1e-6));
+    CHECK_THAT(t[1], WithinAbs(250,    1e-6));
+    CHECK_THAT(t[2], WithinAbs(10,     1e-6));
+    CHECK_THAT(t[3], WithinAbs(200000, 1e-6));
+    CHECK_THAT(t[4], WithinAbs(5,      1e-6));
+    CHECK_THAT(t[5], WithinAbs(250,    1e-6));
+}
+
+TEST_CASE("Scan reports the same for any number of threads") {
+    const auto segy = mksegy(true);
+    auto opts = one::scan_options();
+    const auto single = scan(segy, opts);
+
+    opts.threads = GENERATE(2, 5, 16);
+    CHECK(scan(segy, opts) == single);
+}
+
+TEST_CASE("The sha1-tree guid does not depend on the number of threads") {
+    const auto segy = mksegy(true);
+    auto opts = one::scan_options();
+    opts.digest = "sha1-tree";
+    const auto single = scan(segy, opts)["guid"];
+    CHECK(single != one::sha1(segy.data(), segy.size()));
+
+    opts.threads = 4;
+    CHECK(scan(segy, opts)["guid"] == single);
+}
+
+TEST_CASE("Scan reads little endian files") {
+    const auto big    = scan(mksegy(true),  one::scan_options());
+    auto opts = one::scan_options();
+    opts.big_endian = false;
+    const auto little = scan(mksegy(false), opts);
+
+    CHECK(little["byteorder"] == "little");
+    CHECK(little["dimensions"] == big["dimensions"]);
+    CHECK(little["key1-last-trace"] == big["key1-last-trace"]);
+}
+
+TEST_CASE("Samples fall back to the first trace header") {
+    const auto report = scan(mksegy(true, 0), one::scan_options());
+    CHECK(report["samples"] == 5);
+}
+
+TEST_CASE("Truncated files and unknown digests are rejected") {
+    auto segy = mksegy(true);
+    segy.pop_back();
+    CHECK_THROWS_AS(scan(segy, one::scan_options()), std::invalid_argument);
+
+    auto opts = one::scan_options();
+    opts.digest = "md5";
+    CHECK_THROWS_AS(scan(mksegy(true), opts), std::invalid_argument);
+}
@@ -0,0 +1,71 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <catch/catch.hpp>
+
+#include <oneseismic/plan.hpp>
+#include <oneseismic/source.hpp>
+
+namespace {
+
+std::string as_string(const one::blob& b) {
+    return std::string(b.data(), b.size());
+}
+
+/*
+ * A single object written to a scratch directory (the working directory of
+ * the test runner), removed again when the fixture goes out of scope.
+ */
+struct scratch_object {
+    std::string name = "oneseismic-source-test.f32";
+
+    scratch_object(const std::string& contents) {
+        std::ofstream(this->name, std::ios::binary) << contents;
+    }
+
+    ~scratch_object() {
+        std::remove(this->name.c_str());
+    }
+};
+
+}
+
+TEST_CASE("memory source returns put objects") {
+    one::memory_source source;
+    source.put("guid/manifest.json", "{}");
+    source.put("guid/src/1-1-1/0-0-0.f32", std::string(4, '\0'));
+
+    CHECK(as_string(source.get("guid/manifest.json")) == "{}");
+    CHECK(source.get("guid/src/1-1-1/0-0-0.f32").size() == 4);
+    CHECK_THROWS_AS(source.get("guid/src/1-1-1/0-0-1.f32"), one::not_found);
+}
+
+TEST_CASE("blobs outlive the objects they were read from") {
+    one::memory_source source;
+    source.put("x", "first");
+    const auto first = source.get("x");
+    source.put("x", "second");
+    CHECK(as_string(first) == "first");
+    CHECK(as_string(source.get("x")) == "second");
+}
+
+TEST_CASE("file-backed sources read the same bytes") {
+    const auto contents = std::string("\x01\x02\x00\x04 fragment", 13);
+    scratch_object obj(contents);
+
+    const auto kind = GENERATE(
+        std::string("filesystem"),
+        std::string("mmap"),
+        std::string("memory")
+    );
+    auto source = one::make_source(kind, ".");
+    CHECK(as_string(source->get(obj.name)) == contents);
+    /* mmap and memory cache, so read twice */
+    CHECK(as_string(source->get(obj.name)) == contents);
+    CHECK_THROWS_AS(source->get("no-such-object.f32"), one::not_found);
+}
+
+TEST_CASE("unknown source kinds are rejected") {
+    CHECK_THROWS_AS(one::make_source("blob", "."), std::invalid_argument);
+}
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <catch/catch.hpp>
+#include <nlohmann/json.hpp>
+
+#include <oneseismic/messages.hpp>
+#include <oneseismic/process.hpp>
+#include <oneseismic/tracing.hpp>
+
+TEST_CASE("Spans are recorded into the current recorder") {
+    one::tracing::recorder rec;
+    {
+        one::tracing::scope scope(&rec);
+        one::tracing::span span("cat", "name");
+    }
+
+    const auto evs = rec.events();
+    REQUIRE(evs.size() == 1);
+    CHECK(std::string(evs[0].category) == "cat");
+    CHECK(std::string(evs[0].name) == "name");
+    CHECK(evs[0].ts > 0);
+    CHECK(evs[0].dur >= 0);
+}
+
+TEST_CASE("Spans without a current recorder are not recorded") {
+    one::tracing::recorder rec;
+    {
+        one::tracing::span span("cat", "name");
+    }
+    {
+        one::tracing::scope scope(&rec);
+    }
+    one::tracing::span span("cat", "after-scope");
+    CHECK(rec.events().empty());
+    CHECK(one::tracing::current() == nullptr);
+}
+
+TEST_CASE("Nested scopes restore the previous recorder") {
+    one::tracing::recorder outer;
+    one::tracing::recorder inner;
+    {
+        one::tracing::scope s1(&outer);
+        {
+            one::tracing::scope s2(&inner);
+            one::tracing::span span("cat", "inner");
+        }
+        one::tracing::span span("cat", "outer");
+    }
+
+    REQUIRE(inner.events().size() == 1);
+    REQUIRE(outer.events().size() == 1);
+    CHECK(std::string(inner.events()[0].name) == "inner");
+    CHECK(std::string(outer.events()[0].name) == "outer");
+}
+
+TEST_CASE("Recorders export chrome trace events tagged with pid and part") {
+    one::tracing::recorder rec;
+    {
+        one::tracing::scope scope(&rec);
+        one::tracing::span span("proc", "add");
+    }
+
+    const auto doc = nlohmann::json::parse(rec.chrome_json("some-pid", "0/2"));
+    REQUIRE(doc.is_array());
+    REQUIRE(doc.size() == 3);
+
+    const auto& process_name = doc[0];
+    const auto& thread_name  = doc[1];
+    const auto& span         = doc[2];
+    CHECK(process_name["ph"] == "M");
+    CHECK(process_name["args"]["name"] == "some-pid");
+    CHECK(thread_name["ph"] == "M");
+    CHECK(thread_name["args"]["name"] == "0/2");
+
+    CHECK(span["ph"] == "X");
+    CHECK(span["cat"] == "proc");
+    CHECK(span["name"] == "add");
+    CHECK(span["args"]["pid"] == "some-pid");
+    CHECK(span["args"]["part"] == "0/2");
+    CHECK(span["pid"] == process_name["pid"]);
+    CHECK(span["tid"] == thread_name["tid"]);
+
+    SECTION("The same part maps to the same track in every export") {
+        one::tracing::recorder other;
+        {
+            one::tracing::scope scope(&other);
+            one::tracing::span span("proc", "pack");
+        }
+        const auto odoc = nlohmann::json::parse(
+            other.chrome_json("some-pid", "0/2")
+        );
+        CHECK(odoc[2]["pid"] == span["pid"]);
+        CHECK(odoc[2]["tid"] == span["tid"]);
+    }
+
+    SECTION("Exports can be merged") {
+        const auto merged = one::tracing::merge({
+            rec.chrome_json("some-pid", "0/2"),
+            rec.chrome_json("some-pid", "1/2"),
+            one::tracing::recorder().chrome_json("some-pid", "plan"),
+        });
+        CHECK(nlohmann::json::parse(merged).size() == 6);
+    }
+}
+
+TEST_CASE("Empty recorders export an empty array") {
+    one::tracing::recorder rec;
+    CHECK(rec.chrome_json("pid", "part") == "[]");
+}
+
+#ifdef ONESEISMIC_TRACING
+TEST_CASE("proc records spans of init, add and pack") {
+    one::slice_fetch input;
+    input.pid        = "some-pid";
+    input.guid       = "some-guid";
+    input.storage_endpoint = "some-endpoint";
+    input.shape      = { 1, 1, 1 };
+    input.shape_cube = { 1, 1, 1 };
+    input.dim        = 0;
+    input.lineno     = 0;
+    input.ids        = { { 0, 0, 0 } };
+
+    const auto msg = input.pack();
+    auto slice = one::proc::make("slice");
+    slice->init(msg.data(), msg.size());
+    const float fragment[] = { 1 };
+    slice->add(0, (const char*)fragment, sizeof(fragment));
+    slice->pack();
+
+    std::vector< std::string > names;
+    for (const auto& ev : slice->tracer().events())
+        names.push_back(ev.name);
+    CHECK(std::count(names.begin(), names.end(), "slice_fetch::unpack") == 1);
+    CHECK(std::count(names.begin(), names.end(), "init") == 1);
+    CHECK(std::count(names.begin(), names.end(), "add") == 1);
+    CHECK(std::count(names.begin(), names.end(), "pack") == 1);
+    CHECK(std::count(names.begin(), names.end(), "slice_tiles::pack") == 1);
+}
+#endif
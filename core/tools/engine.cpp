@@ -0,0 +1,259 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include <oneseismic/plan.hpp>
+#include <oneseismic/process.hpp>
+#include <oneseismic/tracing.hpp>
+
+#include "engine.hpp"
+
+namespace one {
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+double ms_since(clock::time_point start) noexcept (true) {
+    const auto elapsed = clock::now() - start;
+    return std::chrono::duration< double, std::milli >(elapsed).count();
+}
+
+std::vector< std::string > split(const std::string& s, char delim) {
+    std::vector< std::string > xs;
+    if (s.empty())
+        return xs;
+
+    std::string::size_type fst = 0;
+    while (true) {
+        const auto lst = s.find(delim, fst);
+        xs.push_back(s.substr(fst, lst - fst));
+        if (lst == std::string::npos)
+            return xs;
+        fst = lst + 1;
+    }
+}
+
+/*
+ * msgpack array header, for arrays of (already packed) elements
+ */
+void write_array_header(std::ostream& os, std::uint32_t n) noexcept (false) {
+    if (n < 16) {
+        os.put(char(0x90 | n));
+        return;
+    }
+
+    const char head[] = {
+        char(0xDD),
+        char((n >> 24) & 0xFF),
+        char((n >> 16) & 0xFF),
+        char((n >>  8) & 0xFF),
+        char((n >>  0) & 0xFF),
+    };
+    os.write(head, sizeof(head));
+}
+
+}
+
+thread_pool::thread_pool(int threads) {
+    if (threads < 1)
+        throw std::invalid_argument("thread_pool: threads must be >= 1");
+
+    for (int i = 0; i < threads; ++i) {
+        this->workers.emplace_back([this] {
+            while (true) {
+                std::packaged_task< void() > job;
+                {
+                    std::unique_lock< std::mutex > lock(this->mtx);
+                    this->cv.wait(lock, [this] {
+                        return this->done or not this->jobs.empty();
+                    });
+                    if (this->jobs.empty())
+                        return;
+                    job = std::move(this->jobs.front());
+                    this->jobs.pop();
+                }
+                job();
+            }
+        });
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard< std::mutex > lock(this->mtx);
+        this->done = true;
+    }
+    this->cv.notify_all();
+    for (auto& worker : this->workers)
+        worker.join();
+}
+
+std::future< void > thread_pool::submit(std::function< void() > job)
+noexcept (false) {
+    std::packaged_task< void() > task(std::move(job));
+    auto future = task.get_future();
+    {
+        std::lock_guard< std::mutex > lock(this->mtx);
+        this->jobs.push(std::move(task));
+    }
+    this->cv.notify_one();
+    return future;
+}
+
+int thread_pool::size() const noexcept (true) {
+    return int(this->workers.size());
+}
+
+engine::engine(fragment_source& source, thread_pool& pool, int task_size) :
+    source(source),
+    pool(pool),
+    task_size(task_size)
+{}
+
+query_result engine::run(const std::string& query, query_stats* stats)
+noexcept (false) {
+    const auto doc = nlohmann::json::parse(query);
+    const std::string function = doc.at("function");
+    const std::string guid     = doc.at("guid");
+
+    tracing::recorder plan_spans;
+    auto start = clock::now();
+    auto sched = [&] {
+        tracing::scope trace(&plan_spans);
+        return one::mkschedule(query.data(), query.size(), this->task_size);
+    }();
+    const auto plan_ms = ms_since(start);
+    const std::string pid = doc.at("pid");
+
+    query_result result;
+    const auto& packed_head = sched.back();
+    result.header.unpack(
+        packed_head.data(),
+        packed_head.data() + packed_head.size()
+    );
+    sched.pop_back();
+    result.bundles.resize(sched.size());
+
+    std::atomic< std::size_t > fragments(0);
+    std::atomic< std::size_t > bytes(0);
+    std::vector< double > fetch_ms(sched.size());
+    std::vector< double > add_ms(sched.size());
+    std::vector< double > pack_ms(sched.size());
+    std::vector< std::string > traces(sched.size() + 1);
+    traces.back() = plan_spans.chrome_json(pid, "plan");
+
+    start = clock::now();
+    std::vector< std::future< void > > pending;
+    pending.reserve(sched.size());
+    for (std::size_t i = 0; i < sched.size(); ++i) {
+        pending.push_back(this->pool.submit([&, i] {
+            const auto& task = sched[i];
+            auto proc = one::proc::make(function);
+            if (!proc)
+                throw std::invalid_argument("no process for " + function);
+
+            proc->init(task.data(), int(task.size()));
+            const auto ids = split(proc->fragments(), ';');
+            for (int key = 0; key < int(ids.size()); ++key) {
+                auto t0 = clock::now();
+                const auto frag = this->source.get(guid + "/" + ids[key]);
+                fetch_ms[i] += ms_since(t0);
+
+                t0 = clock::now();
+                proc->add(key, frag.data(), int(frag.size()));
+                add_ms[i] += ms_since(t0);
+                bytes += frag.size();
+            }
+            fragments += ids.size();
+
+            const auto t0 = clock::now();
+            result.bundles[i] = proc->pack();
+            pack_ms[i] = ms_since(t0);
+
+            const auto part = fmt::format("{}/{}", i, sched.size());
+            traces[i] = proc->tracer().chrome_json(pid, part);
+        }));
+    }
+
+    /*
+     * Wait for all the tasks before re-raising any errors, as the jobs refer
+     * to the schedule and result on this stack frame
+     */
+    for (auto& job : pending)
+        job.wait();
+    for (auto& job : pending)
+        job.get();
+
+    if (stats) {
+        stats->plan_ms    = plan_ms;
+        stats->execute_ms = ms_since(start);
+        stats->tasks      = sched.size();
+        stats->fragments  = fragments;
+        stats->bytes      = bytes;
+        stats->fetch_ms   = std::move(fetch_ms);
+        stats->add_ms     = std::move(add_ms);
+        stats->pack_ms    = std::move(pack_ms);
+        stats->trace      = tracing::merge(traces);
+    }
+    return result;
+}
+
+std::vector< int > parse_ints(const std::string& s) noexcept (false) {
+    std::vector< int > xs;
+    for (const auto& x : split(s, ','))
+        xs.push_back(std::stoi(x));
+    return xs;
+}
+
+void write_result(std::ostream& os, const query_result& result)
+noexcept (false) {
+    const auto& head = result.header;
+
+    /*
+     * The header is written like ResultHeader.Pack in the api, where the
+     * lineno of a phase is left out when unset, and the lineno of the header
+     * is nil.
+     */
+    const auto unset = std::numeric_limits< int >::min();
+    auto phases = nlohmann::json::array();
+    for (const auto& phase : head.phases) {
+        nlohmann::json doc = {
+            { "ntasks",     phase.ntasks     },
+            { "decimation", phase.decimation },
+            { "shape",      phase.shape      },
+            { "index",      phase.index      },
+        };
+        if (phase.lineno != unset)
+            doc["lineno"] = phase.lineno;
+        phases.push_back(std::move(doc));
+    }
+
+    nlohmann::json doc;
+    doc["bundles"]    = result.bundles.size();
+    doc["shape"]      = head.shape;
+    doc["index"]      = head.index;
+    doc["format"]     = head.format;
+    doc["decimation"] = head.decimation;
+    doc["phases"]     = phases;
+    doc["lineno"]     = nullptr;
+    if (head.lineno != unset)
+        doc["lineno"] = head.lineno;
+    doc["fill-value"] = head.fill_value;
+
+    const auto packed = nlohmann::json::to_msgpack(doc);
+    write_array_header(os, 2);
+    os.write(reinterpret_cast< const char* >(packed.data()), packed.size());
+    write_array_header(os, std::uint32_t(result.bundles.size()));
+    for (const auto& bundle : result.bundles)
+        os.write(bundle.data(), bundle.size());
+}
+
+}
@@ -0,0 +1,130 @@
+#ifndef ONESEISMIC_TOOLS_ENGINE_HPP
+#define ONESEISMIC_TOOLS_ENGINE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <ostream>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <oneseismic/messages.hpp>
+#include <oneseismic/source.hpp>
+
+namespace one {
+
+/*
+ * A minimal fixed-size thread pool. Jobs are run in submission order, which
+ * matches how the service workers consume tasks from the job queue.
+ */
+class thread_pool {
+public:
+    explicit thread_pool(int threads);
+    ~thread_pool();
+
+    std::future< void > submit(std::function< void() > job) noexcept (false);
+    int size() const noexcept (true);
+
+private:
+    std::vector< std::thread > workers;
+    std::queue< std::packaged_task< void() > > jobs;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool done = false;
+};
+
+/*
+ * Timings of a single query. The per-task timings are indexed by the task's
+ * position in the plan, and the fetch time is the total time spent reading
+ * fragments from the source for that task.
+ */
+struct query_stats {
+    double      plan_ms    = 0;
+    double      execute_ms = 0;
+    std::size_t tasks      = 0;
+    std::size_t fragments  = 0;
+    std::size_t bytes      = 0;
+
+    std::vector< double > fetch_ms;
+    std::vector< double > add_ms;
+    std::vector< double > pack_ms;
+
+    /*
+     * The tracing spans of the plan and all tasks as a Chrome trace, when
+     * liboneseismic is built with ONESEISMIC_TRACING
+     */
+    std::string trace;
+};
+
+struct query_result {
+    one::process_header        header;
+    std::vector< std::string > bundles;
+};
+
+/*
+ * The query engine - the scheduler and worker of the service without the
+ * service. A query, a packed task as made by the api, is planned with
+ * mkschedule(), and the tasks are run through proc on the thread pool with
+ * fragments read from the source.
+ *
+ * Bundles are kept in plan order, so the output is the same regardless of
+ * the number of threads.
+ */
+class engine {
+public:
+    engine(fragment_source& source, thread_pool& pool, int task_size);
+
+    query_result run(const std::string& query, query_stats* stats = nullptr)
+    noexcept (false);
+
+private:
+    fragment_source& source;
+    thread_pool& pool;
+    int task_size;
+};
+
+/*
+ * Fill the fields of a task the api would otherwise fill, for a cube in a
+ * local directory (or any other fragment source).
+ */
+template < typename Task >
+void local_task(
+        Task& task,
+        const std::string& root,
+        const std::string& guid,
+        const std::string& manifest,
+        const std::vector< int >& fragment_shape)
+noexcept (false) {
+    const auto doc = nlohmann::json::parse(manifest);
+    task.pid      = "local";
+    task.guid     = guid;
+    task.manifest = manifest;
+    task.storage_endpoint = root;
+    task.shape    = fragment_shape;
+
+    task.shape_cube.clear();
+    for (const auto& dimension : doc.at("dimensions"))
+        task.shape_cube.push_back(int(dimension.size()));
+}
+
+/*
+ * Parse a comma-separated list of integers, e.g. 64,64,64, as given on the
+ * command line.
+ */
+std::vector< int > parse_ints(const std::string&) noexcept (false);
+
+/*
+ * Write the result the way the result endpoint would - a msgpack array of
+ * [header, [bundle...]], so the clients can assemble it.
+ */
+void write_result(std::ostream&, const query_result&) noexcept (false);
+
+}
+
+#endif //ONESEISMIC_TOOLS_ENGINE_HPP
@@ -0,0 +1,254 @@
+/*
+ * oneseismic-heatmap - summarise fragment access heatmaps
+ *
+ * Read one or more heatmap snapshots, as written by the access recorder (see
+ * oneseismic/heatmap.hpp), and report the hottest fragment columns (i, j)
+ * and layers (k) of every cube, and the estimated hit rates of fragment
+ * caches of different sizes. Snapshots from several processes, e.g. all the
+ * workers, are merged by cube.
+ *
+ * The cache estimates are for a single cache shared by all cubes, which is
+ * what a worker sees.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include <oneseismic/heatmap.hpp>
+
+#include "engine.hpp"
+
+namespace {
+
+const char* usage =
+R"(usage: oneseismic-heatmap [options] FILE...
+
+Summarise fragment access heatmaps, and estimate cache hit rates.
+
+options:
+    --top N                 number of hottest columns and layers [10]
+    --cache-sizes N,...     cache sizes to estimate, in fragments
+                            [64,256,1024,4096]
+    --json                  write the report as json
+)";
+
+struct options {
+    int top = 10;
+    std::vector< int > cache_sizes = { 64, 256, 1024, 4096 };
+    bool json = false;
+    std::vector< std::string > files;
+};
+
+options parse_args(int argc, char** argv) noexcept (false) {
+    options opts;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+                throw std::invalid_argument(arg + " requires an argument");
+            return argv[++i];
+        };
+
+        if      (arg == "--top")         opts.top = std::stoi(value());
+        else if (arg == "--cache-sizes") opts.cache_sizes = one::parse_ints(value());
+        else if (arg == "--json")        opts.json = true;
+        else if (arg == "--help" or arg == "-h") {
+            std::cout << usage;
+            std::exit(EXIT_SUCCESS);
+        }
+        else if (arg.size() > 1 and arg[0] == '-' and arg[1] == '-')
+            throw std::invalid_argument("unknown option " + arg);
+        else
+            opts.files.push_back(arg);
+    }
+
+    if (opts.files.empty())
+        throw std::invalid_argument("expected at least one FILE");
+    if (opts.top < 1)
+        throw std::invalid_argument("--top must be >= 1");
+    return opts;
+}
+
+using fragment = std::tuple< int, int, int >;
+
+/*
+ * Access counts by cube name and fragment id, merged from all snapshots
+ */
+struct heatmap {
+    std::map< std::string, std::map< fragment, std::uint64_t > > cubes;
+    std::uint64_t dropped = 0;
+};
+
+heatmap load(const std::vector< std::string >& files) noexcept (false) {
+    heatmap hm;
+    for (const auto& path : files) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            throw std::runtime_error("unable to open " + path);
+
+        const auto snap = one::heatmap::read(in);
+        for (const auto& e : snap.entries) {
+            auto& cube = hm.cubes[snap.cubes.at(e.cube)];
+            cube[fragment(e.i, e.j, e.k)] += e.count;
+        }
+        hm.dropped += snap.dropped;
+    }
+    return hm;
+}
+
+template < typename Key >
+nlohmann::json hottest(
+        const std::map< Key, std::uint64_t >& counts,
+        int top,
+        const char* name)
+noexcept (false) {
+    std::vector< std::pair< Key, std::uint64_t > > xs(
+        counts.begin(),
+        counts.end()
+    );
+    const auto n = std::min(std::size_t(top), xs.size());
+    std::partial_sort(
+        xs.begin(),
+        xs.begin() + n,
+        xs.end(),
+        [](const auto& lhs, const auto& rhs) {
+            return lhs.second > rhs.second;
+        }
+    );
+
+    auto doc = nlohmann::json::array();
+    for (std::size_t i = 0; i < n; ++i) {
+        doc.push_back({
+            { name,    xs[i].first  },
+            { "count", xs[i].second },
+        });
+    }
+    return doc;
+}
+
+nlohmann::json summary(const heatmap& hm, const options& opts)
+noexcept (false) {
+    nlohmann::json report;
+    report["dropped"] = hm.dropped;
+
+    std::vector< std::uint64_t > all;
+    auto cubes = nlohmann::json::array();
+    for (const auto& cube : hm.cubes) {
+        std::map< std::vector< int >, std::uint64_t > columns;
+        std::map< int, std::uint64_t > layers;
+        std::uint64_t total = 0;
+        for (const auto& x : cube.second) {
+            int i, j, k;
+            std::tie(i, j, k) = x.first;
+            columns[{ i, j }] += x.second;
+            layers[k]         += x.second;
+            total             += x.second;
+            all.push_back(x.second);
+        }
+
+        cubes.push_back({
+            { "cube",      cube.first },
+            { "accesses",  total },
+            { "fragments", cube.second.size() },
+            { "columns",   hottest(columns, opts.top, "column") },
+            { "layers",    hottest(layers,  opts.top, "layer") },
+        });
+    }
+    report["cubes"] = cubes;
+
+    auto caches = nlohmann::json::array();
+    for (const auto size : opts.cache_sizes) {
+        caches.push_back({
+            { "size",   size },
+            { "static", one::heatmap::static_hit_rate(all, size) },
+            { "lru",    one::heatmap::lru_hit_rate(all, size) },
+        });
+    }
+    report["caches"] = caches;
+    return report;
+}
+
+void print(const nlohmann::json& report) noexcept (false) {
+    for (const auto& cube : report["cubes"]) {
+        std::cout << fmt::format(
+            "{}: {} accesses of {} fragments\n",
+            cube["cube"].get< std::string >(),
+            cube["accesses"].get< std::uint64_t >(),
+            cube["fragments"].get< std::size_t >()
+        );
+
+        std::cout << "    hottest columns (i, j):";
+        for (const auto& x : cube["columns"]) {
+            const auto column = x["column"].get< std::vector< int > >();
+            std::cout << fmt::format(
+                " ({}, {})={}",
+                column[0],
+                column[1],
+                x["count"].get< std::uint64_t >()
+            );
+        }
+        std::cout << "\n    hottest layers (k):";
+        for (const auto& x : cube["layers"]) {
+            std::cout << fmt::format(
+                " {}={}",
+                x["layer"].get< int >(),
+                x["count"].get< std::uint64_t >()
+            );
+        }
+        std::cout << "\n\n";
+    }
+
+    std::cout << fmt::format("{:>12}{:>10}{:>10}\n", "cache size", "static", "lru");
+    for (const auto& cache : report["caches"]) {
+        std::cout << fmt::format(
+            "{:>12}{:>10.3f}{:>10.3f}\n",
+            cache["size"].get< int >(),
+            cache["static"].get< double >(),
+            cache["lru"].get< double >()
+        );
+    }
+
+    const auto dropped = report["dropped"].get< std::uint64_t >();
+    if (dropped > 0) {
+        std::cout << fmt::format(
+            "\nwarning: {} accesses were dropped by a full recorder\n",
+            dropped
+        );
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    options opts;
+    try {
+        opts = parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "oneseismic-heatmap: " << e.what() << "\n\n" << usage;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const auto report = summary(load(opts.files), opts);
+        if (opts.json)
+            std::cout << report.dump(4) << "\n";
+        else
+            print(report);
+    } catch (const std::exception& e) {
+        std::cerr << "oneseismic-heatmap: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+/*
+ * oneseismic-ingest - make the fragments of a cube from a SEG-Y file
+ *
+ * This is the native counterpart of `python -m oneseismic.upload` for local
+ * directories, and writes the same cube, laid out like the blob storage
+ * account:
+ *
+ *      <root>/<guid>/manifest.json
+ *      <root>/<guid>/src/64-64-64/0-0-0.f32
+ *      ...
+ *
+ * The input is the SEG-Y file and the manifest made by
+ * `python -m oneseismic.scan`. The SEG-Y file is memory mapped, and the
+ * fragments are written by a pool of writer threads. The directory can be
+ * served with oneseismic-query, or copied to blob storage as-is.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <oneseismic/ingest.hpp>
+#include <oneseismic/source.hpp>
+
+#include "engine.hpp"
+
+namespace {
+
+const char* usage =
+R"(usage: oneseismic-ingest [options] MANIFEST SEGY ROOT
+
+Make the fragments of the SEG-Y file SEGY, described by the scan manifest
+MANIFEST (- for stdin), and write the cube to the directory ROOT.
+
+options:
+    --threads N             writer threads [hardware concurrency]
+    --memory MB             memory budget of fragment buffers [4096]
+    --fragment-shape I,J,K  fragment shape of the cube [64,64,64]
+    --decimations N,...     decimation factors of the overview levels, 1 for
+                            none [2,4,8]
+    --stats-bins N          histogram bins of the fragment stats, 0 for
+                            none [16]
+)";
+
+struct options {
+    int threads         = int(std::max(1u, std::thread::hardware_concurrency()));
+    std::size_t memory  = 4096;
+    std::vector< int > fragment_shape = { 64, 64, 64 };
+    std::vector< int > decimations    = { 2, 4, 8 };
+    int statsbins       = 16;
+    std::vector< std::string > args;
+};
+
+options parse_args(int argc, char** argv) noexcept (false) {
+    options opts;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+                throw std::invalid_argument(arg + " requires an argument");
+            return argv[++i];
+        };
+
+        if      (arg == "--threads")        opts.threads = std::stoi(value());
+        else if (arg == "--memory")         opts.memory = std::stoul(value());
+        else if (arg == "--fragment-shape") opts.fragment_shape = one::parse_ints(value());
+        else if (arg == "--decimations")    opts.decimations = one::parse_ints(value());
+        else if (arg == "--stats-bins")     opts.statsbins = std::stoi(value());
+        else if (arg == "--help" or arg == "-h") {
+            std::cout << usage;
+            std::exit(EXIT_SUCCESS);
+        }
+        else if (arg.size() > 1 and arg[0] == '-' and arg[1] == '-')
+            throw std::invalid_argument("unknown option " + arg);
+        else
+            opts.args.push_back(arg);
+    }
+
+    if (opts.args.size() != 3)
+        throw std::invalid_argument("expected 3 positional arguments");
+    if (opts.fragment_shape.size() != 3)
+        throw std::invalid_argument("--fragment-shape must have 3 elements");
+    if (opts.statsbins < 0)
+        throw std::invalid_argument("--stats-bins must be >= 0");
+    return opts;
+}
+
+std::string read_manifest(const std::string& path) noexcept (false) {
+    if (path == "-") {
+        return std::string(
+            std::istreambuf_iterator< char >(std::cin),
+            std::istreambuf_iterator< char >()
+        );
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("unable to open " + path);
+    return std::string(
+        std::istreambuf_iterator< char >(in),
+        std::istreambuf_iterator< char >()
+    );
+}
+
+}
+
+int main(int argc, char** argv) {
+    options opts;
+    try {
+        opts = parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "oneseismic-ingest: " << e.what() << "\n\n" << usage;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const auto manifest = read_manifest(opts.args[0]);
+
+        /*
+         * The mmap source maps the file as-is, so SEGY is a path like any
+         * other, relative to the working directory
+         */
+        one::mmap_source input("");
+        const auto segy = input.get(opts.args[1]);
+        one::filesystem_sink sink(opts.args[2]);
+
+        one::ingest_options ingest;
+        ingest.fragment_shape = opts.fragment_shape;
+        ingest.decimations    = opts.decimations;
+        ingest.statsbins      = opts.statsbins;
+        ingest.threads        = opts.threads;
+        ingest.memory         = opts.memory * 1024 * 1024;
+
+        one::ingest_stats stats;
+        const auto start = std::chrono::steady_clock::now();
+        one::ingest(segy.data(), segy.size(), manifest, sink, ingest, &stats);
+        const auto stop = std::chrono::steady_clock::now();
+
+        const auto seconds = std::chrono::duration< double >(stop - start);
+        std::cerr << fmt::format(
+            "traces={} fragments={} bytes={} passes={} threads={} "
+            "seconds={:.3f} MBps={:.1f}\n",
+            stats.traces,
+            stats.fragments,
+            stats.bytes,
+            stats.passes,
+            opts.threads,
+            seconds.count(),
+            seconds.count() > 0 ? segy.size() / seconds.count() / 1e6 : 0.0
+        );
+    } catch (const std::exception& e) {
+        std::cerr << "oneseismic-ingest: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
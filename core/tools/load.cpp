@@ -0,0 +1,339 @@
+/*
+ * oneseismic-load - drive a mixed workload against a local cube
+ *
+ * This runs a number of randomly drawn slices and curtains against a cube in
+ * a local directory, with a configurable number of concurrent clients sharing
+ * one pool of workers, and reports latency percentiles for every stage of the
+ * query:
+ *
+ *      plan        mkschedule(), per query
+ *      fetch       reading fragments from the source, per task
+ *      add         proc::add() of all fragments, per task
+ *      pack        proc::pack(), per task
+ *      end-to-end  plan + all tasks, per query, as a client would see it
+ *
+ * Synthetic cubes of any shape for this tool can be made with:
+ *
+ *      python -m oneseismic synthetic --shape 1024 1024 512 <dir>
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include <oneseismic/heatmap.hpp>
+#include <oneseismic/messages.hpp>
+#include <oneseismic/source.hpp>
+
+#include "engine.hpp"
+
+namespace {
+
+const char* usage =
+R"(usage: oneseismic-load [options] ROOT GUID
+
+Run a mixed slice and curtain workload against the cube GUID in the
+directory ROOT, and report latency percentiles in milliseconds.
+
+options:
+    --source KIND           filesystem, mmap or memory [filesystem]
+    --threads N             worker threads [hardware concurrency]
+    --clients N             concurrent queries [4]
+    --requests N            total number of queries [100]
+    --curtains P            fraction of queries that are curtains [0.3]
+    --curtain-length N      traces per curtain [500]
+    --task-size N           fragments per task [10]
+    --fragment-shape I,J,K  fragment shape of the cube [64,64,64]
+    --seed N                seed of the workload [0]
+    --heatmap FILE          record fragment accesses to FILE, for
+                            oneseismic-heatmap
+    --json                  write the report as json
+)";
+
+struct options {
+    std::string source  = "filesystem";
+    int threads         = int(std::max(1u, std::thread::hardware_concurrency()));
+    int clients         = 4;
+    int requests        = 100;
+    double curtains     = 0.3;
+    int curtain_length  = 500;
+    int task_size       = 10;
+    std::vector< int > fragment_shape = { 64, 64, 64 };
+    unsigned seed       = 0;
+    bool json           = false;
+    std::string heatmap;
+    std::vector< std::string > args;
+};
+
+options parse_args(int argc, char** argv) noexcept (false) {
+    options opts;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+                throw std::invalid_argument(arg + " requires an argument");
+            return argv[++i];
+        };
+
+        if      (arg == "--source")         opts.source = value();
+        else if (arg == "--threads")        opts.threads = std::stoi(value());
+        else if (arg == "--clients")        opts.clients = std::stoi(value());
+        else if (arg == "--requests")       opts.requests = std::stoi(value());
+        else if (arg == "--curtains")       opts.curtains = std::stod(value());
+        else if (arg == "--curtain-length") opts.curtain_length = std::stoi(value());
+        else if (arg == "--task-size")      opts.task_size = std::stoi(value());
+        else if (arg == "--fragment-shape") opts.fragment_shape = one::parse_ints(value());
+        else if (arg == "--seed")           opts.seed = unsigned(std::stoul(value()));
+        else if (arg == "--json")           opts.json = true;
+        else if (arg == "--heatmap")        opts.heatmap = value();
+        else if (arg == "--help" or arg == "-h") {
+            std::cout << usage;
+            std::exit(EXIT_SUCCESS);
+        }
+        else if (arg.size() > 1 and arg[0] == '-' and arg[1] == '-')
+            throw std::invalid_argument("unknown option " + arg);
+        else
+            opts.args.push_back(arg);
+    }
+
+    if (opts.args.size() != 2)
+        throw std::invalid_argument("expected 2 positional arguments");
+    if (opts.fragment_shape.size() != 3)
+        throw std::invalid_argument("--fragment-shape must have 3 elements");
+    if (opts.clients < 1 or opts.requests < 1 or opts.curtain_length < 2)
+        throw std::invalid_argument("--clients, --requests must be >= 1, "
+                                    "--curtain-length >= 2");
+    return opts;
+}
+
+/*
+ * Draw the workload up front, so that the same seed gives the same queries
+ * regardless of the number of clients. Slices are uniform over dimensions and
+ * lines, and curtains are straight lines between two random points at the
+ * edges of the survey, which is a reasonable stand-in for well paths and
+ * arbitrary lines.
+ */
+std::vector< std::string > workload(
+        const options& opts,
+        const std::string& manifest)
+noexcept (false) {
+    const auto doc  = nlohmann::json::parse(manifest);
+    const auto dims = doc.at("dimensions")
+                         .get< std::vector< std::vector< int > > >();
+
+    std::mt19937 rng(opts.seed);
+    std::bernoulli_distribution is_curtain(opts.curtains);
+    std::uniform_int_distribution< int > dim(0, 2);
+    const auto pick = [&](const std::vector< int >& labels) {
+        std::uniform_int_distribution< std::size_t > i(0, labels.size() - 1);
+        return labels[i(rng)];
+    };
+
+    const auto& root = opts.args[0];
+    const auto& guid = opts.args[1];
+    std::vector< std::string > queries;
+    for (int i = 0; i < opts.requests; ++i) {
+        if (not is_curtain(rng)) {
+            one::slice_task task;
+            one::local_task(task, root, guid, manifest, opts.fragment_shape);
+            task.function = "slice";
+            task.dim      = dim(rng);
+            task.lineno   = pick(dims[task.dim]);
+            queries.push_back(task.pack());
+            continue;
+        }
+
+        one::curtain_task task;
+        one::local_task(task, root, guid, manifest, opts.fragment_shape);
+        task.function = "curtain";
+        const int n0 = dims[0].size();
+        const int n1 = dims[1].size();
+        std::uniform_int_distribution< int > x(0, n0 - 1);
+        std::uniform_int_distribution< int > y(0, n1 - 1);
+        const auto x0 = x(rng), x1 = x(rng);
+        const auto y0 = y(rng), y1 = y(rng);
+        const auto n  = opts.curtain_length;
+        for (int k = 0; k < n; ++k) {
+            const double t = double(k) / (n - 1);
+            task.dim0s.push_back(dims[0][int(x0 + t * (x1 - x0) + 0.5)]);
+            task.dim1s.push_back(dims[1][int(y0 + t * (y1 - y0) + 0.5)]);
+        }
+        queries.push_back(task.pack());
+    }
+    return queries;
+}
+
+struct samples {
+    std::vector< double > plan;
+    std::vector< double > fetch;
+    std::vector< double > add;
+    std::vector< double > pack;
+    std::vector< double > end_to_end;
+};
+
+/*
+ * Nearest-rank percentile
+ */
+double percentile(std::vector< double >& xs, double p) noexcept (true) {
+    if (xs.empty())
+        return 0;
+
+    const auto rank = std::size_t(p / 100.0 * (xs.size() - 1) + 0.5);
+    std::nth_element(xs.begin(), xs.begin() + rank, xs.end());
+    return xs[rank];
+}
+
+nlohmann::json summary(std::vector< double >& xs) noexcept (false) {
+    nlohmann::json doc;
+    doc["count"] = xs.size();
+    doc["p50"]   = percentile(xs, 50);
+    doc["p90"]   = percentile(xs, 90);
+    doc["p99"]   = percentile(xs, 99);
+    doc["max"]   = percentile(xs, 100);
+    return doc;
+}
+
+}
+
+int main(int argc, char** argv) {
+    using clock = std::chrono::steady_clock;
+
+    options opts;
+    try {
+        opts = parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "oneseismic-load: " << e.what() << "\n\n" << usage;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        auto source = one::make_source(opts.source, opts.args[0]);
+        const auto blob = source->get(opts.args[1] + "/manifest.json");
+        const auto manifest = std::string(blob.data(), blob.size());
+        const auto queries = workload(opts, manifest);
+
+        /*
+         * Record only in proc, as every planned fragment is also handed out
+         * by a proc in the engine
+         */
+        one::heatmap::recorder heat;
+        std::unique_ptr< one::heatmap::flusher > flusher;
+        if (not opts.heatmap.empty()) {
+            one::heatmap::install(&heat, one::heatmap::at_proc);
+            flusher.reset(new one::heatmap::flusher(
+                heat,
+                opts.heatmap,
+                std::chrono::seconds(10)
+            ));
+        }
+
+        one::thread_pool pool(opts.threads);
+        one::engine engine(*source, pool, opts.task_size);
+
+        samples s;
+        std::mutex mtx;
+        std::size_t next = 0;
+        std::size_t bytes = 0;
+
+        const auto start = clock::now();
+        std::vector< std::thread > clients;
+        for (int c = 0; c < opts.clients; ++c) {
+            clients.emplace_back([&] {
+                while (true) {
+                    std::size_t i;
+                    {
+                        std::lock_guard< std::mutex > lock(mtx);
+                        if (next == queries.size())
+                            return;
+                        i = next++;
+                    }
+
+                    one::query_stats stats;
+                    const auto t0 = clock::now();
+                    engine.run(queries[i], &stats);
+                    const std::chrono::duration< double, std::milli > e2e =
+                        clock::now() - t0;
+
+                    std::lock_guard< std::mutex > lock(mtx);
+                    const auto append = [](auto& dst, const auto& src) {
+                        dst.insert(dst.end(), src.begin(), src.end());
+                    };
+                    s.plan.push_back(stats.plan_ms);
+                    s.end_to_end.push_back(e2e.count());
+                    append(s.fetch, stats.fetch_ms);
+                    append(s.add,   stats.add_ms);
+                    append(s.pack,  stats.pack_ms);
+                    bytes += stats.bytes;
+                }
+            });
+        }
+        for (auto& client : clients)
+            client.join();
+        one::heatmap::install(nullptr);
+        flusher.reset();
+        const std::chrono::duration< double > elapsed = clock::now() - start;
+
+        nlohmann::json report;
+        report["queries"]    = queries.size();
+        report["clients"]    = opts.clients;
+        report["threads"]    = pool.size();
+        report["source"]     = opts.source;
+        report["seconds"]    = elapsed.count();
+        report["qps"]        = queries.size() / elapsed.count();
+        report["MBps"]       = bytes / elapsed.count() / 1e6;
+        report["plan"]       = summary(s.plan);
+        report["fetch"]      = summary(s.fetch);
+        report["add"]        = summary(s.add);
+        report["pack"]       = summary(s.pack);
+        report["end-to-end"] = summary(s.end_to_end);
+
+        if (opts.json) {
+            std::cout << report.dump(4) << "\n";
+            return EXIT_SUCCESS;
+        }
+
+        std::cout << fmt::format(
+            "{} queries in {:.2f}s ({:.1f} q/s, {:.1f} MB/s), "
+            "{} clients, {} threads, {} source\n\n",
+            queries.size(),
+            elapsed.count(),
+            report["qps"].get< double >(),
+            report["MBps"].get< double >(),
+            opts.clients,
+            pool.size(),
+            opts.source
+        );
+        std::cout << fmt::format(
+            "{:<12}{:>8}{:>10}{:>10}{:>10}{:>10}\n",
+            "stage (ms)", "count", "p50", "p90", "p99", "max"
+        );
+        for (const auto* stage : { "plan", "fetch", "add", "pack", "end-to-end" }) {
+            const auto& x = report[stage];
+            std::cout << fmt::format(
+                "{:<12}{:>8}{:>10.3f}{:>10.3f}{:>10.3f}{:>10.3f}\n",
+                stage,
+                x["count"].get< std::size_t >(),
+                x["p50"].get< double >(),
+                x["p90"].get< double >(),
+                x["p99"].get< double >(),
+                x["max"].get< double >()
+            );
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "oneseismic-load: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,213 @@
+/*
+ * oneseismic-query - run queries against a local directory of cubes
+ *
+ * This runs the planner and the query engine in a single process, without
+ * the api, redis, or blob storage, which makes it useful for profiling and
+ * for serving cubes from local disk. The directory is laid out like the blob
+ * storage account, which is what `python -m oneseismic.upload` writes when
+ * given a local directory:
+ *
+ *      <root>/<guid>/manifest.json
+ *      <root>/<guid>/src/64-64-64/0-0-0.f32
+ *      ...
+ *
+ * The result is written as msgpack, in the same format as the result
+ * endpoint, and timings are written to stderr as key=value pairs.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <oneseismic/messages.hpp>
+#include <oneseismic/plan.hpp>
+#include <oneseismic/source.hpp>
+
+#include "engine.hpp"
+
+namespace {
+
+const char* usage =
+R"(usage: oneseismic-query [options] ROOT GUID slice DIM LINENO
+       oneseismic-query [options] ROOT GUID curtain DIM0S DIM1S
+
+Run a query against the cube GUID in the directory ROOT. Curtains are given
+as comma-separated lists of line numbers, e.g. 1,2,3 1000,1000,1001.
+
+options:
+    --source KIND           filesystem, mmap or memory [filesystem]
+    --threads N             worker threads [hardware concurrency]
+    --task-size N           fragments per task [10]
+    --fragment-shape I,J,K  fragment shape of the cube [64,64,64]
+    --format FORMAT         sample encoding: f32, f16, bf16, i16, i8 [f32]
+    --target-shape M,N      minimum output shape, to read overview levels
+    --progressive           schedule a coarse preview first (slice only)
+    --repeat N              run the query N times, for measurements [1]
+    --output FILE           write the result to FILE, - for stdout [-]
+    --trace FILE            write a Chrome trace of the last run to FILE,
+                            when built with ONESEISMIC_TRACING
+)";
+
+struct options {
+    std::string source    = "filesystem";
+    int threads           = int(std::max(1u, std::thread::hardware_concurrency()));
+    int task_size         = 10;
+    std::vector< int > fragment_shape = { 64, 64, 64 };
+    std::string format    = "f32";
+    std::vector< int > target_shape;
+    bool progressive      = false;
+    int repeat            = 1;
+    std::string output    = "-";
+    std::string trace;
+    std::vector< std::string > args;
+};
+
+options parse_args(int argc, char** argv) noexcept (false) {
+    options opts;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto value = [&]() -> std::string {
+            if (i + 1 >= argc)
+                throw std::invalid_argument(arg + " requires an argument");
+            return argv[++i];
+        };
+
+        if      (arg == "--source")         opts.source = value();
+        else if (arg == "--threads")        opts.threads = std::stoi(value());
+        else if (arg == "--task-size")      opts.task_size = std::stoi(value());
+        else if (arg == "--fragment-shape") opts.fragment_shape = one::parse_ints(value());
+        else if (arg == "--format")         opts.format = value();
+        else if (arg == "--target-shape")   opts.target_shape = one::parse_ints(value());
+        else if (arg == "--progressive")    opts.progressive = true;
+        else if (arg == "--repeat")         opts.repeat = std::stoi(value());
+        else if (arg == "--output")         opts.output = value();
+        else if (arg == "--trace")          opts.trace = value();
+        else if (arg == "--help" or arg == "-h") {
+            std::cout << usage;
+            std::exit(EXIT_SUCCESS);
+        }
+        else if (arg.size() > 1 and arg[0] == '-' and arg[1] == '-')
+            throw std::invalid_argument("unknown option " + arg);
+        else
+            opts.args.push_back(arg);
+    }
+
+    if (opts.args.size() != 5)
+        throw std::invalid_argument("expected 5 positional arguments");
+    if (opts.fragment_shape.size() != 3)
+        throw std::invalid_argument("--fragment-shape must have 3 elements");
+    if (opts.repeat < 1)
+        throw std::invalid_argument("--repeat must be >= 1");
+    return opts;
+}
+
+template < typename Task >
+void fill_common(Task& task, const options& opts, const std::string& manifest)
+noexcept (false) {
+    const auto& root = opts.args[0];
+    const auto& guid = opts.args[1];
+    one::local_task(task, root, guid, manifest, opts.fragment_shape);
+    task.pid          = "oneseismic-query";
+    task.format       = opts.format;
+    task.target_shape = opts.target_shape;
+}
+
+std::string make_query(const options& opts, const std::string& manifest)
+noexcept (false) {
+    const auto& function = opts.args[2];
+    if (function == "slice") {
+        one::slice_task task;
+        fill_common(task, opts, manifest);
+        task.function    = "slice";
+        task.dim         = std::stoi(opts.args[3]);
+        task.lineno      = std::stoi(opts.args[4]);
+        task.progressive = opts.progressive;
+        return task.pack();
+    }
+
+    if (function == "curtain") {
+        one::curtain_task task;
+        fill_common(task, opts, manifest);
+        task.function = "curtain";
+        task.dim0s    = one::parse_ints(opts.args[3]);
+        task.dim1s    = one::parse_ints(opts.args[4]);
+        if (task.dim0s.size() != task.dim1s.size())
+            throw std::invalid_argument("DIM0S and DIM1S must be of same size");
+        return task.pack();
+    }
+
+    throw std::invalid_argument("unknown function " + function);
+}
+
+}
+
+int main(int argc, char** argv) {
+    options opts;
+    try {
+        opts = parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "oneseismic-query: " << e.what() << "\n\n" << usage;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        auto source = one::make_source(opts.source, opts.args[0]);
+        const auto manifest = source->get(opts.args[1] + "/manifest.json");
+        const auto query = make_query(
+            opts,
+            std::string(manifest.data(), manifest.size())
+        );
+
+        one::thread_pool pool(opts.threads);
+        one::engine engine(*source, pool, opts.task_size);
+
+        one::query_result result;
+        one::query_stats stats;
+        for (int run = 0; run < opts.repeat; ++run) {
+            stats = one::query_stats();
+            result = engine.run(query, &stats);
+
+            const auto seconds = (stats.plan_ms + stats.execute_ms) / 1000;
+            std::cerr << fmt::format(
+                "run={} threads={} source={} tasks={} fragments={} bytes={} "
+                "plan_ms={:.3f} execute_ms={:.3f} MBps={:.1f}\n",
+                run,
+                pool.size(),
+                opts.source,
+                stats.tasks,
+                stats.fragments,
+                stats.bytes,
+                stats.plan_ms,
+                stats.execute_ms,
+                seconds > 0 ? stats.bytes / seconds / 1e6 : 0.0
+            );
+        }
+
+        if (not opts.trace.empty()) {
+            std::ofstream out(opts.trace);
+            if (!out)
+                throw std::runtime_error("unable to open " + opts.trace);
+            out << stats.trace;
+        }
+
+        if (opts.output == "-") {
+            one::write_result(std::cout, result);
+            std::cout.flush();
+        } else {
+            std::ofstream out(opts.output, std::ios::binary);
+            if (!out)
+                throw std::runtime_error("unable to open " + opts.output);
+            one::write_result(out, result);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "oneseismic-query: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
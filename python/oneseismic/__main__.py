@@ -8,6 +8,7 @@ if __name__ == "__main__":
         'login':   'login.__main__',
         'scan':    'scan.__main__',
         'upload':  'upload.__main__',
+        'synthetic': 'upload.synthetic',
         'ls':      'client.ls',
     }
     parser.add_argument('cmd', choices = programs.keys())
@@ -6,6 +6,74 @@ import msgpack
 import time
 import xarray
 
+def decode(v, fmt, scale = 1.0, offset = 0.0):
+    """Decode samples
+
+    Decode the samples of a tile or trace, as encoded by the server. The
+    format is given in the result header, and the integer formats carry their
+    own scale and offset. The lowest code of the integer formats, -32768 for
+    i16 and -128 for i8, is a non-finite sample, and is decoded as nan.
+
+    Parameters
+    ----------
+    v : list or array_like
+        The encoded samples
+    fmt : { 'f32', 'f16', 'bf16', 'i16', 'i8' }
+    scale : float
+    offset : float
+
+    Returns
+    -------
+    a : numpy.array of float32
+    """
+    if fmt == 'f32':
+        return np.asarray(v, dtype = np.single)
+
+    codes = np.asarray(v, dtype = np.int16)
+    if fmt == 'f16':
+        return codes.view(np.float16).astype(np.single)
+
+    if fmt == 'bf16':
+        bits = codes.view(np.uint16).astype(np.uint32) << 16
+        return bits.view(np.single)
+
+    if fmt in ('i16', 'i8'):
+        nonfinite = -32768 if fmt == 'i16' else -128
+        a = (offset + scale * codes.astype(np.single)).astype(np.single)
+        a[codes == nonfinite] = np.nan
+        return a
+
+    raise ValueError(f'unknown format {fmt}')
+
+def decode_part(part, fmt):
+    """Decode the samples of a tile or trace in a response
+
+    Parameters
+    ----------
+    part : dict
+        Tile or trace, with the 'v' key
+    fmt : str
+
+    Returns
+    -------
+    a : numpy.array of float32
+    """
+    return decode(
+        part['v'],
+        fmt,
+        scale = part.get('scale', 1.0),
+        offset = part.get('offset', 0.0),
+    )
+
+def with_query(resource, **params):
+    """Add the query parameters that are not None to the resource
+    """
+    params = { k: v for k, v in params.items() if v is not None }
+    if not params:
+        return resource
+    query = '&'.join(f'{k}={v}' for k, v in params.items())
+    return f'{resource}?{query}'
+
 class assembler:
     """Base for the assembler
     """
@@ -53,24 +121,26 @@ class assembler:
 class assembler_slice(assembler):
     kind = 'slice'
 
-    def __init__(self, sourcecube, dimlabels, name):
+    def __init__(self, sourcecube, dimlabels, name, label = None):
         super().__init__(sourcecube)
         self.dims = dimlabels
         self.name = name
+        self.label = label
 
-    def numpy(self, unpacked):
-        index = unpacked[0]['index']
+    @staticmethod
+    def assemble(index, fmt, bundles, fill = 0):
         dims0 = len(index[0])
         dims1 = len(index[1])
 
-        result = np.zeros((dims0 * dims1), dtype = np.single)
-        for bundle in unpacked[1]:
+        # absent fragments of sparse cubes are not in any bundle
+        result = np.full((dims0 * dims1), fill_value = fill, dtype = np.single)
+        for bundle in bundles:
             for tile in bundle['tiles']:
                 layout = tile
                 dst = layout['initial-skip']
                 chunk_size = layout['chunk-size']
                 src = 0
-                v = tile['v']
+                v = decode_part(tile, fmt)
                 for _ in range(layout['iterations']):
                     result[dst : dst + chunk_size] = v[src : src + chunk_size]
                     src += layout['substride']
@@ -78,14 +148,76 @@ class assembler_slice(assembler):
 
         return result.reshape((dims0, dims1))
 
+    def numpy(self, unpacked):
+        header = unpacked[0]
+        fmt = header.get('format', 'f32')
+        # progressive slices also carry the bundles of the coarse preview,
+        # which are told apart by their decimation
+        d = header.get('decimation', 1)
+        bundles = [
+            b for b in unpacked[1] if b.get('decimation', 1) == d
+        ]
+        fill = header.get('fill-value', 0)
+        return self.assemble(header['index'], fmt, bundles, fill)
+
+    def preview(self, unpacked):
+        """Assemble the coarse preview of a progressive slice
+
+        Parameters
+        ----------
+        unpacked
+            The (possibly partial) result of msgpack.unpackb(slice.get())
+
+        Returns
+        -------
+        a : numpy.array or None
+            The preview, or None if the slice is not progressive
+        """
+        header = unpacked[0]
+        phases = header.get('phases') or []
+        if len(phases) < 2:
+            return None
+
+        coarse = phases[0]
+        bundles = [
+            b for b in unpacked[1]
+            if b.get('decimation', 1) == coarse['decimation']
+        ]
+        fmt = header.get('format', 'f32')
+        fill = header.get('fill-value', 0)
+        return self.assemble(coarse['index'], fmt, bundles, fill)
+
+    def lineno(self, unpacked):
+        """The line number of the slice
+
+        Overview levels only have every decimation'th line, so a slice read
+        from an overview level is the closest line at or before the requested
+        one.
+
+        Parameters
+        ----------
+        unpacked
+            The result of msgpack.unpackb(slice.get())
+
+        Returns
+        -------
+        lineno : int or None
+            The line number, or None if the server does not tell
+        """
+        return unpacked[0].get('lineno')
+
     def xarray(self, unpacked):
         index = unpacked[0]['index']
         a = self.numpy(unpacked)
+        name = self.name
+        lineno = self.lineno(unpacked)
+        if self.label is not None and lineno is not None:
+            name = f'{self.label} {lineno}'
         # TODO: add units for time/depth
         return xarray.DataArray(
             data   = a,
             dims   = self.dims,
-            name   = self.name,
+            name   = name,
             coords = index,
         )
 
@@ -99,6 +231,7 @@ class assembler_curtain(assembler):
         header = unpacked[0]
         shape = header['shape']
         index = header['index']
+        fmt = header.get('format', 'f32')
         dims0 = len(index[0])
         dimsz = len(index[2])
 
@@ -109,13 +242,15 @@ class assembler_curtain(assembler):
 
         # allocate the result. The shape can be slightly larger than dims0 * dimsz
         # since the traces can be padded at the end. By allocating space for the
-        # padded traces we can just put floats directly into the array
-        xs = np.zeros(shape = shape, dtype = np.single)
+        # padded traces we can just put floats directly into the array. The
+        # traces of absent fragments of sparse cubes are not in any bundle
+        fill = header.get('fill-value', 0)
+        xs = np.full(shape = shape, fill_value = fill, dtype = np.single)
 
         for bundle in unpacked[1]:
             for part in bundle['traces']:
                 x, y, z = part['coordinates']
-                v = part['v']
+                v = decode_part(part, fmt)
                 xs[xyindex[(x, y)], z:z+len(v)] = v[:]
 
         return xs[:dims0, :dimsz]
@@ -124,9 +259,11 @@ class assembler_curtain(assembler):
         index = unpacked[0]['index']
         a = self.numpy(unpacked)
         ijk = self.sourcecube.ijk
+        # index is in the coordinates of the overview level, if decimated
+        d = unpacked[0].get('decimation', 1)
 
-        xs = [ijk[0][x] for x in index[0]]
-        ys = [ijk[1][x] for x in index[1]]
+        xs = [ijk[0][x * d] for x in index[0]]
+        ys = [ijk[1][x * d] for x in index[1]]
         # TODO: address this inconsistency - zs is in 'real' sample offsets,
         # while xs/ys are cube indexed
         zs = index[2]
@@ -144,6 +281,149 @@ class assembler_curtain(assembler):
 
         return da
 
+class assembler_horizon(assembler):
+    kind = 'horizon'
+
+    def numpy(self, unpacked):
+        """Assemble the horizon
+
+        The result is a map of shape (len(dim0s), len(dim1s)), or a stack of
+        shape (len(dim0s), len(dim1s), 2 * window + 1) when the horizon was
+        extracted with a window. Holes in the surface are nan.
+        """
+        header = unpacked[0]
+        shape = header['shape']
+        fmt = header.get('format', 'f32')
+        window = shape[2] if len(shape) > 2 else 1
+
+        xs = np.full(
+            shape = (shape[0] * shape[1], window),
+            fill_value = np.nan,
+            dtype = np.single,
+        )
+        for bundle in unpacked[1]:
+            v = decode_part(bundle, fmt)
+            xs[bundle['index']] = v.reshape(-1, window)
+
+        return xs.reshape(shape)
+
+    def xarray(self, unpacked):
+        index = unpacked[0]['index']
+        a = self.numpy(unpacked)
+        dims = ['inline', 'crossline', 'offset'][:a.ndim]
+        da = xarray.DataArray(
+            data = a,
+            name = 'horizon',
+            dims = dims,
+            coords = { dim: index[i] for i, dim in enumerate(dims) },
+        )
+        return da
+
+class assembler_polyline(assembler):
+    kind = 'polyline'
+
+    def numpy(self, unpacked):
+        """Assemble the interpolated traces of the polyline
+
+        The result has shape (points, samples), with the traces in the order
+        of the densified path.
+        """
+        header = unpacked[0]
+        shape = header['shape']
+        fmt = header.get('format', 'f32')
+        xs = np.zeros(shape = shape, dtype = np.single)
+        for bundle in unpacked[1]:
+            v = decode_part(bundle, fmt)
+            xs[bundle['index']] = v.reshape(-1, bundle['samples'])
+        return xs
+
+    def xarray(self, unpacked):
+        header = unpacked[0]
+        a = self.numpy(unpacked)
+        points = np.zeros(shape = (a.shape[0], 2), dtype = np.single)
+        for bundle in unpacked[1]:
+            points[bundle['index']] = bundle['points']
+
+        da = xarray.DataArray(
+            data = a,
+            name = self.kind,
+            dims = ['point', 'sample'],
+            coords = {
+                'point': header['index'][0],
+                'sample': header['index'][1],
+                'x': ('point', points[:, 0]),
+                'y': ('point', points[:, 1]),
+            },
+        )
+        return da
+
+class assembler_points(assembler):
+    kind = 'points'
+
+    def numpy(self, unpacked):
+        """Assemble the samples of the points, in request order
+
+        Points outside the cube are nan.
+        """
+        header = unpacked[0]
+        fmt = header.get('format', 'f32')
+        xs = np.full(shape = header['shape'], fill_value = np.nan, dtype = np.single)
+        for bundle in unpacked[1]:
+            xs[bundle['index']] = decode_part(bundle, fmt)
+        return xs
+
+    def xarray(self, unpacked):
+        a = self.numpy(unpacked)
+        return xarray.DataArray(data = a, name = self.kind, dims = ['point'])
+
+class assembler_area(assembler):
+    kind = 'area'
+
+    def traces(self, unpacked):
+        """The traces of the area, and their (dim0, dim1) grid positions
+
+        The traces are sorted by (dim0, dim1), i.e. row-major.
+        """
+        header = unpacked[0]
+        fmt = header.get('format', 'f32')
+        samples = header['shape'][1]
+        parts = unpacked[1]
+        if not parts:
+            empty = np.zeros(shape = 0, dtype = np.intc)
+            return np.zeros(shape = (0, samples), dtype = np.single), empty, empty
+
+        dim0s = np.concatenate([np.asarray(p['dim0s'], dtype = np.intc) for p in parts])
+        dim1s = np.concatenate([np.asarray(p['dim1s'], dtype = np.intc) for p in parts])
+        xs = np.concatenate([
+            decode_part(p, fmt).reshape(-1, samples) for p in parts
+        ])
+        order = np.lexsort((dim1s, dim0s))
+        return xs[order], dim0s[order], dim1s[order]
+
+    def numpy(self, unpacked):
+        """Assemble the traces of the area
+
+        The result has shape (traces, samples), with the traces sorted by
+        (dim0, dim1).
+        """
+        xs, _, _ = self.traces(unpacked)
+        return xs
+
+    def xarray(self, unpacked):
+        header = unpacked[0]
+        xs, dim0s, dim1s = self.traces(unpacked)
+        index = self.sourcecube.ijk
+        return xarray.DataArray(
+            data = xs,
+            name = self.kind,
+            dims = ['trace', 'sample'],
+            coords = {
+                'sample': header['index'][1],
+                'dim0': ('trace', np.asarray(index[0])[dim0s]),
+                'dim1': ('trace', np.asarray(index[1])[dim1s]),
+            },
+        )
+
 class cube:
     """ Cube handle
 
@@ -191,7 +471,19 @@ class cube:
         ]
         return self._ijk
 
-    def slice(self, dim, lineno):
+    def slice(
+            self,
+            dim,
+            lineno,
+            format = None,
+            target_shape = None,
+            progressive = False,
+            attribute = None,
+            attribute_window = None,
+            zmin = None,
+            zmax = None,
+            roi = None,
+            stride = None):
         """ Fetch a slice
 
         Parameters
@@ -203,6 +495,41 @@ class cube:
             The line number we would like to fetch. This corresponds to the
             axis labels given in the dim<n> members. In order to fetch the nth
             surface allong the mth dimension use lineno = dim<m>[n].
+        format : { 'f32', 'f16', 'bf16', 'i16', 'i8' }, optional
+            Sample encoding used for transfer. Reduced precision formats
+            make the response smaller, and are always decoded to float32.
+            Defaults to f32.
+        target_shape : tuple of int, optional
+            The minimum shape of the slice, e.g. the size of the view. If
+            set, the slice is read from the coarsest overview level that
+            is at least this large, and the result is decimated. Overview
+            levels only have every n'th line, and the slice is then the
+            closest line at or before lineno, which is given by the
+            assembler's lineno().
+        progressive : bool, optional
+            Schedule a coarse preview from the coarsest overview level ahead
+            of the slice. The preview bundles arrive first, and can be
+            assembled with the assembler's preview().
+        attribute : { 'rms', 'mean', 'maxabs', 'sumpos', 'sumneg' }, optional
+            Reduce the samples to an amplitude attribute over windows in z,
+            which is computed by the server. Slices along z can not be
+            reduced.
+        attribute_window : int, optional
+            The number of samples per attribute window, which must divide
+            the fragment height. Defaults to 1.
+        zmin, zmax : int, optional
+            Crop the slice to the samples in [zmin, zmax], in sample labels.
+            Only the fragments that overlap the range are read. When
+            reducing to an attribute, the range is widened to whole windows.
+            Slices along z can not be cropped.
+        roi : ((int, int), (int, int)), optional
+            The region of interest, as the labels (first, last) of the two
+            dimensions of the slice, e.g. a zoomed-in view. Only the
+            fragments in the region are read.
+        stride : (int, int), optional
+            Return every stride'th sample of the two dimensions of the slice,
+            counted from the start of the region. Fragments without any of
+            these samples are not read.
 
         Returns
         -------
@@ -210,31 +537,87 @@ class cube:
         slice : numpy.ndarray
         """
         resource = f"query/{self.guid}/slice/{dim}/{lineno}"
+        params = {}
+        if format is not None:
+            params['format'] = format
+        if target_shape is not None:
+            params['target_shape'] = ','.join(map(str, target_shape))
+        if progressive:
+            params['progressive'] = 'true'
+        if attribute is not None:
+            params['attribute'] = attribute
+        if attribute_window is not None:
+            params['attribute_window'] = attribute_window
+        if zmin is not None:
+            params['zmin'] = int(zmin)
+        if zmax is not None:
+            params['zmax'] = int(zmax)
+        if roi is not None:
+            params['roi'] = ','.join(str(int(x)) for r in roi for x in r)
+        if stride is not None:
+            params['stride'] = ','.join(str(int(x)) for x in stride)
+        if params:
+            query = '&'.join(f'{k}={v}' for k, v in params.items())
+            resource = f'{resource}?{query}'
         # TODO: derive labels from query, header, or manifest
         labels = ['inline', 'crossline', 'time']
-        name = f'{labels.pop(dim)} {lineno}'
+        label = labels.pop(dim)
+        name = f'{label} {lineno}'
         proc = schedule(
             session = self.session,
             resource = resource,
         )
-        proc.assembler = assembler_slice(self, dimlabels = labels, name = name)
+        proc.assembler = assembler_slice(
+            self,
+            dimlabels = labels,
+            name = name,
+            label = label,
+        )
         return proc
 
-    def curtain(self, intersections):
+    def curtain(
+            self,
+            intersections,
+            format = None,
+            target_shape = None,
+            attribute = None,
+            attribute_window = None,
+            zmin = None,
+            zmax = None):
         """Fetch a curtain
 
         Parameters
         ----------
+        format : { 'f32', 'f16', 'bf16', 'i16', 'i8' }, optional
+            Sample encoding used for transfer, see cube.slice
+        target_shape : tuple of (int, int), optional
+            The minimum (traces, samples) shape of the curtain, see
+            cube.slice
+        attribute : { 'rms', 'mean', 'maxabs', 'sumpos', 'sumneg' }, optional
+            Amplitude attribute, see cube.slice
+        attribute_window : int, optional
+            Samples per attribute window, see cube.slice
+        zmin, zmax : int, optional
+            The z-range of the curtain, in sample labels, see cube.slice
 
         Returns
         -------
         curtain : numpy.ndarray
         """
 
-        resource = f'query/{self.guid}/curtain'
+        resource = with_query(
+            f'query/{self.guid}/curtain',
+            format = format,
+            attribute = attribute,
+            attribute_window = attribute_window,
+        )
         body = {
             'intersections': intersections
         }
+        if target_shape is not None:
+            body['target_shape'] = list(target_shape)
+        if zmin is not None: body['zmin'] = int(zmin)
+        if zmax is not None: body['zmax'] = int(zmax)
         import json
         proc = schedule(
             session = self.session,
@@ -245,6 +628,244 @@ class cube:
         proc.assembler = assembler_curtain(self)
         return proc
 
+    def polyline(
+            self,
+            points,
+            spacing = 1,
+            coordinates = 'label',
+            format = None,
+            attribute = None,
+            attribute_window = None):
+        """Fetch a curtain along a polyline
+
+        The polyline is densified to traces spacing apart along the line, and
+        the traces are bilinearly interpolated from the 4 traces around every
+        point, so the control points need not be on the grid.
+
+        Parameters
+        ----------
+        points : array_like
+            The (x, y) control points of the polyline, of shape (n, 2)
+        spacing : float, optional
+            The distance between the traces along the line, in world units
+            for world coordinates and in traces otherwise. It must be at
+            least a tenth of the distance between neighbouring traces.
+        coordinates : { 'label', 'grid', 'world' }, optional
+            Whether the points are in line numbers, fractional indices into
+            the cube, or the projected (e.g. UTM) coordinates of the survey.
+            Defaults to label.
+        format : { 'f32', 'f16', 'bf16', 'i16', 'i8' }, optional
+            Sample encoding used for transfer, see cube.slice
+        attribute : { 'rms', 'mean', 'maxabs', 'sumpos', 'sumneg' }, optional
+            Amplitude attribute, see cube.slice
+        attribute_window : int, optional
+            Samples per attribute window, see cube.slice
+
+        Returns
+        -------
+        polyline : numpy.ndarray
+            The traces of the densified path, of shape (traces, samples)
+        """
+        resource = with_query(
+            f'query/{self.guid}/curtain',
+            format = format,
+            attribute = attribute,
+            attribute_window = attribute_window,
+        )
+        body = {
+            'polyline': np.asarray(points, dtype = np.double).tolist(),
+            'spacing': float(spacing),
+            'coordinates': coordinates,
+        }
+        import json
+        proc = schedule(
+            session = self.session,
+            resource = resource,
+            data = json.dumps(body),
+        )
+
+        proc.assembler = assembler_polyline(self)
+        return proc
+
+    def horizon(
+            self,
+            dim0s,
+            dim1s,
+            surface,
+            window = 0,
+            format = None,
+            attribute = None):
+        """Fetch the samples along a horizon
+
+        Parameters
+        ----------
+        dim0s : list of int
+            The inlines of the surface grid
+        dim1s : list of int
+            The crosslines of the surface grid
+        surface : array_like
+            The z of the surface at every grid point, of shape (len(dim0s),
+            len(dim1s)), in the units of the last dimension. Points outside
+            the cube, e.g. -999.25, are holes.
+        window : int, optional
+            Samples to extract above and below the surface. With a window,
+            the result is a stack of 2 * window + 1 samples per grid point.
+        format : { 'f32', 'f16', 'bf16', 'i16', 'i8' }, optional
+            Sample encoding used for transfer, see cube.slice
+        attribute : { 'rms', 'mean', 'maxabs', 'sumpos', 'sumneg' }, optional
+            Reduce the window to an amplitude attribute, which gives a map
+
+        Returns
+        -------
+        horizon : numpy.ndarray
+        """
+        resource = with_query(
+            f'query/{self.guid}/horizon',
+            format = format,
+            attribute = attribute,
+        )
+        body = {
+            'dim0s': list(dim0s),
+            'dim1s': list(dim1s),
+            'surface': np.asarray(surface, dtype = np.single).ravel().tolist(),
+            'window': window,
+        }
+        import json
+        proc = schedule(
+            session = self.session,
+            resource = resource,
+            data = json.dumps(body),
+        )
+
+        proc.assembler = assembler_horizon(self)
+        return proc
+
+    def wellpath(self, points, coordinates = 'label', format = None):
+        """Fetch the samples along a well path
+
+        The samples are trilinearly interpolated from the samples around
+        every point, so points need not be on the grid.
+
+        Parameters
+        ----------
+        points : array_like
+            The (x, y, z) points of the path, of shape (n, 3)
+        coordinates : { 'label', 'grid', 'world' }, optional
+            Whether the points are in line numbers and sample labels,
+            fractional indices into the cube, or the projected (e.g. UTM)
+            coordinates of the survey with z as a sample label. Defaults to
+            label.
+        format : { 'f32', 'f16', 'bf16', 'i16', 'i8' }, optional
+            Sample encoding used for transfer, see cube.slice
+
+        Returns
+        -------
+        wellpath : numpy.ndarray
+            One sample per point, nan for points outside the cube
+        """
+        resource = with_query(f'query/{self.guid}/wellpath', format = format)
+        body = {
+            'points': np.asarray(points, dtype = np.double).tolist(),
+            'coordinates': coordinates,
+        }
+        import json
+        proc = schedule(
+            session = self.session,
+            resource = resource,
+            data = json.dumps(body),
+        )
+
+        proc.assembler = assembler_points(self)
+        return proc
+
+    def points(self, dim0s, dim1s, dim2s, coordinates = 'grid', format = None):
+        """Fetch the samples at a set of points
+
+        The points are sampled as-is, without interpolation, and can be
+        scattered anywhere in the cube. Fetching many points in one request is
+        much faster than many small requests, as every fragment is only read
+        once.
+
+        Parameters
+        ----------
+        dim0s, dim1s, dim2s : array_like of int
+            The coordinates of the points, one entry per point
+        coordinates : { 'grid', 'label' }, optional
+            Whether the points are indices into the cube, or line numbers and
+            sample labels. Defaults to grid.
+        format : { 'f32', 'f16', 'bf16', 'i16', 'i8' }, optional
+            Sample encoding used for transfer, see cube.slice
+
+        Returns
+        -------
+        points : numpy.ndarray
+            One sample per point, in the order of the points
+        """
+        resource = with_query(f'query/{self.guid}/points', format = format)
+        body = {
+            'dim0s': [int(x) for x in dim0s],
+            'dim1s': [int(x) for x in dim1s],
+            'dim2s': [int(x) for x in dim2s],
+            'coordinates': coordinates,
+        }
+        import json
+        proc = schedule(
+            session = self.session,
+            resource = resource,
+            data = json.dumps(body),
+        )
+
+        proc.assembler = assembler_points(self)
+        return proc
+
+    def area(
+            self,
+            polygon,
+            zmin = None,
+            zmax = None,
+            coordinates = 'label',
+            format = None):
+        """Fetch all traces inside a polygon
+
+        The traces inside, or on the boundary of, the polygon are extracted in
+        the sample range [zmin, zmax]. The polygon is clipped to the cube, and
+        only the fragments that cover traces inside the polygon are read.
+
+        Parameters
+        ----------
+        polygon : array_like of (float, float)
+            The vertices of the polygon, at least 3
+        zmin, zmax : int, optional
+            The sample range, in sample labels. Defaults to all samples.
+        coordinates : { 'label', 'grid', 'world' }, optional
+            Whether the vertices are line numbers, indices into the cube, or
+            world (x, y) coordinates. Defaults to label.
+        format : { 'f32', 'f16', 'bf16', 'i16', 'i8' }, optional
+            Sample encoding used for transfer, see cube.slice
+
+        Returns
+        -------
+        area : numpy.ndarray
+            The traces, of shape (traces, samples), sorted by (dim0, dim1)
+        """
+        resource = with_query(f'query/{self.guid}/area', format = format)
+        body = {
+            'polygon': [[float(x), float(y)] for x, y in polygon],
+            'coordinates': coordinates,
+        }
+        if zmin is not None: body['zmin'] = int(zmin)
+        if zmax is not None: body['zmax'] = int(zmax)
+
+        import json
+        proc = schedule(
+            session = self.session,
+            resource = resource,
+            data = json.dumps(body),
+        )
+
+        proc.assembler = assembler_area(self)
+        return proc
+
 class process:
     """
 
@@ -294,7 +915,7 @@ class process:
         Retuns
         ------
         status : str
-            Returns one of { 'working', 'finished' }
+            Returns one of { 'working', 'finished', 'failed' }
 
         Notes
         -----
@@ -6,6 +6,7 @@ from .scan import scan
 from .scan import resolve_endianness
 from .scan import hashio
 from .scan import lineset
+from . import native
 from ..internal.argparse import add_auth_args
 from ..internal.argparse import blobfs_from_args
 from ..internal.argparse import localfs_from_args
@@ -26,11 +27,30 @@ def main(argv):
     parser.add_argument('--big-endian',    action = 'store_true', default = None)
     parser.add_argument('--pretty', action = 'store_true',
         help = 'pretty-print output')
+    parser.add_argument('--native', action = 'store_true',
+        help = 'scan a local file with the native scanner')
+    parser.add_argument('--threads', type = int, default = 0,
+        help = 'native scanner threads, defaults to all cores')
+    parser.add_argument('--digest', choices = ['sha1', 'sha1-tree'],
+        default = 'sha1',
+        help = 'native scanner guid digest, defaults to sha1. sha1-tree is '
+               'parallel, but gives a different guid')
     add_auth_args(parser, direction = 'input')
 
     args = parser.parse_args(argv)
     endian = resolve_endianness(args.big_endian, args.little_endian)
 
+    if args.native:
+        d = native.scan(
+            args.src,
+            primary   = args.primary_word,
+            secondary = args.secondary_word,
+            endian    = endian,
+            threads   = args.threads,
+            digest    = args.digest,
+        )
+        return dumps(d, args.pretty)
+
     try:
         inputfs = blobfs_from_args(
             url     = args.src,
@@ -56,7 +76,10 @@ def main(argv):
         d = scan(stream, action)
         d['guid'] = stream.hexdigest()
 
-    if args.pretty:
+    return dumps(d, args.pretty)
+
+def dumps(d, pretty):
+    if pretty:
         return json.dumps(d, sort_keys = True, indent = 4)
 
     return json.dumps(d)
@@ -0,0 +1,91 @@
+"""Native scanner
+
+The native scanner is a C++ implementation of the lineset scan, which
+memory maps the file and reads the trace headers in parallel. It is built as
+the liboneseismic-scan shared library when the core is built with
+BUILD_PYTHON, and loaded with ctypes, either from the path in the
+ONESEISMIC_SCAN_LIBRARY environment variable, or from the library search
+path.
+
+The report is the same as the report of scan() with a lineset and the guid,
+except for the rounding of the transform.
+"""
+import ctypes
+import ctypes.util
+import json
+import os
+
+class scan_result(ctypes.Structure):
+    _fields_ = [
+        ('err', ctypes.c_void_p),
+        ('report', ctypes.c_void_p),
+    ]
+
+def load():
+    """Load the native scanner
+
+    Returns
+    -------
+    lib : ctypes.CDLL or None
+        None if the library is not found
+    """
+    path = os.environ.get('ONESEISMIC_SCAN_LIBRARY')
+    if path is None:
+        path = ctypes.util.find_library('oneseismic-scan')
+    if path is None:
+        return None
+
+    lib = ctypes.CDLL(path)
+    lib.oneseismic_scan.restype = scan_result
+    lib.oneseismic_scan.argtypes = [
+        ctypes.c_char_p,
+        ctypes.c_int,
+        ctypes.c_int,
+        ctypes.c_bool,
+        ctypes.c_int,
+        ctypes.c_char_p,
+    ]
+    lib.oneseismic_scan_cleanup.restype = None
+    lib.oneseismic_scan_cleanup.argtypes = [ctypes.POINTER(scan_result)]
+    return lib
+
+def scan(path, primary, secondary, endian, threads = 0, digest = 'sha1'):
+    """Scan a local SEG-Y file with the native scanner
+
+    Parameters
+    ----------
+    path : str
+    primary : int
+        The primary (inline) header word byte-offset
+    secondary : int
+        The secondary (crossline) header word byte-offset
+    endian : { 'big', 'little' }
+    threads : int, optional
+        Number of threads, 0 for hardware concurrency. Defaults to 0.
+    digest : { 'sha1', 'sha1-tree' }, optional
+        sha1 gives the same guid as scan(), and sha1-tree hashes in parallel,
+        which gives another guid. Defaults to sha1.
+
+    Returns
+    -------
+    report : dict
+    """
+    lib = load()
+    if lib is None:
+        msg = 'native scanner not found, build the core with BUILD_PYTHON'
+        raise RuntimeError(msg)
+
+    result = lib.oneseismic_scan(
+        os.fsencode(path),
+        primary,
+        secondary,
+        endian == 'big',
+        threads,
+        digest.encode(),
+    )
+    try:
+        if result.err:
+            raise RuntimeError(ctypes.string_at(result.err).decode())
+        return json.loads(ctypes.string_at(result.report))
+    finally:
+        lib.oneseismic_scan_cleanup(ctypes.byref(result))
@@ -208,6 +208,13 @@ class lineset(scanner):
         self.last1s = {}
         self.traceno = 0
 
+        # the sums of the least-squares fit of the trace coordinates (cdp-x,
+        # cdp-y) to the line numbers, for the world transform. The sums are
+        # taken relative to the first trace to keep the precision of the
+        # (large) world coordinates
+        self.origin = None
+        self.sums = [0.0] * 12
+
     def add(self, header):
         key1 = self.intp.parse(header[self.key1])
         key2 = self.intp.parse(header[self.key2])
@@ -215,9 +222,94 @@ class lineset(scanner):
         self.key2s.add(key2)
         self.last1s[key1] = self.traceno
         self.traceno += 1
+        self.add_coordinates(key1, key2, header)
         # TODO: detect key-pair duplicates?
         # TODO: check that the sample-interval is consistent across the file?
 
+    def add_coordinates(self, key1, key2, header):
+        intp = parseint(endian = self.endian, default_length = 2)
+        scalar = intp.parse(header.get(int(segyio.su.scalco), 0))
+        x = self.intp.parse(header[int(segyio.su.cdpx)])
+        y = self.intp.parse(header[int(segyio.su.cdpy)])
+        if scalar > 0:
+            x, y = x * scalar, y * scalar
+        elif scalar < 0:
+            x, y = x / -scalar, y / -scalar
+
+        if self.origin is None:
+            self.origin = (key1, key2, x, y)
+
+        k1 = key1 - self.origin[0]
+        k2 = key2 - self.origin[1]
+        dx = x - self.origin[2]
+        dy = y - self.origin[3]
+        for i, term in enumerate([
+            1, k1, k2, k1 * k1, k1 * k2, k2 * k2,
+            dx, k1 * dx, k2 * dx,
+            dy, k1 * dy, k2 * dy,
+        ]):
+            self.sums[i] += term
+
+    def transform(self):
+        """The affine transform from grid to world coordinates
+
+        Fit the trace coordinates to the line numbers with least-squares, and
+        map it to the grid of the (regularly spaced) line numbers. The
+        transform is in the GDAL geotransform convention,
+
+            x = t[0] + t[1] * i + t[2] * j
+            y = t[3] + t[4] * i + t[5] * j
+
+        where (i, j) are the indices of the inline and crossline.
+
+        Returns
+        -------
+        transform : list of float or None
+            None if the survey has no (usable) trace coordinates, or the line
+            numbers are irregular
+        """
+        if self.origin is None:
+            return None
+
+        key1s = sorted(self.key1s)
+        key2s = sorted(self.key2s)
+        if len(key1s) < 2 or len(key2s) < 2:
+            return None
+
+        step1 = key1s[1] - key1s[0]
+        step2 = key2s[1] - key2s[0]
+        if np.any(np.diff(key1s) != step1) or np.any(np.diff(key2s) != step2):
+            return None
+
+        n, s1, s2, s11, s12, s22, sx, s1x, s2x, sy, s1y, s2y = self.sums
+        A = np.array([
+            [n,  s1,  s2],
+            [s1, s11, s12],
+            [s2, s12, s22],
+        ])
+        try:
+            cx = np.linalg.solve(A, [sx, s1x, s2x])
+            cy = np.linalg.solve(A, [sy, s1y, s2y])
+        except np.linalg.LinAlgError:
+            return None
+
+        # x = x0 + cx[0] + cx[1] * (key1 - k0) + cx[2] * (key2 - l0), and
+        # key1 = key1s[0] + step1 * i
+        o1 = key1s[0] - self.origin[0]
+        o2 = key2s[0] - self.origin[1]
+        t = [
+            self.origin[2] + cx[0] + cx[1] * o1 + cx[2] * o2,
+            cx[1] * step1,
+            cx[2] * step2,
+            self.origin[3] + cy[0] + cy[1] * o1 + cy[2] * o2,
+            cy[1] * step1,
+            cy[2] * step2,
+        ]
+
+        if t[1] * t[5] - t[2] * t[4] == 0:
+            return None
+        return [float(x) for x in t]
+
     def report(self):
         r = super().report()
         interval = r['sampleinterval']
@@ -229,6 +321,9 @@ class lineset(scanner):
         ]
         r['key1-last-trace'] = self.last1s
         r['key-words'] = [self.key1, self.key2]
+        transform = self.transform()
+        if transform is not None:
+            r['transform'] = transform
         return r
 
 def scan(stream, action):
@@ -1,3 +1,4 @@
+import pytest
 import segyio
 import struct
 import sys
@@ -40,3 +41,64 @@ def test_regular_intervals(inlines, crosslines):
         seg.add(header)
 
     assert len(seg.key2s) == crosslines
+
+def as_read(value, fmt = 'i'):
+    """Signed value as read by segyio from a file of native byte order
+    """
+    chunk = struct.pack('>' + fmt, value)
+    return int.from_bytes(chunk, byteorder = sys.byteorder, signed = True)
+
+def test_world_transform():
+    # a survey with inlines 10, 12, ... and crosslines 100, 101, ... with
+    # 25m x 12.5m bins, rotated 90 degrees, and coordinates in centimetres
+    headers = [
+        {
+            int(segyio.su.iline): as_read(10 + 2 * i),
+            int(segyio.su.xline): as_read(100 + x),
+            int(segyio.su.cdpx): as_read(45600000 - 1250 * x),
+            int(segyio.su.cdpy): as_read(678000000 + 2500 * i),
+            int(segyio.su.scalco): as_read(-100, 'h'),
+            int(segyio.su.ns): 0,
+            int(segyio.su.dt): 0,
+        }
+        for i in range(5)
+        for x in range(4)
+    ]
+
+    seg = lineset(
+            primary = int(segyio.su.iline),
+            secondary = int(segyio.su.xline),
+            endian = sys.byteorder,
+        )
+
+    for header in headers:
+        seg.add(header)
+
+    t = seg.transform()
+    expected = [456000.0, 0.0, -12.5, 6780000.0, 25.0, 0.0]
+    assert t == pytest.approx(expected)
+
+def test_no_world_transform_without_coordinates():
+    headers = [
+        {
+            int(segyio.su.iline): big_endian(i),
+            int(segyio.su.xline): big_endian(x),
+            int(segyio.su.cdpx): 0,
+            int(segyio.su.cdpy): 0,
+            int(segyio.su.ns): 0,
+            int(segyio.su.dt): 0,
+        }
+        for i in range(1, 4)
+        for x in range(1, 4)
+    ]
+
+    seg = lineset(
+            primary = int(segyio.su.iline),
+            secondary = int(segyio.su.xline),
+            endian = sys.byteorder,
+        )
+
+    for header in headers:
+        seg.add(header)
+
+    assert seg.transform() is None
@@ -61,6 +61,18 @@ def main(argv):
         metavar = 'k',
         dest = 'k',
     )
+    parser.add_argument(
+        '--decimations',
+        type = int,
+        nargs = '*',
+        default = [2, 4, 8],
+        metavar = 'n',
+        help = '''
+            Decimation factors of the overview levels, used to serve
+            zoomed-out views without reading the full resolution fragments.
+            Pass no values to only upload the full resolution cube.
+        ''',
+    )
     add_auth_args(parser, direction = 'input')
     add_auth_args(parser, direction = 'output')
 
@@ -98,7 +110,13 @@ def main(argv):
 
     fragment_shape = (args.i, args.j, args.k)
     with inputfs.open(src, 'rb') as src:
-        upload(meta, fragment_shape, src, outputfs)
+        upload(
+            meta,
+            fragment_shape,
+            src,
+            outputfs,
+            decimations = args.decimations,
+        )
 
 if __name__ == '__main__':
     main(sys.argv[1:])
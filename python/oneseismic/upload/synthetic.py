@@ -0,0 +1,165 @@
+import argparse
+import hashlib
+import json
+import sys
+
+import numpy as np
+
+from .upload import store
+from ..internal.argparse import add_auth_args
+from ..internal.argparse import blobfs_from_args
+from ..internal.argparse import localfs_from_args
+
+def synthetic_manifest(shape, sampleinterval = 4000, first = (1, 1), seed = 0):
+    """Manifest of a synthetic survey
+
+    Make a manifest equivalent to what the scan program would report for a
+    regular survey of shape, with traces sorted inline-major.
+
+    Parameters
+    ----------
+    shape : tuple of int
+        Number of inlines, crosslines and samples
+    sampleinterval : int, optional
+        Sample interval in microseconds. Defaults to 4000.
+    first : tuple of int, optional
+        The first inline and crossline number. Defaults to (1, 1).
+    seed : int, optional
+        Seed of the synthetic data, which is a part of the guid
+
+    Returns
+    -------
+    manifest : dict
+    """
+    ni, nx, ns = shape
+    guid = hashlib.sha1(
+        f'synthetic {ni} {nx} {ns} {sampleinterval} {first} {seed}'.encode()
+    ).hexdigest()
+
+    return {
+        'byteorder': 'little',
+        'format': 5,
+        'samples': ns,
+        'sampleinterval': sampleinterval,
+        'byteoffset-first-trace': 3600,
+        'dimensions': [
+            list(range(first[0], first[0] + ni)),
+            list(range(first[1], first[1] + nx)),
+            list(range(0, ns * sampleinterval, sampleinterval)),
+        ],
+        'key1-last-trace': {
+            str(first[0] + i): (i + 1) * nx - 1 for i in range(ni)
+        },
+        'key-words': [189, 193],
+        'guid': guid,
+        'seed': seed,
+    }
+
+def synthetic_traces(manifest, seed = 0):
+    """Traces of a synthetic survey
+
+    The survey is a layer cake of gently dipping reflectors with a little
+    noise, which looks plausible when plotted and compresses about as poorly
+    as real data does. Traces are generated lazily, so surveys of any size can
+    be made without holding them in memory.
+
+    Yields
+    ------
+    key1, key2, trace : int, int, np.array of float32
+    """
+    key1s, key2s, key3s = manifest['dimensions']
+    rng = np.random.default_rng(seed)
+    z = np.arange(len(key3s), dtype = np.float32)
+
+    # reflector periods, in samples, and their amplitudes
+    periods = np.array([7.0, 17.0, 41.0], dtype = np.float32)
+    amplitudes = np.array([0.5, 1.0, 0.7], dtype = np.float32)
+
+    for i, key1 in enumerate(key1s):
+        for j, key2 in enumerate(key2s):
+            shift = 0.05 * i + 0.02 * j
+            phase = 2 * np.pi * (z[:, None] + shift) / periods
+            trace = (amplitudes * np.sin(phase)).sum(axis = 1)
+            trace += rng.normal(scale = 0.05, size = len(z))
+            yield key1, key2, trace.astype(np.float32)
+
+def synthetic(
+        shape,
+        fragment_shape,
+        filesys,
+        decimations = (2, 4, 8),
+        seed = 0):
+    """Store a synthetic survey
+
+    Generate a survey of shape and store it with the same layout as
+    upload(), through filesys.
+
+    Returns
+    -------
+    manifest : dict
+        The manifest of the stored survey, including the guid
+    """
+    manifest = synthetic_manifest(shape, seed = seed)
+    traces = synthetic_traces(manifest, seed = seed)
+    store(manifest, fragment_shape, traces, filesys, decimations)
+    return manifest
+
+def main(argv):
+    parser = argparse.ArgumentParser(
+        prog = 'synthetic',
+        description = '''
+            Generate a synthetic survey straight into oneseismic storage, e.g.
+            for load testing without production cubes. Prints the manifest.
+        ''',
+    )
+    parser.add_argument(
+        'dst',
+        type = str,
+        help = 'Destination storage account URL, or a local directory',
+    )
+    parser.add_argument(
+        '--shape',
+        type = int,
+        nargs = 3,
+        default = [512, 512, 512],
+        metavar = ('inlines', 'crosslines', 'samples'),
+    )
+    parser.add_argument(
+        '--fragment-shape',
+        type = int,
+        nargs = 3,
+        default = [64, 64, 64],
+        metavar = ('i', 'j', 'k'),
+    )
+    parser.add_argument(
+        '--decimations',
+        type = int,
+        nargs = '*',
+        default = [2, 4, 8],
+        metavar = 'n',
+    )
+    parser.add_argument('--seed', type = int, default = 0)
+    add_auth_args(parser, direction = 'output')
+    args = parser.parse_args(argv)
+
+    try:
+        filesys = blobfs_from_args(
+            url     = args.dst,
+            method  = args.output_auth_method,
+            connstr = args.output_connection_string,
+            creds   = args.output_credentials,
+        )
+    except ValueError:
+        filesys = localfs_from_args(args.dst)
+
+    manifest = synthetic(
+        shape = args.shape,
+        fragment_shape = args.fragment_shape,
+        filesys = filesys,
+        decimations = args.decimations,
+        seed = args.seed,
+    )
+    return json.dumps(manifest)
+
+if __name__ == '__main__':
+    print(main(sys.argv[1:]))
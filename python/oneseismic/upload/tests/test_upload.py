@@ -212,3 +212,58 @@ def test_upload_scrambled_traces(tmp_path):
             from_scramble = f.read()
             from_orig     = g.read()
         assert from_scramble == from_orig
+
+def test_upload_decimated_levels(tmp_path):
+    filesys = localfs(tmp_path)
+    fragment_shape = (4, 4, 4)
+    meta = json.loads(small_manifest)
+    with open(source, 'rb') as src:
+        upload(meta, fragment_shape, src, filesys, decimations = (2, 4, 8))
+
+    guid = meta['guid']
+    # 5x5x50 is decimated to 3x3x25, 2x2x13 and 1x1x7
+    zfrags = { 2: 7, 4: 4, 8: 2 }
+    for d, k in zfrags.items():
+        root = tmp_path / Path(f'{guid}/lod{d}/4-4-4')
+        uploaded = sorted([p.name for p in root.iterdir()])
+        assert uploaded == sorted([f'0-0-{z}.f32' for z in range(k)])
+
+    # sample (i, j, k) in lod2 is sample (2i, 2j, 2k) in src
+    src = tmp_path / Path(f'{guid}/src/4-4-4/0-0-0.f32')
+    lod = tmp_path / Path(f'{guid}/lod2/4-4-4/0-0-0.f32')
+    src = np.fromfile(src, dtype = np.float32).reshape(fragment_shape)
+    lod = np.fromfile(lod, dtype = np.float32).reshape(fragment_shape)
+    np.testing.assert_array_equal(lod[:2, :2, :2], src[::2, ::2, ::2])
+
+    with open(tmp_path / Path(f'{guid}/manifest.json')) as f:
+        manifest = json.load(f)
+    assert manifest['decimations'] == [2, 4, 8]
+
+def test_synthetic_survey_is_stored_like_upload(tmp_path):
+    from ..synthetic import synthetic, synthetic_traces
+
+    filesys = localfs(tmp_path)
+    fragment_shape = (4, 4, 4)
+    manifest = synthetic((6, 5, 9), fragment_shape, filesys, decimations = ())
+
+    guid = manifest['guid']
+    root = tmp_path / Path(f'{guid}/src/4-4-4')
+    uploaded = sorted([p.name for p in root.iterdir()])
+    assert uploaded == sorted([
+        f'{i}-{j}-{k}.f32'
+        for i in range(2)
+        for j in range(2)
+        for k in range(3)
+    ])
+
+    # the first trace is in the top of fragment 0-0-0, and the generator is
+    # deterministic for the same seed
+    _, _, first = next(synthetic_traces(manifest))
+    fragment = np.fromfile(root / '0-0-0.f32', dtype = np.float32)
+    fragment = fragment.reshape(fragment_shape)
+    np.testing.assert_array_equal(fragment[0, 0, :], first[:4])
+
+    with open(tmp_path / Path(f'{guid}/manifest.json')) as f:
+        stored = json.load(f)
+    assert stored['dimensions'][0] == [1, 2, 3, 4, 5, 6]
+    assert stored['key1-last-trace']['6'] == 29
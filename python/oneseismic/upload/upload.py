@@ -51,16 +51,27 @@ class fileset:
     key2s : list of int
     key3s : list of int
     fragment_shape : tuple of int
+    decimation : int, optional
+        Only store every decimation'th sample in all directions, for building
+        overview levels. Traces that are not on the decimated grid are
+        ignored by put(). Defaults to 1, i.e. full resolution.
+    statsbins : int, optional
+        Summarise the fragments with a histogram of statsbins bins, for the
+        fragment stats sidecar given by statistics(). Defaults to 0, i.e. no
+        stats.
 
     Notes
     -----
-    Right now, oneseismic is not mature enough to properly handle "holes" in
-    the volumes, and require explicit padding.  The fileset class is aware of
-    this and will generate padding fragments when necessary. This may change in
-    the future and should not be relied on. However, uploading programs should
-    be written so it they are oblivious to this.
+    Only the fragment columns (i, j) with at least one trace are stored, so
+    holes and the outside of irregular surveys take no storage. The stored
+    columns are recorded in the fragment-existence bitmap given by mask(),
+    which must be written to the manifest. Fragments at the edges of holes
+    are still padded with zeros.
+
+    The fragment stats only cover the traced samples, and not the padding.
     """
-    def __init__(self, key1s, key2s, key3s, fragment_shape):
+    def __init__(self, key1s, key2s, key3s, fragment_shape, decimation = 1,
+                 statsbins = 0):
         mkfile = lambda: np.zeros(shape = fragment_shape, dtype = np.float32)
         # fileset is built on the files dict, which is a mapping from (i,j,k)
         # fragment IDs to arrays. When a new fragment is accessed, a full
@@ -68,6 +79,14 @@ class fileset:
         # needs padding.
         self.files = collections.defaultdict(mkfile)
 
+        # the decimated levels are sampled on a regular grid with the same
+        # origin as the full-resolution cube, so sample (i, j, k) in the
+        # decimated level is sample (i*d, j*d, k*d) in the source
+        self.decimation = decimation
+        key1s = list(key1s)[::decimation]
+        key2s = list(key2s)[::decimation]
+        key3s = list(key3s)[::decimation]
+
         # map line-numbers to the fragment ID
         self.key1s = {k: i // fragment_shape[0] for i, k in enumerate(key1s)}
         self.key2s = {k: i // fragment_shape[1] for i, k in enumerate(key2s)}
@@ -83,6 +102,19 @@ class fileset:
         self.traceno = 0
         self.limits = {}
 
+        # the (i, j) fragment columns with at least one trace
+        self.columns = set()
+        # the traced (i, j) positions of the columns not yet committed, and
+        # the stats of the committed fragments
+        self.traced = {}
+        self.summaries = {}
+        self.statsbins = statsbins
+        self.nsamples = len(key3s)
+        self.shape = (
+            math.ceil(len(key1s) / fragment_shape[0]),
+            math.ceil(len(key2s) / fragment_shape[1]),
+        )
+
     def commit(self, key1):
         """
         Commit a "lane", yielding all completed. This function assumes that the
@@ -102,29 +134,39 @@ class fileset:
 
         Notes
         -----
+        For decimated filesets, commit() must still be called for every trace
+        in the input, including the ones not on the decimated grid, as it
+        counts traces.
+
         Commit will prune files whenever it can, to keep resource usage low,
         but can in pathological cases end up storing the original volume in
-        memory. Calling commit() on the same lane twice will result in the
-        second call giving all zero-padded files.
+        memory. Calling commit() on the same lane twice will give nothing the
+        second time.
         """
-        index1 = self.key1s[key1]
-        if self.limits[index1] == self.traceno:
+        index1 = self.key1s.get(key1)
+        if index1 is not None and self.limits[index1] == self.traceno:
             # todo: cache.
             js = set(self.key2s.values())
             ks = set(range(self.zsections))
             i = index1
 
-            # since self.files is a defaultdict, which means that even though an
-            # (i,j,k) has never been written to before, it is generated and yielded
-            # by the generator. This ensures that fragments or even holes [1] with
-            # no data still get explicit representation when uploaded to
-            # oneseismic.
-            # [1] this happens quite often, especially at the edges of surveys
+            # Columns without any traces are holes, which are not stored and
+            # are left out of the mask. A column with a trace has data in all
+            # its fragments, since every trace spans the whole z-axis.
             for j in js:
+                if (i, j) not in self.columns:
+                    continue
+                traced = self.traced.pop((i, j))
                 for k in ks:
                     ident = (i, j, k)
-                    yield ident, self.files[ident]
-                    del self.files[ident]
+                    fragment = self.files.pop(ident)
+                    if self.statsbins > 0:
+                        self.summaries[ident] = self.summarise(
+                            ident,
+                            fragment,
+                            traced,
+                        )
+                    yield ident, fragment
 
         self.traceno += 1
 
@@ -143,19 +185,108 @@ class fileset:
             line-no in dimension 1
         trace : np.array of float
         """
+        # traces off the decimated grid are not a part of this fileset
+        if key1 not in self.key1s or key2 not in self.key2s:
+            return
+
         # determine what file this trace goes into
         # this is the (i, j, _) fragment ID
         index1 = self.key1s[key1]
         index2 = self.key2s[key2]
+        trace = trace[::self.decimation]
 
         # the offset in a specific file the trace starts at
         i = self.off1s[key1]
         j = self.off2s[key2]
 
+        self.columns.add((index1, index2))
+        if (index1, index2) not in self.traced:
+            shape = self.fragment_shape[:2]
+            self.traced[(index1, index2)] = np.zeros(shape, dtype = bool)
+        self.traced[(index1, index2)][i, j] = True
         for index3, tr in enumerate(splitarray(trace, self.fragment_shape[2])):
             fragment = self.files[(index1, index2, index3)]
             fragment[i, j, :len(tr)] = tr
 
+    def mask(self):
+        """Fragment-existence bitmap
+
+        The bitmap of the stored fragment columns (i, j), for the
+        fragment-mask of the manifest. Bit n = i * columns(j) + j is set when
+        the column is stored, and is bit n % 8 (least significant first) of
+        byte n / 8.
+
+        Returns
+        -------
+        mask : str
+            The bitmap as hex
+        """
+        bits = np.zeros(shape = self.shape, dtype = np.uint8)
+        for i, j in self.columns:
+            bits[i, j] = 1
+        return np.packbits(bits.ravel(), bitorder = 'little').tobytes().hex()
+
+    def summarise(self, ident, fragment, traced):
+        """Stats record of a fragment
+
+        The stats of the traced samples of the fragment, as a record of the
+        fragment stats sidecar. The samples below the end of the traces, in
+        the bottom fragments, are padding and not counted.
+
+        Parameters
+        ----------
+        ident : tuple of int
+            The (i, j, k) fragment ID
+        fragment : np.array
+        traced : np.array of bool
+            The traced (i, j) positions of the fragment
+
+        Returns
+        -------
+        record : bytes
+        """
+        depth = self.fragment_shape[2]
+        nz = min(depth, self.nsamples - ident[2] * depth)
+        samples = fragment[traced][:, :nz].astype(np.float64).ravel()
+        if len(samples) == 0:
+            return bytes(self.statsize())
+
+        lo, hi = samples.min(), samples.max()
+        hist, _ = np.histogram(samples, bins = self.statsbins, range = (lo, hi))
+        mean = samples.mean()
+        rms = np.sqrt(np.mean(np.square(samples)))
+        return b''.join((
+            np.array([lo, hi, mean, rms], dtype = '<f4').tobytes(),
+            np.array([len(samples)], dtype = '<u4').tobytes(),
+            hist.astype('<u4').tobytes(),
+        ))
+
+    def statsize(self):
+        """Size of a record of the fragment stats sidecar, in bytes"""
+        return 4 * 4 + 4 + 4 * self.statsbins
+
+    def statistics(self):
+        """Fragment stats sidecar
+
+        The stats of all fragments, as records of min, max, mean, rms (float32),
+        count (uint32) and a histogram of statsbins bins (uint32) evenly spaced
+        between min and max, all little endian. The records are in (i, j, k)
+        fragment ID order, where k is the fastest, and fragments that are not
+        stored have a count of zero. This is the stats.bin read by the stats
+        function of the query server.
+
+        Returns
+        -------
+        sidecar : bytes
+        """
+        empty = bytes(self.statsize())
+        return b''.join(
+            self.summaries.get((i, j, k), empty)
+            for i in range(self.shape[0])
+            for j in range(self.shape[1])
+            for k in range(self.zsections)
+        )
+
     def setlimits(self, last_trace):
         """
         fileset needs to know when the last trace of a lane is read, to safely
@@ -172,12 +303,90 @@ class fileset:
         """
         limits = collections.defaultdict(int)
         for k, v in last_trace.items():
-            x = self.key1s[int(k)]
+            x = self.key1s.get(int(k))
+            if x is None:
+                continue
             limits[x] = max(int(v), limits[x])
 
         self.limits.update(limits)
 
-def upload(manifest, fragment_shape, src, filesys):
+def store(manifest, fragment_shape, traces, filesys, decimations = (2, 4, 8)):
+    """Store a volume as fragments
+
+    Write the traces as fragments of the full resolution cube and the
+    overview levels, and write the manifest. This is the storage half of
+    upload(), and does not care where the traces come from.
+
+    Parameters
+    ----------
+    manifest : dict
+        The parsed output of the scan program, or an equivalent document
+    fragment_shape : tuple of int
+    traces : iterable of (int, int, np.array)
+        The (key1, key2, samples) of every trace, in file order
+    filesys : localfs or blobfs
+    decimations : iterable of int, optional
+        Decimation factors of the overview levels to build alongside the full
+        resolution cube. The levels are stored as lod<n>/, and listed in the
+        manifest. Defaults to (2, 4, 8).
+    """
+    key1s = manifest['dimensions'][0]
+    key2s = manifest['dimensions'][1]
+    key3s = manifest['dimensions'][2]
+    guid  = manifest['guid']
+
+    decimations = sorted(set(d for d in decimations if d > 1))
+    # the number of histogram bins of the fragment stats
+    statsbins = 16
+    shapeident = '-'.join(map(str, fragment_shape))
+    levels = [
+        (
+            fileset(key1s, key2s, key3s, fragment_shape, statsbins = statsbins),
+            f'src/{shapeident}',
+        ),
+    ]
+    for d in decimations:
+        levels.append((
+            fileset(key1s, key2s, key3s, fragment_shape, decimation = d),
+            f'lod{d}/{shapeident}',
+        ))
+
+    for files, _ in levels:
+        files.setlimits(manifest['key1-last-trace'])
+
+    filesys.mkdir(guid)
+    filesys.cd(guid)
+
+    for key1, key2, data in traces:
+        for files, prefix in levels:
+            files.put(key1, key2, data)
+            for ident, fragment in files.commit(key1):
+                ident = '-'.join(map(str, ident))
+                name = f'{prefix}/{ident}.f32'
+                print('uploading', name)
+                with filesys.open(name, mode = 'wb') as f:
+                    f.write(fragment)
+
+    manifest['decimations'] = decimations
+    # Holes are not stored, and are read as fill-value. The fragments were
+    # padded with zeros before the holes were left out, so keep that.
+    manifest['fragment-mask'] = {
+        str(files.decimation): files.mask() for files, _ in levels
+    }
+    manifest['fill-value'] = 0
+
+    # The stats are only of the full resolution cube, which is the first level
+    src, prefix = levels[0]
+    with filesys.open(f'{prefix}/stats.bin', mode = 'wb') as f:
+        f.write(src.statistics())
+    manifest['fragment-stats'] = {
+        'shape': list(fragment_shape),
+        'bins': statsbins,
+    }
+    with filesys.open('manifest.json', mode = 'wb') as f:
+        f.write(json.dumps(manifest).encode())
+
+def upload(manifest, fragment_shape, src, filesys, decimations = (2, 4, 8)):
     """Upload volume to oneseismic
 
     Parameters
@@ -187,13 +396,14 @@ def upload(manifest, fragment_shape, src, filesys):
     fragment_shape : tuple of int
     src : io.BaseIO
     blob : azure.storage.blob.BlobServiceClient
+    decimations : iterable of int, optional
+        Decimation factors of the overview levels to build alongside the full
+        resolution cube. The levels are stored as lod<n>/, and listed in the
+        manifest. Defaults to (2, 4, 8).
     """
     word1 = manifest['key-words'][0]
     word2 = manifest['key-words'][1]
-    key1s = manifest['dimensions'][0]
-    key2s = manifest['dimensions'][1]
     key3s = manifest['dimensions'][2]
-    guid  = manifest['guid']
 
     # Seek past the textual headers and the binary header
     src.seek(int(manifest['byteoffset-first-trace']), io.SEEK_CUR)
@@ -213,31 +423,14 @@ def upload(manifest, fragment_shape, src, filesys):
     trace = np.array(1, dtype = dtype)
     fmt = manifest['format']
 
-    files = fileset(key1s, key2s, key3s, fragment_shape)
-    files.setlimits(manifest['key1-last-trace'])
-    shapeident = '-'.join(map(str, fragment_shape))
-    prefix = f'src/{shapeident}'
-
-    filesys.mkdir(guid)
-    filesys.cd(guid)
-
-    while True:
-        n = src.readinto(trace)
-        if n == 0:
-            break
+    def traces():
+        while True:
+            n = src.readinto(trace)
+            if n == 0:
+                break
 
-        header = segyio.field.Field(buf = trace['header'], kind = 'trace')
-        data = native(data = trace['samples'], format = fmt)
+            header = segyio.field.Field(buf = trace['header'], kind = 'trace')
+            data = native(data = trace['samples'], format = fmt)
+            yield header[word1], header[word2], data
 
-        key1 = header[word1]
-        key2 = header[word2]
-        files.put(key1, key2, data)
-        for ident, fragment in files.commit(key1):
-            ident = '-'.join(map(str, ident))
-            name = f'{prefix}/{ident}.f32'
-            print('uploading', name)
-            with filesys.open(name, mode = 'wb') as f:
-                f.write(fragment)
-
-    with filesys.open('manifest.json', mode = 'wb') as f:
-        f.write(json.dumps(manifest).encode())
+    store(manifest, fragment_shape, traces(), filesys, decimations)
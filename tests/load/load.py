@@ -0,0 +1,170 @@
+"""Load test oneseismic end-to-end
+
+Drive a mixed slice and curtain workload against a running oneseismic, and
+report latency percentiles as seen by the client. The cube is either given by
+guid, or a synthetic survey is generated and uploaded to STORAGE_URL first.
+
+This is meant to run against the local stand-ins in docker-compose_load.yml
+(azurite for blob, a local redis), but works against any deployment:
+
+    docker-compose -f docker-compose.yml -f docker-compose_tests.yml \\
+                   -f docker-compose_load.yml up --build load
+
+For the per-stage (plan, fetch, add, pack) latencies of the query engine
+itself, without the service stack, use oneseismic-load from core/.
+"""
+import argparse
+import concurrent.futures
+import json
+import os
+import random
+import sys
+import time
+from urllib.parse import parse_qs, urlparse
+
+import numpy as np
+import requests
+from azure.core.credentials import AccessToken
+from azure.storage.blob import BlobServiceClient
+
+from oneseismic.client.client import cube, http_session
+from oneseismic.internal import blobfs
+from oneseismic.upload.synthetic import synthetic
+
+API_ADDR = os.getenv("API_ADDR", "http://localhost:8080")
+AUTHSERVER = os.getenv("AUTHSERVER", "http://localhost:8089")
+AUDIENCE = os.getenv("AUDIENCE")
+STORAGE_URL = os.getenv("STORAGE_URL")
+
+
+class CustomTokenCredential(object):
+    def get_token(self, *scopes, **kwargs):
+        r = requests.post(AUTHSERVER + "/oauth2/v2.0/token")
+        access_token = r.json()["access_token"]
+        return AccessToken(access_token, 1)
+
+
+class tokens:
+    def headers(self):
+        r = requests.get(
+            AUTHSERVER + "/oauth2/v2.0/authorize" + "?client_id=" + AUDIENCE,
+            headers={"content-type": "application/json"},
+            allow_redirects=False,
+        )
+        token = parse_qs(urlparse(r.headers["location"]).fragment)["access_token"]
+
+        return {"Authorization": f"Bearer {token[0]}"}
+
+
+def upload_synthetic(shape, fragment_shape, seed):
+    client = BlobServiceClient(STORAGE_URL, CustomTokenCredential())
+    manifest = synthetic(
+        shape = shape,
+        fragment_shape = fragment_shape,
+        filesys = blobfs(client),
+        seed = seed,
+    )
+    return manifest["guid"]
+
+
+def workload(dims, n, curtains, curtain_length, seed):
+    """Draw n queries, as (kind, args) tuples
+
+    Slices are uniform over dimensions and lines, curtains are straight lines
+    between random points in the survey.
+    """
+    rng = random.Random(seed)
+    for _ in range(n):
+        if rng.random() >= curtains:
+            dim = rng.randrange(3)
+            yield "slice", (dim, rng.choice(dims[dim]))
+            continue
+
+        x0, x1 = rng.randrange(len(dims[0])), rng.randrange(len(dims[0]))
+        y0, y1 = rng.randrange(len(dims[1])), rng.randrange(len(dims[1]))
+        t = np.linspace(0, 1, curtain_length)
+        xs = np.rint(x0 + t * (x1 - x0)).astype(int)
+        ys = np.rint(y0 + t * (y1 - y0)).astype(int)
+        yield "curtain", ([
+            [dims[0][x], dims[1][y]] for x, y in zip(xs, ys)
+        ],)
+
+
+def run(c, kind, args):
+    start = time.perf_counter()
+    proc = getattr(c, kind)(*args)
+    scheduled = time.perf_counter()
+    raw = proc.get_raw()
+    done = time.perf_counter()
+    return {
+        "kind": kind,
+        "schedule": (scheduled - start) * 1000,
+        "end-to-end": (done - start) * 1000,
+        "bytes": len(raw),
+    }
+
+
+def summary(xs):
+    xs = np.asarray(xs)
+    if len(xs) == 0:
+        return { "count": 0 }
+    return {
+        "count": len(xs),
+        "p50": float(np.percentile(xs, 50)),
+        "p90": float(np.percentile(xs, 90)),
+        "p99": float(np.percentile(xs, 99)),
+        "max": float(xs.max()),
+    }
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(prog = "load", description = __doc__)
+    parser.add_argument("--guid", type = str, default = None)
+    parser.add_argument("--shape", type = int, nargs = 3, default = [256, 256, 256])
+    parser.add_argument("--fragment-shape", type = int, nargs = 3, default = [64, 64, 64])
+    parser.add_argument("--clients", type = int, default = 4)
+    parser.add_argument("--requests", type = int, default = 100)
+    parser.add_argument("--curtains", type = float, default = 0.3)
+    parser.add_argument("--curtain-length", type = int, default = 200)
+    parser.add_argument("--seed", type = int, default = 0)
+    args = parser.parse_args(argv)
+
+    guid = args.guid
+    if guid is None:
+        guid = upload_synthetic(args.shape, args.fragment_shape, args.seed)
+
+    session = http_session(base_url = API_ADDR, tokens = tokens())
+    c = cube(guid, session)
+    queries = list(workload(
+        c.ijk,
+        args.requests,
+        args.curtains,
+        args.curtain_length,
+        args.seed,
+    ))
+
+    start = time.perf_counter()
+    with concurrent.futures.ThreadPoolExecutor(args.clients) as pool:
+        results = list(pool.map(lambda q: run(c, *q), queries))
+    elapsed = time.perf_counter() - start
+
+    report = {
+        "guid": guid,
+        "queries": len(results),
+        "clients": args.clients,
+        "seconds": elapsed,
+        "qps": len(results) / elapsed,
+        "MBps": sum(r["bytes"] for r in results) / elapsed / 1e6,
+    }
+    for kind in ["slice", "curtain"]:
+        rs = [r for r in results if r["kind"] == kind]
+        report[kind] = {
+            stage: summary([r[stage] for r in rs])
+            for stage in ["schedule", "end-to-end"]
+        }
+
+    print(json.dumps(report, indent = 4))
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])